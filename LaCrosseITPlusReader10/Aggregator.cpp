@@ -0,0 +1,302 @@
+#include "Aggregator.h"
+#include "RecordWriter.h"
+#include "LineWriter.h"
+#include "SensorBase.h"
+#include "SerialQueue.h"
+
+#if AGGREGATOR_SIZE > 0
+Aggregator::Entry Aggregator::m_entries[AGGREGATOR_SIZE];
+#endif
+word Aggregator::m_window = 0;
+byte Aggregator::m_nextCheck = 0;
+unsigned long Aggregator::m_frames = 0;
+unsigned long Aggregator::m_sent = 0;
+
+// Without the table it stays off
+bool Aggregator::Configure(word window) {
+#if AGGREGATOR_SIZE == 0
+  return window == 0;
+#else
+  for (byte i = 0; i < AGGREGATOR_SIZE; i++) {
+    if (m_entries[i].Key != 0) {
+      Send(&m_entries[i]);
+      SerialQueue::Flush();
+    }
+  }
+
+  m_window = window > AGGREGATOR_MAX_WINDOW ? AGGREGATOR_MAX_WINDOW : window;
+  m_nextCheck = 0;
+  memset(m_entries, 0, sizeof(m_entries));
+  return true;
+#endif
+}
+
+bool Aggregator::IsEnabled() {
+  return m_window > 0;
+}
+
+word Aggregator::GetNow() {
+  return millis() / 1000;
+}
+
+#if AGGREGATOR_SIZE > 0
+// Sent entries are freed, so the key is looked for in the whole table.
+// Without a match the first free entry, NULL if the table is full.
+Aggregator::Entry *Aggregator::Find(word key) {
+  Entry *free = NULL;
+  for (byte i = 0; i < AGGREGATOR_SIZE; i++) {
+    Entry *entry = &m_entries[i];
+    if (entry->Key == key) {
+      return entry;
+    }
+    if (entry->Key == 0 && free == NULL) {
+      free = entry;
+    }
+  }
+  return free;
+}
+#endif
+
+#if AGGREGATOR_SIZE == 0
+bool Aggregator::TryAdd(const byte * /* record */, byte /* length */) {
+  return false;
+}
+#else
+bool Aggregator::TryAdd(const byte *record, byte length) {
+  if (!IsEnabled() || length < 3) {
+    return false;
+  }
+
+  // Where temperature and humidity are in the record, see RecordWriter.h
+  byte fields;
+  byte channel = 0;
+  const byte *values = record + 3;
+  switch (record[0]) {
+  case RECORD_LACROSSE:
+  case RECORD_WT440XH:
+  case RECORD_TX38IT:
+    if (length != 6) {
+      return false;
+    }
+    fields = RECORD_HAS_TEMPERATURE | RECORD_HAS_HUMIDITY;
+    channel = record[2] & 4 ? 1 : 0;
+    break;
+
+  case RECORD_TX22IT:
+  case RECORD_WS1080:
+  case RECORD_INTERNAL:
+    fields = record[3];
+    values = record + 4;
+    if (fields == 0 || (fields & ~(RECORD_HAS_TEMPERATURE | RECORD_HAS_HUMIDITY)) != 0) {
+      return false;
+    }
+    if (length != 4 + (fields & RECORD_HAS_TEMPERATURE ? 2 : 0) + (fields & RECORD_HAS_HUMIDITY ? 1 : 0)) {
+      return false;
+    }
+    break;
+
+  default:
+    return false;
+  }
+
+  int temperature = 0;
+  byte humidity = 0;
+  if (fields & RECORD_HAS_TEMPERATURE) {
+    temperature = (int16_t)(values[0] << 8 | values[1]);
+    values += 2;
+    if (temperature < -400 || temperature > 600) {
+      return false;
+    }
+  }
+  if (fields & RECORD_HAS_HUMIDITY) {
+    humidity = values[0];
+  }
+
+  word key = (word)record[0] << 12 | channel << 8 | record[1];
+  word now = GetNow();
+  Entry *entry = Find(key);
+  if (entry == NULL) {
+    return false;
+  }
+  if (entry->Key == key && ((word)(now - entry->WindowStart) >= m_window || entry->Fields != fields)) {
+    Send(entry);
+  }
+
+  if (entry->Key != key) {
+    entry->Key = key;
+    entry->Flags = 0;
+    entry->Fields = fields;
+    entry->Count = 0;
+    entry->WindowStart = now;
+    entry->TemperatureMin = temperature;
+    entry->TemperatureMax = temperature;
+    entry->TemperatureSum = 0;
+    entry->HumidityMin = humidity;
+    entry->HumidityMax = humidity;
+    entry->HumiditySum = 0;
+  }
+
+  entry->Flags |= record[2];
+  entry->Count++;
+  if (temperature < entry->TemperatureMin) {
+    entry->TemperatureMin = temperature;
+  }
+  if (temperature > entry->TemperatureMax) {
+    entry->TemperatureMax = temperature;
+  }
+  entry->TemperatureSum += temperature + 400;
+  if (humidity < entry->HumidityMin) {
+    entry->HumidityMin = humidity;
+  }
+  if (humidity > entry->HumidityMax) {
+    entry->HumidityMax = humidity;
+  }
+  entry->HumiditySum += humidity;
+  m_frames++;
+
+  if (entry->Count == AGGREGATOR_MAX_COUNT) {
+    Send(entry);
+  }
+  return true;
+}
+#endif
+
+// One entry per call, and only when its line fits into the SerialQueue
+void Aggregator::Handle() {
+#if AGGREGATOR_SIZE > 0
+  if (!IsEnabled()) {
+    return;
+  }
+
+  Entry *entry = &m_entries[m_nextCheck];
+  if (entry->Key != 0 && (word)(GetNow() - entry->WindowStart) >= m_window
+    && SERIAL_QUEUE_SIZE - SerialQueue::GetCount() >= FHEM_LINE_SIZE) {
+    Send(entry);
+  }
+  m_nextCheck = (m_nextCheck + 1) % AGGREGATOR_SIZE;
+#endif
+}
+
+// The entry is free afterwards
+void Aggregator::Send(Entry *entry) {
+  if (SensorBase::IsBinaryOutput()) {
+    SendRecord(entry);
+  }
+  else {
+    SendLine(entry);
+  }
+  entry->Key = 0;
+  m_sent++;
+}
+
+// Rounded, the temperature mean is + 400 as its sum
+word Aggregator::GetMean(word sum, byte count) {
+  return ((unsigned long)sum + count / 2) / count;
+}
+
+static void AddValue(LineWriter *line, byte value) {
+  line->Add(' ');
+  line->AddNumber(value);
+}
+
+static void AddTemperature(LineWriter *line, int temperature, bool hasValue) {
+  word value = hasValue ? temperature + 1000 : 0xFFFF;
+  AddValue(line, value >> 8);
+  AddValue(line, value);
+}
+
+void Aggregator::SendLine(Entry *entry) {
+  char buffer[FHEM_LINE_SIZE];
+  LineWriter line(buffer, sizeof(buffer));
+  byte tag = entry->Key >> 12;
+  bool hasTemperature = entry->Fields & RECORD_HAS_TEMPERATURE;
+  bool hasHumidity = entry->Fields & RECORD_HAS_HUMIDITY;
+  byte flags = entry->Flags;
+  byte humidityMean = GetMean(entry->HumiditySum, entry->Count);
+  bool isWS = false;
+
+  if (tag == RECORD_LACROSSE || tag == RECORD_WT440XH || tag == RECORD_TX38IT) {
+    line.Add(F("OK 9A "));
+    line.AddNumber((byte)entry->Key);
+    line.Add(' ');
+    line.AddNumber(flags & 4 ? 130 : (flags & 1 ? 129 : 1));
+    hasTemperature = true;
+    hasHumidity = true;
+    humidityMean |= flags & 2 ? 0x80 : 0;
+  }
+  else {
+    isWS = true;
+    line.Add(F("OK WSA "));
+    line.AddNumber((byte)entry->Key);
+    line.Add(' ');
+    line.AddNumber(tag == RECORD_TX22IT ? 1 : (tag == RECORD_INTERNAL ? 2 : 3));
+  }
+
+  AddTemperature(&line, (int)GetMean(entry->TemperatureSum, entry->Count) - 400, hasTemperature);
+  AddValue(&line, hasHumidity ? humidityMean : 0xFF);
+  AddTemperature(&line, entry->TemperatureMin, hasTemperature);
+  AddTemperature(&line, entry->TemperatureMax, hasTemperature);
+  AddValue(&line, hasHumidity ? entry->HumidityMin : 0xFF);
+  AddValue(&line, hasHumidity ? entry->HumidityMax : 0xFF);
+  if (isWS) {
+    AddValue(&line, flags);
+  }
+  AddValue(&line, entry->Count);
+
+  SerialQueue::AddLine(line.GetText());
+}
+
+void Aggregator::SendRecord(Entry *entry) {
+  byte buffer[RECORD_SIZE];
+  RecordWriter record(buffer, sizeof(buffer));
+  record.Add(RECORD_AGGREGATE);
+  record.Add(entry->Key >> 12);
+  record.Add(entry->Key);
+  record.Add(entry->Flags);
+  record.Add(entry->Fields);
+  record.Add(entry->Count);
+  if (entry->Fields & RECORD_HAS_TEMPERATURE) {
+    record.AddWord((int)GetMean(entry->TemperatureSum, entry->Count) - 400);
+    record.AddWord(entry->TemperatureMin);
+    record.AddWord(entry->TemperatureMax);
+  }
+  if (entry->Fields & RECORD_HAS_HUMIDITY) {
+    record.Add(GetMean(entry->HumiditySum, entry->Count));
+    record.Add(entry->HumidityMin);
+    record.Add(entry->HumidityMax);
+  }
+  record.Send();
+}
+
+unsigned long Aggregator::GetFrames() {
+  return m_frames;
+}
+
+unsigned long Aggregator::GetSent() {
+  return m_sent;
+}
+
+void Aggregator::ResetStatistics() {
+  m_frames = 0;
+  m_sent = 0;
+}
+
+void Aggregator::ShowStatistics() {
+  byte count = 0;
+#if AGGREGATOR_SIZE > 0
+  for (byte i = 0; i < AGGREGATOR_SIZE; i++) {
+    if (m_entries[i].Key != 0) {
+      count++;
+    }
+  }
+#endif
+  Serial.print(F("[Aggregation sensors:"));
+  Serial.print(count);
+  Serial.print('/');
+  Serial.print(AGGREGATOR_SIZE);
+  Serial.print(F(" frames:"));
+  Serial.print(m_frames);
+  Serial.print(F(" sent:"));
+  Serial.print(m_sent);
+  Serial.println(']');
+}
@@ -0,0 +1,91 @@
+#ifndef _AGGREGATOR_h
+#define _AGGREGATOR_h
+
+#include "Arduino.h"
+
+// Sensors that are aggregated at the same time, 17 bytes each. Opt-in as
+// the SensorTable: 0 leaves the aggregation out of the build (w answers
+// failed), define it (16 takes 272 bytes) here or with -DAGGREGATOR_SIZE=16
+// to have it
+#ifndef AGGREGATOR_SIZE
+#define AGGREGATOR_SIZE 0
+#endif
+
+#define AGGREGATOR_MAX_WINDOW 3600
+// The sum of the temperatures has to fit a word, a sensor that sends more
+// often than this in a window gets more than one line
+#define AGGREGATOR_MAX_COUNT 64
+
+// Aggregation (<n>w): instead of every frame one line per sensor and window
+// of n seconds with min, max and mean of temperature and humidity and the
+// number of frames. The flags are those of all frames together, so a weak
+// battery is not lost.
+// Only sensors with nothing but temperature and humidity are aggregated
+// (OK 9 and OK WS without rain, wind or pressure), all others are passed on
+// as before. So are the frames of further sensors when the table is full.
+//
+// OK 9A ID XXX TTT TTT HHH TTT TTT TTT TTT HHH HHH CCC
+//       |  |   |       |   |       |       |   |   |-- Frames in the window
+//       |  |   |       |   |       |       |   |------ Humidity max
+//       |  |   |       |   |       |       |---------- Humidity min
+//       |  |   |       |   |       |------------------ Temp max * 10 + 1000 MSB LSB
+//       |  |   |       |   |-------------------------- Temp min * 10 + 1000 MSB LSB
+//       |  |   |       |------------------------------ Humidity mean incl. WeakBatteryFlag
+//       |  |   |-------------------------------------- Temp mean * 10 + 1000 MSB LSB
+//       |  |------------------------------------------ Sensor type as in OK 9
+//       |--------------------------------------------- Sensor ID
+// OK WSA is the same with the sensor type of OK WS, missing values are 255,
+// and the flags of OK WS before the number of frames.
+//
+// The values come from the binary record of the frame, see RecordWriter.h.
+class Aggregator {
+public:
+  // Window in seconds, 0 switches the aggregation off. What has been
+  // collected so far is sent first. False with AGGREGATOR_SIZE 0 for
+  // anything but 0, it stays off then
+  static bool Configure(word window);
+  static bool IsEnabled();
+  // True when the record has been taken
+  static bool TryAdd(const byte *record, byte length);
+  // Called from loop(), sends the windows of sensors that went quiet
+  static void Handle();
+
+  static unsigned long GetFrames();
+  static unsigned long GetSent();
+  static void ResetStatistics();
+  static void ShowStatistics();
+
+private:
+  struct Entry {
+    word Key;                 // tag << 12 | channel << 8 | ID, 0 if the entry is free
+    byte Flags;
+    byte Fields;
+    byte Count;
+    word WindowStart;         // seconds
+    int16_t TemperatureMin;   // 1/10 C
+    int16_t TemperatureMax;
+    word TemperatureSum;      // of the temperatures + 400
+    byte HumidityMin;
+    byte HumidityMax;
+    word HumiditySum;
+  };
+
+#if AGGREGATOR_SIZE > 0
+  static Entry m_entries[AGGREGATOR_SIZE];
+#endif
+  static word m_window;
+  static byte m_nextCheck;
+  static unsigned long m_frames;
+  static unsigned long m_sent;
+
+  static word GetNow();
+#if AGGREGATOR_SIZE > 0
+  static Entry *Find(word key);
+#endif
+  static void Send(Entry *entry);
+  static void SendLine(Entry *entry);
+  static void SendRecord(Entry *entry);
+  static word GetMean(word sum, byte count);
+};
+
+#endif
@@ -1,6 +1,22 @@
 #include "BMP180.h"
 
+// Fixed point numbers with 30 fractional bits
+#define Q30_ONE (1L << 30)
+
+static int32_t MultiplyQ30(int32_t a, int32_t b) {
+  return ((int64_t)a * b) >> 30;
+}
+
+static uint32_t MultiplyQ30(uint32_t a, uint32_t b) {
+  return ((uint64_t)a * b) >> 30;
+}
+
 BMP180::BMP180() {
+  SetAltitudeAboveSeaLevel(0);
+  m_oversampling = BMP180_DEFAULT_OVERSAMPLING;
+  m_state = Idle;
+  m_conversionStart = 0;
+  m_rawTemperature = 0;
 }
 
 
@@ -28,8 +44,45 @@ boolean BMP180::TryInitialize() {
   return result;
 }
 
+// p0 = p / (1 - h / 44330)^5.255 = p * u^5.255 with u = 44330 / (44330 - h).
+// The factor is only calculated here, in fixed point without pow():
+// u^5 by multiplication and u^0.255 by its series around 1 (|u - 1| < 0.26).
+// Between -500 and 4000 m the result is within 4 Pa of the float formula.
 void BMP180::SetAltitudeAboveSeaLevel(int32_t altitude) {
-  m_altitudeAboveSeaLevel = altitude;
+  // 0.255, 0.255 * (0.255 - 1) / 2, ... in Q30
+  static const int32_t series[] PROGMEM = { 273804165L, -101992052L, 59325377L, -40712040L };
+
+  if (altitude < BMP180_MIN_ALTITUDE) {
+    altitude = BMP180_MIN_ALTITUDE;
+  }
+  else if (altitude > BMP180_MAX_ALTITUDE) {
+    altitude = BMP180_MAX_ALTITUDE;
+  }
+
+  // u in Q30, divided in two steps of 15 bits to stay in 32 bits
+  uint32_t divisor = 44330L - altitude;
+  uint32_t dividend = 44330UL << 15;
+  uint32_t u = (dividend / divisor) << 15;
+  u |= ((dividend % divisor) << 15) / divisor;
+
+  uint32_t u2 = MultiplyQ30(u, u);
+  uint32_t u5 = MultiplyQ30(MultiplyQ30(u2, u2), u);
+
+  int32_t d = u - Q30_ONE;
+  int32_t s = (int32_t)pgm_read_dword(&series[3]);
+  for (int8_t i = 2; i >= 0; i--) {
+    s = (int32_t)pgm_read_dword(&series[i]) + MultiplyQ30(d, s);
+  }
+  s = Q30_ONE + MultiplyQ30(d, s);
+
+  // Q16, below 2^18 for the highest altitude
+  m_seaLevelFactor = MultiplyQ30(u5, (uint32_t)s) >> 14;
+}
+
+// Split in two products, so that neither overflows 32 bits
+int32_t BMP180::GetSeaLevelPressure(int32_t pressure) {
+  uint32_t p = pressure;
+  return (((p >> 8) * m_seaLevelFactor) >> 8) + (((p & 0xFF) * m_seaLevelFactor) >> 16);
 }
 
 int32_t BMP180::CalculateB5(int32_t ut) {
@@ -38,49 +91,78 @@ int32_t BMP180::CalculateB5(int32_t ut) {
   return x1 + x2;
 }
 
-uint16_t BMP180::GetRawTemperature(void) {
-  Write8(0xF4, 0x2E);
-  delay(5);
-  uint16_t rt = Read16(0xF6);
-  m_lastValue.ADCT = rt;
-  return rt;
+void BMP180::SetOversampling(uint8_t oversampling) {
+  if (oversampling <= 3) {
+    m_oversampling = oversampling;
+  }
 }
 
-uint32_t BMP180::GetRawPressure(void) {
-  uint32_t raw;
+bool BMP180::IsIdle() {
+  return m_state == Idle;
+}
 
-  Write8(0xF4, 0x34 + (2 << 6));
-  delay(14);
+void BMP180::StartConversion(uint8_t command) {
+  Write8(0xF4, command);
+  m_conversionStart = micros();
+}
 
-  raw = Read16(0xF6);
+void BMP180::StartMeasurement() {
+  StartConversion(0x2E);
+  m_state = MeasuringTemperature;
+}
 
-  raw <<= 8;
-  raw |= Read8(0xF6 + 2);
-  raw >>= 6;
-  m_lastValue.ADCP = raw;
+bool BMP180::Handle() {
+  // Maximum conversion times for oss 0 ... 3
+  static const uint16_t pressureMicros[] PROGMEM = { 4500, 7500, 13500, 25500 };
+  bool result = false;
+
+  if (m_state == MeasuringTemperature) {
+    if (micros() - m_conversionStart >= BMP180_TEMPERATURE_MICROS) {
+      m_rawTemperature = Read16(0xF6);
+      StartConversion(0x34 + (m_oversampling << 6));
+      m_state = MeasuringPressure;
+    }
+  }
+  else if (m_state == MeasuringPressure) {
+    if (micros() - m_conversionStart >= pgm_read_word(&pressureMicros[m_oversampling])) {
+      uint32_t raw = Read16(0xF6);
+      raw <<= 8;
+      raw |= Read8(0xF6 + 2);
+      raw >>= 8 - m_oversampling;
+
+      Calculate(m_rawTemperature, raw);
+      m_state = Idle;
+      result = true;
+    }
+  }
 
-  return raw;
+  return result;
 }
 
-
-int32_t BMP180::GetPressure(void) {
-  int32_t UT, UP, B3, B5, B6, X1, X2, X3, p;
+// Both values come from the same raw temperature (B5)
+void BMP180::Calculate(int32_t UT, int32_t UP) {
+  int32_t B3, B5, B6, X1, X2, X3, p;
   uint32_t B4, B7;
+  float temp;
+
+  m_lastValue.ADCT = UT;
+  m_lastValue.ADCP = UP;
 
-  UT = GetRawTemperature();
-  UP = GetRawPressure();
   B5 = CalculateB5(UT);
+  temp = (B5 + 8) >> 4;
+  temp /= 10.0;
+  m_lastValue.Temperature = temp;
 
   B6 = B5 - 4000;
   X1 = ((int32_t)m_compensation.CB2 * ((B6 * B6) >> 12)) >> 11;
   X2 = ((int32_t)m_compensation.CAC2 * B6) >> 11;
   X3 = X1 + X2;
-  B3 = ((((int32_t)m_compensation.CAC1 * 4 + X3) << 2) + 2) / 4;
+  B3 = ((((int32_t)m_compensation.CAC1 * 4 + X3) << m_oversampling) + 2) / 4;
   X1 = ((int32_t)m_compensation.CAC3 * B6) >> 13;
   X2 = ((int32_t)m_compensation.CB1 * ((B6 * B6) >> 12)) >> 16;
   X3 = ((X1 + X2) + 2) >> 2;
   B4 = ((uint32_t)m_compensation.CAC4 * (uint32_t)(X3 + 32768)) >> 15;
-  B7 = ((uint32_t)UP - B3) * (uint32_t)(50000UL >> 2);
+  B7 = ((uint32_t)UP - B3) * (uint32_t)(50000UL >> m_oversampling);
 
   if (B7 < 0x80000000) {
     p = (B7 * 2) / B4;
@@ -96,25 +178,10 @@ int32_t BMP180::GetPressure(void) {
 
   m_lastValue.Pressure = p / 100;
 
-  p /= pow(((float) 1.0 - ((float)m_altitudeAboveSeaLevel / 44330.0)), (float) 5.255);
+  p = GetSeaLevelPressure(p);
   p /= 100;
 
-  return p;
-}
-
-
-float BMP180::GetTemperature(void) {
-  int32_t UT, B5;
-  float temp;
-
-  UT = GetRawTemperature();
-
-  B5 = CalculateB5(UT);
-  temp = (B5 + 8) >> 4;
-  temp /= 10.0;
-  m_lastValue.Temperature = temp;
-
-  return temp;
+  m_lastValue.SeaLevelPressure = p;
 }
 
 bmp180_compensation BMP180::GetCompensationValues() {
@@ -6,6 +6,16 @@
 
 #define BMP180_ADDRESS 0x77
 
+// Pressure oversampling (oss) 0 ... 3: 1, 2, 4 or 8 samples
+#define BMP180_DEFAULT_OVERSAMPLING 2
+
+// Maximum conversion times from the data sheet
+#define BMP180_TEMPERATURE_MICROS 4500
+
+// Altitudes the sea level correction is made for (300 hPa is about 9000 m)
+#define BMP180_MIN_ALTITUDE -1000
+#define BMP180_MAX_ALTITUDE 9000
+
 typedef struct {
   int16_t CAC1;
   int16_t  CAC2;
@@ -26,23 +36,43 @@ typedef struct {
   int32_t ADCP;
 
   float Temperature;
-  int32_t Pressure;
+  int32_t Pressure;            // hPa at the sensor
+  int32_t SeaLevelPressure;    // hPa reduced to sea level
 } BMP180Value;
 
+// A measurement never blocks: StartMeasurement() starts the temperature
+// conversion, Handle() has to be called from loop(). When the conversion
+// time is over it reads the result and starts the next conversion. It
+// returns true once both values of one temperature conversion are in
+// GetLastMeasuredValue().
 class BMP180 {
 public:
   BMP180();
   boolean TryInitialize();
   void SetAltitudeAboveSeaLevel(int32_t altitude);
-  float GetTemperature(void);
-  int32_t GetPressure(void);
+  void SetOversampling(uint8_t oversampling);
+  // Pa at the sensor to Pa at sea level
+  int32_t GetSeaLevelPressure(int32_t pressure);
+  void StartMeasurement();
+  bool Handle();
+  bool IsIdle();
   bmp180_compensation GetCompensationValues();
   BMP180Value GetLastMeasuredValue();
 
 private:
-  int32_t m_altitudeAboveSeaLevel = 0;
-  uint16_t GetRawTemperature(void);
-  uint32_t GetRawPressure(void);
+  enum State {
+    Idle,
+    MeasuringTemperature,
+    MeasuringPressure
+  };
+
+  uint32_t m_seaLevelFactor;
+  uint8_t m_oversampling;
+  State m_state;
+  unsigned long m_conversionStart;
+  uint16_t m_rawTemperature;
+  void StartConversion(uint8_t command);
+  void Calculate(int32_t ut, int32_t up);
   int32_t CalculateB5(int32_t ut);
   uint8_t Read8(uint8_t addr);
   uint16_t Read16(uint8_t addr);
@@ -0,0 +1,35 @@
+#ifndef _CRC8_h
+#define _CRC8_h
+
+#include "Arduino.h"
+
+// CRC8 with polynomial 0x31 (x^8 + x^5 + x^4 + 1), MSB first, init 0
+// as used by the LaCrosse IT+ family, WS1080, LevelSender and CustomSensor.
+//
+// Implementation used by Calculate() / CalculateBits():
+//   CRC8_BITWISE       no table, 8 shifts per byte
+//   CRC8_NIBBLE_TABLE  2 x 16 bytes PROGMEM, for flash constrained builds
+//   CRC8_BYTE_TABLE    256 bytes PROGMEM, fastest
+#define CRC8_BITWISE      0
+#define CRC8_NIBBLE_TABLE 1
+#define CRC8_BYTE_TABLE   2
+
+#ifndef CRC8_IMPLEMENTATION
+#define CRC8_IMPLEMENTATION CRC8_BYTE_TABLE
+#endif
+
+class CRC8 {
+public:
+  static byte Calculate(const byte *data, byte len);
+  static byte CalculateBits(const byte *data, byte bits);
+
+  static byte CalculateBitwise(const byte *data, byte len);
+  static byte CalculateNibbleTable(const byte *data, byte len);
+  static byte CalculateByteTable(const byte *data, byte len);
+
+private:
+  static byte Update(byte crc, byte value);
+  static byte UpdateBits(byte crc, byte value, byte bits);
+};
+
+#endif
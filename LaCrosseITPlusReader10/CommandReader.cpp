@@ -0,0 +1,113 @@
+#include "CommandReader.h"
+#include "SerialQueue.h"
+#include "SensorBase.h"
+
+byte CommandReader::m_arguments[COMMAND_MAX_ARGUMENTS + 1];
+byte CommandReader::m_count = 0;
+unsigned long CommandReader::m_value = 0;
+bool CommandReader::m_isStarted = false;
+bool CommandReader::m_isTooLong = false;
+unsigned long CommandReader::m_startTime = 0;
+
+unsigned long CommandReader::m_commands = 0;
+unsigned long CommandReader::m_rejected = 0;
+unsigned long CommandReader::m_maxLatency = 0;
+unsigned long CommandReader::m_latencySum = 0;
+
+void CommandReader::Handle(CommandHandler handler) {
+  for (byte i = 0; i < COMMAND_READ_LIMIT && Serial.available(); i++) {
+    char c = Serial.read();
+
+    // Line ends and blanks between the commands
+    if (c <= ' ') {
+      continue;
+    }
+    if (!m_isStarted) {
+      m_isStarted = true;
+      m_startTime = micros();
+    }
+
+    if (c == ',') {
+      if (m_count < COMMAND_MAX_ARGUMENTS) {
+        m_arguments[m_count++] = m_value;
+      }
+      else {
+        m_isTooLong = true;
+      }
+      m_value = 0;
+    }
+    else if ('0' <= c && c <= '9') {
+      m_value = 10 * m_value + c - '0';
+    }
+    else if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c < 'A') {
+      // A letter, or something else that shows the help
+      Execute(c, handler);
+    }
+  }
+}
+
+void CommandReader::Execute(char name, CommandHandler handler) {
+  unsigned long latency = micros() - m_startTime;
+  if (m_isTooLong) {
+    m_rejected++;
+    SerialQueue::Flush();
+    Serial.print(F("[Command:"));
+    Serial.print(name);
+    Serial.println(F(" too long]"));
+    if (SensorBase::IsBinaryOutput()) {
+      Serial.write((byte)0);
+    }
+  }
+  else {
+    m_commands++;
+    m_latencySum += latency;
+    if (latency > m_maxLatency) {
+      m_maxLatency = latency;
+    }
+    handler(name, m_value, m_arguments, m_count);
+  }
+  Reset();
+}
+
+void CommandReader::Reset() {
+  m_count = 0;
+  m_value = 0;
+  m_isStarted = false;
+  m_isTooLong = false;
+}
+
+unsigned long CommandReader::GetCommands() {
+  return m_commands;
+}
+
+unsigned long CommandReader::GetRejected() {
+  return m_rejected;
+}
+
+unsigned long CommandReader::GetMaxLatency() {
+  return m_maxLatency;
+}
+
+unsigned long CommandReader::GetMeanLatency() {
+  return m_commands > 0 ? m_latencySum / m_commands : 0;
+}
+
+void CommandReader::ResetStatistics() {
+  m_commands = 0;
+  m_rejected = 0;
+  m_maxLatency = 0;
+  m_latencySum = 0;
+}
+
+// [Commands:12 latency mean:520 max:1610 us rejected:0]
+void CommandReader::ShowStatistics() {
+  Serial.print(F("[Commands:"));
+  Serial.print(m_commands);
+  Serial.print(F(" latency mean:"));
+  Serial.print(GetMeanLatency());
+  Serial.print(F(" max:"));
+  Serial.print(m_maxLatency);
+  Serial.print(F(" us rejected:"));
+  Serial.print(m_rejected);
+  Serial.println(']');
+}
@@ -0,0 +1,58 @@
+#ifndef _COMMANDREADER_h
+#define _COMMANDREADER_h
+
+#include "Arduino.h"
+
+// Comma separated values in front of the last value of a command (the data
+// bytes of <id,b,b,...>s), each one byte
+#ifndef COMMAND_MAX_ARGUMENTS
+#define COMMAND_MAX_ARGUMENTS 32
+#endif
+
+// Bytes taken from the UART per loop(), the RX buffer of the core
+#ifndef COMMAND_READ_LIMIT
+#define COMMAND_READ_LIMIT 64
+#endif
+
+// Called with the letter, the last value and the values before it.
+// arguments has one byte more than count, so the handler can append the
+// value (s and o take it as the last data byte).
+typedef void (*CommandHandler)(char name, unsigned long value, byte *arguments, byte count);
+
+// Commands from the host ("30t", "1,4o", "17,1,2,3s").
+// Handle() takes everything the UART has at once, up to COMMAND_READ_LIMIT
+// bytes, and calls the handler for every command that is complete, so a
+// long command no longer needs one loop() for each of its characters.
+// The values before the last one go into a bounded argument vector; a
+// command with more than COMMAND_MAX_ARGUMENTS of them is rejected as a
+// whole instead of running over the vector.
+// The latency is taken from the first byte of a command to its execution.
+class CommandReader {
+public:
+  static void Handle(CommandHandler handler);
+
+  static unsigned long GetCommands();
+  static unsigned long GetRejected();
+  static unsigned long GetMaxLatency();
+  static unsigned long GetMeanLatency();
+  static void ResetStatistics();
+  static void ShowStatistics();
+
+private:
+  static byte m_arguments[COMMAND_MAX_ARGUMENTS + 1];
+  static byte m_count;
+  static unsigned long m_value;
+  static bool m_isStarted;
+  static bool m_isTooLong;
+  static unsigned long m_startTime;
+
+  static unsigned long m_commands;
+  static unsigned long m_rejected;
+  static unsigned long m_maxLatency;
+  static unsigned long m_latencySum;
+
+  static void Execute(char name, CommandHandler handler);
+  static void Reset();
+};
+
+#endif
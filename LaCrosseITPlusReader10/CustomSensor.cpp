@@ -1,4 +1,5 @@
 #include "CustomSensor.h"
+#include "TransmitQueue.h"
 
 // Message-Format
 // --------------
@@ -31,11 +32,7 @@ void CustomSensor::DecodeFrame(byte *bytes, struct CustomSensor::Frame *frame) {
   if (frame->IsValid) {
     frame->ID = bytes[1];
     frame->NbrOfDataBytes = bytes[2];
-
-    for (int i = 3; i < len -1; i++) {
-      frame->Data[i-3] = bytes[i];
-    }
-    
+    frame->Data = &bytes[3];
   }
 }
 
@@ -45,8 +42,7 @@ byte CustomSensor::GetFrameLength(byte data[]) {
 }
 
 // ----------------------------------------------------------------
-String CustomSensor::BuildFhemDataString(struct CustomSensor::Frame *frame) {
-  String pBuf = "";
+bool CustomSensor::BuildFhemDataString(struct CustomSensor::Frame *frame, LineWriter *line) {
   
   /* Format
   OK  CC  11  1   2   3   4   5   ...
@@ -62,29 +58,28 @@ String CustomSensor::BuildFhemDataString(struct CustomSensor::Frame *frame) {
   |-------------------------------------------------------------- fix "OK"
   */
   
-  pBuf += "OK CC ";
-  pBuf += frame->ID;
-  pBuf += " ";
+  line->Add(F("OK CC "));
+  line->AddNumber(frame->ID);
+  line->Add(' ');
 
   for (int i = 0; i < frame->NbrOfDataBytes; i++) {
-    pBuf += frame->Data[i];
-    pBuf += " ";
+    line->AddNumber(frame->Data[i]);
+    line->Add(' ');
   }
   
-  return pBuf;
+  return true;
 }
 
 // ----------------------------------------------------------------
-void CustomSensor::SendFrame(struct CustomSensor::Frame *frame, RFM *rfm, unsigned long dataRate) {
+// Queued, the TransmitQueue switches the rate and the receiver of the radio
+bool CustomSensor::SendFrame(struct CustomSensor::Frame *frame, RFM *rfm, unsigned long dataRate) {
+  if (frame->NbrOfDataBytes > CS_MAX_SEND_BYTES) {
+    return false;
+  }
   byte payload[CS_PL_BUFFER_SIZE];
   EncodeFrame(frame, payload);
 
-  rfm->EnableReceiver(false);
-  unsigned long currentDataRate = rfm->GetDataRate();
-  rfm->SetDataRate(dataRate);
-  rfm->SendArray(payload, CustomSensor::GetFrameLength(payload));
-  rfm->SetDataRate(currentDataRate);
-  rfm->EnableReceiver(true);
+  return TransmitQueue::Add(rfm, payload, CustomSensor::GetFrameLength(payload), dataRate);
 }
 
 // ----------------------------------------------------------------
@@ -95,38 +90,38 @@ String CustomSensor::AnalyzeFrame(byte *data) {
   byte frameLength = CustomSensor::GetFrameLength(data);
 
   // Show the raw data bytes
-  result += "CustomSensor [";
+  result += F("CustomSensor [");
   for (int i = 0; i < frameLength; i++) {
     result += String(data[i], HEX);
-    result += " ";
+    result += F(" ");
   }
-  result += "] ";
+  result += F("] ");
 
   // CRC
   if (!frame.IsValid) {
-    result += " CRC:WRONG";
+    result += F(" CRC:WRONG");
   }
   else {
-    result += " CRC:OK";
+    result += F(" CRC:OK");
 
     // Sensor ID
-    result += " ID:0x";
+    result += F(" ID:0x");
     result += String(frame.ID, HEX);
 
     // Size
-    result += " NbrOfDataBytes:";
+    result += F(" NbrOfDataBytes:");
     result += String(frame.NbrOfDataBytes, DEC);
     
     // Data
-    result += " Data:";
+    result += F(" Data:");
     for (int i = 0; i < frame.NbrOfDataBytes; i++) {
-      result += "0x";
+      result += F("0x");
       result += String(frame.Data[i], HEX);
-      result += " ";
+      result += F(" ");
     }
 
     // CRC
-    result += " CRC:0x";
+    result += F(" CRC:0x");
     result += String(frame.CRC, HEX);
   }
 
@@ -134,29 +129,61 @@ String CustomSensor::AnalyzeFrame(byte *data) {
 }
 
 // ----------------------------------------------------------------
-String CustomSensor::GetFhemDataString(byte *data) {
-  String fhemString = "";
+// See RecordWriter.h for the layout
+bool CustomSensor::BuildBinaryRecord(struct CustomSensor::Frame *frame, RecordWriter *record) {
+  record->Add(RECORD_CUSTOMSENSOR);
+  record->Add(frame->ID);
+  record->Add(0);
+
+  for (int i = 0; i < frame->NbrOfDataBytes; i++) {
+    record->Add(frame->Data[i]);
+  }
+
+  return true;
+}
+
+// ----------------------------------------------------------------
+bool CustomSensor::GetFhemDataString(byte *data, LineWriter *line) {
+  bool result = false;
 
   if (data[0] == CUSTOM_SENSOR_HEADER) {
     struct Frame frame;
     DecodeFrame(data, &frame);
     if (frame.IsValid) {
-      fhemString = BuildFhemDataString(&frame);
+      result = BuildFhemDataString(&frame, line);
     }
   }
 
-  return fhemString;
+  return result;
 }
 
 // ----------------------------------------------------------------
+bool CustomSensor::BuildRecord(const void *frame, RecordWriter *record) {
+  return BuildBinaryRecord((struct Frame *)frame, record);
+}
+
+bool CustomSensor::BuildLine(const void *frame, LineWriter *line) {
+  return BuildFhemDataString((struct Frame *)frame, line);
+}
+
 bool CustomSensor::TryHandleData(byte *data) {
-  String fhemString = GetFhemDataString(data);
+  bool result = false;
 
-  if (fhemString.length() > 0) {
-    Serial.println(fhemString);
+  if (data[0] == CUSTOM_SENSOR_HEADER) {
+    struct Frame frame;
+    DecodeFrame(data, &frame);
+    if (frame.IsValid) {
+      // The text line needs no buffer, so the deepest output path stays flat
+      result = IsRecordNeeded() ? HandleRecord(&frame) : HandleFrame(&frame, BuildRecord, BuildLine, NULL, 0);
+    }
   }
- 
-  return fhemString.length() > 0;
+
+  return result;
+}
+
+bool CustomSensor::HandleRecord(struct Frame *frame) {
+  byte buffer[CS_RECORD_SIZE];
+  return HandleFrame(frame, BuildRecord, BuildLine, buffer, sizeof(buffer));
 }
 
 // ----------------------------------------------------------------
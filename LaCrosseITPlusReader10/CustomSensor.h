@@ -3,10 +3,18 @@
 
 #include "Arduino.h"
 #include "SensorBase.h"
+#include "LineWriter.h"
+#include "RecordWriter.h"
 #include "RFM.h"
+#include "TransmitQueue.h"
 
 #define CUSTOM_SENSOR_HEADER 0xCC
-#define CS_PL_BUFFER_SIZE 128
+// Received are as many data bytes as a payload holds, sent only as many as
+// a TransmitQueue frame takes (the s command)
+#define CS_MAX_DATA_BYTES (PAYLOADSIZE - 4)
+#define CS_MAX_SEND_BYTES (TRANSMIT_FRAME_SIZE - 4)
+#define CS_PL_BUFFER_SIZE (4 + CS_MAX_DATA_BYTES)
+#define CS_RECORD_SIZE (3 + CS_MAX_DATA_BYTES + 1)      // tag, ID, flags, data bytes, CRC
 
 class CustomSensor : public SensorBase {
 public:
@@ -14,7 +22,7 @@ public:
     byte  ID;
     byte  CRC;
     bool  IsValid;
-    byte  Data[128];
+    const byte *Data;             // into the payload or the command, not copied
     byte  NbrOfDataBytes;
   };
 
@@ -23,14 +31,19 @@ public:
   static void DecodeFrame(byte *bytes, struct CustomSensor::Frame *frame);
   static String AnalyzeFrame(byte *data);
   static bool TryHandleData(byte *data);
-  static String GetFhemDataString(byte *data);
+  static bool GetFhemDataString(byte *data, LineWriter *line);
   static bool IsValidDataRate(unsigned long dataRate);
-  static void SendFrame(struct CustomSensor::Frame *frame, RFM *rfm, unsigned long dataRate);
+  static bool SendFrame(struct CustomSensor::Frame *frame, RFM *rfm, unsigned long dataRate);
 
 
 protected:
   unsigned long m_dataRate;
-  static String BuildFhemDataString(struct CustomSensor::Frame *frame);
+  static bool BuildFhemDataString(struct CustomSensor::Frame *frame, LineWriter *line);
+  static bool BuildBinaryRecord(struct CustomSensor::Frame *frame, RecordWriter *record);
+  static bool BuildRecord(const void *frame, RecordWriter *record);
+  static bool BuildLine(const void *frame, LineWriter *line);
+  // Not inlined, so its buffer of up to 64 bytes is only on the stack with a record
+  static bool HandleRecord(struct CustomSensor::Frame *frame) __attribute__((noinline));
 
 };
 
@@ -28,19 +28,19 @@ void EMT7110::DecodeFrame(byte *data, struct Frame *frame) {
   frame->Byte9_7 = (data[9] & 0b10000000) > 0;
 
   if (frame->PairingFlag) {
-    frame->Voltage = 0.0;
-    frame->Current = 0.0;
-    frame->Power = 0.0;
-    frame->AccumulatedPower = 0.0;
+    frame->Voltage = 0;
+    frame->Current = 0;
+    frame->Power = 0;
+    frame->AccumulatedPower = 0;
     frame->ConsumersConnected = false;
     frame->CRC = 0;
     frame->IsValid = false;
   }
   else {
-    frame->Voltage = 128.0 + data[8] * 0.5;
+    frame->Voltage = 1280 + data[8] * 5;
     frame->Current = (data[6] << 8) | data[7];
     frame->Power = ((data[4] & 0x3F) << 8 | data[5]) / 2;
-    frame->AccumulatedPower = ((data[9] & 0x3F) << 8 | data[10]) / 100.0;
+    frame->AccumulatedPower = (data[9] & 0x3F) << 8 | data[10];
     frame->ConsumersConnected = (data[4] & 0b01000000) > 0;
     frame->CRC = data[11];
     frame->IsValid = CrcIsValid(data);
@@ -66,56 +66,56 @@ String EMT7110::AnalyzeFrame(byte *data) {
   DecodeFrame(data, &frame);
 
   // Show the raw data bytes
-  result += "EMT7110 [";
+  result += F("EMT7110 [");
   for (int i = 0; i < FRAME_LENGTH; i++) {
     result += String(data[i], HEX);
-    result += " ";
+    result += F(" ");
   }
-  result += "]";
+  result += F("]");
 
   // Check CRC
   if (!frame.IsValid) {
-    result += " CRC:WRONG";
+    result += F(" CRC:WRONG");
   }
   else {
-    result += " CRC:OK";
+    result += F(" CRC:OK");
   }
   // Start
-  result += " S:";
+  result += F(" S:");
   result += String(frame.Header1, HEX);
-  result += " ";
+  result += F(" ");
   result += String(frame.Header2, HEX);
 
   // ID
-  result += " ID:";
+  result += F(" ID:");
   result += String(frame.ID, HEX);
 
   // Voltag
-  result += " V:";
-  result += frame.Voltage;
+  result += F(" V:");
+  result += frame.Voltage / 10.0;
 
   // Current
-  result += " mA:";
+  result += F(" mA:");
   result += frame.Current;
 
   // Power
-  result += " W:";
+  result += F(" W:");
   result += frame.Power;
 
   // AccumulatedPower
-  result += " kWh:";
-  result += frame.AccumulatedPower;
+  result += F(" kWh:");
+  result += frame.AccumulatedPower / 100.0;
 
   // Connected
-  result += " Con.:";
+  result += F(" Con.:");
   result += frame.ConsumersConnected;
 
   // Pairing
-  result += " Pair:";
+  result += F(" Pair:");
   result += frame.PairingFlag;
 
   // CRC
-  result += " CRC:";
+  result += F(" CRC:");
   result += frame.CRC;
  
   return result;
@@ -132,7 +132,7 @@ bool EMT7110::CrcIsValid(byte data[]) {
 }
 
 
-String EMT7110::BuildFhemDataString(struct Frame *frame) {
+bool EMT7110::BuildFhemDataString(struct Frame *frame, LineWriter *line) {
   // Format
   // 
   // OK  EMT7110  84 81  8  237 0  13  0  2   1  6  1  -> ID 5451   228,5V   13mA   2W   2,62kWh
@@ -152,72 +152,98 @@ String EMT7110::BuildFhemDataString(struct Frame *frame) {
   //      `--- fix "EMT7110"
 
   // Header and ID
-  String result;
-  result += "OK EMT7110 ";
-  result += (byte)(frame->ID >> 8);
-  result += " ";
-  result += (byte)(frame->ID);
-  result += " ";
+  line->Add(F("OK EMT7110 "));
+  line->AddNumber((byte)(frame->ID >> 8));
+  line->Add(' ');
+  line->AddNumber((byte)(frame->ID));
+  line->Add(' ');
 
   // Voltage (V * 10)
-  int volt = (int)(frame->Voltage * 10);
-  result += (byte)(volt >> 8);
-  result += " ";
-  result += (byte)(volt);
-  result += " ";
+  line->AddNumber((byte)(frame->Voltage >> 8));
+  line->Add(' ');
+  line->AddNumber((byte)(frame->Voltage));
+  line->Add(' ');
 
   // Current (mA)
-  result += (byte)((int)frame->Current >> 8);
-  result += " ";
-  result += (byte)(frame->Current);
-  result += " ";
+  line->AddNumber((byte)(frame->Current >> 8));
+  line->Add(' ');
+  line->AddNumber((byte)(frame->Current));
+  line->Add(' ');
 
   // Power (W)
-  result += (byte)((int)frame->Power >> 8);
-  result += " ";
-  result += (byte)(frame->Power);
-  result += " ";
+  line->AddNumber((byte)(frame->Power >> 8));
+  line->Add(' ');
+  line->AddNumber((byte)(frame->Power));
+  line->Add(' ');
 
   // AccumulatedPower (kWh * 100)
-  int acp = (int)(frame->AccumulatedPower * 100);
-  result += (byte)(acp >> 8);
-  result += " ";
-  result += (byte)(acp);
-  result += " ";
+  line->AddNumber((byte)(frame->AccumulatedPower >> 8));
+  line->Add(' ');
+  line->AddNumber((byte)(frame->AccumulatedPower));
+  line->Add(' ');
 
   // Flags
   byte flags = 0;
   flags += frame->ConsumersConnected * 1;
   flags += frame->PairingFlag * 2;
-  result += flags;
+  line->AddNumber(flags);
   
-  return result;
+  return true;
 }
 
 
-String EMT7110::GetFhemDataString(byte *data) {
-  String fhemString = "";
+// See RecordWriter.h for the layout
+bool EMT7110::BuildBinaryRecord(struct Frame *frame, RecordWriter *record) {
+  byte flags = 0;
+  flags += frame->ConsumersConnected * 1;
+  flags += frame->PairingFlag * 2;
+
+  record->Add(RECORD_EMT7110);
+  record->AddWord(frame->ID);
+  record->Add(flags);
+  record->AddWord(frame->Voltage);
+  record->AddWord(frame->Current);
+  record->AddWord(frame->Power);
+  record->AddWord(frame->AccumulatedPower);
+
+  return true;
+}
+
+bool EMT7110::GetFhemDataString(byte *data, LineWriter *line) {
+  bool result = false;
 
   if (data[0] == 0x25 && (data[1] == 0x6A || data[1] == 0x2A || data[1] == 0x40)) {
     struct Frame frame;
     DecodeFrame(data, &frame);
     if (frame.IsValid) {
-      fhemString = BuildFhemDataString(&frame);
+      result = BuildFhemDataString(&frame, line);
     }
 
   }
 
-  return fhemString;
+  return result;
+}
+
+bool EMT7110::BuildRecord(const void *frame, RecordWriter *record) {
+  return BuildBinaryRecord((struct Frame *)frame, record);
+}
+
+bool EMT7110::BuildLine(const void *frame, LineWriter *line) {
+  return BuildFhemDataString((struct Frame *)frame, line);
 }
 
 bool EMT7110::TryHandleData(byte *data) {
-  String fhemString = GetFhemDataString(data);
+  bool result = false;
 
-  if (fhemString.length() > 0) {
-    Serial.println(fhemString);
+  if (data[0] == 0x25 && (data[1] == 0x6A || data[1] == 0x2A || data[1] == 0x40)) {
+    struct Frame frame;
+    DecodeFrame(data, &frame);
+    if (frame.IsValid) {
+      result = HandleFrame(&frame, BuildRecord, BuildLine);
+    }
   }
 
-  return fhemString.length() > 0;
+  return result;
 }
 
 bool EMT7110::IsValidDataRate(unsigned long dataRate) {
@@ -3,6 +3,8 @@
 
 #include "Arduino.h"
 #include "SensorBase.h"
+#include "LineWriter.h"
+#include "RecordWriter.h"
 
 class EMT7110 : public SensorBase {
 
@@ -13,10 +15,10 @@ public:
     word  ID;
     bool ConsumersConnected;
     bool PairingFlag;
-    float Voltage;
-    float Current;
-    float Power;
-    float AccumulatedPower;
+    word  Voltage;            // 1/10 V
+    word  Current;            // mA
+    word  Power;              // W
+    word  AccumulatedPower;   // 1/100 kWh
     bool Byte9_6;
     bool Byte9_7;
     byte  CRC;
@@ -27,12 +29,15 @@ public:
   static const byte FRAME_LENGTH = 12;
   static void DecodeFrame(byte *data, struct EMT7110::Frame *frame);
   static String AnalyzeFrame(byte *data);
-  static String GetFhemDataString(byte *data);
+  static bool GetFhemDataString(byte *data, LineWriter *line);
   static bool TryHandleData(byte *data);
   static bool IsValidDataRate(unsigned long dataRate);
 
 protected:
-  static String BuildFhemDataString(struct EMT7110::Frame *frame);
+  static bool BuildFhemDataString(struct EMT7110::Frame *frame, LineWriter *line);
+  static bool BuildBinaryRecord(struct EMT7110::Frame *frame, RecordWriter *record);
+  static bool BuildRecord(const void *frame, RecordWriter *record);
+  static bool BuildLine(const void *frame, LineWriter *line);
 
 };
 
@@ -0,0 +1,269 @@
+#include "FrameDispatcher.h"
+#include "RFM.h"
+#include "LaCrosse.h"
+#include "LevelSenderLib.h"
+#include "EMT7110.h"
+#include "WT440XH.h"
+#include "TX38IT.h"
+#include "WS1080.h"
+#include "TX22IT.h"
+#include "CustomSensor.h"
+#include "IdFilter.h"
+
+// Header of the first byte(s) and data rates of the protocols
+// ---------------------------------------------------------------------------
+// LaCrosse      9x            17.241, 9.579
+// TX22IT        Ax            8.842
+// WS1080        Ax            17.241
+// LevelSender   Bx            all
+// EMT7110       25 6A|2A|40   9.579
+// WT440XH       51            17.241, 9.579
+// TX38IT        11xx.xxxx     17.241
+// CustomSensor  CC            all
+//
+// CC at 17.241 kbps is a valid TX38IT header too. It is tried as TX38IT first
+// and then as CustomSensor, like the old cascade did.
+
+unsigned long FrameDispatcher::m_hits[FrameDispatcher::ProtocolCount];
+word FrameDispatcher::m_misses[FrameDispatcher::ProtocolCount];
+
+// The length byte is not protected, don't decode behind the payload. It is
+// checked before GetFrameLength(), whose byte sized 4 + n wraps above 251.
+static bool IsCustomSensorInPayload(byte *payload) {
+  return payload[2] <= PAYLOADSIZE - 4;
+}
+
+static bool IsTX38ITFrame(byte *payload) {
+  struct TX38IT::Frame frame;
+  TX38IT::DecodeFrame(payload, &frame);
+  return frame.IsValid;
+}
+
+FrameDispatcher::Protocol FrameDispatcher::Classify(byte *payload, unsigned long dataRate) {
+  Protocol result = ProtocolUnknown;
+  byte header = payload[0] >> 4;
+
+  if (header == 0x9) {
+    if (LaCrosse::IsValidDataRate(dataRate)) {
+      result = ProtocolLaCrosse;
+    }
+  }
+  else if (header == 0xA) {
+    if (TX22IT::IsValidDataRate(dataRate)) {
+      result = ProtocolTX22IT;
+    }
+    else if (WS1080::IsValidDataRate(dataRate)) {
+      result = ProtocolWS1080;
+    }
+  }
+  else if (header == 0xB) {
+    if (LevelSenderLib::IsValidDataRate(dataRate)) {
+      result = ProtocolLevelSender;
+    }
+  }
+  else if (payload[0] == 0x25) {
+    if (EMT7110::IsValidDataRate(dataRate) && (payload[1] == 0x6A || payload[1] == 0x2A || payload[1] == 0x40)) {
+      result = ProtocolEMT7110;
+    }
+  }
+  else if (payload[0] == 0x51) {
+    if (WT440XH::IsValidDataRate(dataRate)) {
+      result = ProtocolWT440XH;
+    }
+  }
+  else if ((payload[0] & 0xC0) == 0xC0 && TX38IT::IsValidDataRate(dataRate)) {
+    result = ProtocolTX38IT;
+  }
+  else if (payload[0] == CUSTOM_SENSOR_HEADER) {
+    if (CustomSensor::IsValidDataRate(dataRate) && IsCustomSensorInPayload(payload)) {
+      result = ProtocolCustomSensor;
+    }
+  }
+
+  return result;
+}
+
+byte FrameDispatcher::HandleProtocol(Protocol protocol, byte *payload) {
+  byte frameLength = 0;
+
+  switch (protocol) {
+    case ProtocolLaCrosse:
+      if (LaCrosse::TryHandleData(payload)) {
+        frameLength = LaCrosse::FRAME_LENGTH;
+      }
+      break;
+    case ProtocolTX22IT:
+      if (TX22IT::TryHandleData(payload)) {
+        frameLength = TX22IT::GetFrameLength(payload);
+      }
+      break;
+    case ProtocolWS1080:
+      if (WS1080::TryHandleData(payload)) {
+        frameLength = WS1080::FRAME_LENGTH;
+      }
+      break;
+    case ProtocolLevelSender:
+      if (LevelSenderLib::TryHandleData(payload)) {
+        frameLength = LevelSenderLib::FRAME_LENGTH;
+      }
+      break;
+    case ProtocolEMT7110:
+      if (EMT7110::TryHandleData(payload)) {
+        frameLength = EMT7110::FRAME_LENGTH;
+      }
+      break;
+    case ProtocolWT440XH:
+      if (WT440XH::TryHandleData(payload)) {
+        frameLength = WT440XH::FRAME_LENGTH;
+      }
+      break;
+    case ProtocolTX38IT:
+      if (TX38IT::TryHandleData(payload)) {
+        frameLength = TX38IT::FRAME_LENGTH;
+      }
+      break;
+    case ProtocolCustomSensor:
+      if (CustomSensor::TryHandleData(payload)) {
+        frameLength = CustomSensor::GetFrameLength(payload);
+      }
+      break;
+    default:
+      break;
+  }
+
+  if (frameLength > 0) {
+    m_hits[protocol]++;
+  }
+  else {
+    CountMiss(protocol);
+  }
+
+  return frameLength;
+}
+
+// A frame of a filtered ID counts as recognized, so <2>p does not pass it on.
+// CC at 17.241 kbps is a TX38IT with ID 12 when its CRC is right, else it is
+// tried as CustomSensor. The filter is asked once it is known which one.
+byte FrameDispatcher::TryHandleData(byte *payload, unsigned long dataRate) {
+  Protocol protocol = Classify(payload, dataRate);
+  if (protocol == ProtocolTX38IT && payload[0] == CUSTOM_SENSOR_HEADER && !IsTX38ITFrame(payload)) {
+    CountMiss(ProtocolTX38IT);
+    if (!CustomSensor::IsValidDataRate(dataRate) || !IsCustomSensorInPayload(payload)) {
+      return 0;
+    }
+    protocol = ProtocolCustomSensor;
+  }
+
+  if (protocol != ProtocolUnknown && !IdFilter::IsAccepted(protocol, payload)) {
+    return GetFrameLength(protocol, payload);
+  }
+
+  return HandleProtocol(protocol, payload);
+}
+
+// Length of the frame that starts with the header, so a radio with a packet
+// engine only has to read that much of the payload. Frames that are not
+// recognized are read completely, they may be passed on raw.
+byte FrameDispatcher::GetFrameLength(byte *payload, unsigned long dataRate) {
+  Protocol protocol = Classify(payload, dataRate);
+
+  // CC may still turn out to be a CustomSensor frame
+  if (protocol == ProtocolTX38IT && payload[0] == CUSTOM_SENSOR_HEADER) {
+    return PAYLOADSIZE;
+  }
+
+  return GetFrameLength(protocol, payload);
+}
+
+byte FrameDispatcher::GetFrameLength(Protocol protocol, byte *payload) {
+  byte result = PAYLOADSIZE;
+
+  switch (protocol) {
+    case ProtocolLaCrosse:
+      result = LaCrosse::FRAME_LENGTH;
+      break;
+    case ProtocolTX22IT:
+      result = TX22IT::GetFrameLength(payload);
+      break;
+    case ProtocolWS1080:
+      result = WS1080::FRAME_LENGTH;
+      break;
+    case ProtocolLevelSender:
+      result = LevelSenderLib::FRAME_LENGTH;
+      break;
+    case ProtocolEMT7110:
+      result = EMT7110::FRAME_LENGTH;
+      break;
+    case ProtocolWT440XH:
+      result = WT440XH::FRAME_LENGTH;
+      break;
+    case ProtocolTX38IT:
+      result = TX38IT::FRAME_LENGTH;
+      break;
+    case ProtocolCustomSensor:
+      result = CustomSensor::GetFrameLength(payload);
+      break;
+    default:
+      break;
+  }
+
+  return result;
+}
+
+unsigned long FrameDispatcher::GetHits(Protocol protocol) {
+  return m_hits[protocol];
+}
+
+word FrameDispatcher::GetMisses(Protocol protocol) {
+  return m_misses[protocol];
+}
+
+void FrameDispatcher::CountMiss(Protocol protocol) {
+  if (m_misses[protocol] < 0xFFFF) {
+    m_misses[protocol]++;
+  }
+}
+
+void FrameDispatcher::ResetStatistics() {
+  for (byte i = 0; i < ProtocolCount; i++) {
+    m_hits[i] = 0;
+    m_misses[i] = 0;
+  }
+}
+
+const __FlashStringHelper *FrameDispatcher::GetProtocolName(Protocol protocol) {
+  switch (protocol) {
+    case ProtocolLaCrosse:
+      return F("LaCrosse");
+    case ProtocolTX22IT:
+      return F("TX22IT");
+    case ProtocolWS1080:
+      return F("WS1080");
+    case ProtocolLevelSender:
+      return F("LevelSender");
+    case ProtocolEMT7110:
+      return F("EMT7110");
+    case ProtocolWT440XH:
+      return F("WT440XH");
+    case ProtocolTX38IT:
+      return F("TX38IT");
+    case ProtocolCustomSensor:
+      return F("CustomSensor");
+    default:
+      return F("Unknown");
+  }
+}
+
+void FrameDispatcher::ShowStatistics() {
+  // Unknown frames are never decoded, so they only have misses
+  Serial.print(F("\n[Frames"));
+  for (byte i = 0; i < ProtocolCount; i++) {
+    Serial.print(' ');
+    Serial.print(GetProtocolName((Protocol)i));
+    Serial.print(':');
+    Serial.print(m_hits[i]);
+    Serial.print('/');
+    Serial.print(m_misses[i]);
+  }
+  Serial.println(']');
+}
@@ -0,0 +1,44 @@
+#ifndef _FRAMEDISPATCHER_h
+#define _FRAMEDISPATCHER_h
+
+#include "Arduino.h"
+
+// Bytes Classify and GetFrameLength look at (CustomSensor has its length in the third)
+#define FRAME_HEADER_LENGTH 3
+
+// Classifies a received payload once by its header and the data rate and
+// hands it to the one decoder that can handle it
+class FrameDispatcher {
+public:
+  enum Protocol {
+    ProtocolUnknown = 0,
+    ProtocolLaCrosse,
+    ProtocolTX22IT,
+    ProtocolWS1080,
+    ProtocolLevelSender,
+    ProtocolEMT7110,
+    ProtocolWT440XH,
+    ProtocolTX38IT,
+    ProtocolCustomSensor,
+    ProtocolCount
+  };
+
+  static Protocol Classify(byte *payload, unsigned long dataRate);
+  static byte TryHandleData(byte *payload, unsigned long dataRate);
+  static byte GetFrameLength(byte *payload, unsigned long dataRate);
+  static unsigned long GetHits(Protocol protocol);
+  static word GetMisses(Protocol protocol);
+  static void ResetStatistics();
+  static void ShowStatistics();
+  static const __FlashStringHelper *GetProtocolName(Protocol protocol);
+
+private:
+  static unsigned long m_hits[ProtocolCount];
+  // Up to 65535, like the filtered frames of the IdFilter
+  static word m_misses[ProtocolCount];
+  static void CountMiss(Protocol protocol);
+  static byte HandleProtocol(Protocol protocol, byte *payload);
+  static byte GetFrameLength(Protocol protocol, byte *payload);
+};
+
+#endif
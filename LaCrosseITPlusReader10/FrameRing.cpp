@@ -0,0 +1,47 @@
+#include "FrameRing.h"
+
+// Keeps the compiler from moving the payload accesses behind the index update
+#define MEMORY_BARRIER() asm volatile("" ::: "memory")
+
+FrameRing::FrameRing() {
+  m_head = 0;
+  m_tail = 0;
+}
+
+FrameRing::Entry *FrameRing::GetWriteEntry() {
+  if (IsFull()) {
+    return NULL;
+  }
+  MEMORY_BARRIER();
+  return &m_entries[m_head & (FRAME_RING_SIZE - 1)];
+}
+
+void FrameRing::Commit() {
+  MEMORY_BARRIER();
+  m_head++;
+}
+
+FrameRing::Entry *FrameRing::GetReadEntry() {
+  if (IsEmpty()) {
+    return NULL;
+  }
+  MEMORY_BARRIER();
+  return &m_entries[m_tail & (FRAME_RING_SIZE - 1)];
+}
+
+void FrameRing::Release() {
+  MEMORY_BARRIER();
+  m_tail++;
+}
+
+byte FrameRing::GetCount() {
+  return (byte)(m_head - m_tail);
+}
+
+bool FrameRing::IsEmpty() {
+  return m_head == m_tail;
+}
+
+bool FrameRing::IsFull() {
+  return GetCount() >= FRAME_RING_SIZE;
+}
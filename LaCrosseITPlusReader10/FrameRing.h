@@ -0,0 +1,48 @@
+#ifndef _FRAMERING_h
+#define _FRAMERING_h
+
+#include "Arduino.h"
+
+#define PAYLOADSIZE 64
+
+// Completed frames per radio, must be a power of two, 73 bytes each. The
+// frame loop() works on stays in the ring until ReleaseFrame(), so 2 is the
+// least that lets the next frame come in meanwhile
+#ifndef FRAME_RING_SIZE
+#define FRAME_RING_SIZE 2
+#endif
+
+// Lock-free single producer / single consumer queue of received frames.
+// The producer (Receive or the nIRQ handler) only moves m_head, the consumer
+// (loop) only moves m_tail, so neither side has to disable interrupts.
+class FrameRing {
+public:
+  struct Entry {
+    unsigned long Time;      // millis() when the first byte was received
+    unsigned long DataRate;
+    byte Radio;              // number of the radio, 1 is the primary
+    byte Payload[PAYLOADSIZE];
+  };
+
+  FrameRing();
+
+  // Producer: the entry at the head can be filled and is then committed
+  Entry *GetWriteEntry();
+  void Commit();
+
+  // Consumer: the oldest entry stays valid until it is released
+  Entry *GetReadEntry();
+  void Release();
+
+  byte GetCount();
+  bool IsEmpty();
+  bool IsFull();
+
+private:
+  Entry m_entries[FRAME_RING_SIZE];
+  // Free running, the index is taken modulo FRAME_RING_SIZE
+  volatile byte m_head;
+  volatile byte m_tail;
+};
+
+#endif
@@ -7,19 +7,29 @@ const char helpText[] PROGMEM =
 "\n"
 "Available commands:" "\n"
 "  <n>a             - activity LED (0=off, 1=on)" "\n"
+"  <n>b             - output format (0=text lines, 1=binary records)" "\n"
 "  <n>c             - TX data rate (0: 17.241 kbps, 1: 9.579 kbps, 2: 8.842 kbps)" "\n"
 "  <n>d             - DEBUG mode (0=suppress TX and bad packets)" "\n"
+"  <r>,<n>e         - role of radio r (0: fixed rate, 1: toggling, 2: transmit only, 3: relay)" "\n"
 "  <n>h             - height above sea level (m)" "\n"
 "  <nnnnnn>f        - frequency (5 kHz steps e.g. 868315)" "\n"
-"  <n>m             - toggle mode (1: 17.241 kbps, 2: 9.579 kbps, 4: 8.842 kbps)" "\n"
+"  <p>,<m>i         - ID filter of protocol p (m: 0=off, 1=drop listed, 2=only listed), <p>,1,<id>i add, <p>,0,<id>i remove, 0i clear" "\n"
+"  <t,h,s>k         - report only changes (t/10 C, h %, every s seconds anyway, 0=report all, -k: not built)" "\n"
+"  <n>l             - tasks of loop(): runs, longest run and latest start in us (1=reset)" "\n"
+"  <n>m             - toggle mode (1: 17.241 kbps, 2: 9.579 kbps, 4: 8.842 kbps, 8: predict the known sensors, -m8: not built)" "\n"
 "  <n>p             - show raw payload data (0=off, 1=on, 2=only undecoded)" "\n"
+"  <n>q             - statistics: decoded/rejected frames per protocol, lost frames and rx/tx/idle ms per radio, serial and transmit queue, commands, reported, aggregated and filtered sensors, capture ratio per sensor (1=reset)" "\n"
 "  <n>r             - data rate (0: 17.241 kbps, 1: 9.579 kbps, 2: 8.842 kbps)" "\n"
-"  <id,b,b,b,...>s  - send the bytes ti the address id" "\n"
+"  <id,b,b,b,...>s  - send the bytes ti the address id (on the transmit radio or the last one found, radio 1 keeps receiving)" "\n"
 "  <n>t             - toggle data rate intervall (0=no toggle, >0=seconds)" "\n"
+"  <n>u             - baud rate (0: 57600, 1: 115200, 2: 250000, 3: 500000, 4: 1000000, repeat at the new rate)" "\n"
 "  <n>v             - version and configuration report" "\n"
+"  <n>w             - aggregation window (0=off, >0=seconds, one min/max/mean line per sensor, -w: not built)" "\n"
 "  <n>x             - used for tests" "\n"
 "  <n>y             - Relay (0=no relay, 1=Relay received packets)" "\n"
-"  <n>z             - 1 = display analyzed frame data instead of normal data" "\n"
+"  <n>z             - 1 = display analyzed frame data instead of normal data (-z: not built)" "\n"
+"  f, m, r and t are for radio 1, F, M, R and T for radio 2, <r>,<n>f etc. for radio r" "\n"
+"  -k, -w, -m8, -z in the version line: left out of this build, the command answers failed" "\n"
 ;
 
 
@@ -0,0 +1,96 @@
+#include "HostLink.h"
+#include "SerialQueue.h"
+#include <EEPROM.h>
+
+#define HOST_LINK_NO_RATE 0xFF
+
+// The AVR reaches 250000 and above exactly at 16 MHz, 115200 within 2.1 %
+static const unsigned long s_baudRates[] PROGMEM = { HOST_LINK_DEFAULT_BAUD, 115200ul, 250000ul, 500000ul, 1000000ul };
+#define HOST_LINK_RATE_COUNT (sizeof(s_baudRates) / sizeof(s_baudRates[0]))
+
+HostLink::HostLink() {
+  m_index = 0;
+  m_pending = false;
+  m_switchTime = 0;
+}
+
+// Starts with the stored rate, which needs a confirmation like a new one
+void HostLink::Begin() {
+  byte index = 0;
+  if (EEPROM.read(HOST_LINK_EEPROM_ADDRESS) == HOST_LINK_EEPROM_MAGIC) {
+    index = EEPROM.read(HOST_LINK_EEPROM_ADDRESS + 1);
+    if (index >= HOST_LINK_RATE_COUNT) {
+      index = 0;
+    }
+  }
+
+  m_index = index;
+  Serial.begin(GetBaudRate());
+  m_pending = index != 0;
+  m_switchTime = millis();
+}
+
+void HostLink::Request(unsigned long value) {
+  byte index = ConvertBaudRate(value);
+  if (index == HOST_LINK_NO_RATE) {
+    ShowBaudRate();
+    return;
+  }
+
+  // The host talks at the new rate, so it has switched as well
+  if (index == m_index) {
+    m_pending = false;
+    EEPROM.update(HOST_LINK_EEPROM_ADDRESS, HOST_LINK_EEPROM_MAGIC);
+    EEPROM.update(HOST_LINK_EEPROM_ADDRESS + 1, index);
+    ShowBaudRate();
+    return;
+  }
+
+  // Announced at the old rate, which must be on the wire before switching
+  Serial.print(F("[Baud:"));
+  Serial.print(pgm_read_dword(&s_baudRates[index]));
+  Serial.println(']');
+  SerialQueue::Flush();
+  Serial.flush();
+
+  Switch(index);
+  m_pending = true;
+}
+
+void HostLink::Handle() {
+  if (m_pending && millis() - m_switchTime >= HOST_LINK_CONFIRM_MILLIS) {
+    m_pending = false;
+    Switch(0);
+    ShowBaudRate();
+  }
+}
+
+unsigned long HostLink::GetBaudRate() {
+  return pgm_read_dword(&s_baudRates[m_index]);
+}
+
+bool HostLink::IsPending() {
+  return m_pending;
+}
+
+void HostLink::Switch(byte index) {
+  m_index = index;
+  Serial.end();
+  Serial.begin(GetBaudRate());
+  m_switchTime = millis();
+}
+
+void HostLink::ShowBaudRate() {
+  Serial.print(F("[Baud:"));
+  Serial.print(GetBaudRate());
+  Serial.println(']');
+}
+
+byte HostLink::ConvertBaudRate(unsigned long value) {
+  for (byte i = 0; i < HOST_LINK_RATE_COUNT; i++) {
+    if (value == i || value == pgm_read_dword(&s_baudRates[i])) {
+      return i;
+    }
+  }
+  return HOST_LINK_NO_RATE;
+}
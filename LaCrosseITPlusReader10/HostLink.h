@@ -0,0 +1,39 @@
+#ifndef _HOSTLINK_h
+#define _HOSTLINK_h
+
+#include "Arduino.h"
+
+#define HOST_LINK_DEFAULT_BAUD   57600ul
+// Time the host has to confirm a new baud rate
+#define HOST_LINK_CONFIRM_MILLIS 2000
+// Two bytes: HOST_LINK_EEPROM_MAGIC and the index of the rate
+#define HOST_LINK_EEPROM_ADDRESS 0
+#define HOST_LINK_EEPROM_MAGIC   0xB5
+
+// Baud rate of the serial port to the host (<n>u).
+// A new rate is announced at the old one ("[Baud:500000]"), then the port
+// switches and the host has HOST_LINK_CONFIRM_MILLIS to send the same
+// command again at the new rate. Confirmed rates are stored in the EEPROM,
+// without a confirmation the link falls back to 57600.
+// After a reset the stored rate has to be confirmed the same way.
+class HostLink {
+public:
+  HostLink();
+  void Begin();
+  // value is the index of the rate (0: 57600, 1: 115200, 2: 250000,
+  // 3: 500000, 4: 1000000) or the rate itself
+  void Request(unsigned long value);
+  void Handle();
+  unsigned long GetBaudRate();
+  bool IsPending();
+
+private:
+  byte m_index;
+  bool m_pending;
+  unsigned long m_switchTime;
+  void Switch(byte index);
+  void ShowBaudRate();
+  static byte ConvertBaudRate(unsigned long value);
+};
+
+#endif
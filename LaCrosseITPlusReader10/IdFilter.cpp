@@ -0,0 +1,272 @@
+#include "IdFilter.h"
+#include "LaCrosse.h"
+#include <EEPROM.h>
+
+#define ID_FILTER_NO_ENTRY -1
+
+byte IdFilter::m_modes[FrameDispatcher::ProtocolCount];
+byte IdFilter::m_bitmaps[4][8];
+IdFilter::Entry IdFilter::m_set[ID_FILTER_SET_SIZE];
+word IdFilter::m_filtered[FrameDispatcher::ProtocolCount];
+
+void IdFilter::Begin() {
+  memset(m_modes, 0, sizeof(m_modes));
+  memset(m_bitmaps, 0, sizeof(m_bitmaps));
+  memset(m_set, 0, sizeof(m_set));
+  if (EEPROM.read(ID_FILTER_EEPROM_ADDRESS) != ID_FILTER_EEPROM_MAGIC) {
+    return;
+  }
+
+  int address = ID_FILTER_EEPROM_ADDRESS + 1;
+  for (byte i = 0; i < FrameDispatcher::ProtocolCount; i++) {
+    m_modes[i] = EEPROM.read(address++);
+  }
+  for (byte i = 0; i < sizeof(m_bitmaps); i++) {
+    m_bitmaps[i / 8][i % 8] = EEPROM.read(address++);
+  }
+  for (byte i = 0; i < ID_FILTER_SET_SIZE; i++) {
+    m_set[i].Protocol = EEPROM.read(address++);
+    m_set[i].ID = EEPROM.read(address++) << 8;
+    m_set[i].ID |= EEPROM.read(address++);
+  }
+}
+
+// Only bytes that changed are written
+void IdFilter::Save() {
+  int address = ID_FILTER_EEPROM_ADDRESS;
+  EEPROM.update(address++, ID_FILTER_EEPROM_MAGIC);
+  for (byte i = 0; i < FrameDispatcher::ProtocolCount; i++) {
+    EEPROM.update(address++, m_modes[i]);
+  }
+  for (byte i = 0; i < sizeof(m_bitmaps); i++) {
+    EEPROM.update(address++, m_bitmaps[i / 8][i % 8]);
+  }
+  for (byte i = 0; i < ID_FILTER_SET_SIZE; i++) {
+    EEPROM.update(address++, m_set[i].Protocol);
+    EEPROM.update(address++, m_set[i].ID >> 8);
+    EEPROM.update(address++, m_set[i].ID);
+  }
+}
+
+// The same bits as DecodeFrame() of the decoders, but from the header only
+word IdFilter::GetID(FrameDispatcher::Protocol protocol, byte *payload) {
+  byte deviceCode;
+
+  switch (protocol) {
+  case FrameDispatcher::ProtocolLaCrosse:
+    if (LaCrosse::USE_OLD_ID_CALCULATION) {
+      return (payload[0] & 0xF) << 2 | (payload[1] & 0xC0);
+    }
+    return (payload[0] & 0xF) << 2 | (payload[1] & 0xC0) >> 6;
+  case FrameDispatcher::ProtocolTX22IT:
+    return (payload[0] & 0xF) << 2 | (payload[1] & 0xC0) >> 6;
+  case FrameDispatcher::ProtocolWS1080:
+    return (payload[0] & 0xF) << 4 | (payload[1] & 0xF0) >> 4;
+  case FrameDispatcher::ProtocolLevelSender:
+    return payload[0] & 0x0F;
+  case FrameDispatcher::ProtocolEMT7110:
+    return payload[2] << 8 | payload[3];
+  case FrameDispatcher::ProtocolWT440XH:
+    deviceCode = (payload[1] & 0x30) >> 4;
+    return (deviceCode == 0 ? 4 : deviceCode) << 4 | (payload[1] & 0xF);
+  case FrameDispatcher::ProtocolTX38IT:
+    return payload[0] & 0x3F;
+  case FrameDispatcher::ProtocolCustomSensor:
+    return payload[1];
+  default:
+    return 0;
+  }
+}
+
+bool IdFilter::IsAccepted(FrameDispatcher::Protocol protocol, byte *payload) {
+  if (IsWanted(protocol, GetID(protocol, payload))) {
+    return true;
+  }
+  if (m_filtered[protocol] < 0xFFFF) {
+    m_filtered[protocol]++;
+  }
+  return false;
+}
+
+// The same as IsAccepted, but not counted
+bool IdFilter::IsWanted(FrameDispatcher::Protocol protocol, word id) {
+  byte mode = m_modes[protocol];
+  if (mode == ID_FILTER_OFF) {
+    return true;
+  }
+  return IsListed(protocol, id) == (mode == ID_FILTER_ALLOW);
+}
+
+int8_t IdFilter::GetBitmap(byte protocol) {
+  switch (protocol) {
+  case FrameDispatcher::ProtocolLaCrosse:
+    return 0;
+  case FrameDispatcher::ProtocolTX22IT:
+    return 1;
+  case FrameDispatcher::ProtocolTX38IT:
+    return 2;
+  case FrameDispatcher::ProtocolLevelSender:
+    return 3;
+  default:
+    return -1;
+  }
+}
+
+bool IdFilter::IsListed(byte protocol, word id) {
+  int8_t bitmap = GetBitmap(protocol);
+  if (bitmap >= 0 && id < 64) {
+    return m_bitmaps[bitmap][id >> 3] & (1 << (id & 7));
+  }
+  return FindInSet(protocol, id) != ID_FILTER_NO_ENTRY;
+}
+
+byte IdFilter::GetHash(byte protocol, word id) {
+  return (id ^ id >> 8 ^ protocol * 7) % ID_FILTER_SET_SIZE;
+}
+
+// Linear probing, a free entry ends the search
+int8_t IdFilter::FindInSet(byte protocol, word id) {
+  byte index = GetHash(protocol, id);
+  for (byte i = 0; i < ID_FILTER_SET_SIZE; i++) {
+    Entry *entry = &m_set[index];
+    if (entry->Protocol == 0) {
+      break;
+    }
+    if (entry->Protocol == protocol && entry->ID == id) {
+      return index;
+    }
+    index = (index + 1) % ID_FILTER_SET_SIZE;
+  }
+  return ID_FILTER_NO_ENTRY;
+}
+
+bool IdFilter::SetMode(byte protocol, byte mode) {
+  if (protocol == FrameDispatcher::ProtocolUnknown || protocol >= FrameDispatcher::ProtocolCount
+    || mode > ID_FILTER_ALLOW) {
+    return false;
+  }
+  m_modes[protocol] = mode;
+  Save();
+  return true;
+}
+
+// False for an unknown protocol or a full set
+bool IdFilter::Add(byte protocol, word id) {
+  if (protocol == FrameDispatcher::ProtocolUnknown || protocol >= FrameDispatcher::ProtocolCount) {
+    return false;
+  }
+  if (IsListed(protocol, id)) {
+    return true;
+  }
+
+  int8_t bitmap = GetBitmap(protocol);
+  if (bitmap >= 0 && id < 64) {
+    m_bitmaps[bitmap][id >> 3] |= 1 << (id & 7);
+    Save();
+    return true;
+  }
+
+  byte index = GetHash(protocol, id);
+  for (byte i = 0; i < ID_FILTER_SET_SIZE; i++) {
+    if (m_set[index].Protocol == 0) {
+      m_set[index].Protocol = protocol;
+      m_set[index].ID = id;
+      Save();
+      return true;
+    }
+    index = (index + 1) % ID_FILTER_SET_SIZE;
+  }
+  return false;
+}
+
+bool IdFilter::Remove(byte protocol, word id) {
+  int8_t bitmap = GetBitmap(protocol);
+  if (bitmap >= 0 && id < 64) {
+    m_bitmaps[bitmap][id >> 3] &= ~(1 << (id & 7));
+    Save();
+    return true;
+  }
+
+  int8_t found = FindInSet(protocol, id);
+  if (found == ID_FILTER_NO_ENTRY) {
+    return false;
+  }
+
+  // The entries behind it in the same run may have probed past it
+  m_set[(byte)found].Protocol = 0;
+  byte index = ((byte)found + 1) % ID_FILTER_SET_SIZE;
+  while (m_set[index].Protocol != 0) {
+    Entry entry = m_set[index];
+    m_set[index].Protocol = 0;
+    byte target = GetHash(entry.Protocol, entry.ID);
+    while (m_set[target].Protocol != 0) {
+      target = (target + 1) % ID_FILTER_SET_SIZE;
+    }
+    m_set[target] = entry;
+    index = (index + 1) % ID_FILTER_SET_SIZE;
+  }
+  Save();
+  return true;
+}
+
+void IdFilter::Clear() {
+  memset(m_modes, 0, sizeof(m_modes));
+  memset(m_bitmaps, 0, sizeof(m_bitmaps));
+  memset(m_set, 0, sizeof(m_set));
+  Save();
+}
+
+// [Filter LaCrosse:allow 12 17 EMT7110:deny 5451]
+void IdFilter::Show() {
+  Serial.print(F("[Filter"));
+  for (byte protocol = 1; protocol < FrameDispatcher::ProtocolCount; protocol++) {
+    if (m_modes[protocol] == ID_FILTER_OFF) {
+      continue;
+    }
+    Serial.print(' ');
+    Serial.print(FrameDispatcher::GetProtocolName((FrameDispatcher::Protocol)protocol));
+    Serial.print(m_modes[protocol] == ID_FILTER_ALLOW ? F(":allow") : F(":deny"));
+
+    int8_t bitmap = GetBitmap(protocol);
+    if (bitmap >= 0) {
+      for (byte id = 0; id < 64; id++) {
+        if (m_bitmaps[bitmap][id >> 3] & (1 << (id & 7))) {
+          Serial.print(' ');
+          Serial.print(id);
+        }
+      }
+    }
+    for (byte i = 0; i < ID_FILTER_SET_SIZE; i++) {
+      if (m_set[i].Protocol == protocol) {
+        Serial.print(' ');
+        Serial.print(m_set[i].ID);
+      }
+    }
+  }
+  Serial.println(']');
+}
+
+word IdFilter::GetFiltered(FrameDispatcher::Protocol protocol) {
+  return m_filtered[protocol];
+}
+
+void IdFilter::ResetStatistics() {
+  for (byte i = 0; i < FrameDispatcher::ProtocolCount; i++) {
+    m_filtered[i] = 0;
+  }
+}
+
+// Only the protocols that have a filter or filtered frames
+void IdFilter::ShowStatistics() {
+  Serial.print(F("[Filtered"));
+  for (byte protocol = 1; protocol < FrameDispatcher::ProtocolCount; protocol++) {
+    if (m_modes[protocol] == ID_FILTER_OFF && m_filtered[protocol] == 0) {
+      continue;
+    }
+    Serial.print(' ');
+    Serial.print(FrameDispatcher::GetProtocolName((FrameDispatcher::Protocol)protocol));
+    Serial.print(':');
+    Serial.print(m_filtered[protocol]);
+  }
+  Serial.println(']');
+}
@@ -0,0 +1,65 @@
+#ifndef _IDFILTER_h
+#define _IDFILTER_h
+
+#include "Arduino.h"
+#include "FrameDispatcher.h"
+
+// Stored after the two bytes of the HostLink: magic, modes, bitmaps, set
+#define ID_FILTER_EEPROM_ADDRESS 2
+#define ID_FILTER_EEPROM_MAGIC   0xF1
+
+// IDs of the protocols without a bitmap (EMT7110, WS1080, WT440XH,
+// CustomSensor and the old LaCrosse IDs), 3 bytes each
+#ifndef ID_FILTER_SET_SIZE
+#define ID_FILTER_SET_SIZE 16
+#endif
+
+#define ID_FILTER_OFF   0
+#define ID_FILTER_DENY  1
+#define ID_FILTER_ALLOW 2
+
+// Sensor ID filter per protocol (<p>,<mode>i and <p>,<n>,<id>i).
+// A protocol drops the listed IDs (deny) or everything else (allow). The ID
+// is taken from the header right after the FrameDispatcher has classified
+// the frame, so a filtered frame is neither decoded nor formatted.
+// The 6 bit IDs of LaCrosse, TX22IT, TX38IT and LevelSender are a bit in a
+// 64 bit map each, all other IDs share a small hash set.
+// The protocols are those of FrameDispatcher::Protocol, the filters are
+// stored in the EEPROM on every change.
+class IdFilter {
+public:
+  static void Begin();
+  static bool IsAccepted(FrameDispatcher::Protocol protocol, byte *payload);
+  static bool IsWanted(FrameDispatcher::Protocol protocol, word id);
+  static word GetID(FrameDispatcher::Protocol protocol, byte *payload);
+
+  static bool SetMode(byte protocol, byte mode);
+  static bool Add(byte protocol, word id);
+  static bool Remove(byte protocol, word id);
+  static void Clear();
+  static void Show();
+
+  static word GetFiltered(FrameDispatcher::Protocol protocol);
+  static void ResetStatistics();
+  static void ShowStatistics();
+
+private:
+  struct Entry {
+    byte Protocol;    // 0 if the entry is free
+    word ID;
+  };
+
+  static byte m_modes[FrameDispatcher::ProtocolCount];
+  static byte m_bitmaps[4][8];
+  static Entry m_set[ID_FILTER_SET_SIZE];
+  // Up to 65535 frames, q1 resets them
+  static word m_filtered[FrameDispatcher::ProtocolCount];
+
+  static int8_t GetBitmap(byte protocol);
+  static bool IsListed(byte protocol, word id);
+  static int8_t FindInSet(byte protocol, word id);
+  static byte GetHash(byte protocol, word id);
+  static void Save();
+};
+
+#endif
@@ -21,8 +21,7 @@ void InternalSensors::SetAltitudeAboveSeaLevel(int altitude) {
 }
 
 
-String InternalSensors::BuildFhemDataString(struct Frame *frame) {
-  String result = "";
+bool InternalSensors::BuildFhemDataString(struct Frame *frame, LineWriter *line) {
 
   // Check if data is in the valid range
   bool isValid = true;
@@ -33,31 +32,31 @@ String InternalSensors::BuildFhemDataString(struct Frame *frame) {
   
   
   if(isValid) {
-    result += "OK WS ";
-    result += frame->ID;
-    result += " 2";
+    line->Add(F("OK WS "));
+    line->AddNumber(frame->ID);
+    line->Add(F(" 2"));
 
     // add temperature
     int temp = frame->Temperature * 10 + 1000;
-    result += " ";
-    result += (byte)(temp >> 8);
-    result += " ";
-    result += (byte)(temp);
+    line->Add(' ');
+    line->AddNumber((byte)(temp >> 8));
+    line->Add(' ');
+    line->AddNumber((byte)(temp));
 
     // no humidity
-    result += " 255";
+    line->Add(F(" 255"));
 
     // no rain
-    result += " 255 255";
+    line->Add(F(" 255 255"));
 
     // no wind direction
-    result += " 255 255";
+    line->Add(F(" 255 255"));
 
     // no wind speed
-    result += " 255 255";
+    line->Add(F(" 255 255"));
 
     // no wind gust
-    result += " 255 255";
+    line->Add(F(" 255 255"));
 
     // add Flags
     byte flags = 0;
@@ -67,54 +66,89 @@ String InternalSensors::BuildFhemDataString(struct Frame *frame) {
     if (frame->LowBatteryFlag) {
       flags += 4;
     }
-    result += " ";
-    result += flags;
+    line->Add(' ');
+    line->AddNumber(flags);
 
     // add pressure
-    result += " ";
-    result += (byte)(frame->Pressure >> 8);
-    result += " ";
-    result += (byte)(frame->Pressure);
+    line->Add(' ');
+    line->AddNumber((byte)(frame->Pressure >> 8));
+    line->Add(' ');
+    line->AddNumber((byte)(frame->Pressure));
 
   }
   
-  return result;
+  return isValid;
 }
 
- String InternalSensors::GetFhemDataString(){
-  String fhemString = "";
+ // Same checks and rounding as the text line, see RecordWriter.h for the layout
+bool InternalSensors::BuildBinaryRecord(struct Frame *frame, RecordWriter *record) {
+  if (frame->Temperature < -40.0 || frame->Temperature > 85.0) {
+    return false;
+  }
 
-  struct Frame frame;
+  byte flags = 0;
+  if (frame->NewBatteryFlag) {
+    flags += 1;
+  }
+  if (frame->LowBatteryFlag) {
+    flags += 4;
+  }
 
-  if (m_hasBMP180) {
-    if (millis() >= m_lastMeasurement + 10000) {
-      m_lastMeasurement = millis();
+  int temp = frame->Temperature * 10 + 1000;
+
+  record->Add(RECORD_INTERNAL);
+  record->Add(frame->ID);
+  record->Add(flags);
+  record->Add(RECORD_HAS_TEMPERATURE | RECORD_HAS_PRESSURE);
+  record->AddWord(temp - 1000);
+  record->AddWord(frame->Pressure);
 
-      frame.ID = 0;
-      frame.LowBatteryFlag = false;
-      frame.NewBatteryFlag = false;
-      frame.IsValid = true;
-      frame.Temperature = m_bmp.GetTemperature();
-      frame.Pressure = m_bmp.GetPressure();
+  return true;
+}
+
+// The conversions run while loop() goes on, the frame comes when they are done
+bool InternalSensors::TryGetFrame(struct Frame *frame) {
+  bool result = false;
 
-      if (frame.IsValid) {
-        fhemString = BuildFhemDataString(&frame);
-      }
+  if (m_hasBMP180) {
+    if (m_bmp.Handle()) {
+      BMP180Value value = m_bmp.GetLastMeasuredValue();
 
+      frame->ID = 0;
+      frame->LowBatteryFlag = false;
+      frame->NewBatteryFlag = false;
+      frame->IsValid = true;
+      frame->Temperature = value.Temperature;
+      frame->Pressure = value.SeaLevelPressure;
+
+      result = frame->IsValid;
+    }
+    else if (m_bmp.IsIdle() && millis() >= m_lastMeasurement + 10000) {
+      m_lastMeasurement = millis();
+      m_bmp.StartMeasurement();
     }
 
   }
 
-  return fhemString;
+  return result;
 }
 
- bool InternalSensors::TryHandleData(){
-   String fhemString = GetFhemDataString();
+ bool InternalSensors::GetFhemDataString(LineWriter *line) {
+  struct Frame frame;
+  return TryGetFrame(&frame) && BuildFhemDataString(&frame, line);
+}
 
-   if (fhemString.length() > 0) {
-     Serial.println(fhemString);
-   }
+bool InternalSensors::BuildRecord(const void *frame, RecordWriter *record) {
+  return BuildBinaryRecord((struct Frame *)frame, record);
+}
 
-   return fhemString.length() > 0;
+bool InternalSensors::BuildLine(const void *frame, LineWriter *line) {
+  return BuildFhemDataString((struct Frame *)frame, line);
+}
+
+ bool InternalSensors::TryHandleData(){
+   // One frame for the record and the line, the BMP180 is read only once
+   struct Frame frame;
+   return TryGetFrame(&frame) && SensorBase::HandleFrame(&frame, BuildRecord, BuildLine);
  }
 
@@ -3,6 +3,8 @@
 
 #include "TX22IT.h"
 #include "BMP180.h"
+#include "LineWriter.h"
+#include "RecordWriter.h"
 
 
 class InternalSensors {
@@ -24,14 +26,18 @@ public:
   bool TryInitializeBMP180();
   bool HasBMP180();
   bool TryHandleData();
-  String GetFhemDataString();
+  bool GetFhemDataString(LineWriter *line);
   void SetAltitudeAboveSeaLevel(int altitude);
 
 protected:
   bool m_hasBMP180;
   BMP180 m_bmp;
   unsigned long m_lastMeasurement;
-  String BuildFhemDataString(struct InternalSensors::Frame *frame);
+  bool TryGetFrame(struct InternalSensors::Frame *frame);
+  static bool BuildFhemDataString(struct InternalSensors::Frame *frame, LineWriter *line);
+  static bool BuildBinaryRecord(struct InternalSensors::Frame *frame, RecordWriter *record);
+  static bool BuildRecord(const void *frame, RecordWriter *record);
+  static bool BuildLine(const void *frame, LineWriter *line);
 };
 
 
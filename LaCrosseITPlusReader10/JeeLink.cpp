@@ -2,6 +2,9 @@
 
 JeeLink::JeeLink() {
   m_ledEnabled = true;
+  m_ledOn = false;
+  m_pendingBlinks = 0;
+  m_lastSwitch = 0;
 }
 
 void JeeLink::SwitchLed(boolean on) {
@@ -13,25 +16,50 @@ void JeeLink::SwitchLed(boolean on) {
 }
 
 void JeeLink::Blink(byte ct) {
-  if (ct > 0) {
-    if (ct > 10) {
-      ct = 10;
+  if (ct > 0 && m_ledEnabled) {
+    if (ct > JEELINK_MAX_BLINKS - m_pendingBlinks) {
+      m_pendingBlinks = JEELINK_MAX_BLINKS;
     }
-    for (int i = 0; i < ct; i++) {
-      SwitchLed(true);
-      delay(50);
-      SwitchLed(false);
-      delay(50);
+    else {
+      m_pendingBlinks += ct;
     }
 
+    // An idle LED goes on right away
+    Handle();
   }
 }
 
-void JeeLink::EnableLED(bool enabled) {
-  m_ledEnabled = enabled;
+// Every pulse is JEELINK_BLINK_MILLIS on and then as long off
+void JeeLink::Handle() {
+  unsigned long now = millis();
+  if (now - m_lastSwitch < JEELINK_BLINK_MILLIS) {
+    return;
+  }
 
-  if (!m_ledEnabled) {
+  if (m_ledOn) {
     SwitchLed(false);
+    m_ledOn = false;
+    m_lastSwitch = now;
+  }
+  else if (m_pendingBlinks > 0) {
+    SwitchLed(true);
+    m_ledOn = true;
+    m_pendingBlinks--;
+    m_lastSwitch = now;
   }
+}
+
+bool JeeLink::IsBlinking() {
+  return m_ledOn || m_pendingBlinks > 0;
+}
+
+void JeeLink::EnableLED(bool enabled) {
+  if (!enabled) {
+    SwitchLed(false);
+    m_ledOn = false;
+    m_pendingBlinks = 0;
+  }
+
+  m_ledEnabled = enabled;
 
 }
@@ -3,16 +3,25 @@
 
 #include "Arduino.h"
 
+#define JEELINK_BLINK_MILLIS 50
+#define JEELINK_MAX_BLINKS 10
+
+// Blink() only queues the pulses, Handle() switches the LED from loop(),
+// so the receive loop never waits for the LED
 class JeeLink {
 private:
   bool m_ledEnabled;
+  bool m_ledOn;
+  byte m_pendingBlinks;
+  unsigned long m_lastSwitch;
   void SwitchLed(boolean on);
 
 public:
   JeeLink();
   void EnableLED(bool enabled);
   void Blink(byte ct);
+  void Handle();
+  bool IsBlinking();
 };
 
 #endif
-
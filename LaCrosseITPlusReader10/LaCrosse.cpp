@@ -1,4 +1,5 @@
 #include "LaCrosse.h"
+#include "IdFilter.h"
 
 /*
 * Message Format:
@@ -45,10 +46,10 @@ void LaCrosse::EncodeFrame(struct Frame *frame, byte bytes[5]) {
   bytes[1] |= frame->Bit12 << 4;
 
   // Temperature
-  float temp = frame->Temperature + 40.0;
-  bytes[1] |= (int)(temp / 10);
-  bytes[2] |= ((int)temp % 10) << 4;
-  bytes[2] |= (int)((int)(temp * 10) % 10);
+  int temp = frame->Temperature + 400;
+  bytes[1] |= temp / 100;
+  bytes[2] |= (temp / 10 % 10) << 4;
+  bytes[2] |= temp % 10;
 
   // Humidity
   bytes[3] = frame->Humidity;
@@ -97,13 +98,7 @@ void LaCrosse::DecodeFrame(byte *bytes, struct Frame *frame) {
   bcd[0] = bytes[1] & 0xF;
   bcd[1] = (bytes[2] & 0xF0) >> 4;
   bcd[2] = (bytes[2] & 0xF);
-  float t = 0;
-  t += bcd[0] * 100.0;
-  t += bcd[1] * 10.0;
-  t += bcd[2] * 1.0;
-  t = t / 10;
-  t -= 40;
-  frame->Temperature = t;
+  frame->Temperature = bcd[0] * 100 + bcd[1] * 10 + bcd[2] - 400;
 
   frame->WeakBatteryFlag = (bytes[3] & 0x80) >> 7;
 
@@ -111,7 +106,7 @@ void LaCrosse::DecodeFrame(byte *bytes, struct Frame *frame) {
 }
 
 
-String LaCrosse::BuildFhemDataString(struct Frame *frame) {
+bool LaCrosse::BuildFhemDataString(struct Frame *frame, LineWriter *line) {
   // Format
   //
   // OK 9 56 1   4   156 37     ID = 56  T: 18.0  H: 37  no NewBatt
@@ -127,47 +122,87 @@ String LaCrosse::BuildFhemDataString(struct Frame *frame) {
   // |  |------------------- fix "9"
   // |---------------------- fix "OK"
 
-  String pBuf;
-  pBuf += "OK 9 ";
-  pBuf += frame->ID;
-  pBuf += ' ';
+  line->Add(F("OK 9 "));
+  line->AddNumber(frame->ID);
+  line->Add(' ');
 
+  byte sensorType = GetSensorType(frame);
+  if (sensorType == 1) {
+    line->AddNumber(frame->NewBatteryFlag ? 129 : 1);
+    line->Add(' ');
+  }
+  else if (sensorType == 2) {
+    line->AddNumber(2 | frame->NewBatteryFlag ? 130 : 2);
+    line->Add(' ');
+  }
+  else {
+    return false;
+  }
+
+  // add temperature
+  uint16_t pTemp = frame->Temperature + 1000;
+  line->AddNumber((byte)(pTemp >> 8));
+  line->Add(' ');
+  line->AddNumber((byte)(pTemp));
+  line->Add(' ');
+
+  // bogus check temperature
+  if (frame->Temperature >= 600 || frame->Temperature <= -400)
+    return false;
+
+  // add humidity
+  byte hum = frame->Humidity;
+  if (frame->WeakBatteryFlag) {
+    hum |= 0x80;
+  }
+  line->AddNumber(hum);
+
+  return true;
+}
+
+// 1, 2 for the second channel of a TX25IT or 0 if the humidity is bogus
+byte LaCrosse::GetSensorType(struct Frame *frame) {
   // bogus check humidity + eval 2 channel TX25IT
   // TBD .. Dont understand the magic here!?
   if ((frame->Humidity >= 0 && frame->Humidity <= 99)
     || frame->Humidity == 106
     || (frame->Humidity >= 128 && frame->Humidity <= 227)
     || frame->Humidity == 234) {
-    pBuf += frame->NewBatteryFlag ? 129 : 1;
-    pBuf += ' ';
+    return 1;
   }
   else if (frame->Humidity == 125 || frame->Humidity == 253) {
-    pBuf += 2 | frame->NewBatteryFlag ? 130 : 2;
-    pBuf += ' ';
+    return 2;
   }
   else {
-    return "";
+    return 0;
   }
+}
 
-  // add temperature
-  uint16_t pTemp = (uint16_t)(frame->Temperature * 10 + 1000);
-  pBuf += (byte)(pTemp >> 8);
-  pBuf += ' ';
-  pBuf += (byte)(pTemp);
-  pBuf += ' ';
-
-  // bogus check temperature
-  if (frame->Temperature >= 60 || frame->Temperature <= -40)
-    return "";
+// Same checks as the text line, see RecordWriter.h for the layout
+bool LaCrosse::BuildBinaryRecord(struct Frame *frame, byte tag, RecordWriter *record) {
+  byte sensorType = GetSensorType(frame);
+  if (sensorType == 0 || frame->Temperature >= 600 || frame->Temperature <= -400) {
+    return false;
+  }
 
-  // add humidity
-  byte hum = frame->Humidity;
+  byte flags = 0;
+  if (frame->NewBatteryFlag) {
+    flags |= 1;
+  }
   if (frame->WeakBatteryFlag) {
-    hum |= 0x80;
+    flags |= 2;
+  }
+  if (sensorType == 2) {
+    flags |= 4;
   }
-  pBuf += hum;
 
-  return pBuf;
+  record->Add(tag);
+  record->Add(frame->ID);
+  record->Add(flags);
+  record->AddWord(frame->Temperature);
+  record->Add(frame->Humidity);
+
+  return true;
 }
 
 String LaCrosse::AnalyzeFrame(byte *data) {
@@ -175,67 +210,55 @@ String LaCrosse::AnalyzeFrame(byte *data) {
   struct Frame frame;
   DecodeFrame(data, &frame);
 
-  byte filter[5];
-  filter[0] = 0;
-  filter[1] = 0;
-  filter[2] = 0;
-  filter[3] = 0;
-  filter[4] = 0;
-
-  bool hideIt = false;
-  for (int f = 0; f < 5; f++) {
-    if (frame.ID == filter[f]) {
-      hideIt = true;
-      break;
-    }
-  }
+  // The same sensors as in the normal output (<p>,<mode>i)
+  bool hideIt = !IdFilter::IsAccepted(FrameDispatcher::ProtocolLaCrosse, data);
 
   if (!hideIt) {
     // Show the raw data bytes
-    result += "LaCrosse [";
+    result += F("LaCrosse [");
     for (int i = 0; i < FRAME_LENGTH; i++) {
       result += String(data[i], HEX);
-      result += " ";
+      result += F(" ");
     }
-    result += "]";
+    result += F("]");
 
     // Check CRC
     if (!frame.IsValid) {
-      result += " CRC:WRONG";
+      result += F(" CRC:WRONG");
     }
     else {
-      result += " CRC:OK";
+      result += F(" CRC:OK");
 
       // Start
-      result += " S:";
+      result += F(" S:");
       result += String(frame.Header, HEX);
 
       // Sensor ID
-      result += " ID:";
+      result += F(" ID:");
       result += String(frame.ID, HEX);
 
       // New battery flag
-      result += " NewBatt:";
+      result += F(" NewBatt:");
       result += String(frame.NewBatteryFlag, DEC);
 
       // Bit 12
-      result += " Bit12:";
+      result += F(" Bit12:");
       result += String(frame.Bit12, DEC);
 
       // Temperature
-      result += " Temp:";
-      result += frame.Temperature;
+      result += F(" Temp:");
+      result += frame.Temperature / 10.0;
 
       // Humidity
-      result += " Hum:";
+      result += F(" Hum:");
       result += frame.Humidity;
 
       // Weak battery flag
-      result += " WeakBatt:";
+      result += F(" WeakBatt:");
       result += String(frame.WeakBatteryFlag, DEC);
 
       // CRC
-      result += " CRC:";
+      result += F(" CRC:");
       result += String(frame.CRC, DEC);
     }
     
@@ -244,29 +267,40 @@ String LaCrosse::AnalyzeFrame(byte *data) {
   return result;
 }
 
-String LaCrosse::GetFhemDataString(byte *data) {
-  String fhemString = "";
+bool LaCrosse::GetFhemDataString(byte *data, LineWriter *line) {
+  bool result = false;
 
   if ((data[0] & 0xF0) >> 4 == 9) {
     struct Frame frame;
     DecodeFrame(data, &frame);
     if (frame.IsValid) {
-      fhemString = BuildFhemDataString(&frame);
+      result = BuildFhemDataString(&frame, line);
     }
   }
 
-  return fhemString;
+  return result;
+}
+
+bool LaCrosse::BuildRecord(const void *frame, RecordWriter *record) {
+  return BuildBinaryRecord((struct Frame *)frame, RECORD_LACROSSE, record);
+}
+
+bool LaCrosse::BuildLine(const void *frame, LineWriter *line) {
+  return BuildFhemDataString((struct Frame *)frame, line);
 }
 
 bool LaCrosse::TryHandleData(byte *data) {
-  String fhemString = GetFhemDataString(data);
+  bool result = false;
 
-  if (fhemString.length() > 0) {
-    Serial.println(fhemString);
+  if ((data[0] & 0xF0) >> 4 == 9) {
+    struct Frame frame;
+    DecodeFrame(data, &frame);
+    if (frame.IsValid) {
+      result = HandleFrame(&frame, BuildRecord, BuildLine);
+    }
   }
 
-  return fhemString.length() > 0;
-
+  return result;
 }
 
 
@@ -3,6 +3,8 @@
 
 #include "Arduino.h"
 #include "SensorBase.h"
+#include "LineWriter.h"
+#include "RecordWriter.h"
 
 
 class LaCrosse : public SensorBase {
@@ -12,7 +14,7 @@ public:
     byte  ID;
     bool  NewBatteryFlag;
     bool  Bit12;
-    float Temperature;
+    int   Temperature;    // 1/10 C
     bool  WeakBatteryFlag;
     byte  Humidity;
     byte  CRC;
@@ -26,12 +28,15 @@ public:
   static void DecodeFrame(byte *bytes, struct LaCrosse::Frame *frame);
   static String AnalyzeFrame(byte *data);
   static bool TryHandleData(byte *data);
-  static String GetFhemDataString(byte *data);
+  static bool GetFhemDataString(byte *data, LineWriter *line);
   static bool IsValidDataRate(unsigned long dataRate);
-  static String BuildFhemDataString(struct LaCrosse::Frame *frame);
+  static bool BuildFhemDataString(struct LaCrosse::Frame *frame, LineWriter *line);
+  static bool BuildBinaryRecord(struct LaCrosse::Frame *frame, byte tag, RecordWriter *record);
 
 protected:
-  
+  static byte GetSensorType(struct LaCrosse::Frame *frame);
+  static bool BuildRecord(const void *frame, RecordWriter *record);
+  static bool BuildLine(const void *frame, LineWriter *line);
 
 };
 
@@ -29,41 +29,79 @@
 #include <Wire.h>
 #include "InternalSensors.h"
 #include "CustomSensor.h"
+#include "FrameDispatcher.h"
+#include "RecordWriter.h"
+#include "SerialQueue.h"
+#include "HostLink.h"
+#include "SensorTable.h"
+#include "Aggregator.h"
+#include "IdFilter.h"
+#include "CommandReader.h"
+#include "Scheduler.h"
+#include "RatePlanner.h"
+#include "RadioConfig.h"
+#include "TransmitQueue.h"
 
 // --- Configuration ---------------------------------------------------------------------------------------------------
 #define RECEIVER_ENABLED       1                     // Set to 0 if you don't want to receive 
 #define USE_OLD_IDS            0                     // Set to 1 to use the old ID calcualtion
+#define RFM1_IRQ_PIN           2                     // nIRQ of RFM #1 (RFM12 only), RFM_NO_IRQ to poll the radio
+#define USE_HARDWARE_SPI       1                     // Set to 0 to bit-bang the bus of the RFMs (other pins than MOSI/MISO/SCK)
+#define RADIO_COUNT            2                     // RFMs on the board, see the radio table below
+#define ANALYZE_ENABLED        0                     // Set to 1 for the z command, its Strings need more heap than an ATmega328 has left
 
 // The following settings can also be set from FHEM
 #define ENABLE_ACTIVITY_LED    1         // <n>a     set to 0 if the blue LED bothers
-unsigned long DATA_RATE_S1   = 17241ul;  // <n>c     use one of the possible data rates (for transmit on RFM #1)
+                                         // <n>b     output format 0: "OK ..." text lines, 1: binary records (see RecordWriter.h)
+unsigned long DATA_RATE_S1   = 17241ul;  // <n>c     use one of the possible data rates (for transmit)
 bool DEBUG                   = 0;        // <n>d     set to 1 to see debug messages
+                                         // <r>,<n>e role of radio r 0: fixed rate, 1: toggling, 2: transmit only, 3: relay
 unsigned long INITIAL_FREQ   = 868300;   // <n>f     initial frequency in kHz (5 kHz steps, 860480 ... 879515) 
 int ALTITUDE_ABOVE_SEA_LEVEL = 0;        // <n>h     altituide above sea level
-byte TOGGLE_MODE_R1          = 3;        // <n>m     bits 1: 17.241 kbps, 2 : 9.579 kbps, 4 : 8.842 kbps (for RFM #1)
-byte TOGGLE_MODE_R2          = 3;        // <n>M     bits 1: 17.241 kbps, 2 : 9.579 kbps, 4 : 8.842 kbps (for RFM #2)
+                                         // <p>,<m>i ID filter of protocol p (1: LaCrosse, 2: TX22IT, 3: WS1080, 4: LevelSender,
+                                         //          5: EMT7110, 6: WT440XH, 7: TX38IT, 8: CustomSensor) 0: off, 1: drop the listed IDs,
+                                         //          2: only the listed IDs; <p>,1,<id>i adds an ID, <p>,0,<id>i removes it,
+                                         //          0i clears all filters, 1i shows them (stored in the EEPROM)
+                                         // <t,h,s>k report a sensor only on a change of t/10 C or h % or after s seconds
+                                         //          (0k: every frame, <s>k keeps the deltas, max. 1000 s)
+                                         // <n>m     bits 1: 17.241 kbps, 2 : 9.579 kbps, 4 : 8.842 kbps
+                                         //          8: predict the frames of the known sensors, toggle only in between
+                                         // <n>l     show the tasks of loop(): runs, longest run, latest start (1: reset them)
                                          // <n>o     set HF-parameter e.g. 50305o for RFM12 or 1,4o for RFM69
 byte PASS_PAYLOAD            = 0;        // <n>p     transmitted the payload on the serial port 1: all, 2: only undecoded data
-unsigned long DATA_RATE_R1   = 17241ul;  // <n>r     use one of the possible data rates (for RFM #1)
-unsigned long DATA_RATE_R2   = 9579ul;   // <n>R     use one of the possible data rates (for RFM #2)
-                                         // <id,..>s send the bytes to the address id
-uint16_t TOGGLE_INTERVAL_R1  = 0;        // <n>t     0=no toggle, else interval in seconds (for RFM #1)
-uint16_t TOGGLE_INTERVAL_R2  = 0;        // <n>T     0=no toggle, else interval in seconds (for RFM #2)
+                                         // <n>q     show the statistics (1: reset them afterwards)
+                                         // <n>r     use one of the possible data rates
+                                         // <id,..>s send the bytes to the address id (on the transmit radio, else on the last
+                                         //          radio found, radio 1 only on a board with one radio)
+                                         // <n>t     0=no toggle, else interval in seconds
+                                         // <n>u     baud rate to the host 0: 57600, 1: 115200, 2: 250000, 3: 500000, 4: 1000000
+                                         //          (send it again at the new rate within 2 s to keep it, it is stored then)
                                          // v        show version
+                                         // <n>w     one aggregated line (min/max/mean) per sensor every n seconds, 0: off
                                          // x        test command 
-bool RELAY                   = 0;        // <n>y     if 1 all received packets will be retransmitted  
+bool RELAY                   = 0;        // <n>y     if 1 all received packets will be retransmitted (like s)
 bool ANALYZE_FRAMES          = 0;        // <n>z     set to 1 to display analyzed frame data instead of the normal data
+                                         //          (only with ANALYZE_ENABLED, else it answers failed)
+                                         // f, m, r and t are for radio 1, F, M, R and T for radio 2 and <r>,<n>f etc. for radio r
+
+// Role, data rate, toggle interval and toggle mode of each radio, the first one is the primary
+RadioConfig radioConfigs[RADIO_COUNT] = {
+  RadioConfig(RADIO_ROLE_FIXED, 17241ul, 0, 3),
+  RadioConfig(RADIO_ROLE_FIXED, 9579ul,  0, 3)
+};
 
 
 // --- Variables -------------------------------------------------------------------------------------------------------
-unsigned long lastToggleR1 = 0;
-unsigned long lastToggleR2 = 0;
-byte commandData[32];
-byte commandDataPointer = 0;
-RFM rfm1(11, 12, 13, 10);
-RFM rfm2(11, 12, 13, 8);
+// SS of the radios, the primary one may have its nIRQ connected
+#if USE_HARDWARE_SPI
+HardwareSpi spis[RADIO_COUNT] = { HardwareSpi(10), HardwareSpi(8) };
+#else
+BitBangSpi spis[RADIO_COUNT] = { BitBangSpi(11, 12, 13, 10), BitBangSpi(11, 12, 13, 8) };
+#endif
+RFM radios[RADIO_COUNT] = { RFM(&spis[0], RFM1_IRQ_PIN), RFM(&spis[1]) };
 
 JeeLink jeeLink;
+HostLink hostLink;
 InternalSensors internalSensors;
 
 static unsigned long ConvertDataRate(unsigned long value) {
@@ -85,23 +123,36 @@ static unsigned long ConvertDataRate(unsigned long value) {
   return result;
 }
 
-static void HandleSerialPort(char c) {
-  static unsigned long value;
-  unsigned long dataRate = 0;
-
-  if (c == ',') {
-    commandData[commandDataPointer++] = value;
-    value = 0;
+// <n>x is for radio 1, <n>X for radio 2 and <r>,<n>x for radio r, -1 if
+// that radio is not there
+static int8_t GetRadioIndex(char c, byte *data, byte size) {
+  byte index = c >= 'a' ? 0 : 1;
+  if (size == 1) {
+    index = data[0] - 1;
   }
-  else if ('0' <= c && c <= '9') {
-    value = 10 * value + c - '0';
+  if (index >= RADIO_COUNT || !radios[index].IsConnected()) {
+    return -1;
   }
-  else if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z')) {
-    switch (c) {
+  return index;
+}
+
+// A complete command from the CommandReader, data holds the values before the
+// last one and has room for one more
+static void HandleCommand(char c, unsigned long value, byte *data, byte size) {
+  unsigned long dataRate = 0;
+  int8_t radio = GetRadioIndex(c, data, size);
+
+  // The replies go straight to Serial, so they must not overtake queued lines
+  SerialQueue::Flush();
+  switch (c) {
     case 'd':
       // DEBUG
       SetDebugMode(value);
       break;
+    case 'b':
+      // Output format
+      SetOutputFormat(value);
+      break;
     case 'h':
       // height
       internalSensors.SetAltitudeAboveSeaLevel(value);
@@ -117,16 +168,9 @@ static void HandleSerialPort(char c) {
     case 'r':
     case 'R':
       // Data rate
-      dataRate = ConvertDataRate(value);
-      if (c == 'r') {
-        DATA_RATE_R1 = dataRate;
-        rfm1.SetDataRate(DATA_RATE_R1);
-      }
-      else {
-        if (rfm2.IsConnected()) {
-          DATA_RATE_R2 = dataRate;
-          rfm2.SetDataRate(DATA_RATE_R2);
-        }
+      if (radio >= 0) {
+        radioConfigs[radio].DataRate = ConvertDataRate(value);
+        radios[radio].SetDataRate(radioConfigs[radio].DataRate);
       }
       break;
     case 'c':
@@ -134,50 +178,82 @@ static void HandleSerialPort(char c) {
       dataRate = ConvertDataRate(value);
       DATA_RATE_S1 = dataRate;
       break;
-    case 'm':
-      TOGGLE_MODE_R1 = value;
+    case 'e':
+      // Role of a radio
+      if (radio >= 0 && size == 1) {
+        SetRadioRole(radio, value);
+      }
+      break;
+    case 'i':
+      // Sensor ID filter
+      HandleCommandI(value, data, size);
+      break;
+    case 'k':
+      // Change-only reporting
+      HandleCommandK(value, data, size);
       break;
+    case 'l':
+      // Task statistics
+      HandleCommandL(value);
+      break;
+    case 'm':
     case 'M':
-      TOGGLE_MODE_R2 = value;
+      // The prediction needs the RatePlanner table
+      if (RATE_PLANNER_SIZE == 0 && (value & RATE_PLANNER_MODE)) {
+        Serial.println(F("[Predict:failed]"));
+        EndTextReply();
+      }
+      else if (radio >= 0) {
+        radioConfigs[radio].ToggleMode = value;
+      }
       break;
     case 'p':
       PASS_PAYLOAD = value;
       break;
-    case 't':
-      // Toggle data rate
-      TOGGLE_INTERVAL_R1 = value;
+    case 'q':
+      // Statistics
+      HandleCommandQ(value);
       break;
+    case 't':
     case 'T':
       // Toggle data rate
-      TOGGLE_INTERVAL_R2 = value;
+      if (radio >= 0) {
+        radioConfigs[radio].SetToggleInterval(value);
+      }
+      break;
+    case 'u':
+      // Baud rate of the host link
+      hostLink.Request(value);
       break;
     case 'v':
       // Version info
       HandleCommandV();
       break;
+    case 'w':
+      // Aggregation window
+      if (!Aggregator::Configure(value > AGGREGATOR_MAX_WINDOW ? AGGREGATOR_MAX_WINDOW : value)) {
+        Serial.println(F("[Aggregation:failed]"));
+        EndTextReply();
+      }
+      break;
 
     case 's':
       // Send
-      commandData[commandDataPointer] = value;
-      HandleCommandS(commandData, ++commandDataPointer);
-      commandDataPointer = 0;
+      data[size] = value;
+      HandleCommandS(data, size + 1);
       break;
 
     case 'o':
     case 'O':
       // Set HF parameter
-      commandData[commandDataPointer] = value;
-      HandleCommandO(c == 'O' ? 2 : 1, value, commandData, ++commandDataPointer);
-      commandDataPointer = 0;
+      data[size] = value;
+      HandleCommandO(c == 'O' ? 2 : 1, value, data, size + 1);
       break;
 
     case 'f':
-      rfm1.SetFrequency(value);
-      break;
-
     case 'F':
-      if (rfm2.IsConnected()) {
-        rfm2.SetFrequency(value);
+      if (radio >= 0) {
+        radios[radio].SetFrequency(value);
       }
       break;
 
@@ -186,23 +262,46 @@ static void HandleSerialPort(char c) {
       break;
 
     case 'z':
-      ANALYZE_FRAMES = value;
+      // The analysis builds Strings on the heap
+      if (!ANALYZE_ENABLED && value) {
+        Serial.println(F("[Analyze:failed]"));
+        EndTextReply();
+      }
+      else {
+        ANALYZE_FRAMES = value;
+      }
       break;
 
     default:
       HandleCommandV();
       #ifndef NOHELP
       Help::Show();
+      EndTextReply();
       #endif
       break;
-    }
-    value = 0;
   }
-  else if (' ' < c && c < 'A') {
-    HandleCommandV();
-    #ifndef NOHELP
-    Help::Show();
-    #endif
+}
+
+// The format record tells the host that the records start here, the zero
+// before it closes the text that was sent so far
+void SetOutputFormat(byte value) {
+  SensorBase::SetBinaryOutput(value == 1);
+
+  if (SensorBase::IsBinaryOutput()) {
+    Serial.write((byte)0);
+    byte buffer[3];
+    RecordWriter record(buffer, sizeof(buffer));
+    record.Add(RECORD_FORMAT);
+    record.Add(RECORD_FORMAT_VERSION);
+    record.Send();
+  }
+}
+
+// With binary output the text replies are closed with a zero as well, so
+// the host gets them as one chunk that is no record
+void EndTextReply() {
+  if (SensorBase::IsBinaryOutput()) {
+    Serial.write((byte)0);
   }
 }
 
@@ -210,50 +309,188 @@ void SetDebugMode(boolean mode) {
   DEBUG = mode;
   LevelSenderLib::SetDebugMode(mode);
   WT440XH::SetDebugMode(mode);
-  rfm1.SetDebugMode(mode);
-  rfm2.SetDebugMode(mode);
+  for (byte i = 0; i < RADIO_COUNT; i++) {
+    radios[i].SetDebugMode(mode);
+  }
 
 }
 
+// o is radio 1, O radio 2; the format follows the type of that radio
 void HandleCommandO(byte rfmNbr, unsigned long value, byte *data, byte size) {
+  if (rfmNbr == 0 || rfmNbr > RADIO_COUNT) {
+    return;
+  }
+  RFM *rfm = &radios[rfmNbr - 1];
+  if (!rfm->IsConnected()) {
+    return;
+  }
+
   // 50305o (is 0xC481) for RFM12 or 1,4o for RFM69
-  if (size == 1 && rfm1.GetRadioType() == RFM::RFM12B) {
-    if (rfmNbr == 1) {
-      rfm1.SetHFParameter(value);
-    }
-    else if (rfmNbr == 2) {
-      rfm2.SetHFParameter(value);
-    }
+  if (size == 1 && rfm->GetRadioType() == RFM::RFM12B) {
+    rfm->SetHFParameter(value);
   }
-  else if (size == 2 && rfm1.GetRadioType() == RFM::RFM69CW) {
-    if (rfmNbr == 1) {
-      rfm1.SetHFParameter(data[0], data[1]);
-    }
-    else if (rfmNbr == 2) {
-      rfm2.SetHFParameter(data[0], data[1]);
+  else if (size == 2 && rfm->GetRadioType() == RFM::RFM69CW) {
+    rfm->SetHFParameter(data[0], data[1]);
+  }
+}
+
+// The receiver of a radio that only sends is off
+void SetRadioRole(byte radio, byte role) {
+  if (role >= RADIO_ROLE_COUNT) {
+    return;
+  }
+  RadioConfig *config = &radioConfigs[radio];
+  config->Role = role;
+  if (config->IsReceiving()) {
+    radios[radio].SetDataRate(config->DataRate);
+  }
+  radios[radio].EnableReceiver(config->IsReceiving());
+}
+
+// The first radio with the role, -1 if there is none
+int8_t FindRadio(byte role) {
+  for (byte i = 0; i < RADIO_COUNT; i++) {
+    if (radioConfigs[i].Role == role && radios[i].IsConnected()) {
+      return i;
     }
   }
+  return -1;
+}
 
+// The RatePlanner only learns while a radio uses it
+bool IsPredicting() {
+  for (byte i = 0; i < RADIO_COUNT; i++) {
+    if (radioConfigs[i].IsPredicting() && radios[i].IsConnected()) {
+      return true;
+    }
+  }
+  return false;
+}
 
+// The radio with the role, else a transmit radio, else the last radio found,
+// so that radio 1 keeps receiving. Only a board with one radio sends on it.
+RFM *GetSendingRadio(byte role) {
+  int8_t radio = FindRadio(role);
+  if (radio < 0) {
+    radio = FindRadio(RADIO_ROLE_TRANSMIT);
+  }
+  for (int8_t i = RADIO_COUNT - 1; radio < 0 && i > 0; i--) {
+    if (radios[i].IsConnected()) {
+      radio = i;
+    }
+  }
+  return &radios[radio < 0 ? 0 : radio];
 }
 
 void HandleCommandS(byte *data, byte size) {
-  rfm1.EnableReceiver(false);
-
   struct CustomSensor::Frame frame;
   frame.ID = data[0];
   frame.NbrOfDataBytes = size -1;
+  frame.Data = &data[1];
 
-  for (int i = 0; i < frame.NbrOfDataBytes; i++) {
-    frame.Data[i] = data[i+1];
+  if (!CustomSensor::SendFrame(&frame, GetSendingRadio(RADIO_ROLE_TRANSMIT), DATA_RATE_S1) && DEBUG) {
+    Serial.println(F("Transmit queue full"));
   }
+}
 
-  CustomSensor::SendFrame(&frame, &rfm1, DATA_RATE_S1);
 
+void HandleCommandK(unsigned long maxSilence, byte *deltas, byte size) {
+  if (size >= 2) {
+    SensorTable::SetDeltas(deltas[0], deltas[1]);
+  }
+  if (!SensorTable::Configure(maxSilence > SENSOR_TABLE_MAX_SILENCE ? SENSOR_TABLE_MAX_SILENCE : maxSilence)) {
+    Serial.println(F("[Sensors:failed]"));
+    EndTextReply();
+  }
+}
 
-  rfm1.EnableReceiver(true);
+// <n>i, <p>,<mode>i or <p>,<n>,<id>i, the ID can be 16 bit, so it comes last
+void HandleCommandI(unsigned long value, byte *data, byte size) {
+  bool result = true;
+  if (size == 0) {
+    if (value == 0) {
+      IdFilter::Clear();
+    }
+  }
+  else if (size == 1) {
+    result = IdFilter::SetMode(data[0], value);
+  }
+  else if (data[1] == 1) {
+    result = IdFilter::Add(data[0], value);
+  }
+  else {
+    result = IdFilter::Remove(data[0], value);
+  }
+
+  if (!result) {
+    Serial.println(F("[Filter:failed]"));
+  }
+  IdFilter::Show();
+  EndTextReply();
+}
+
+void HandleCommandL(byte value) {
+  Scheduler::ShowStatistics();
+  if (value == 1) {
+    Scheduler::ResetStatistics();
+  }
+  EndTextReply();
 }
 
+void HandleCommandQ(byte value) {
+  FrameDispatcher::ShowStatistics();
+
+  Serial.print(F("[Lost"));
+  for (byte i = 0; i < RADIO_COUNT; i++) {
+    if (radios[i].IsConnected()) {
+      Serial.print(F(" R"));
+      Serial.print(i + 1);
+      Serial.print(':');
+      Serial.print(radios[i].GetLostFrames());
+    }
+  }
+  Serial.println(']');
+
+  // How long each radio was receiving, transmitting and idle
+  Serial.print(F("[Radio ms"));
+  for (byte i = 0; i < RADIO_COUNT; i++) {
+    if (radios[i].IsConnected()) {
+      Serial.print(F(" R"));
+      Serial.print(i + 1);
+      Serial.print(F(" rx:"));
+      Serial.print(radios[i].GetModeMillis(RFM::Receiving));
+      Serial.print(F(" tx:"));
+      Serial.print(radios[i].GetModeMillis(RFM::Transmitting));
+      Serial.print(F(" idle:"));
+      Serial.print(radios[i].GetModeMillis(RFM::Idle));
+    }
+  }
+  Serial.println(']');
+  SerialQueue::ShowStatistics();
+  TransmitQueue::ShowStatistics();
+  SensorTable::ShowStatistics();
+  Aggregator::ShowStatistics();
+  IdFilter::ShowStatistics();
+  CommandReader::ShowStatistics();
+  RatePlanner::ShowStatistics();
+
+  if (value == 1) {
+    FrameDispatcher::ResetStatistics();
+    for (byte i = 0; i < RADIO_COUNT; i++) {
+      radios[i].ResetLostFrames();
+      radios[i].ResetModeMillis();
+    }
+    SerialQueue::ResetStatistics();
+    TransmitQueue::ResetStatistics();
+    SensorTable::ResetStatistics();
+    Aggregator::ResetStatistics();
+    IdFilter::ResetStatistics();
+    CommandReader::ResetStatistics();
+    RatePlanner::ResetStatistics();
+  }
+
+  EndTextReply();
+}
 
 // This function is for testing 
 void HandleCommandX(byte value) {
@@ -278,63 +515,104 @@ void HandleCommandX(byte value) {
 }
 
 void HandleCommandV() {
-  Serial.print("\n[");
+  Serial.print(F("\n["));
   Serial.print(PROGNAME);
   Serial.print('.');
   Serial.print(PROGVERS);
 
-  Serial.print(" (");
-  Serial.print(rfm1.GetRadioName());
-
-  Serial.print(" f:");
-  Serial.print(rfm1.GetFrequency());
-  
-  if (TOGGLE_INTERVAL_R1) {
-    Serial.print(" t:");
-    Serial.print(TOGGLE_INTERVAL_R1);
-    Serial.print("~");
-    Serial.print(TOGGLE_MODE_R1);
-  }
-  else {
-    Serial.print(" r:");
-    Serial.print(rfm1.GetDataRate());
-    
-  }
-  Serial.print(")");
-
-  if(rfm2.IsConnected()) {
-    Serial.print(" + (");
-    Serial.print(rfm2.GetRadioName());
-    Serial.print(" f:");
-    Serial.print(rfm2.GetFrequency());
-    if (TOGGLE_INTERVAL_R2) {
-      Serial.print(" t:");
-      Serial.print(TOGGLE_INTERVAL_R2);
-      Serial.print("~");
-      Serial.print(TOGGLE_MODE_R2);
+  // Radio 1 is always shown, the others when they are there
+  for (byte i = 0; i < RADIO_COUNT; i++) {
+    RadioConfig *config = &radioConfigs[i];
+    if (i > 0) {
+      if (!radios[i].IsConnected()) {
+        continue;
+      }
+      Serial.print(F(" +"));
+    }
+    Serial.print(F(" ("));
+    Serial.print(radios[i].GetRadioName());
+    Serial.print(F(" f:"));
+    Serial.print(radios[i].GetFrequency());
+
+    if (!config->IsReceiving()) {
+      Serial.print(F(" e:"));
+      Serial.print(config->Role);
+    }
+    else if (config->IsToggling()) {
+      Serial.print(F(" t:"));
+      Serial.print(config->ToggleInterval);
+      Serial.print(F("~"));
+      Serial.print(config->ToggleMode);
     }
     else {
-      Serial.print(" r:");
-      Serial.print(rfm2.GetDataRate());
-
+      Serial.print(F(" r:"));
+      Serial.print(radios[i].GetDataRate());
     }
-    Serial.print(")");
+    Serial.print(F(")"));
   }
 
   if (internalSensors.HasBMP180()) {
-    Serial.print(" + BMP180");
+    Serial.print(F(" + BMP180"));
   }
 
+  Serial.print(F(" u:"));
+  Serial.print(hostLink.GetBaudRate());
+
+  // Commands the opt-in tables and the analysis would take, left out of this build
+  #if SENSOR_TABLE_SIZE == 0
+  Serial.print(F(" -k"));
+  #endif
+  #if AGGREGATOR_SIZE == 0
+  Serial.print(F(" -w"));
+  #endif
+  #if RATE_PLANNER_SIZE == 0
+  Serial.print(F(" -m8"));
+  #endif
+  #if !ANALYZE_ENABLED
+  Serial.print(F(" -z"));
+  #endif
+
   Serial.println(']');
+  EndTextReply();
 }
 
-void HandleReceivedData(RFM *rfm) {
-  rfm->EnableReceiver(false);
+void SendPayload(byte *payload) {
+  if (SensorBase::IsBinaryOutput()) {
+    byte buffer[PAYLOADSIZE + 2];
+    RecordWriter record(buffer, sizeof(buffer));
+    record.Add(RECORD_RAW);
+    for (int i = 0; i < PAYLOADSIZE; i++) {
+      record.Add(payload[i]);
+    }
+    record.Send();
+  }
+  else {
+    // Straight into the SerialQueue, counted first like in SensorBase::HandleFrame()
+    LineWriter counter(false);
+    AddPayload(payload, &counter);
+    if (SerialQueue::Reserve(counter.GetLength() + 2)) {
+      LineWriter line(true);
+      AddPayload(payload, &line);
+      SerialQueue::Put('\r');
+      SerialQueue::Put('\n');
+      SerialQueue::Handle();
+    }
+  }
+}
 
-  byte payload[PAYLOADSIZE];
-  rfm->GetPayload(payload);
+void AddPayload(byte *payload, LineWriter *line) {
+  for (int i = 0; i < PAYLOADSIZE; i++) {
+    line->AddHex(payload[i]);
+    line->Add(' ');
+  }
+}
 
-  if (ANALYZE_FRAMES) {
+void HandleReceivedData(RFM *rfm) {
+  // The radio keeps receiving into its ring while this frame is handled
+  FrameRing::Entry *frame = rfm->GetFrame();
+  byte *payload = frame->Payload;
+
+  if (ANALYZE_ENABLED && ANALYZE_FRAMES) {
     ////WS1080::AnalyzeFrame(payload);
     ////TX22IT::AnalyzeFrame(payload);
     LaCrosse::AnalyzeFrame(payload);
@@ -346,167 +624,142 @@ void HandleReceivedData(RFM *rfm) {
   }
   else if (PASS_PAYLOAD == 1) {
     jeeLink.Blink(1);
-    for (int i = 0; i < PAYLOADSIZE; i++) {
-      Serial.print(payload[i], HEX);
-      Serial.print(" ");
-    }
-    Serial.println();
+    SendPayload(payload);
   }
   else {
     jeeLink.Blink(1);
 
     if (DEBUG) {
-      Serial.print("\nEnd receiving, HEX raw data: ");
+      Serial.print(F("\nEnd receiving, HEX raw data: "));
       for (int i = 0; i < 16; i++) {
         Serial.print(payload[i], HEX);
-        Serial.print(" ");
+        Serial.print(F(" "));
       }
       Serial.println();
     }
 
-    byte frameLength = 0;
-
-    // Try LaCrosse like TX29DTH
-    if (LaCrosse::IsValidDataRate(rfm->GetDataRate()) && LaCrosse::TryHandleData(payload)) {
-      frameLength = LaCrosse::FRAME_LENGTH;
+    // Classify the frame and let the matching decoder handle it
+    byte frameLength = FrameDispatcher::TryHandleData(payload, frame->DataRate);
+    if (frameLength == 0 && PASS_PAYLOAD == 2) {
+      SendPayload(payload);
     }
-
-    // Try TX22IT (WS 1600)
-    else if (TX22IT::IsValidDataRate(rfm->GetDataRate()) && TX22IT::TryHandleData(payload)) {
-      frameLength = TX22IT::GetFrameLength(payload);
+    else if (frameLength > 0 && IsPredicting()) {
+      RatePlanner::Learn(payload, frame->DataRate, frame->Time);
     }
 
-    // Try WS 1080
-    else if (WS1080::IsValidDataRate(rfm->GetDataRate()) && WS1080::TryHandleData(payload)) {
-      frameLength = WS1080::FRAME_LENGTH;
-    }
 
-    // Try LevelSender
-    else if (LevelSenderLib::IsValidDataRate(rfm->GetDataRate()) && LevelSenderLib::TryHandleData(payload)) {
-      frameLength = LevelSenderLib::FRAME_LENGTH;
+    // A relay radio sends every frame again at the rate it came with, 64 ms
+    // later; without one <1>y does it on the radio that s would take
+    if ((RELAY || FindRadio(RADIO_ROLE_RELAY) >= 0) && frameLength > 0) {
+      if (TransmitQueue::Add(GetSendingRadio(RADIO_ROLE_RELAY), payload, frameLength, frame->DataRate, 64) && DEBUG) {
+        Serial.println(F("Relayed"));
+      }
     }
 
-    // Try EMT7110
-    else if (EMT7110::IsValidDataRate(rfm->GetDataRate()) && EMT7110::TryHandleData(payload)) {
-      frameLength = EMT7110::FRAME_LENGTH;
-    }
+  }
+  rfm->ReleaseFrame();
 
-    // Try WT440XH
-    else if (WT440XH::IsValidDataRate(rfm->GetDataRate()) && WT440XH::TryHandleData(payload)) {
-      frameLength = WT440XH::FRAME_LENGTH;
-    }
+  // Nobody drained the FIFO of a polled RFM12 meanwhile, so what it holds now
+  // is broken. Restarting the sync is enough, the receiver stays on.
+  if (rfm->GetRadioType() == RFM::RFM12B && !rfm->IsInterruptDriven()) {
+    rfm->RestartReceiver();
+  }
+}
 
-    // Try TX38IT
-    else if (TX38IT::IsValidDataRate(rfm->GetDataRate()) && TX38IT::TryHandleData(payload)) {
-      frameLength = TX38IT::FRAME_LENGTH;
-    }
-    // Try CustomSensor
-    else if (CustomSensor::IsValidDataRate(rfm->GetDataRate()) && CustomSensor::TryHandleData(payload)) {
-      frameLength = CustomSensor::GetFrameLength(payload);
-    }
-    else if (PASS_PAYLOAD == 2) {
-      for (int i = 0; i < PAYLOADSIZE; i++) {
-        Serial.print(payload[i], HEX);
-        Serial.print(" ");
+// --- Tasks of loop() ------------------------------------------------------------------------------------------------
+
+// Handle the data reception of the radios that receive, not of one that is
+// sending for the transmit queue
+static void ReceiveRadios() {
+  for (byte i = 0; i < RADIO_COUNT; i++) {
+    if (radioConfigs[i].IsReceiving() && radios[i].IsConnected() && !TransmitQueue::IsSending(&radios[i])) {
+      radios[i].Receive();
+      if (radios[i].PayloadIsReady()) {
+        HandleReceivedData(&radios[i]);
       }
-      Serial.println();
     }
+  }
+}
 
+// Handle the commands from the serial port
+static void ReadCommands() {
+  CommandReader::Handle(HandleCommand);
+}
 
-    if (RELAY && frameLength > 0) {
-      delay(64);
-      rfm->SendArray(payload, frameLength);
-      if (DEBUG) { Serial.println("Relayed"); }
-    }
+// Pass the queued output on to the UART, as much as it takes
+static void SendOutput() {
+  SerialQueue::Handle();
+}
 
-  }
-  rfm->EnableReceiver(true);
+// Periodically send own sensor data
+static void HandleInternalSensors() {
+  internalSensors.TryHandleData();
 }
 
-void HandleDataRateToggle(RFM *rfm, unsigned long *lastToggle, unsigned long *dataRate, uint16_t interval, byte toggleMode) {
-  if (interval > 0) {
-    // After about 50 days millis() will overflow to zero 
-    if (millis() < *lastToggle) {
-      *lastToggle = 0;
-    }
+// Switch the activity LED
+static void HandleLED() {
+  jeeLink.Handle();
+}
 
-    if (millis() > *lastToggle + interval * 1000) {
-      // Bits 1: 17.241 kbps, 2 : 9.579 kbps, 4 : 8.842 kbps
+// Fall back to 57600 if a new baud rate is not confirmed
+static void HandleHostLink() {
+  hostLink.Handle();
+}
 
-      if (*dataRate == 8842ul) {
-        if (toggleMode & 2) {
-          *dataRate = 9579ul;
-        }
-        else if (toggleMode & 1) {
-          *dataRate = 17241ul;
-        }
-      }
-      else if (*dataRate == 9579ul) {
-        if (toggleMode & 1) {
-          *dataRate = 17241ul;
-        }
-        else if (toggleMode & 4) {
-          *dataRate = 8842ul;
-        }
-      }
-      else if (*dataRate == 17241ul) {
-        if (toggleMode & 4) {
-          *dataRate = 8842ul;
-        }
-        else if (toggleMode & 2) {
-          *dataRate = 9579ul;
-        }
-      }
+// Keep the age of quiet sensors in the change-only reporting
+static void HandleSensorTable() {
+  SensorTable::Handle();
+}
 
-      rfm->SetDataRate(*dataRate);
-      *lastToggle = millis();
+// Send the aggregated lines of sensors that went quiet
+static void HandleAggregator() {
+  Aggregator::Handle();
+}
 
-    }
-  }
+// Start and finish the frames to send
+static void HandleTransmitQueue() {
+  TransmitQueue::Handle();
 }
 
-// **********************************************************************
-void loop(void) {
-  // Handle the commands from the serial port
-  // ----------------------------------------
-  if (Serial.available()) {
-    HandleSerialPort(Serial.read());
+// Toggle the data rate of the radios that toggle, a sending one keeps its
+// rate until the frame is out
+static void HandleDataRates() {
+  for (byte i = 0; i < RADIO_COUNT; i++) {
+    if (radios[i].IsConnected() && !TransmitQueue::IsSending(&radios[i]) && radioConfigs[i].UpdateDataRate(millis())) {
+      radios[i].SetDataRate(radioConfigs[i].DataRate);
+    }
   }
+}
 
-  // Periodically send own sensor data
-  // ---------------------------------
-  internalSensors.TryHandleData();
-
-  // Handle the data reception
-  // -------------------------
+// The radios run in every pass, the others by priority and deadline
+static void AddTasks() {
   if (RECEIVER_ENABLED) {
-    rfm1.Receive();
-    if (rfm1.PayloadIsReady()) {
-      HandleReceivedData(&rfm1);
-    }
-    
-    if(rfm2.IsConnected()) {
-      rfm2.Receive();
-      if (rfm2.PayloadIsReady()) {
-        HandleReceivedData(&rfm2);
-      }
-    }
-    
+    Scheduler::Add(F("Radios"), ReceiveRadios, 0, 0, TASK_PRIORITY_RADIO);
   }
- 
-  // Handle the data rate
-  // --------------------
-  HandleDataRateToggle(&rfm1, &lastToggleR1, &DATA_RATE_R1, TOGGLE_INTERVAL_R1, TOGGLE_MODE_R1);
-  HandleDataRateToggle(&rfm2, &lastToggleR2, &DATA_RATE_R2, TOGGLE_INTERVAL_R2, TOGGLE_MODE_R2);
+  //             Name            Function               Period Deadline Priority (ms)
+  Scheduler::Add(F("Serial"),    SendOutput,            1,     1,       1);
+  Scheduler::Add(F("Commands"),  ReadCommands,          1,     5,       1);
+  Scheduler::Add(F("Transmit"),  HandleTransmitQueue,   1,     2,       1);
+  Scheduler::Add(F("DataRate"),  HandleDataRates,       10,    10,      2);
+  Scheduler::Add(F("HostLink"),  HandleHostLink,        100,   500,     2);
+  Scheduler::Add(F("LED"),       HandleLED,             10,    20,      3);
+  Scheduler::Add(F("BMP180"),    HandleInternalSensors, 5,     20,      3);
+  Scheduler::Add(F("Aggregate"), HandleAggregator,      10,    100,     3);
+  Scheduler::Add(F("Table"),     HandleSensorTable,     1000,  1000,    3);
+}
 
+// **********************************************************************
+void loop(void) {
+  Scheduler::Run();
 }
 
 
 void setup(void) {
-  Serial.begin(57600);
+  hostLink.Begin();
+  IdFilter::Begin();
   delay(200);
   if (DEBUG) {
-    Serial.println("*** LaCrosse weather station wireless receiver for IT+ sensors ***");
+    Serial.println(F("*** LaCrosse weather station wireless receiver for IT+ sensors ***"));
   }
 
   SetDebugMode(DEBUG);
@@ -518,27 +771,25 @@ void setup(void) {
   internalSensors.SetAltitudeAboveSeaLevel(ALTITUDE_ABOVE_SEA_LEVEL);
 
   jeeLink.EnableLED(ENABLE_ACTIVITY_LED);
-  lastToggleR1 = millis();
 
-  rfm1.Begin(true);
-  rfm1.InitializeLaCrosse();
-  rfm1.SetFrequency(INITIAL_FREQ);
-  rfm1.SetDataRate(DATA_RATE_R1);
-  rfm1.EnableReceiver(true);
-  
-  rfm2.Begin(false);
-  if(rfm2.IsConnected()) {
-    rfm2.InitializeLaCrosse();
-    rfm2.SetFrequency(INITIAL_FREQ);
-    rfm2.SetDataRate(DATA_RATE_R2);
-    rfm2.EnableReceiver(true);
+  // The primary radio is taken to be there, the others only if they are found
+  for (byte i = 0; i < RADIO_COUNT; i++) {
+    radios[i].Begin(i + 1);
+    if (radios[i].IsConnected()) {
+      radios[i].InitializeLaCrosse();
+      radios[i].SetFrequency(INITIAL_FREQ);
+      radios[i].SetDataRate(radioConfigs[i].DataRate);
+      radios[i].EnableReceiver(radioConfigs[i].IsReceiving());
+    }
   }
   
   
   if (DEBUG) {
-    Serial.println("Radio setup complete. Starting to receive messages");
+    Serial.println(F("Radio setup complete. Starting to receive messages"));
   }
 
+  AddTasks();
+
   // FHEM needs this information
   delay(1000);
   HandleCommandV();
@@ -32,7 +32,7 @@ void LevelSenderLib::DecodeFrame(byte *data, struct Frame *frame){
 
   frame->CRC = data[5];
   if (frame->CRC != CalculateCRC(data)) {
-    if (m_debug) { Serial.println("## CRC FAIL ##"); }
+    if (m_debug) { Serial.println(F("## CRC FAIL ##")); }
     frame->IsValid = false;
   }
 
@@ -40,44 +40,43 @@ void LevelSenderLib::DecodeFrame(byte *data, struct Frame *frame){
 
   frame->Header = (data[0] & 0xF0) >> 4;
   if (frame->Header != 11) {
-    if (m_debug) { Serial.println("No valid start"); }
+    if (m_debug) { Serial.println(F("No valid start")); }
     frame->IsValid = false;
   }
 
   frame->Level = ((data[1] & 0xF0) >> 4) * 100;
   frame->Level += (data[1] & 0x0F) * 10;
   frame->Level += ((data[2] & 0xF0) >> 4);
-  frame->Level *= 0.5;
 
-  frame->Temperature = (data[2] & 0xF) * 10;
-  frame->Temperature += ((data[3] & 0xF0) >> 4);
-  frame->Temperature += (data[3] & 0xF) * 0.1;
-  frame->Temperature -= 40;
+  frame->Temperature = (data[2] & 0xF) * 100;
+  frame->Temperature += ((data[3] & 0xF0) >> 4) * 10;
+  frame->Temperature += (data[3] & 0xF);
+  frame->Temperature -= 400;
 
-  frame->Voltage = (data[4] & 0xF0) >> 4;
-  frame->Voltage += (data[4] & 0x0F) * 0.1;
+  frame->Voltage = ((data[4] & 0xF0) >> 4) * 10;
+  frame->Voltage += (data[4] & 0x0F);
 
 
   // Check if the data can be valid
-  if (frame->Temperature < -40.0 || frame->Temperature > 60.0) {
+  if (frame->Temperature < -400 || frame->Temperature > 600) {
     frame->IsValid = false;
     if (m_debug) {
-      Serial.print("No valid Temperature: ");
-      Serial.println(frame->Temperature);
+      Serial.print(F("No valid Temperature: "));
+      Serial.println(frame->Temperature / 10.0);
     }
   }
-  if (frame->Level < 2.0 || frame->Level > 300) {
+  if (frame->Level < 4 || frame->Level > 600) {
     frame->IsValid = false;
     if (m_debug) {
-      Serial.print("No valid Level: ");
-      Serial.println(frame->Level);
+      Serial.print(F("No valid Level: "));
+      Serial.println(frame->Level / 2.0);
     }
   }
-  if (frame->Voltage < 2.0 || frame->Voltage > 13.0) {
+  if (frame->Voltage < 20 || frame->Voltage > 130) {
     frame->IsValid = false;
     if (m_debug) {
-      Serial.print("No valid Voltage: ");
-      Serial.println(frame->Voltage);
+      Serial.print(F("No valid Voltage: "));
+      Serial.println(frame->Voltage / 10.0);
     }
   }
 }
@@ -91,20 +90,19 @@ void LevelSenderLib::EncodeFrame(struct Frame *frame, byte *bytes) {
   bytes[0] |= frame->ID;
 
   // Level
-  float levelSteps = frame->Level / 0.5;
-  bytes[1] |= ((int)(levelSteps / 100)) << 4;
-  bytes[1] |= ((int)levelSteps % 100) / 10;
-  bytes[2] |= ((int)((int)(levelSteps * 100) % 100)) << 4;
+  bytes[1] |= (frame->Level / 100) << 4;
+  bytes[1] |= frame->Level / 10 % 10;
+  bytes[2] |= (frame->Level % 10) << 4;
 
   // Temperature
-  float temp = frame->Temperature + 40.0;
-  bytes[2] |= (int)(temp / 10);
-  bytes[3] |= ((int)temp % 10) << 4;
-  bytes[3] |= (int)((int)(temp * 10) % 10);
+  int temp = frame->Temperature + 400;
+  bytes[2] |= temp / 100;
+  bytes[3] |= (temp / 10 % 10) << 4;
+  bytes[3] |= temp % 10;
 
   // Voltage
-  bytes[4] |= ((int)frame->Voltage % 10) << 4;
-  bytes[4] |= (int)((int)(frame->Voltage * 10) % 10);
+  bytes[4] |= (frame->Voltage / 10 % 10) << 4;
+  bytes[4] |= frame->Voltage % 10;
 
   // CRC
   bytes[FRAME_LENGTH - 1] = CalculateCRC(bytes);
@@ -116,42 +114,42 @@ String LevelSenderLib::AnalyzeFrame(byte *data) {
   DecodeFrame(data, &frame);
 
   // Show the raw data bytes
-  result += "LevelSender [";
+  result += F("LevelSender [");
   for (int i = 0; i < FRAME_LENGTH; i++) {
     result += String(data[i], HEX);
-    result += " ";
+    result += F(" ");
   }
-  result += "]";
+  result += F("]");
 
   // Check CRC
   if (!frame.IsValid) {
-    result += " CRC:WRONG";
+    result += F(" CRC:WRONG");
   }
   else {
-    result += " CRC:OK";
+    result += F(" CRC:OK");
 
     // Start
-    result += " S:";
+    result += F(" S:");
     result += String(frame.Header, HEX);
 
     // Sensor ID
-    result += " ID:";
+    result += F(" ID:");
     result += String(frame.ID, HEX);
 
     // Level
-    result += " Level:";
-    result += frame.Level;
+    result += F(" Level:");
+    result += frame.Level / 2.0;
 
     // Temperature
-    result += " Temp:";
-    result += frame.Temperature;
+    result += F(" Temp:");
+    result += frame.Temperature / 10.0;
 
     // Voltage
-    result += " Volt:";
-    result += frame.Voltage;
+    result += F(" Volt:");
+    result += frame.Voltage / 10.0;
 
     // CRC
-    result += " CRC:";
+    result += F(" CRC:");
     result += String(frame.CRC, HEX);
   }
 
@@ -164,7 +162,7 @@ byte LevelSenderLib::CalculateCRC(byte data[]) {
 }
 
 
-String LevelSenderLib::BuildFhemDataString(struct Frame *frame) {
+bool LevelSenderLib::BuildFhemDataString(struct Frame *frame, LineWriter *line) {
   // Format
   // 
   // OK LS 1  0   5   100 4   191 60      =  38,0cm    21,5C   6,0V
@@ -181,51 +179,72 @@ String LevelSenderLib::BuildFhemDataString(struct Frame *frame) {
   // |   `----------------------------- fix "11"
   // `--------------------------------- fix "LS"
 
-  String result;
-  result += "OK LS ";
-  result += frame->ID;
-  result += " 0 ";
+  line->Add(F("OK LS "));
+  line->AddNumber(frame->ID);
+  line->Add(F(" 0 "));
 
   // Level
-  int level = (int)(frame->Level * 10 + 1000);
-  result += (byte)(level >> 8);
-  result += " ";
-  result += (byte)(level);
-  result += " ";
+  int level = frame->Level * 5 + 1000;
+  line->AddNumber((byte)(level >> 8));
+  line->Add(' ');
+  line->AddNumber((byte)(level));
+  line->Add(' ');
 
   // Temperature
-  int temp = (int)(frame->Temperature * 10 + 1000);
-  result += (byte)(temp >> 8);
-  result += " ";
-  result += (byte)(temp);
-  result += " ";
+  int temp = frame->Temperature + 1000;
+  line->AddNumber((byte)(temp >> 8));
+  line->Add(' ');
+  line->AddNumber((byte)(temp));
+  line->Add(' ');
 
   // Voltage
-  result += (int)(frame->Voltage * 10);
+  line->AddNumber(frame->Voltage);
 
-  return result;
+  return true;
 }
 
-String LevelSenderLib::GetFhemDataString(byte *data) {
-  String fhemString = "";
+// See RecordWriter.h for the layout
+bool LevelSenderLib::BuildBinaryRecord(struct Frame *frame, RecordWriter *record) {
+  record->Add(RECORD_LEVELSENDER);
+  record->Add(frame->ID);
+  record->Add(0);
+  record->AddWord(frame->Level);
+  record->AddWord(frame->Temperature);
+  record->Add(frame->Voltage);
+
+  return true;
+}
+
+bool LevelSenderLib::GetFhemDataString(byte *data, LineWriter *line) {
+  bool result = false;
 
   struct Frame frame;
   DecodeFrame(data, &frame);
   if (frame.IsValid) {
-    fhemString = BuildFhemDataString(&frame);
+    result = BuildFhemDataString(&frame, line);
   }
 
-  return fhemString;
+  return result;
+}
+
+bool LevelSenderLib::BuildRecord(const void *frame, RecordWriter *record) {
+  return BuildBinaryRecord((struct Frame *)frame, record);
+}
+
+bool LevelSenderLib::BuildLine(const void *frame, LineWriter *line) {
+  return BuildFhemDataString((struct Frame *)frame, line);
 }
 
 bool LevelSenderLib::TryHandleData(byte *data) {
-  String fhemString = GetFhemDataString(data);
+  bool result = false;
 
-  if (fhemString.length() > 0) {
-    Serial.println(fhemString);
+  struct Frame frame;
+  DecodeFrame(data, &frame);
+  if (frame.IsValid) {
+    result = HandleFrame(&frame, BuildRecord, BuildLine);
   }
 
-  return fhemString.length() > 0;
+  return result;
 }
 
 bool LevelSenderLib::IsValidDataRate(unsigned long dataRate) {
@@ -3,15 +3,17 @@
 
 #include "Arduino.h"
 #include "SensorBase.h"
+#include "LineWriter.h"
+#include "RecordWriter.h"
 
 class LevelSenderLib : public SensorBase {
 public:
   struct Frame {
     byte  Header;
     byte  ID;
-    float Level;
-    float Temperature;
-    float Voltage;
+    int   Level;          // 0.5 cm steps
+    int   Temperature;    // 1/10 C
+    byte  Voltage;        // 1/10 V
     byte  CRC;
     bool  IsValid;
   };
@@ -21,12 +23,15 @@ public:
   static void DecodeFrame(byte *data, struct Frame *frame);
   static String AnalyzeFrame(byte *data);
   static bool TryHandleData(byte *data);
-  static String GetFhemDataString(byte *data);
+  static bool GetFhemDataString(byte *data, LineWriter *line);
   static bool IsValidDataRate(unsigned long dataRate);
   
 
 protected:
-  static String BuildFhemDataString(struct LevelSenderLib::Frame *frame);
+  static bool BuildFhemDataString(struct LevelSenderLib::Frame *frame, LineWriter *line);
+  static bool BuildBinaryRecord(struct LevelSenderLib::Frame *frame, RecordWriter *record);
+  static bool BuildRecord(const void *frame, RecordWriter *record);
+  static bool BuildLine(const void *frame, LineWriter *line);
 
 };
 
@@ -0,0 +1,81 @@
+#include "LineWriter.h"
+#include "SerialQueue.h"
+
+LineWriter::LineWriter(char *buffer, byte size) {
+  m_buffer = buffer;
+  m_size = size;
+  m_queue = false;
+  Clear();
+}
+
+LineWriter::LineWriter(bool queue) {
+  m_buffer = NULL;
+  m_size = 255;
+  m_queue = queue;
+  Clear();
+}
+
+void LineWriter::Clear() {
+  m_length = 0;
+  m_overflow = false;
+  if (m_buffer != NULL) {
+    m_buffer[0] = 0;
+  }
+}
+
+void LineWriter::Add(const char *text) {
+  while (*text) {
+    Add(*text++);
+  }
+}
+
+void LineWriter::Add(const __FlashStringHelper *text) {
+  PGM_P p = reinterpret_cast<PGM_P>(text);
+  char c;
+  while ((c = pgm_read_byte(p++)) != 0) {
+    Add(c);
+  }
+}
+
+void LineWriter::Add(char c) {
+  if (m_length < m_size - 1) {
+    if (m_buffer != NULL) {
+      m_buffer[m_length] = c;
+      m_buffer[m_length + 1] = 0;
+    }
+    else if (m_queue) {
+      SerialQueue::Put(c);
+    }
+    m_length++;
+  }
+  else {
+    m_overflow = true;
+  }
+}
+
+void LineWriter::AddNumber(int value) {
+  char digits[7];
+  itoa(value, digits, 10);
+  Add(digits);
+}
+
+// Like Serial.print(value, HEX): upper case, no leading zero
+void LineWriter::AddHex(byte value) {
+  static const char digits[] PROGMEM = "0123456789ABCDEF";
+  if (value >= 16) {
+    Add((char)pgm_read_byte(&digits[value >> 4]));
+  }
+  Add((char)pgm_read_byte(&digits[value & 0xF]));
+}
+
+byte LineWriter::GetLength() {
+  return m_length;
+}
+
+const char *LineWriter::GetText() {
+  return m_buffer != NULL ? m_buffer : "";
+}
+
+bool LineWriter::IsOverflow() {
+  return m_overflow;
+}
@@ -0,0 +1,37 @@
+#ifndef _LINEWRITER_h
+#define _LINEWRITER_h
+
+#include "Arduino.h"
+
+// Longest line is a WS line with pressure: "OK WS 255 3 255 ... 255 255" (71 chars)
+#define FHEM_LINE_SIZE 80
+
+// Builds a text line in a caller supplied buffer (normally on the stack),
+// so the output path does not touch the heap.
+// If the buffer is too small, the text is truncated and IsOverflow() is set.
+// Without a buffer the text goes straight into the SerialQueue (queue true),
+// after room for it was reserved, or it is only counted (queue false). So a
+// line takes no stack at all, see SensorBase::HandleFrame.
+class LineWriter {
+public:
+  LineWriter(char *buffer, byte size);
+  explicit LineWriter(bool queue);
+  void Clear();
+  void Add(const char *text);
+  void Add(const __FlashStringHelper *text);
+  void Add(char c);
+  void AddNumber(int value);
+  void AddHex(byte value);
+  byte GetLength();
+  const char *GetText();
+  bool IsOverflow();
+
+private:
+  char *m_buffer;
+  byte m_size;
+  byte m_length;
+  bool m_overflow;
+  bool m_queue;
+};
+
+#endif
@@ -1,42 +1,228 @@
 #include "RFM.h"
+#include "FrameDispatcher.h"
+
+RFM *RFM::m_interruptRadios[2];
 
 void RFM::Receive() {
   if (IsRF69) {
     if (ReadReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY) {
-      for (int i = 0; i < PAYLOADSIZE; i++) {
-        byte bt = GetByteFromFifo();
-        m_payload[i] = bt;
+      FrameRing::Entry *entry = m_frames.GetWriteEntry();
+      if (entry) {
+        ReadPayload(entry->Payload);
+      }
+
+      // What was not read is dropped with the FIFO
+      ClearFifo();
+
+      if (entry) {
+        entry->Time = millis();
+        entry->DataRate = m_dataRate;
+        entry->Radio = m_radio;
+        m_frames.Commit();
+      }
+      else {
+        m_lostFrames++;
       }
-      m_payloadReady = true;
     }
   }
+  else if (m_interruptDriven) {
+    // HandleInterrupt fills the frames, only a stalled frame is finished here
+    noInterrupts();
+    if (m_payloadPointer > 0 && millis() > m_lastReceiveTime + 50) {
+      FinishFrame();
+    }
+    interrupts();
+  }
   else {
+    // HandleInterrupt of the other radio uses the bus too
+    byte sreg = SREG;
+    cli();
     bool hasData = false;
-    digitalWrite(m_ss, LOW);
+    m_spi->Select();
     asm("nop");
     asm("nop");
-    if (digitalRead(m_miso)) {
+    if (m_spi->ReadMiso()) {
       hasData = true;
     }
-    digitalWrite(m_ss, HIGH);
+    m_spi->Deselect();
+    SREG = sreg;
 
     if (hasData) {
-      m_payload[m_payloadPointer++] = GetByteFromFifo();
-      m_lastReceiveTime = millis();
+      AddByte(GetByteFromFifo());
+    }
+
+    if (m_payloadPointer > 0 && millis() > m_lastReceiveTime + 50) {
+      FinishFrame();
+    }
+  }
+}
+
+// Burst read of the RFM69 FIFO: the address is sent once and only the bytes
+// of the frame are clocked, as far as its header tells. The rest of the
+// payload is zeroed, so raw dumps do not show an older frame.
+void RFM::ReadPayload(byte *payload) {
+  // HandleInterrupt of the other radio uses the bus too
+  byte sreg = SREG;
+  cli();
+
+  m_spi->Select();
+  spi8(REG_FIFO & 0x7F);
+  byte length = FRAME_HEADER_LENGTH;
+  for (byte i = 0; i < length; i++) {
+    payload[i] = spi8(0);
+    if (i == FRAME_HEADER_LENGTH - 1) {
+      length = FrameDispatcher::GetFrameLength(payload, m_dataRate);
     }
+  }
+  m_spi->Deselect();
+
+  SREG = sreg;
+
+  memset(payload + length, 0, PAYLOADSIZE - length);
+}
 
-    if ((m_payloadPointer > 0 && millis() > m_lastReceiveTime + 50) || m_payloadPointer >= 32) {
-      m_payloadReady = true;
+// Runs as long as nIRQ is low. Reading the status clears the interrupt
+// sources, reading the FIFO releases nIRQ.
+void RFM::HandleInterrupt() {
+  unsigned short status = spi16(0x0000);
+
+  if ((status & RFM12_STATUS_FFOV) && m_payloadPointer > 0) {
+    // Bytes of the current frame were overwritten
+    m_lostFrames++;
+    m_payloadPointer = 0;
+    RestartSync();
+  }
+  else if (status & RFM12_STATUS_FFIT) {
+    AddByte((byte)spi16(0xB000));
+  }
+}
+
+// Adds a byte of the RFM12 FIFO to the frame that is received
+void RFM::AddByte(byte data) {
+  if (m_payloadPointer == 0) {
+    m_receiving = m_frames.GetWriteEntry();
+    if (m_receiving) {
+      m_receiving->Time = millis();
+      m_receiving->DataRate = m_dataRate;
+      m_receiving->Radio = m_radio;
+    }
+    else {
+      // loop() did not keep up, the ring is full
+      m_lostFrames++;
     }
   }
+
+  if (m_receiving) {
+    m_receiving->Payload[m_payloadPointer] = data;
+  }
+  m_payloadPointer++;
+  m_lastReceiveTime = millis();
+
+  if (m_payloadPointer >= RFM12_FRAME_LENGTH) {
+    FinishFrame();
+  }
 }
 
-void RFM::GetPayload(byte *data) {
-  m_payloadReady = false;
+// The RFM12 fills the FIFO until it is told to look for the next sync
+void RFM::FinishFrame() {
+  if (m_receiving) {
+    m_frames.Commit();
+    m_receiving = NULL;
+  }
   m_payloadPointer = 0;
-  for (int i = 0; i < PAYLOADSIZE; i++) {
-    data[i] = m_payload[i];
+  RestartSync();
+}
+
+void RFM::HandleInterrupt0() {
+  m_interruptRadios[0]->HandleInterrupt();
+}
+
+void RFM::HandleInterrupt1() {
+  m_interruptRadios[1]->HandleInterrupt();
+}
+
+void RFM::AttachInterrupt(bool attach) {
+  if (m_interruptDriven) {
+    int interruptNumber = digitalPinToInterrupt(m_irq);
+    if (attach) {
+      attachInterrupt(interruptNumber, interruptNumber == 0 ? HandleInterrupt0 : HandleInterrupt1, LOW);
+    }
+    else {
+      detachInterrupt(interruptNumber);
+    }
+  }
+}
+
+// Stops filling the FIFO, drops what is left of the old frame and waits for
+// the next sync pattern
+void RFM::RestartSync() {
+  spi16(0xCA81);
+  for (byte i = 0; i < 2 && (spi16(0x0000) & RFM12_STATUS_FFIT); i++) {
+    spi16(0xB000);
+  }
+  spi16(0xCA83);
+}
+
+// Drops a partly received frame and waits for the next one, unlike
+// EnableReceiver(false) + EnableReceiver(true) the receiver stays on
+void RFM::RestartReceiver() {
+  if (IsRF69) {
+    WriteReg(REG_PACKETCONFIG2, (ReadReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART);
+  }
+  else {
+    noInterrupts();
+    m_payloadPointer = 0;
+    m_receiving = NULL;
+    RestartSync();
+    interrupts();
+  }
+}
+
+bool RFM::IsInterruptDriven() {
+  return m_interruptDriven;
+}
+
+unsigned long RFM::GetLostFrames() {
+  return m_lostFrames;
+}
+
+void RFM::ResetLostFrames() {
+  m_lostFrames = 0;
+}
+
+RFM::Mode RFM::GetMode() {
+  return m_mode;
+}
+
+// The ms of the current mode are added up to now
+unsigned long RFM::GetModeMillis(Mode mode) {
+  SetMode(m_mode);
+  return m_modeMillis[mode];
+}
+
+void RFM::ResetModeMillis() {
+  for (byte i = 0; i < 3; i++) {
+    m_modeMillis[i] = 0;
   }
+  m_modeSince = micros();
+}
+
+// Books the time since the last change on the old mode, the part below a ms
+// is kept for the next one
+void RFM::SetMode(Mode mode) {
+  unsigned long now = micros();
+  unsigned long elapsed = now - m_modeSince;
+  m_modeMillis[m_mode] += elapsed / 1000;
+  m_modeSince = now - elapsed % 1000;
+  m_mode = mode;
+}
+
+FrameRing::Entry *RFM::GetFrame() {
+  return m_frames.GetReadEntry();
+}
+
+void RFM::ReleaseFrame() {
+  m_frames.Release();
 }
 
 
@@ -76,8 +262,7 @@ void RFM::EnableReceiver(bool enable) {
     }
     else {
       spi16(0x82C8);
-      spi16(0xCA81);
-      spi16(0xCA83);
+      RestartSync();
     }
   }
   else {
@@ -88,7 +273,19 @@ void RFM::EnableReceiver(bool enable) {
       spi16(0x8208);
     }
   }
-  ClearFifo();
+
+  // RestartSync already emptied the FIFO of the RFM12
+  if (IsRF69) {
+    ClearFifo();
+  }
+
+  // A partly received frame is gone
+  noInterrupts();
+  m_payloadPointer = 0;
+  m_receiving = NULL;
+  interrupts();
+
+  SetMode(enable ? Receiving : Idle);
 }
 
 void RFM::EnableTransmitter(bool enable) {
@@ -97,6 +294,8 @@ void RFM::EnableTransmitter(bool enable) {
       WriteReg(REG_OPMODE, (ReadReg(REG_OPMODE) & 0xE3) | RF_OPMODE_TRANSMITTER);
     }
     else {
+      // In TX mode nIRQ signals the free TX register
+      AttachInterrupt(false);
       spi16(0x8238);
     }
   }
@@ -106,8 +305,11 @@ void RFM::EnableTransmitter(bool enable) {
     }
     else {
       spi16(0x8208);
+      AttachInterrupt(true);
     }
   }
+
+  SetMode(enable ? Transmitting : Idle);
 }
 
 byte RFM::GetByteFromFifo() {
@@ -115,11 +317,11 @@ byte RFM::GetByteFromFifo() {
 }
 
 bool RFM::PayloadIsReady() {
-  return m_payloadReady;
+  return !m_frames.IsEmpty();
 }
 
 
-bool RFM::ClearFifo() {
+void RFM::ClearFifo() {
   if (IsRF69) {
     WriteReg(REG_IRQFLAGS2, 16);
   }
@@ -138,15 +340,15 @@ void RFM::PowerDown() {
   else {
     spi16(0x8201);
   }
+  SetMode(Idle);
 }
 
 void RFM::InitializeLaCrosse() {
   if (m_debug) {
-    Serial.print("Radio is: ");
+    Serial.print(F("Radio is: "));
     Serial.println(GetRadioName());
   }
 
-  digitalWrite(m_ss, HIGH);
   EnableReceiver(false);
 
   if (IsRF69) {
@@ -187,73 +389,60 @@ void RFM::InitializeLaCrosse() {
   SetDataRate(m_dataRate);
 
   ClearFifo();
+
+  // The FIFO of the RFM12 holds only two bytes, so it is drained on nIRQ
+  int interruptNumber = digitalPinToInterrupt(m_irq);
+  if (m_radioType == RFM12B && (interruptNumber == 0 || interruptNumber == 1)) {
+    pinMode(m_irq, INPUT);
+    m_interruptRadios[interruptNumber] = this;
+    m_interruptDriven = true;
+    AttachInterrupt(true);
+  }
 }
 
 
-#define clrb(pin) (*portOutputRegister(digitalPinToPort(pin)) &= ~digitalPinToBitMask(pin))
-#define setb(pin) (*portOutputRegister(digitalPinToPort(pin)) |= digitalPinToBitMask(pin))
 byte RFM::spi8(byte value) {
-  volatile byte *misoPort = portInputRegister(digitalPinToPort(m_miso));
-  byte misoBit = digitalPinToBitMask(m_miso);
-  for (byte i = 8; i; i--) {
-    clrb(m_sck);
-    if (value & 0x80) {
-      setb(m_mosi);
-    }
-    else {
-      clrb(m_mosi);
-    }
-    value <<= 1;
-    setb(m_sck);
-    if (*misoPort & misoBit) {
-      value |= 1;
-    }
-  }
-  clrb(m_sck);
-
-  return value;
+  return m_spi->Transfer(value);
 }
 
 unsigned short RFM::spi16(unsigned short value) {
-  volatile byte *misoPort = portInputRegister(digitalPinToPort(m_miso));
-  byte misoBit = digitalPinToBitMask(m_miso);
+  // HandleInterrupt uses the bus too
+  byte sreg = SREG;
+  cli();
 
-  clrb(m_ss);
-  for (byte i = 0; i < 16; i++) {
-    if (value & 32768) {
-      setb(m_mosi);
-    }
-    else {
-      clrb(m_mosi);
-    }
-    value <<= 1;
-    if (*misoPort & misoBit) {
-      value |= 1;
-    }
-    setb(m_sck);
-    asm("nop");
-    asm("nop");
-    clrb(m_sck);
-  }
-  setb(m_ss);
+  m_spi->Select();
+  byte high = m_spi->Transfer(value >> 8);
+  value = (high << 8) | m_spi->Transfer(value & 0xFF);
+  m_spi->Deselect();
+
+  SREG = sreg;
   return value;
 }
 
+// Like spi16, an RFM12 on nIRQ must not cut into the transfer
 byte RFM::ReadReg(byte addr) {
-  digitalWrite(m_ss, LOW);
+  byte sreg = SREG;
+  cli();
+
+  m_spi->Select();
   spi8(addr & 0x7F);
   byte regval = spi8(0);
-  digitalWrite(m_ss, HIGH);
-  return regval;
+  m_spi->Deselect();
 
+  SREG = sreg;
+  return regval;
 }
 
 void RFM::WriteReg(byte addr, byte value) {
-  digitalWrite(m_ss, LOW);
+  byte sreg = SREG;
+  cli();
+
+  m_spi->Select();
   spi8(addr | 0x80);
   spi8(value);
+  m_spi->Deselect();
 
-  digitalWrite(m_ss, HIGH);
+  SREG = sreg;
 }
 
 RFM::RadioType RFM::GetRadioType() {
@@ -263,13 +452,13 @@ RFM::RadioType RFM::GetRadioType() {
 String RFM::GetRadioName() {
   switch (GetRadioType()) {
     case RFM::RFM12B:
-      return String("RFM12B");
+      return String(F("RFM12B"));
       break;
     case RFM::RFM69CW:
-      return String("RFM69CW");
+      return String(F("RFM69CW"));
       break;
     default:
-      return String("None");
+      return String(F("None"));
   }
 }
 
@@ -277,7 +466,14 @@ bool RFM::IsConnected() {
   return m_radioType != RFM::None;
 }
 
-void RFM::Begin(bool isPrimary) {
+// The radio number (1 is the primary) tags the frames of this radio
+void RFM::Begin(byte radio) {
+  m_radio = radio;
+  bool isPrimary = radio == 1;
+
+  m_spi->Begin(digitalPinToInterrupt(m_irq));
+  m_spi->SetClock(RFM12_SPI_CLOCK);
+
   // No radio found until now
   m_radioType = RFM::None;
 
@@ -287,6 +483,7 @@ void RFM::Begin(bool isPrimary) {
     WriteReg(REG_PAYLOADLENGTH, 0x40);
     if (ReadReg(REG_PAYLOADLENGTH) == 0x40) {
       m_radioType = RFM::RFM69CW;
+      m_spi->SetClock(RFM69_SPI_CLOCK);
     }
   }
 
@@ -319,27 +516,26 @@ void RFM::Begin(bool isPrimary) {
   }
 }
 
-RFM::RFM(byte mosi, byte miso, byte sck, byte ss) {
-  m_mosi = mosi;
-  m_miso = miso;
-  m_sck = sck;
-  m_ss = ss;
+RFM::RFM(SpiTransport *spi, byte irq) {
+  m_spi = spi;
+  m_irq = irq;
 
   m_debug = false;
   m_dataRate = 17241;
   m_frequency = 868300;
   m_payloadPointer = 0;
   m_lastReceiveTime = 0;
-  m_payloadReady = false;
-
-
-  pinMode(m_mosi, OUTPUT);
-  pinMode(m_miso, INPUT);
-  pinMode(m_sck, OUTPUT);
-  pinMode(m_ss, OUTPUT);
-
-  digitalWrite(m_ss, HIGH);
-
+  m_receiving = NULL;
+  m_radio = 1;
+  m_lostFrames = 0;
+  m_interruptDriven = false;
+  m_sending = false;
+  m_sendStart = 0;
+  m_mode = Idle;
+  m_modeSince = 0;
+  for (byte i = 0; i < 3; i++) {
+    m_modeMillis[i] = 0;
+  }
 }
 
 void RFM::SetDebugMode(boolean mode) {
@@ -359,30 +555,32 @@ void RFM::SendByte(byte data) {
 
 
 void RFM::SendArray(byte *data, byte length) {
+  StartSend(data, length);
+  while (IsSending());
+}
+
+void RFM::StartSend(byte *data, byte length) {
   if (IsRF69) {
     WriteReg(REG_PACKETCONFIG2, (ReadReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART); // avoid RX deadlocks
 
     EnableReceiver(false);
     ClearFifo();
 
-    noInterrupts();
-    digitalWrite(m_ss, LOW);
+    byte sreg = SREG;
+    cli();
+    m_spi->Select();
 
     spi8(REG_FIFO | 0x80);
     for (byte i = 0; i < length; i++) {
       spi8(data[i]);
     }
 
-    digitalWrite(m_ss, HIGH);
-    interrupts();
+    m_spi->Deselect();
+    SREG = sreg;
 
     EnableTransmitter(true);
-
-    // Wait until transmission is finished
-    unsigned long txStart = millis();
-    while (!(ReadReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PACKETSENT) && millis() - txStart < 500);
-
-    EnableTransmitter(false);
+    m_sending = true;
+    m_sendStart = millis();
   }
   else {
     // Transmitter on
@@ -406,21 +604,30 @@ void RFM::SendArray(byte *data, byte length) {
   }
 
   if (m_debug) {
-    Serial.print("Sending data: ");
+    Serial.print(F("Sending data: "));
     for (int p = 0; p < length; p++) {
       Serial.print(data[p], DEC);
-      Serial.print(" ");
+      Serial.print(F(" "));
     }
     Serial.println();
   }
 }
 
+// Switches the transmitter off when the packet is out, or after 500 ms
+bool RFM::IsSending() {
+  if (m_sending && ((ReadReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PACKETSENT) || millis() - m_sendStart >= 500)) {
+    EnableTransmitter(false);
+    m_sending = false;
+  }
+  return m_sending;
+}
+
 void RFM::SetHFParameter(byte address, byte value) {
   WriteReg(address, value);
   if (m_debug) {
-    Serial.print("WriteReg:");
+    Serial.print(F("WriteReg:"));
     Serial.print(address);
-    Serial.print("->");
+    Serial.print(F("->"));
     Serial.print(value);
   }
 }
@@ -428,7 +635,7 @@ void RFM::SetHFParameter(byte address, byte value) {
 void RFM::SetHFParameter(unsigned short value) {
   spi16(value);
   if (m_debug) {
-    Serial.print("spi16:");
+    Serial.print(F("spi16:"));
     Serial.print(value);
   }
 }
@@ -2,10 +2,24 @@
 #define _RFMXX_h
 
 #include "Arduino.h"
+#include "FrameRing.h"
+#include "SpiTransport.h"
 
-#define PAYLOADSIZE 64
 #define IsRF69 m_radioType == RFM69CW
 
+// Pass as irq to the constructor to poll the radio
+#define RFM_NO_IRQ 0xFF
+
+// The RFM12 has no packet engine, after this many bytes the frame is complete
+#define RFM12_FRAME_LENGTH 32
+
+#define RFM12_STATUS_FFIT 0x8000
+#define RFM12_STATUS_FFOV 0x2000
+
+// SCK limits: the RFM12 FIFO can only be read below 2.5 MHz, the RFM69 allows 10 MHz
+#define RFM12_SPI_CLOCK 2000000
+#define RFM69_SPI_CLOCK 8000000
+
 
 class RFM {
 public:
@@ -15,18 +29,31 @@ public:
     RFM69CW = 2
   };
 
-  RFM(byte mosi, byte miso, byte sck, byte ss);
-  void Begin(bool isPrimary);
+  // What the radio does, the time in each mode is summed up
+  enum Mode {
+    Idle = 0,
+    Receiving = 1,
+    Transmitting = 2
+  };
+
+  RFM(SpiTransport *spi, byte irq = RFM_NO_IRQ);
+  void Begin(byte radio);
   bool IsConnected();
   bool PayloadIsReady();
-  void GetPayload(byte *data);
+  FrameRing::Entry *GetFrame();
+  void ReleaseFrame();
   void InitializeLaCrosse();
   void SendArray(byte *data, byte length);
+  // Non-blocking send: the RFM69 sends from its FIFO while IsSending() is
+  // true, the RFM12 has no TX FIFO and is done when StartSend() returns
+  void StartSend(byte *data, byte length);
+  bool IsSending();
   void SetDataRate(unsigned long dataRate);
   unsigned long GetDataRate();
   void SetFrequency(unsigned long kHz);
   unsigned long GetFrequency();
   void EnableReceiver(bool enable);
+  void RestartReceiver();
   void EnableTransmitter(bool enable);
   static byte CalculateCRC(byte data[], int len);
   void PowerDown();
@@ -36,24 +63,49 @@ public:
   void Receive();
   void SetHFParameter(byte address, byte value);
   void SetHFParameter(unsigned short value);
+  bool IsInterruptDriven();
+  unsigned long GetLostFrames();
+  void ResetLostFrames();
+  Mode GetMode();
+  unsigned long GetModeMillis(Mode mode);
+  void ResetModeMillis();
 
 private:
   RadioType m_radioType;
-  byte m_mosi, m_miso, m_sck, m_ss;
+  SpiTransport *m_spi;
+  byte m_irq;
   bool m_debug;
   unsigned long m_dataRate;
   unsigned long m_frequency;
-  byte m_payloadPointer;
-  unsigned long m_lastReceiveTime;
-  bool m_payloadReady;
-  byte m_payload[PAYLOADSIZE];
+  byte m_radio;
+  volatile byte m_payloadPointer;
+  volatile unsigned long m_lastReceiveTime;
+  volatile unsigned long m_lostFrames;
+  bool m_interruptDriven;
+  bool m_sending;
+  unsigned long m_sendStart;
+  Mode m_mode;
+  unsigned long m_modeSince;
+  unsigned long m_modeMillis[3];
+  FrameRing m_frames;
+  FrameRing::Entry *m_receiving;
+  static RFM *m_interruptRadios[2];
+  static void HandleInterrupt0();
+  static void HandleInterrupt1();
+  void HandleInterrupt();
+  void AttachInterrupt(bool attach);
+  void RestartSync();
+  void AddByte(byte data);
+  void FinishFrame();
+  void ReadPayload(byte *payload);
   byte spi8(byte);
   unsigned short spi16(unsigned short value);
   byte ReadReg(byte addr);
   void WriteReg(byte addr, byte value);
   byte GetByteFromFifo();
-  bool ClearFifo();
+  void ClearFifo();
   void SendByte(byte data);
+  void SetMode(Mode mode);
 
 };
 
@@ -0,0 +1,99 @@
+#include "RadioConfig.h"
+
+RadioConfig::RadioConfig(byte role, unsigned long dataRate, uint16_t toggleInterval, byte toggleMode) {
+  Role = role;
+  DataRate = dataRate;
+  ToggleInterval = toggleInterval;
+  ToggleMode = toggleMode;
+  m_lastToggle = 0;
+  if (toggleInterval > 0 && role == RADIO_ROLE_FIXED) {
+    Role = RADIO_ROLE_TOGGLE;
+  }
+}
+
+bool RadioConfig::IsReceiving() {
+  return Role == RADIO_ROLE_FIXED || Role == RADIO_ROLE_TOGGLE;
+}
+
+bool RadioConfig::IsToggling() {
+  return Role == RADIO_ROLE_TOGGLE && ToggleInterval > 0;
+}
+
+bool RadioConfig::IsPredicting() {
+  return RATE_PLANNER_SIZE > 0 && IsToggling() && (ToggleMode & RATE_PLANNER_MODE);
+}
+
+void RadioConfig::SetToggleInterval(uint16_t interval) {
+  ToggleInterval = interval;
+  if (IsReceiving()) {
+    Role = interval > 0 ? RADIO_ROLE_TOGGLE : RADIO_ROLE_FIXED;
+  }
+}
+
+// 17.241 -> 8.842 -> 9.579 -> 17.241, skipping the rates not in the mode
+unsigned long RadioConfig::GetNextRate() {
+  if (DataRate == 8842ul) {
+    if (ToggleMode & 2) {
+      return 9579ul;
+    }
+    else if (ToggleMode & 1) {
+      return 17241ul;
+    }
+  }
+  else if (DataRate == 9579ul) {
+    if (ToggleMode & 1) {
+      return 17241ul;
+    }
+    else if (ToggleMode & 4) {
+      return 8842ul;
+    }
+  }
+  else if (DataRate == 17241ul) {
+    if (ToggleMode & 4) {
+      return 8842ul;
+    }
+    else if (ToggleMode & 2) {
+      return 9579ul;
+    }
+  }
+  return DataRate;
+}
+
+bool RadioConfig::UpdateDataRate(unsigned long now) {
+  if (!IsToggling()) {
+    return false;
+  }
+
+  unsigned long dataRate = DataRate;
+  if (IsPredicting()) {
+    // The toggle interval is the time per rate while no sensor is expected
+#if RATE_PLANNER_SIZE > 0
+    dataRate = m_planner.GetDataRate(now, ToggleMode, ToggleInterval * 1000ul);
+#endif
+  }
+  else if (now - m_lastToggle > ToggleInterval * 1000ul) {
+    dataRate = GetNextRate();
+    m_lastToggle = now;
+  }
+
+  if (dataRate == DataRate) {
+    return false;
+  }
+  DataRate = dataRate;
+  return true;
+}
+
+const char *RadioConfig::GetRoleName(byte role) {
+  switch (role) {
+    case RADIO_ROLE_FIXED:
+      return "fixed";
+    case RADIO_ROLE_TOGGLE:
+      return "toggle";
+    case RADIO_ROLE_TRANSMIT:
+      return "transmit";
+    case RADIO_ROLE_RELAY:
+      return "relay";
+    default:
+      return "unknown";
+  }
+}
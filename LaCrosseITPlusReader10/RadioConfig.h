@@ -0,0 +1,47 @@
+#ifndef _RADIOCONFIG_h
+#define _RADIOCONFIG_h
+
+#include "Arduino.h"
+#include "RatePlanner.h"
+
+// What a radio is used for (<radio>,<role>e)
+#define RADIO_ROLE_FIXED    0   // receives on one data rate
+#define RADIO_ROLE_TOGGLE   1   // receives and toggles the rates of the toggle mode
+#define RADIO_ROLE_TRANSMIT 2   // only sends (s command)
+#define RADIO_ROLE_RELAY    3   // only sends the frames the others received again
+#define RADIO_ROLE_COUNT    4
+
+// Settings of one radio of the board. The receiving roles switch the data
+// rate here, the sketch passes it on to the RFM when it changed.
+// A toggling radio without an interval stays on its rate, <n>t with n > 0
+// makes a fixed radio toggle and 0t a toggling one fixed, as before.
+class RadioConfig {
+public:
+  RadioConfig(byte role = RADIO_ROLE_FIXED, unsigned long dataRate = 17241ul, uint16_t toggleInterval = 0,
+    byte toggleMode = 3);
+
+  byte Role;
+  unsigned long DataRate;     // the fixed one, or the current one while toggling
+  uint16_t ToggleInterval;    // s
+  byte ToggleMode;            // bits 1: 17.241 kbps, 2: 9.579 kbps, 4: 8.842 kbps, 8: predict
+
+  bool IsReceiving();
+  bool IsToggling();
+  // Toggling with bit 8 of the mode, and the RatePlanner is in the build
+  bool IsPredicting();
+  void SetToggleInterval(uint16_t interval);
+  // The rate for now (millis()), true when DataRate has changed
+  bool UpdateDataRate(unsigned long now);
+
+  static const char *GetRoleName(byte role);
+
+private:
+#if RATE_PLANNER_SIZE > 0
+  RatePlanner m_planner;
+#endif
+  unsigned long m_lastToggle;
+
+  unsigned long GetNextRate();
+};
+
+#endif
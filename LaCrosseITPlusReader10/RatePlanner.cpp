@@ -0,0 +1,268 @@
+#include "RatePlanner.h"
+#include "IdFilter.h"
+
+#if RATE_PLANNER_SIZE > 0
+RatePlanner::Entry RatePlanner::m_entries[RATE_PLANNER_SIZE];
+#endif
+
+RatePlanner::RatePlanner() {
+  m_discoveryRate = 0;
+  m_lastToggle = 0;
+  m_isPredicting = false;
+}
+
+// Index 0: 17.241 kbps, 1: 9.579 kbps, 2: 8.842 kbps, the bits of the toggle mode
+byte RatePlanner::GetRateIndex(unsigned long dataRate) {
+  switch (dataRate) {
+    case 17241ul:
+      return 0;
+    case 9579ul:
+      return 1;
+    case 8842ul:
+      return 2;
+    default:
+      return 0xFF;
+  }
+}
+
+unsigned long RatePlanner::GetRate(byte index) {
+  static const unsigned long rates[] PROGMEM = { 17241ul, 9579ul, 8842ul };
+  return pgm_read_dword(&rates[index]);
+}
+
+#if RATE_PLANNER_SIZE > 0
+// Without a match the first free entry or the one heard longest ago
+RatePlanner::Entry *RatePlanner::Find(byte protocol, word id, byte rate, unsigned long now) {
+  Entry *oldest = NULL;
+  for (byte i = 0; i < RATE_PLANNER_SIZE; i++) {
+    Entry *entry = &m_entries[i];
+    if (entry->Protocol == protocol && entry->ID == id && entry->Rate == rate) {
+      return entry;
+    }
+    if (entry->Protocol == 0) {
+      if (oldest == NULL || oldest->Protocol != 0) {
+        oldest = entry;
+      }
+    }
+    else if (oldest == NULL || (oldest->Protocol != 0 && now - entry->Last > now - oldest->Last)) {
+      oldest = entry;
+    }
+  }
+
+  memset(oldest, 0, sizeof(Entry));
+  return oldest;
+}
+#endif
+
+// The period follows slow drift, a sample that is more than 1/8 off (or a
+// frame before half a period) starts learning it again. Frames that did not
+// come in between count as expected, up to RATE_PLANNER_MAX_MISSED.
+#if RATE_PLANNER_SIZE == 0
+void RatePlanner::Learn(byte * /* payload */, unsigned long /* dataRate */, unsigned long /* time */) {
+}
+#else
+void RatePlanner::Learn(byte *payload, unsigned long dataRate, unsigned long time) {
+  FrameDispatcher::Protocol protocol = FrameDispatcher::Classify(payload, dataRate);
+  byte rate = GetRateIndex(dataRate);
+  if (protocol == FrameDispatcher::ProtocolUnknown || rate == 0xFF) {
+    return;
+  }
+  word id = IdFilter::GetID(protocol, payload);
+  if (!IdFilter::IsWanted(protocol, id)) {
+    return;
+  }
+
+  Entry *entry = Find(protocol, id, rate, time);
+  if (entry->Protocol == 0) {
+    entry->Protocol = protocol;
+    entry->ID = id;
+    entry->Rate = rate;
+    entry->Last = time;
+    entry->Captured = 1;
+    entry->Expected = 1;
+    return;
+  }
+
+  // The same frame from the other radio
+  unsigned long delta = time - entry->Last;
+  if (delta < RATE_PLANNER_HOLD) {
+    return;
+  }
+
+  unsigned long frames = 1;
+  if (entry->Period > 0) {
+    frames = (delta + entry->Period / 2) / entry->Period;
+    if (frames == 0) {
+      entry->Period = 0;
+      frames = 1;
+    }
+    else {
+      long difference = (long)(delta / frames) - entry->Period;
+      if (difference > entry->Period / 8 || difference < -(long)(entry->Period / 8)) {
+        entry->Period = 0;
+        frames = 1;
+      }
+      else {
+        entry->Period += difference / 4;
+      }
+    }
+  }
+  if (entry->Period == 0 && delta >= RATE_PLANNER_MIN_PERIOD && delta <= RATE_PLANNER_MAX_PERIOD) {
+    entry->Period = delta;
+  }
+
+  if (frames > RATE_PLANNER_MAX_MISSED) {
+    frames = RATE_PLANNER_MAX_MISSED;
+  }
+  while (entry->Expected + frames > 0xFFFF) {
+    entry->Expected /= 2;
+    entry->Captured /= 2;
+  }
+  entry->Expected += frames;
+  entry->Captured++;
+  entry->Last = time;
+}
+#endif
+
+// The first frame that can still come (up to HOLD ms late) after now
+bool RatePlanner::TryGetNext(Entry *entry, unsigned long now, unsigned long *next) {
+  if (entry->Protocol == 0 || entry->Period == 0) {
+    return false;
+  }
+  unsigned long elapsed = now - entry->Last;
+  if (elapsed > (unsigned long)entry->Period * RATE_PLANNER_MAX_MISSED) {
+    return false;
+  }
+
+  unsigned long periods = 1;
+  if (elapsed > RATE_PLANNER_HOLD) {
+    periods = (elapsed - RATE_PLANNER_HOLD + entry->Period - 1) / entry->Period;
+    if (periods == 0) {
+      periods = 1;
+    }
+  }
+  *next = entry->Last + periods * entry->Period;
+  return true;
+}
+
+// Of the sensors within their window the one expected first, otherwise the
+// next rate of the toggle mode every dwell ms
+unsigned long RatePlanner::GetDataRate(unsigned long now, byte rates, unsigned long dwell) {
+  Entry *best = NULL;
+#if RATE_PLANNER_SIZE > 0
+  unsigned long bestNext = 0;
+  for (byte i = 0; i < RATE_PLANNER_SIZE; i++) {
+    Entry *entry = &m_entries[i];
+    unsigned long next;
+    if (!(rates & (1 << entry->Rate)) || !TryGetNext(entry, now, &next)) {
+      continue;
+    }
+    if ((long)(now - (next - RATE_PLANNER_LEAD)) >= 0 && (best == NULL || (long)(next - bestNext) < 0)) {
+      best = entry;
+      bestNext = next;
+    }
+  }
+#endif
+
+  m_isPredicting = best != NULL;
+  if (m_isPredicting) {
+    return GetRate(best->Rate);
+  }
+
+  if ((rates & 7) != 0 && (now - m_lastToggle >= dwell || !(rates & (1 << m_discoveryRate)))) {
+    do {
+      m_discoveryRate = (m_discoveryRate + 1) % 3;
+    } while (!(rates & (1 << m_discoveryRate)));
+    m_lastToggle = now;
+  }
+  return GetRate(m_discoveryRate);
+}
+
+bool RatePlanner::IsPredicting() {
+  return m_isPredicting;
+}
+
+void RatePlanner::Clear() {
+#if RATE_PLANNER_SIZE > 0
+  memset(m_entries, 0, sizeof(m_entries));
+#endif
+}
+
+byte RatePlanner::GetCount() {
+  byte count = 0;
+#if RATE_PLANNER_SIZE > 0
+  for (byte i = 0; i < RATE_PLANNER_SIZE; i++) {
+    if (m_entries[i].Protocol != 0) {
+      count++;
+    }
+  }
+#endif
+  return count;
+}
+
+#if RATE_PLANNER_SIZE == 0
+RatePlanner::Entry *RatePlanner::Get(FrameDispatcher::Protocol /* protocol */, word /* id */) {
+  return NULL;
+}
+#else
+RatePlanner::Entry *RatePlanner::Get(FrameDispatcher::Protocol protocol, word id) {
+  for (byte i = 0; i < RATE_PLANNER_SIZE; i++) {
+    if (m_entries[i].Protocol == protocol && m_entries[i].ID == id) {
+      return &m_entries[i];
+    }
+  }
+  return NULL;
+}
+#endif
+
+word RatePlanner::GetPeriod(FrameDispatcher::Protocol protocol, word id) {
+  Entry *entry = Get(protocol, id);
+  return entry != NULL ? entry->Period : 0;
+}
+
+word RatePlanner::GetCaptured(FrameDispatcher::Protocol protocol, word id) {
+  Entry *entry = Get(protocol, id);
+  return entry != NULL ? entry->Captured : 0;
+}
+
+word RatePlanner::GetExpected(FrameDispatcher::Protocol protocol, word id) {
+  Entry *entry = Get(protocol, id);
+  return entry != NULL ? entry->Expected : 0;
+}
+
+// The learned periods are kept
+void RatePlanner::ResetStatistics() {
+#if RATE_PLANNER_SIZE > 0
+  for (byte i = 0; i < RATE_PLANNER_SIZE; i++) {
+    m_entries[i].Captured = 0;
+    m_entries[i].Expected = 0;
+  }
+#endif
+}
+
+// [Sensor LaCrosse:9 r:17241 p:4012 c:120/122 98%]
+void RatePlanner::ShowStatistics() {
+#if RATE_PLANNER_SIZE > 0
+  for (byte i = 0; i < RATE_PLANNER_SIZE; i++) {
+    Entry *entry = &m_entries[i];
+    if (entry->Protocol == 0) {
+      continue;
+    }
+    Serial.print(F("[Sensor "));
+    Serial.print(FrameDispatcher::GetProtocolName((FrameDispatcher::Protocol)entry->Protocol));
+    Serial.print(':');
+    Serial.print(entry->ID);
+    Serial.print(F(" r:"));
+    Serial.print(GetRate(entry->Rate));
+    Serial.print(F(" p:"));
+    Serial.print(entry->Period);
+    Serial.print(F(" c:"));
+    Serial.print(entry->Captured);
+    Serial.print('/');
+    Serial.print(entry->Expected);
+    Serial.print(' ');
+    Serial.print(entry->Expected > 0 ? (unsigned long)entry->Captured * 100 / entry->Expected : 0);
+    Serial.println(F("%]"));
+  }
+#endif
+}
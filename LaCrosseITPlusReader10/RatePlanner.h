@@ -0,0 +1,90 @@
+#ifndef _RATEPLANNER_h
+#define _RATEPLANNER_h
+
+#include "Arduino.h"
+#include "FrameDispatcher.h"
+
+// Sensors whose transmit period is learned, 14 bytes each. Opt-in as the
+// SensorTable: 0 leaves the prediction out of the build (m with bit 8
+// answers failed). Define it (16 takes 224 bytes) here or with
+// -DRATE_PLANNER_SIZE=16 to have it
+#ifndef RATE_PLANNER_SIZE
+#define RATE_PLANNER_SIZE 0
+#endif
+
+// Bit of the toggle mode (<n>m) that switches the prediction on
+#define RATE_PLANNER_MODE 8
+
+// The radio is on the rate of a sensor from LEAD ms before its next frame is
+// expected until HOLD ms after it
+#define RATE_PLANNER_LEAD 150
+#define RATE_PLANNER_HOLD 150
+
+// Periods that are learned (ms), longer gaps only count the missed frames
+#define RATE_PLANNER_MIN_PERIOD 1000
+#define RATE_PLANNER_MAX_PERIOD 60000
+
+// A sensor that missed this many periods in a row is not predicted any more
+#define RATE_PLANNER_MAX_MISSED 16
+
+// Predictive data rate toggling (toggle mode bit 8, e.g. 15m).
+// The sensors send periodically, LaCrosse about every 4 s, EMT7110 every
+// 30 s. From the receive times of their frames the table learns period and
+// phase of each sensor, and a radio switches to the rate of the sensor that
+// is expected next shortly before its frame. In between it toggles through
+// the rates of the toggle mode as before (every <n>t seconds), so new
+// sensors are found.
+// Per sensor it counts the frames captured and those expected from the
+// period, the capture ratio is shown by q.
+// The table is shared by the radios, the discovery is one object per radio.
+// The sketch passes the frames to Learn() only while a radio predicts.
+class RatePlanner {
+public:
+  RatePlanner();
+
+  // Data rate the radio should be on at now (millis()), rates are the bits of
+  // the toggle mode, dwell is the time per rate while discovering (ms)
+  unsigned long GetDataRate(unsigned long now, byte rates, unsigned long dwell);
+  bool IsPredicting();
+
+  // A decoded frame, time is millis() of its first byte
+  static void Learn(byte *payload, unsigned long dataRate, unsigned long time);
+  static void Clear();
+
+  static byte GetCount();
+  static word GetPeriod(FrameDispatcher::Protocol protocol, word id);
+  static word GetCaptured(FrameDispatcher::Protocol protocol, word id);
+  static word GetExpected(FrameDispatcher::Protocol protocol, word id);
+  static void ResetStatistics();
+  static void ShowStatistics();
+
+  static byte GetRateIndex(unsigned long dataRate);
+  static unsigned long GetRate(byte index);
+
+private:
+  struct Entry {
+    byte Protocol;           // 0 if the entry is free
+    byte Rate;               // index of GetRate()
+    word ID;
+    word Period;             // ms, 0 until it is known
+    unsigned long Last;      // millis() of the last frame
+    word Captured;           // both are halved before Expected overflows
+    word Expected;
+  };
+
+#if RATE_PLANNER_SIZE > 0
+  static Entry m_entries[RATE_PLANNER_SIZE];
+#endif
+
+  byte m_discoveryRate;
+  unsigned long m_lastToggle;
+  bool m_isPredicting;
+
+#if RATE_PLANNER_SIZE > 0
+  static Entry *Find(byte protocol, word id, byte rate, unsigned long now);
+#endif
+  static Entry *Get(FrameDispatcher::Protocol protocol, word id);
+  static bool TryGetNext(Entry *entry, unsigned long now, unsigned long *next);
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "RecordWriter.h"
+#include "CRC8.h"
+#include "SerialQueue.h"
+
+RecordWriter::RecordWriter(byte *buffer, byte size) {
+  m_buffer = buffer;
+  m_size = size;
+  Clear();
+}
+
+void RecordWriter::Clear() {
+  m_length = 0;
+  m_overflow = false;
+}
+
+// The last byte of the buffer is kept for the CRC
+void RecordWriter::Add(byte value) {
+  if (m_length < m_size - 1) {
+    m_buffer[m_length++] = value;
+  }
+  else {
+    m_overflow = true;
+  }
+}
+
+void RecordWriter::AddWord(word value) {
+  Add(value >> 8);
+  Add(value);
+}
+
+byte RecordWriter::GetLength() {
+  return m_length;
+}
+
+bool RecordWriter::IsOverflow() {
+  return m_overflow;
+}
+
+// COBS: each block up to a zero is sent as its length + 1 and its bytes
+// without the zero. Records are shorter than 254 bytes, so no block
+// needs to be split and the encoded record is the CRC, one code byte and
+// the terminating zero longer.
+bool RecordWriter::Send() {
+  byte length = m_length;
+  m_buffer[length++] = CRC8::Calculate(m_buffer, m_length);
+  if (!SerialQueue::Reserve(length + 2)) {
+    return false;
+  }
+
+  byte start = 0;
+  for (;;) {
+    byte end = start;
+    while (end < length && m_buffer[end] != 0) {
+      end++;
+    }
+    SerialQueue::Put(end - start + 1);
+    SerialQueue::Put(m_buffer + start, end - start);
+    if (end == length) {
+      break;
+    }
+    start = end + 1;
+  }
+  SerialQueue::Put(0);
+  SerialQueue::Handle();
+  return true;
+}
@@ -0,0 +1,79 @@
+#ifndef _RECORDWRITER_h
+#define _RECORDWRITER_h
+
+#include "Arduino.h"
+
+// Binary output (<1>b): instead of the "OK ..." line every decoded frame is
+// sent as one record
+//   Tag  ID  Flags  Fields ...  CRC
+// The tag says which protocol and so how the fields are laid out, words are
+// MSB first and temperatures are signed in 1/10 C. The CRC8 (polynomial 0x31)
+// covers everything before it. The record is COBS encoded, so the zero that
+// follows it is the only one on the line and a host can always resync there.
+//
+// Tag                        ID  Flags                Fields
+// 1 LaCrosse, 6 WT440XH,     1   1 new battery        Temperature(2) Humidity(1)
+//   7 TX38IT                     2 weak battery
+//                                4 second channel
+// 2 TX22IT, 3 WS1080,        1   1 new battery        Fields(1), then those of them that are there:
+//   9 internal sensors           2 error              1 Temperature(2), 2 Humidity(1), 4 Rain 1/10 mm(2),
+//                                4 low battery        8 WindDirection 1/10 degree(2), 16 WindSpeed 1/10 m/s(2),
+//                                                     32 WindGust 1/10 m/s(2), 64 Pressure hPa(2)
+// 4 LevelSender              1   0                    Level 0.5 cm(2) Temperature(2) Voltage 1/10 V(1)
+// 5 EMT7110                  2   1 consumers          Voltage 1/10 V(2) Current mA(2) Power W(2)
+//                                2 pairing            AccumulatedPower 1/100 kWh(2)
+// 8 CustomSensor             1   0                    the data bytes
+// 10 aggregate (<n>w)        2   of all frames        Fields(1) Count(1), then those of them that are there:
+//                                                     1 Temperature mean, min, max(2 each), 2 Humidity mean, min, max(1 each)
+//                                                     ID is the tag of the sensor and its ID, flags 4 is the
+//                                                     second channel for the tags 1, 6, 7
+// 0 raw payload (<n>p)       -   -                    the PAYLOADSIZE bytes of the payload
+// 127 format                 -   -                    RECORD_FORMAT_VERSION, sent when <1>b switches on
+#define RECORD_RAW            0
+#define RECORD_LACROSSE       1
+#define RECORD_TX22IT         2
+#define RECORD_WS1080         3
+#define RECORD_LEVELSENDER    4
+#define RECORD_EMT7110        5
+#define RECORD_WT440XH        6
+#define RECORD_TX38IT         7
+#define RECORD_CUSTOMSENSOR   8
+#define RECORD_INTERNAL       9
+#define RECORD_AGGREGATE      10
+#define RECORD_FORMAT         127
+
+#define RECORD_FORMAT_VERSION 2
+
+// Fields byte of the WS records
+#define RECORD_HAS_TEMPERATURE     1
+#define RECORD_HAS_HUMIDITY        2
+#define RECORD_HAS_RAIN            4
+#define RECORD_HAS_WIND_DIRECTION  8
+#define RECORD_HAS_WIND_SPEED      16
+#define RECORD_HAS_WIND_GUST       32
+#define RECORD_HAS_PRESSURE        64
+
+// Longest sensor record is a WS record with all fields (18 bytes)
+#define RECORD_SIZE 20
+
+// Builds a record in a caller supplied buffer, like the LineWriter does for
+// the text lines. The buffer needs one byte for the CRC, which Send() adds
+// before it puts the record in the SerialQueue.
+class RecordWriter {
+public:
+  RecordWriter(byte *buffer, byte size);
+  void Clear();
+  void Add(byte value);
+  void AddWord(word value);
+  byte GetLength();
+  bool IsOverflow();
+  bool Send();
+
+private:
+  byte *m_buffer;
+  byte m_size;
+  byte m_length;
+  bool m_overflow;
+};
+
+#endif
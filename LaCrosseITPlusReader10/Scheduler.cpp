@@ -0,0 +1,133 @@
+#include "Scheduler.h"
+
+Scheduler::Task Scheduler::m_tasks[SCHEDULER_MAX_TASKS];
+byte Scheduler::m_count = 0;
+
+// Due right away
+bool Scheduler::Add(const __FlashStringHelper *name, TaskFunction function, word period, word deadline, byte priority) {
+  if (m_count >= SCHEDULER_MAX_TASKS) {
+    return false;
+  }
+
+  Task *task = &m_tasks[m_count++];
+  memset(task, 0, sizeof(Task));
+  task->Name = name;
+  task->Function = function;
+  task->Period = period;
+  task->Deadline = deadline;
+  task->Priority = priority;
+  task->Due = micros();
+  return true;
+}
+
+bool Scheduler::IsDue(Task *task, unsigned long now) {
+  return (long)(now - task->Due) >= 0;
+}
+
+// A task past its deadline goes before every other one, so a busy task of a
+// better priority cannot starve it
+void Scheduler::Run() {
+  for (byte i = 0; i < m_count; i++) {
+    if (m_tasks[i].Priority == TASK_PRIORITY_RADIO) {
+      RunTask(&m_tasks[i], micros());
+    }
+  }
+
+  unsigned long now = micros();
+  Task *next = NULL;
+  byte nextPriority = 0;
+  unsigned long nextDeadline = 0;
+  for (byte i = 0; i < m_count; i++) {
+    Task *task = &m_tasks[i];
+    if (task->Priority == TASK_PRIORITY_RADIO || !IsDue(task, now)) {
+      continue;
+    }
+    unsigned long deadline = task->Due + task->Deadline * 1000UL;
+    byte priority = (long)(now - deadline) > 0 ? TASK_PRIORITY_RADIO : task->Priority;
+    if (next == NULL || priority < nextPriority
+      || (priority == nextPriority && (long)(deadline - nextDeadline) < 0)) {
+      next = task;
+      nextPriority = priority;
+      nextDeadline = deadline;
+    }
+  }
+
+  if (next != NULL) {
+    RunTask(next, now);
+  }
+}
+
+// The next run is a period after the time it was due, so a late run does not
+// shift the following ones; what it missed altogether is skipped. A task
+// without a period is due again as soon as it returns
+void Scheduler::RunTask(Task *task, unsigned long now) {
+  unsigned long lateness = now - task->Due;
+  task->Function();
+  unsigned long end = micros();
+  unsigned long runTime = end - now;
+
+  task->Runs++;
+  SetMax(&task->MaxRunTime, runTime);
+  SetMax(&task->MaxLateness, lateness);
+  if (task->Period > 0) {
+    task->Due += task->Period * 1000UL;
+    if (IsDue(task, end)) {
+      task->Due = now + task->Period * 1000UL;
+    }
+  }
+  else {
+    task->Due = end;
+  }
+}
+
+void Scheduler::SetMax(word *max, unsigned long value) {
+  if (value > 0xFFFF) {
+    value = 0xFFFF;
+  }
+  if (value > *max) {
+    *max = value;
+  }
+}
+
+byte Scheduler::GetTaskCount() {
+  return m_count;
+}
+
+const __FlashStringHelper *Scheduler::GetName(byte task) {
+  return m_tasks[task].Name;
+}
+
+unsigned long Scheduler::GetRuns(byte task) {
+  return m_tasks[task].Runs;
+}
+
+word Scheduler::GetMaxRunTime(byte task) {
+  return m_tasks[task].MaxRunTime;
+}
+
+word Scheduler::GetMaxLateness(byte task) {
+  return m_tasks[task].MaxLateness;
+}
+
+void Scheduler::ResetStatistics() {
+  for (byte i = 0; i < m_count; i++) {
+    m_tasks[i].Runs = 0;
+    m_tasks[i].MaxRunTime = 0;
+    m_tasks[i].MaxLateness = 0;
+  }
+}
+
+// [Task R1 runs:81234 run:1830 late:2410 us]
+void Scheduler::ShowStatistics() {
+  for (byte i = 0; i < m_count; i++) {
+    Serial.print(F("[Task "));
+    Serial.print(m_tasks[i].Name);
+    Serial.print(F(" runs:"));
+    Serial.print(m_tasks[i].Runs);
+    Serial.print(F(" run:"));
+    Serial.print(m_tasks[i].MaxRunTime);
+    Serial.print(F(" late:"));
+    Serial.print(m_tasks[i].MaxLateness);
+    Serial.println(F(" us]"));
+  }
+}
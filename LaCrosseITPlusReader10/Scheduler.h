@@ -0,0 +1,63 @@
+#ifndef _SCHEDULER_h
+#define _SCHEDULER_h
+
+#include "Arduino.h"
+
+// The sketch adds 10 tasks, 21 bytes each
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS 10
+#endif
+
+// Priority of the radios, they run in every Run()
+#define TASK_PRIORITY_RADIO 0
+
+typedef void (*TaskFunction)();
+
+// Cooperative scheduler of the tasks of loop().
+// The tasks are in a static table, each with a period (ms, 0: as often as
+// possible), a deadline (ms after it became due) and a priority. Every
+// Run() polls the radios (TASK_PRIORITY_RADIO) first and then runs at most
+// one other task: of the due ones the one with the best (lowest) priority,
+// between equal priorities the one with the earliest deadline. A task past
+// its deadline goes first, so none starves. So a radio waits for one task at
+// most, not for the whole loop().
+// Per task it keeps the runs, the longest run and the latest start after it
+// became due; for the radios that is the longest gap between two polls. The
+// two times are words, they stop at 65535 us.
+// The names are flash strings (F()), they take no RAM.
+// Only micros() is used, so it runs the same on the host clock.
+class Scheduler {
+public:
+  static bool Add(const __FlashStringHelper *name, TaskFunction function, word period, word deadline, byte priority);
+  static void Run();
+
+  static byte GetTaskCount();
+  static const __FlashStringHelper *GetName(byte task);
+  static unsigned long GetRuns(byte task);
+  static word GetMaxRunTime(byte task);
+  static word GetMaxLateness(byte task);
+  static void ResetStatistics();
+  static void ShowStatistics();
+
+private:
+  struct Task {
+    const __FlashStringHelper *Name;
+    TaskFunction Function;
+    word Period;
+    word Deadline;
+    byte Priority;
+    unsigned long Due;          // micros()
+    unsigned long Runs;
+    word MaxRunTime;            // us, at most 65535
+    word MaxLateness;
+  };
+
+  static Task m_tasks[SCHEDULER_MAX_TASKS];
+  static byte m_count;
+
+  static void RunTask(Task *task, unsigned long now);
+  static bool IsDue(Task *task, unsigned long now);
+  static void SetMax(word *max, unsigned long value);
+};
+
+#endif
@@ -1,25 +1,69 @@
 #include "SensorBase.h"
+#include "CRC8.h"
+#include "SensorTable.h"
+#include "Aggregator.h"
+#include "SerialQueue.h"
 
 bool SensorBase::m_debug = false;
+bool SensorBase::m_binaryOutput = false;
 
 byte SensorBase::CalculateCRC(byte *data, byte len) {
-  int i, j;
-  byte res = 0;
-  for (j = 0; j < len; j++) {
-    uint8_t val = data[j];
-    for (i = 0; i < 8; i++) {
-      uint8_t tmp = (uint8_t)((res ^ val) & 0x80);
-      res <<= 1;
-      if (0 != tmp) {
-        res ^= 0x31;
-      }
-      val <<= 1;
-    }
-  }
-  return res;
+  return CRC8::Calculate(data, len);
 }
 
 void SensorBase::SetDebugMode(boolean mode) {
   m_debug = mode;
 }
 
+void SensorBase::SetBinaryOutput(bool binary) {
+  m_binaryOutput = binary;
+}
+
+bool SensorBase::IsBinaryOutput() {
+  return m_binaryOutput;
+}
+
+bool SensorBase::IsRecordNeeded() {
+  return m_binaryOutput || SensorTable::IsEnabled() || Aggregator::IsEnabled();
+}
+
+
+bool SensorBase::HandleFrame(const void *frame, RecordBuilder buildRecord, LineBuilder buildLine) {
+  byte buffer[RECORD_SIZE];
+  return HandleFrame(frame, buildRecord, buildLine, buffer, sizeof(buffer));
+}
+
+bool SensorBase::HandleFrame(const void *frame, RecordBuilder buildRecord, LineBuilder buildLine,
+  byte *buffer, byte size) {
+  // Change-only reporting and aggregation work on the record, also for the text output
+  if (IsRecordNeeded()) {
+    RecordWriter record(buffer, size);
+    if (!buildRecord(frame, &record)) {
+      return false;
+    }
+    if (Aggregator::TryAdd(buffer, record.GetLength())
+      || !SensorTable::IsReported(buffer, record.GetLength())) {
+      return true;
+    }
+    if (m_binaryOutput) {
+      record.Send();
+      return true;
+    }
+  }
+
+  // The line is counted first and then built again straight into the queue,
+  // whole or not at all like SerialQueue::AddLine()
+  LineWriter counter(false);
+  if (!buildLine(frame, &counter)) {
+    return false;
+  }
+  if (SerialQueue::Reserve(counter.GetLength() + 2)) {
+    LineWriter line(true);
+    buildLine(frame, &line);
+    SerialQueue::Put('\r');
+    SerialQueue::Put('\n');
+    SerialQueue::Handle();
+  }
+
+  return true;
+}
@@ -2,14 +2,34 @@
 #define _SENSORBASE_h
 
 #include "Arduino.h"
+#include "LineWriter.h"
+#include "RecordWriter.h"
 
 class SensorBase {
 public:
+  // Build the record or the line of a frame, which the decoder passes through HandleFrame
+  typedef bool (*RecordBuilder)(const void *frame, RecordWriter *record);
+  typedef bool (*LineBuilder)(const void *frame, LineWriter *line);
+
   static byte CalculateCRC(byte *data, byte len);
   static void SetDebugMode(boolean mode);
+  // Records of the RecordWriter instead of the text lines
+  static void SetBinaryOutput(bool binary);
+  static bool IsBinaryOutput();
+  // Binary output, change-only reporting or aggregation: a frame needs its record
+  static bool IsRecordNeeded();
+  // Output of a decoded frame: the record goes to the aggregation and the
+  // change-only reporting, then it is sent or the line is queued. False when
+  // the builder rejects the frame. Only the record takes a buffer, RECORD_SIZE
+  // on the stack unless the decoder passes a longer one (or none while no
+  // record is needed), the line is built straight into the SerialQueue.
+  static bool HandleFrame(const void *frame, RecordBuilder buildRecord, LineBuilder buildLine);
+  static bool HandleFrame(const void *frame, RecordBuilder buildRecord, LineBuilder buildLine,
+    byte *buffer, byte size);
 
 protected:
   static bool m_debug;
+  static bool m_binaryOutput;
 
 };
 
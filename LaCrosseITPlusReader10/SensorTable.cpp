@@ -0,0 +1,253 @@
+#include "SensorTable.h"
+#include "RecordWriter.h"
+
+#if SENSOR_TABLE_SIZE > 0
+SensorTable::Entry SensorTable::m_entries[SENSOR_TABLE_SIZE];
+#endif
+byte SensorTable::m_maxSilence = 0;
+byte SensorTable::m_temperatureDelta = 0;
+byte SensorTable::m_humidityDelta = 0;
+byte SensorTable::m_lastSweep = 0;
+unsigned long SensorTable::m_reported = 0;
+unsigned long SensorTable::m_suppressed = 0;
+
+// Starts with an empty table, so every sensor is reported once more.
+// Without the table it stays off.
+bool SensorTable::Configure(word maxSilence) {
+#if SENSOR_TABLE_SIZE == 0
+  return maxSilence == 0;
+#else
+  if (maxSilence > SENSOR_TABLE_MAX_SILENCE) {
+    maxSilence = SENSOR_TABLE_MAX_SILENCE;
+  }
+  m_maxSilence = ((unsigned long)maxSilence * 1000) >> SENSOR_TABLE_TICK_SHIFT;
+  if (maxSilence > 0 && m_maxSilence == 0) {
+    m_maxSilence = 1;
+  }
+  memset(m_entries, 0, sizeof(m_entries));
+  return true;
+#endif
+}
+
+void SensorTable::SetDeltas(byte temperatureDelta, byte humidityDelta) {
+  m_temperatureDelta = temperatureDelta;
+  m_humidityDelta = humidityDelta;
+}
+
+bool SensorTable::IsEnabled() {
+  return m_maxSilence > 0;
+}
+
+byte SensorTable::GetNow() {
+  return millis() >> SENSOR_TABLE_TICK_SHIFT;
+}
+
+// Once per tick the age of the entries is held at the max silence, so it
+// cannot wrap while a sensor is quiet for longer than a byte of ticks
+void SensorTable::Handle() {
+#if SENSOR_TABLE_SIZE > 0
+  byte now = GetNow();
+  if (!IsEnabled() || now == m_lastSweep) {
+    return;
+  }
+  m_lastSweep = now;
+
+  for (byte i = 0; i < SENSOR_TABLE_SIZE; i++) {
+    if (GetTag(&m_entries[i]) != 0 && (byte)(now - m_entries[i].LastReport) > m_maxSilence) {
+      m_entries[i].LastReport = now - m_maxSilence;
+    }
+  }
+#endif
+}
+
+#if SENSOR_TABLE_SIZE > 0
+// Entries are never freed one by one, so the free ones are all at the end.
+// Without a match the first free entry or the one reported longest ago.
+SensorTable::Entry *SensorTable::Find(byte tag, byte id, byte now) {
+  Entry *oldest = m_entries;
+  for (byte i = 0; i < SENSOR_TABLE_SIZE; i++) {
+    Entry *entry = &m_entries[i];
+    if (GetTag(entry) == tag && entry->ID == id) {
+      return entry;
+    }
+    if (GetTag(entry) == 0) {
+      oldest = entry;
+      break;
+    }
+    if ((byte)(now - entry->LastReport) > (byte)(now - oldest->LastReport)) {
+      oldest = entry;
+    }
+  }
+
+  oldest->Temperature = 0;
+  return oldest;
+}
+
+byte SensorTable::GetTag(const Entry *entry) {
+  return entry->Temperature >> 12;
+}
+
+int SensorTable::GetTemperature(const Entry *entry) {
+  return (int16_t)(entry->Temperature << 4) >> 4;
+}
+#endif
+
+bool SensorTable::IsDifferent(int value, int last, byte delta) {
+  int difference = value - last;
+  if (difference < 0) {
+    difference = -difference;
+  }
+  return difference >= (delta > 0 ? delta : 1);
+}
+
+// CRC-16/CCITT (polynomial 0x1021, init 0xFFFF), it detects every error
+// burst of up to 16 bits
+word SensorTable::CalculateChecksum(const byte *data, byte length) {
+  word crc = 0xFFFF;
+  for (byte i = 0; i < length; i++) {
+    crc ^= (word)data[i] << 8;
+    for (byte j = 0; j < 8; j++) {
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+#if SENSOR_TABLE_SIZE == 0
+bool SensorTable::IsReported(const byte * /* record */, byte /* length */) {
+  return true;
+}
+#else
+bool SensorTable::IsReported(const byte *record, byte length) {
+  if (!IsEnabled() || length < 3) {
+    return true;
+  }
+
+  // Where temperature and humidity are in the record, see RecordWriter.h
+  byte id = record[1];
+  int8_t temperatureAt = -1;
+  int8_t humidityAt = -1;
+  switch (record[0]) {
+  case RECORD_LACROSSE:
+  case RECORD_WT440XH:
+  case RECORD_TX38IT:
+    temperatureAt = 3;
+    humidityAt = 5;
+    break;
+
+  case RECORD_TX22IT:
+  case RECORD_WS1080:
+  case RECORD_INTERNAL: {
+    byte position = 4;
+    if (record[3] & RECORD_HAS_TEMPERATURE) {
+      temperatureAt = position;
+      position += 2;
+    }
+    if (record[3] & RECORD_HAS_HUMIDITY) {
+      humidityAt = position;
+    }
+    break;
+  }
+
+  case RECORD_LEVELSENDER:
+    temperatureAt = 5;
+    break;
+
+  case RECORD_EMT7110:
+    id = record[1] ^ record[2];
+    break;
+  }
+  if (temperatureAt + 2 > length || humidityAt + 1 > length || ((temperatureAt >= 0 || humidityAt >= 0) && length > RECORD_SIZE)) {
+    return true;
+  }
+
+  int temperature = 0;
+  byte humidity = 0;
+  word checksum;
+  if (temperatureAt >= 0 || humidityAt >= 0) {
+    byte values[RECORD_SIZE];
+    memcpy(values, record, length);
+    if (temperatureAt >= 0) {
+      temperature = (int16_t)(values[temperatureAt] << 8 | values[temperatureAt + 1]);
+      if (temperature > SENSOR_TABLE_MAX_TEMPERATURE) {
+        temperature = SENSOR_TABLE_MAX_TEMPERATURE;
+      }
+      else if (temperature < -SENSOR_TABLE_MAX_TEMPERATURE - 1) {
+        temperature = -SENSOR_TABLE_MAX_TEMPERATURE - 1;
+      }
+      values[temperatureAt] = 0;
+      values[temperatureAt + 1] = 0;
+    }
+    if (humidityAt >= 0) {
+      humidity = values[humidityAt];
+      values[humidityAt] = 0;
+    }
+    checksum = CalculateChecksum(values, length);
+  }
+  else {
+    checksum = CalculateChecksum(record, length);
+  }
+
+  byte tag = record[0];
+  byte now = GetNow();
+  Entry *entry = Find(tag, id, now);
+  bool isReported = GetTag(entry) != tag
+    || entry->Checksum != checksum
+    || (temperatureAt >= 0 && IsDifferent(temperature, GetTemperature(entry), m_temperatureDelta))
+    || (humidityAt >= 0 && IsDifferent(humidity, entry->Humidity, m_humidityDelta))
+    || (byte)(now - entry->LastReport) >= m_maxSilence;
+
+  if (!isReported) {
+    m_suppressed++;
+    return false;
+  }
+
+  entry->ID = id;
+  entry->Temperature = (word)tag << 12 | (temperature & 0x0FFF);
+  entry->Humidity = humidity;
+  entry->Checksum = checksum;
+  entry->LastReport = now;
+  m_reported++;
+  return true;
+}
+#endif
+
+byte SensorTable::GetCount() {
+  byte count = 0;
+#if SENSOR_TABLE_SIZE > 0
+  for (byte i = 0; i < SENSOR_TABLE_SIZE; i++) {
+    if (GetTag(&m_entries[i]) != 0) {
+      count++;
+    }
+  }
+#endif
+  return count;
+}
+
+unsigned long SensorTable::GetReported() {
+  return m_reported;
+}
+
+unsigned long SensorTable::GetSuppressed() {
+  return m_suppressed;
+}
+
+void SensorTable::ResetStatistics() {
+  m_reported = 0;
+  m_suppressed = 0;
+}
+
+void SensorTable::ShowStatistics() {
+  unsigned long frames = m_reported + m_suppressed;
+  Serial.print(F("[Sensors:"));
+  Serial.print(GetCount());
+  Serial.print('/');
+  Serial.print(SENSOR_TABLE_SIZE);
+  Serial.print(F(" reported:"));
+  Serial.print(m_reported);
+  Serial.print(F(" suppressed:"));
+  Serial.print(m_suppressed);
+  Serial.print(F(" ("));
+  Serial.print(frames > 0 ? m_suppressed * 100 / frames : 0);
+  Serial.println(F("%)]"));
+}
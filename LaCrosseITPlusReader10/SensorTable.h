@@ -0,0 +1,82 @@
+#ifndef _SENSORTABLE_h
+#define _SENSORTABLE_h
+
+#include "Arduino.h"
+
+// Sensors whose last report is kept, 7 bytes each. The ATmega328P has no
+// room for the table next to the radios, so it is opt-in: 0 leaves
+// change-only reporting out of the build (k answers failed), define it (16
+// takes 112 bytes) here or with -DSENSOR_TABLE_SIZE=16 to have it
+#ifndef SENSOR_TABLE_SIZE
+#define SENSOR_TABLE_SIZE 0
+#endif
+
+// LastReport counts in millis() >> SENSOR_TABLE_TICK_SHIFT (4.096 s), a byte
+// of them covers a little more than the longest silence
+#define SENSOR_TABLE_TICK_SHIFT 12
+#define SENSOR_TABLE_MAX_SILENCE 1000
+// The temperature is kept in 12 bits, beyond +-204.7 C it counts as the same
+#define SENSOR_TABLE_MAX_TEMPERATURE 2047
+
+// Change-only reporting (<n>k): a frame is only passed on when its values
+// differ from the last reported ones of the same sensor, or when that sensor
+// has not been reported for the max silence. Temperature and humidity count
+// as changed from a delta on, all other fields of the record (flags, rain,
+// wind, pressure, power, level ...) on any change.
+// The values are taken from the binary record of the frame, so the table
+// works the same for every protocol and output format. The other fields are
+// kept as a CRC16 of the record: a change within one byte or one word
+// (flags, rain, a wind value ...) is always seen, only a change of several
+// fields at once goes unnoticed with a chance of 1 in 65536, until the max
+// silence reports the sensor anyway.
+// A sensor is known by the tag of its record and the low byte of its ID
+// (EMT7110: both bytes folded), two EMT7110 that meet there share an entry.
+class SensorTable {
+public:
+  // maxSilence in seconds, 0 switches change-only reporting off. False with
+  // SENSOR_TABLE_SIZE 0 for anything else, it stays off then
+  static bool Configure(word maxSilence);
+  // Temperature in 1/10 C, humidity in %, 0 = any change
+  static void SetDeltas(byte temperatureDelta, byte humidityDelta);
+  static bool IsEnabled();
+  // Remembers the values when the record is to be reported
+  static bool IsReported(const byte *record, byte length);
+  // Called from loop()
+  static void Handle();
+
+  static byte GetCount();
+  static unsigned long GetReported();
+  static unsigned long GetSuppressed();
+  static void ResetStatistics();
+  static void ShowStatistics();
+
+private:
+  struct __attribute__((packed)) Entry {
+    byte ID;             // low byte of the ID
+    word Temperature;    // tag << 12 | temperature in 1/10 C (12 bits), tag 0 if the entry is free
+    byte Humidity;
+    word Checksum;       // CRC16 of the record without temperature and humidity
+    byte LastReport;     // in ticks
+  };
+
+#if SENSOR_TABLE_SIZE > 0
+  static Entry m_entries[SENSOR_TABLE_SIZE];
+#endif
+  static byte m_maxSilence;        // in ticks, 0 = off
+  static byte m_temperatureDelta;
+  static byte m_humidityDelta;
+  static byte m_lastSweep;
+  static unsigned long m_reported;
+  static unsigned long m_suppressed;
+
+  static byte GetNow();
+#if SENSOR_TABLE_SIZE > 0
+  static Entry *Find(byte tag, byte id, byte now);
+  static byte GetTag(const Entry *entry);
+  static int GetTemperature(const Entry *entry);
+#endif
+  static bool IsDifferent(int value, int last, byte delta);
+  static word CalculateChecksum(const byte *data, byte length);
+};
+
+#endif
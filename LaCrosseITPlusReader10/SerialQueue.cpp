@@ -0,0 +1,91 @@
+#include "SerialQueue.h"
+
+byte SerialQueue::m_buffer[SERIAL_QUEUE_SIZE];
+word SerialQueue::m_head = 0;
+word SerialQueue::m_tail = 0;
+word SerialQueue::m_highWaterMark = 0;
+unsigned long SerialQueue::m_droppedLines = 0;
+
+// Makes room first, the TX buffer may have emptied since the last loop()
+bool SerialQueue::Reserve(word length) {
+  Handle();
+
+  if (length > SERIAL_QUEUE_SIZE - GetCount()) {
+    m_droppedLines++;
+    return false;
+  }
+
+  if (GetCount() + length > m_highWaterMark) {
+    m_highWaterMark = GetCount() + length;
+  }
+  return true;
+}
+
+void SerialQueue::Put(byte value) {
+  m_buffer[m_head & (SERIAL_QUEUE_SIZE - 1)] = value;
+  m_head++;
+}
+
+void SerialQueue::Put(const byte *data, word length) {
+  for (word i = 0; i < length; i++) {
+    Put(data[i]);
+  }
+}
+
+bool SerialQueue::AddLine(const char *text) {
+  word length = strlen(text);
+  if (!Reserve(length + 2)) {
+    return false;
+  }
+
+  Put((const byte *)text, length);
+  Put('\r');
+  Put('\n');
+  Handle();
+  return true;
+}
+
+// Never blocks: only what the TX buffer of the core takes right now
+void SerialQueue::Handle() {
+  int space = Serial.availableForWrite();
+  while (space > 0 && m_tail != m_head) {
+    Serial.write(m_buffer[m_tail & (SERIAL_QUEUE_SIZE - 1)]);
+    m_tail++;
+    space--;
+  }
+}
+
+// Blocks until everything is in the TX buffer of the core
+void SerialQueue::Flush() {
+  while (m_tail != m_head) {
+    Serial.write(m_buffer[m_tail & (SERIAL_QUEUE_SIZE - 1)]);
+    m_tail++;
+  }
+}
+
+word SerialQueue::GetCount() {
+  return m_head - m_tail;
+}
+
+word SerialQueue::GetHighWaterMark() {
+  return m_highWaterMark;
+}
+
+unsigned long SerialQueue::GetDroppedLines() {
+  return m_droppedLines;
+}
+
+void SerialQueue::ResetStatistics() {
+  m_highWaterMark = GetCount();
+  m_droppedLines = 0;
+}
+
+void SerialQueue::ShowStatistics() {
+  Serial.print(F("[Serial queue max:"));
+  Serial.print(m_highWaterMark);
+  Serial.print('/');
+  Serial.print(SERIAL_QUEUE_SIZE);
+  Serial.print(F(" dropped:"));
+  Serial.print(m_droppedLines);
+  Serial.println(']');
+}
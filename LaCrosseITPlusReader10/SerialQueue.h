@@ -0,0 +1,48 @@
+#ifndef _SERIALQUEUE_h
+#define _SERIALQUEUE_h
+
+#include "Arduino.h"
+
+// Bytes of decoded output that can wait for the UART, must be a power of two
+#ifndef SERIAL_QUEUE_SIZE
+#define SERIAL_QUEUE_SIZE 256
+#endif
+
+// Output queue of the decoded frames in front of the serial port.
+// Serial.print() blocks as soon as the 64 byte TX buffer of the core is full,
+// and while it waits no radio is polled. The decoders put their lines and
+// records in here instead, whole or not at all, and loop() moves only as much
+// into the TX buffer as fits without blocking. The UDRE interrupt of the core
+// does the rest. A line that does not fit is dropped and counted.
+// Command replies and debug messages still go straight to Serial, so the
+// queue is flushed before a command is handled.
+class SerialQueue {
+public:
+  // Producer: Reserve() room for length bytes, Put() exactly that many and
+  // Handle() to start sending them
+  static bool Reserve(word length);
+  static void Put(byte value);
+  static void Put(const byte *data, word length);
+  // Text and "\r\n" like Serial.println()
+  static bool AddLine(const char *text);
+
+  // Consumer
+  static void Handle();
+  static void Flush();
+
+  static word GetCount();
+  static word GetHighWaterMark();
+  static unsigned long GetDroppedLines();
+  static void ResetStatistics();
+  static void ShowStatistics();
+
+private:
+  static byte m_buffer[SERIAL_QUEUE_SIZE];
+  // Free running, the index is taken modulo SERIAL_QUEUE_SIZE
+  static word m_head;
+  static word m_tail;
+  static word m_highWaterMark;
+  static unsigned long m_droppedLines;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "SpiTransport.h"
+
+#define clrb(pin) (*portOutputRegister(digitalPinToPort(pin)) &= ~digitalPinToBitMask(pin))
+#define setb(pin) (*portOutputRegister(digitalPinToPort(pin)) |= digitalPinToBitMask(pin))
+
+BitBangSpi::BitBangSpi(byte mosi, byte miso, byte sck, byte ss) {
+  m_mosi = mosi;
+  m_miso = miso;
+  m_sck = sck;
+  m_ss = ss;
+
+  pinMode(m_mosi, OUTPUT);
+  pinMode(m_miso, INPUT);
+  pinMode(m_sck, OUTPUT);
+  pinMode(m_ss, OUTPUT);
+
+  digitalWrite(m_ss, HIGH);
+}
+
+// No SPI library transactions to mask the interrupt in, nor a clock to set
+void BitBangSpi::Begin(int /* interruptNumber */) {
+}
+
+void BitBangSpi::SetClock(unsigned long /* hz */) {
+}
+
+void BitBangSpi::Select() {
+  clrb(m_ss);
+}
+
+void BitBangSpi::Deselect() {
+  setb(m_ss);
+}
+
+// MISO is sampled after the rising edge, the RFMs change it on the falling edge
+byte BitBangSpi::Transfer(byte value) {
+  volatile byte *misoPort = portInputRegister(digitalPinToPort(m_miso));
+  byte misoBit = digitalPinToBitMask(m_miso);
+  for (byte i = 8; i; i--) {
+    clrb(m_sck);
+    if (value & 0x80) {
+      setb(m_mosi);
+    }
+    else {
+      clrb(m_mosi);
+    }
+    value <<= 1;
+    setb(m_sck);
+    asm("nop");
+    asm("nop");
+    if (*misoPort & misoBit) {
+      value |= 1;
+    }
+  }
+  clrb(m_sck);
+
+  return value;
+}
+
+bool BitBangSpi::ReadMiso() {
+  return digitalRead(m_miso);
+}
+
+
+HardwareSpi::HardwareSpi(byte ss) {
+  m_ss = ss;
+
+  pinMode(m_ss, OUTPUT);
+  digitalWrite(m_ss, HIGH);
+}
+
+void HardwareSpi::Begin(int interruptNumber) {
+  SPI.begin();
+  // beginTransaction masks it, so the handler of the radio never finds
+  // the bus in the middle of a transaction
+  if (interruptNumber == 0 || interruptNumber == 1) {
+    SPI.usingInterrupt(interruptNumber);
+  }
+}
+
+void HardwareSpi::SetClock(unsigned long hz) {
+  m_settings = SPISettings(hz, MSBFIRST, SPI_MODE0);
+}
+
+void HardwareSpi::Select() {
+  SPI.beginTransaction(m_settings);
+  clrb(m_ss);
+}
+
+void HardwareSpi::Deselect() {
+  setb(m_ss);
+  SPI.endTransaction();
+}
+
+byte HardwareSpi::Transfer(byte value) {
+  return SPI.transfer(value);
+}
+
+bool HardwareSpi::ReadMiso() {
+  return digitalRead(MISO);
+}
@@ -0,0 +1,56 @@
+#ifndef _SPITRANSPORT_h
+#define _SPITRANSPORT_h
+
+#include "Arduino.h"
+#include <SPI.h>
+
+// Bus of a radio. The RFM class only selects the chip, transfers bytes and
+// looks at MISO (a selected RFM12 shows FFIT there), so each radio can use
+// the SPI hardware or bit-bang its own pins.
+// The constructors already drive SS high, so that a radio which is not
+// initialized yet does not listen to the bus.
+class SpiTransport {
+public:
+  // interruptNumber is the external interrupt of nIRQ or NOT_AN_INTERRUPT,
+  // its handler uses the bus as well
+  virtual void Begin(int interruptNumber) = 0;
+  // Highest SCK frequency the radio allows, a bit-banged bus is slower anyway
+  virtual void SetClock(unsigned long hz) = 0;
+  virtual void Select() = 0;
+  virtual void Deselect() = 0;
+  virtual byte Transfer(byte value) = 0;
+  virtual bool ReadMiso() = 0;
+};
+
+// SPI mode 0 on any pins with the port macros
+class BitBangSpi : public SpiTransport {
+public:
+  BitBangSpi(byte mosi, byte miso, byte sck, byte ss);
+  void Begin(int interruptNumber);
+  void SetClock(unsigned long hz);
+  void Select();
+  void Deselect();
+  byte Transfer(byte value);
+  bool ReadMiso();
+
+private:
+  byte m_mosi, m_miso, m_sck, m_ss;
+};
+
+// SPI library with transactions, MOSI, MISO and SCK are the fixed pins of the board
+class HardwareSpi : public SpiTransport {
+public:
+  HardwareSpi(byte ss);
+  void Begin(int interruptNumber);
+  void SetClock(unsigned long hz);
+  void Select();
+  void Deselect();
+  byte Transfer(byte value);
+  bool ReadMiso();
+
+private:
+  byte m_ss;
+  SPISettings m_settings;
+};
+
+#endif
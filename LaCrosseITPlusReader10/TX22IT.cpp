@@ -40,63 +40,9 @@ TX22IT [A    1    C    2     0  5 5 3              2  0 1 B
 
 */
 
+// CRC8 with polynomial 0x31 over all bytes except the CRC itself
 byte TX22IT::CalculateCRC(byte data[]) {
-  byte CRC[8];
-  byte bits[8];
-  int i,j;
-  byte val;
-  byte DoInvert;
-  byte result;
-  
-  byte len = TX22IT::GetFrameLength(data) -1;
-
-  for(i=0; i<8; i++) {
-    CRC[i] = 0;
-  }
-
-  for(j=0; j<len; j++) {
-    val = data[j];
-    
-    for(i=0; i<8; i++) {
-      switch(i) {
-        case 0: if((val & 0x80) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
-        case 1: if((val & 0x40) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
-        case 2: if((val & 0x20) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
-        case 3: if((val & 0x10) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
-        case 4: if((val & 0x8) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
-        case 5: if((val & 0x4) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
-        case 6: if((val & 0x2) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
-        case 7: if((val & 0x1) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
-      }
-  
-      if(bits[i] == 1) {
-        DoInvert = 1 ^ CRC[7];
-      }
-      else {
-        DoInvert = 0 ^ CRC[7];
-      }  
-      
-      CRC[7] = CRC[6];
-      CRC[6] = CRC[5];
-      CRC[5] = CRC[4] ^ DoInvert;
-      CRC[4] = CRC[3] ^ DoInvert;
-      CRC[3] = CRC[2];
-      CRC[2] = CRC[1];
-      CRC[1] = CRC[0];
-      CRC[0] = DoInvert;
-    }
-  }
-
-  result = (CRC[7] << 7) |
-           (CRC[6] << 6) |
-           (CRC[5] << 5) |
-           (CRC[4] << 4) |
-           (CRC[3] << 3) |
-           (CRC[2] << 2) |
-           (CRC[1] << 1) |
-           (CRC[0]);
-              
-  return result;
+  return SensorBase::CalculateCRC(data, GetFrameLength(data) - 1);
 }
 
 void TX22IT::DecodeFrame(byte *bytes, struct Frame *frame) {
@@ -123,8 +69,9 @@ void TX22IT::DecodeFrame(byte *bytes, struct Frame *frame) {
   frame->WindGust = 0;
   frame->CRC = 0;
 
-  frame->CRC = bytes[GetFrameLength(bytes) -1];
-  if (frame->CRC != CalculateCRC(bytes)) {
+  byte frameLength = GetFrameLength(bytes);
+  frame->CRC = bytes[frameLength - 1];
+  if (frame->CRC != SensorBase::CalculateCRC(bytes, frameLength - 1)) {
     frame->IsValid = false;
   }
 
@@ -142,6 +89,7 @@ void TX22IT::DecodeFrame(byte *bytes, struct Frame *frame) {
 
     byte ct = bytes[1] & 0x7;
     for (int i = 0; i < ct; i++) {
+      word value;
       byte byte1 = bytes[2 + i * 2];
       byte byte2 = bytes[3 + i * 2];
 
@@ -153,36 +101,37 @@ void TX22IT::DecodeFrame(byte *bytes, struct Frame *frame) {
       switch (type) {
         case 0:
           frame->HasTemperature = true;
-          frame->Temperature = (DecodeValue(q1, q2, q3) - 400) / 10.0;
-          if (frame->Temperature > 60 || frame->Temperature < -40) {
+          frame->Temperature = DecodeValue(q1, q2, q3) - 400;
+          if (frame->Temperature > 600 || frame->Temperature < -400) {
             frame->IsValid = false;
           }
           break;
         
         case 1:
           frame->HasHumidity= true;
-          frame->Humidity = DecodeValue(q1, q2, q3);
-          if (frame->Humidity > 100 || frame->Humidity < 0) {
+          value = DecodeValue(q1, q2, q3);
+          frame->Humidity = value;
+          if (value > 100) {
             frame->IsValid = false;
           }
           break;
 
         case 2:
           frame->HasRain = true;
-          frame->Rain = q1 * 256 + q2 * 16 + q3;
+          frame->Rain = (q1 * 256 + q2 * 16 + q3) * 10;
           break;
 
         case 3:
           frame->HasWindDirection = true;
           frame->HasWindSpeed = true;
 
-          frame->WindDirection = q1 * 22.5;
-          frame->WindSpeed = (q2 * 16 + q3) / 10.0;
+          frame->WindDirection = q1 * 225;
+          frame->WindSpeed = q2 * 16 + q3;
           break;
 
         case 4:
           frame->HasWindGust = true;
-          frame->WindGust = (q2 * 16 + q3) / 10.0;
+          frame->WindGust = q2 * 16 + q3;
           break;
       }
 
@@ -203,35 +152,45 @@ String TX22IT::AnalyzeFrame(byte *data) {
 
   byte frameLength = TX22IT::GetFrameLength(data);
 
-  return WSBase::AnalyzeFrame(data, &frame, frameLength, "TX22IT");
+  return WSBase::AnalyzeFrame(data, &frame, frameLength, F("TX22IT"));
 
 }
 
-String TX22IT::GetFhemDataString(byte *data) {
-  String fhemString = "";
+bool TX22IT::GetFhemDataString(byte *data, LineWriter *line) {
+  bool result = false;
 
   if ((data[0] & 0xA0) == 0xA0) {
     struct Frame frame;
     DecodeFrame(data, &frame);
     if (frame.IsValid) {
-      fhemString = BuildFhemDataString(&frame, 1);
+      result = BuildFhemDataString(&frame, 1, line);
     }
   }
 
-  return fhemString;
+  return result;
+}
+
+bool TX22IT::BuildRecord(const void *frame, RecordWriter *record) {
+  return BuildBinaryRecord((struct Frame *)frame, RECORD_TX22IT, record);
+}
+
+bool TX22IT::BuildLine(const void *frame, LineWriter *line) {
+  return BuildFhemDataString((struct Frame *)frame, 1, line);
 }
 
 bool TX22IT::TryHandleData(byte *data) {
-  String fhemString = GetFhemDataString(data);
+  bool result = false;
 
-  if (fhemString.length() > 0) {
-    Serial.println(fhemString);
+  if ((data[0] & 0xA0) == 0xA0) {
+    struct Frame frame;
+    DecodeFrame(data, &frame);
+    if (frame.IsValid) {
+      result = HandleFrame(&frame, BuildRecord, BuildLine);
+    }
   }
- 
-  return fhemString.length() > 0;
-}
-
 
+  return result;
+}
 
 void TX22IT::EncodeFrame(struct Frame *frame, byte bytes[4]) {
 
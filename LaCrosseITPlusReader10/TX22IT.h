@@ -13,12 +13,14 @@ public:
   static void DecodeFrame(byte *bytes, struct WSBase::Frame *frame);
   static String AnalyzeFrame(byte *data);
   static bool TryHandleData(byte *data);
-  static String GetFhemDataString(byte *data);
+  static bool GetFhemDataString(byte *data, LineWriter *line);
   static bool IsValidDataRate(unsigned long dataRate);
 
 
 protected:
   
+  static bool BuildRecord(const void *frame, RecordWriter *record);
+  static bool BuildLine(const void *frame, LineWriter *line);
 
 };
 
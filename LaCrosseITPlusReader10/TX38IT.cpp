@@ -1,4 +1,5 @@
 #include "TX38IT.h"
+#include "CRC8.h"
 
 /*
 * Technoline TX38-IT 17.241 868.3 MHz
@@ -22,32 +23,9 @@
 */
 
 
+// The CRC covers the first 20 bits (ID, flags and temperature)
 byte TX38IT::CalculateCRC(byte data[]) {
-  int i, j;
-  byte res = 0;
-  
-  int len = 3;
-  int bits = 20;
-  
-  for (j = 0; j < len; j++) 
-  {
-    uint8_t val = data[j];
-    for (i = 0; i < 8; i++) 
-    {
-      int bitNum = j * 8 + i;
-      
-      if(bitNum < bits)
-      {          
-        uint8_t tmp = (uint8_t)((res ^ val) & 0x80);
-        res <<= 1;
-        if (0 != tmp) {
-          res ^= 0x31;
-        }
-        val <<= 1;
-      }
-    }
-  }
-  return res;
+  return CRC8::CalculateBits(data, 20);
 }
 
 void TX38IT::EncodeFrame(struct Frame *frame, byte bytes[4]) {
@@ -62,7 +40,7 @@ void TX38IT::EncodeFrame(struct Frame *frame, byte bytes[4]) {
   bytes[1] |= frame->WeakBatteryFlag << 6;
 
   // Temperature
-  long tempVal = (frame->Temperature + 40.0) * 10.0;
+  int tempVal = frame->Temperature + 400;
 
   bytes[1] |= (tempVal >> 4) & 0x3F;
   bytes[2] |= (tempVal << 4) & 0xF0;
@@ -94,11 +72,9 @@ void TX38IT::DecodeFrame(byte *bytes, struct Frame *frame) {
   frame->NewBatteryFlag  = (bytes[1] & 0x80) >> 7;
   frame->WeakBatteryFlag = (bytes[1] & 0x40) >> 6;
 
-  long tempVal;
-  
-  tempVal = ((bytes[1] & 0x3F) << 4) | (bytes[2] & 0xf0) >> 4;
+  int tempVal = ((bytes[1] & 0x3F) << 4) | (bytes[2] & 0xf0) >> 4;
   
-  frame->Temperature = (tempVal * 0.1) - 40.0;
+  frame->Temperature = tempVal - 400;
   
   frame->miscBits = (bytes[3] & 0x0f);
 
@@ -107,7 +83,7 @@ void TX38IT::DecodeFrame(byte *bytes, struct Frame *frame) {
 }
 
 
-String TX38IT::BuildFhemDataString(struct Frame *frame) {
+bool TX38IT::BuildFhemDataString(struct Frame *frame, LineWriter *line) {
   // Format
   //
   // OK 9 56 1   4   156 37     ID = 56  T: 18.0  H: 37  no NewBatt
@@ -123,10 +99,9 @@ String TX38IT::BuildFhemDataString(struct Frame *frame) {
   // |  |------------------- fix "9"
   // |---------------------- fix "OK"
 
-  String pBuf;
-  pBuf += "OK 9 ";
-  pBuf += frame->ID;
-  pBuf += ' ';
+  line->Add(F("OK 9 "));
+  line->AddNumber(frame->ID);
+  line->Add(' ');
 
   // bogus check humidity + eval 2 channel TX25IT
   // TBD .. Dont understand the magic here!?
@@ -134,36 +109,59 @@ String TX38IT::BuildFhemDataString(struct Frame *frame) {
     || frame->Humidity == 106
     || (frame->Humidity >= 128 && frame->Humidity <= 227)
     || frame->Humidity == 234) {
-    pBuf += frame->NewBatteryFlag ? 129 : 1;
-    pBuf += ' ';
+    line->AddNumber(frame->NewBatteryFlag ? 129 : 1);
+    line->Add(' ');
   }
   else if (frame->Humidity == 125 || frame->Humidity == 253) {
-    pBuf += 2 | frame->NewBatteryFlag ? 130 : 2;
-    pBuf += ' ';
+    line->AddNumber(2 | frame->NewBatteryFlag ? 130 : 2);
+    line->Add(' ');
   }
   else {
-    return "";
+    return false;
   }
 
   // add temperature
-  uint16_t pTemp = (uint16_t)(frame->Temperature * 10 + 1000);
-  pBuf += (byte)(pTemp >> 8);
-  pBuf += ' ';
-  pBuf += (byte)(pTemp);
-  pBuf += ' ';
+  uint16_t pTemp = frame->Temperature + 1000;
+  line->AddNumber((byte)(pTemp >> 8));
+  line->Add(' ');
+  line->AddNumber((byte)(pTemp));
+  line->Add(' ');
 
   // bogus check temperature
-  if (frame->Temperature >= 60 || frame->Temperature <= -40)
-    return "";
+  if (frame->Temperature >= 600 || frame->Temperature <= -400)
+    return false;
 
   // add humidity
   byte hum = frame->Humidity;
   if (frame->WeakBatteryFlag) {
     hum |= 0x80;
   }
-  pBuf += hum;
+  line->AddNumber(hum);
 
-  return pBuf;
+  return true;
+}
+
+// Laid out like a LaCrosse record, the humidity is always 106 (none)
+bool TX38IT::BuildBinaryRecord(struct Frame *frame, RecordWriter *record) {
+  if (frame->Temperature >= 600 || frame->Temperature <= -400) {
+    return false;
+  }
+
+  byte flags = 0;
+  if (frame->NewBatteryFlag) {
+    flags |= 1;
+  }
+  if (frame->WeakBatteryFlag) {
+    flags |= 2;
+  }
+
+  record->Add(RECORD_TX38IT);
+  record->Add(frame->ID);
+  record->Add(flags);
+  record->AddWord(frame->Temperature);
+  record->Add(frame->Humidity);
+
+  return true;
 }
 
 void TX38IT::AnalyzeFrame(byte *data) {
@@ -195,42 +193,42 @@ void TX38IT::AnalyzeFrame(byte *data) {
     Serial.print(div);
 
     // Show the raw data bytes
-    Serial.print("TX38IT [");
+    Serial.print(F("TX38IT ["));
     for (int i = 0; i < FRAME_LENGTH; i++) {
       Serial.print(data[i], DEC);
-      Serial.print(" ");
+      Serial.print(F(" "));
     }
-    Serial.print("]");
+    Serial.print(F("]"));
 
     // Check CRC
     if (!frame.IsValid) {
-      Serial.print(" CRC:WRONG");
+      Serial.print(F(" CRC:WRONG"));
     }
     else {
-      Serial.print(" CRC:OK");
+      Serial.print(F(" CRC:OK"));
 
       // Start
-      Serial.print(" S:");
+      Serial.print(F(" S:"));
       Serial.print(frame.Header, DEC);
 
       // Sensor ID
-      Serial.print(" ID:");
+      Serial.print(F(" ID:"));
       Serial.print(frame.ID, DEC);
 
       // New battery flag
-      Serial.print(" NewBatt:");
+      Serial.print(F(" NewBatt:"));
       Serial.print(frame.NewBatteryFlag, DEC);
 
       // Weak battery flag
-      Serial.print(" WeakBatt:");
+      Serial.print(F(" WeakBatt:"));
       Serial.print(frame.WeakBatteryFlag, DEC);
 
       // Temperature
-      Serial.print(" Temp:");
-      Serial.print(frame.Temperature);
+      Serial.print(F(" Temp:"));
+      Serial.print(frame.Temperature / 10.0);
 
       // CRC
-      Serial.print(" CRC:");
+      Serial.print(F(" CRC:"));
       Serial.print(frame.CRC, DEC);
     }
 
@@ -239,29 +237,41 @@ void TX38IT::AnalyzeFrame(byte *data) {
 
 }
 
-String TX38IT::GetFhemDataString(byte *data) {
-  String fhemString = "";
+bool TX38IT::GetFhemDataString(byte *data, LineWriter *line) {
+  bool result = false;
 
   if ((data[0] & 0xC0) == 0xC0) {
     struct Frame frame;
     DecodeFrame(data, &frame);
     if (frame.IsValid) {
-      fhemString = BuildFhemDataString(&frame);
+      result = BuildFhemDataString(&frame, line);
     }
   }
 
-  return fhemString;
+  return result;
+
+}
+
+bool TX38IT::BuildRecord(const void *frame, RecordWriter *record) {
+  return BuildBinaryRecord((struct Frame *)frame, record);
+}
 
+bool TX38IT::BuildLine(const void *frame, LineWriter *line) {
+  return BuildFhemDataString((struct Frame *)frame, line);
 }
 
 bool TX38IT::TryHandleData(byte *data) {
-  String fhemString = GetFhemDataString(data);
+  bool result = false;
 
-  if (fhemString.length() > 0) {
-    Serial.println(fhemString);
+  if ((data[0] & 0xC0) == 0xC0) {
+    struct Frame frame;
+    DecodeFrame(data, &frame);
+    if (frame.IsValid) {
+      result = HandleFrame(&frame, BuildRecord, BuildLine);
+    }
   }
 
-  return fhemString.length() > 0;
+  return result;
 }
 
 bool TX38IT::IsValidDataRate(unsigned long dataRate) {
@@ -3,6 +3,8 @@
 
 #include "Arduino.h"
 #include "SensorBase.h"
+#include "LineWriter.h"
+#include "RecordWriter.h"
 
 
 class TX38IT : public SensorBase {
@@ -12,7 +14,7 @@ public:
     byte  ID;
     bool  NewBatteryFlag;
     bool  WeakBatteryFlag;    
-    float Temperature;
+    int   Temperature;    // 1/10 C
     byte  Humidity;
     byte  CRC;
     byte  miscBits;
@@ -26,11 +28,14 @@ public:
   static void DecodeFrame(byte *bytes, struct TX38IT::Frame *frame);
   static void AnalyzeFrame(byte *data);
   static bool TryHandleData(byte *data);
-  static String GetFhemDataString(byte *data);
+  static bool GetFhemDataString(byte *data, LineWriter *line);
   static bool IsValidDataRate(unsigned long dataRate);
 
 protected:
-  static String BuildFhemDataString(struct TX38IT::Frame *frame);
+  static bool BuildFhemDataString(struct TX38IT::Frame *frame, LineWriter *line);
+  static bool BuildBinaryRecord(struct TX38IT::Frame *frame, RecordWriter *record);
+  static bool BuildRecord(const void *frame, RecordWriter *record);
+  static bool BuildLine(const void *frame, LineWriter *line);
 
 };
 
@@ -0,0 +1,137 @@
+#include "TransmitQueue.h"
+
+byte TransmitQueue::m_buffer[TRANSMIT_QUEUE_SIZE * (sizeof(Entry) + TRANSMIT_FRAME_SIZE)];
+byte TransmitQueue::m_used = 0;
+byte TransmitQueue::m_count = 0;
+bool TransmitQueue::m_sending = false;
+unsigned long TransmitQueue::m_restoreRate = 0;
+bool TransmitQueue::m_restoreReceiver = false;
+byte TransmitQueue::m_highWaterMark = 0;
+unsigned long TransmitQueue::m_sentFrames = 0;
+unsigned long TransmitQueue::m_droppedFrames = 0;
+unsigned long TransmitQueue::m_maxWait = 0;
+
+// The header is copied byte by byte, in the buffer it is not aligned
+bool TransmitQueue::Add(RFM *rfm, const byte *data, byte length, unsigned long dataRate, unsigned long delay) {
+  if (length > TRANSMIT_FRAME_SIZE || sizeof(m_buffer) - m_used < sizeof(Entry) + length) {
+    m_droppedFrames++;
+    return false;
+  }
+
+  Entry entry;
+  entry.Radio = rfm;
+  entry.DataRate = dataRate;
+  entry.Due = millis() + delay;
+  entry.Length = length;
+  memcpy(m_buffer + m_used, &entry, sizeof(Entry));
+  memcpy(m_buffer + m_used + sizeof(Entry), data, length);
+
+  m_used += sizeof(Entry) + length;
+  m_count++;
+  if (m_used > m_highWaterMark) {
+    m_highWaterMark = m_used;
+  }
+  return true;
+}
+
+void TransmitQueue::GetHead(Entry *entry) {
+  memcpy(entry, m_buffer, sizeof(Entry));
+}
+
+// Never waits for the radio, a frame is started or finished per call
+void TransmitQueue::Handle() {
+  if (m_count == 0) {
+    return;
+  }
+
+  Entry entry;
+  GetHead(&entry);
+  if (m_sending) {
+    if (!entry.Radio->IsSending()) {
+      Finish(&entry);
+    }
+  }
+  else if ((long)(millis() - entry.Due) >= 0) {
+    Start(&entry);
+    // The RFM12 is already done
+    if (!entry.Radio->IsSending()) {
+      Finish(&entry);
+    }
+  }
+}
+
+void TransmitQueue::Start(Entry *entry) {
+  RFM *rfm = entry->Radio;
+  m_restoreRate = rfm->GetDataRate();
+  m_restoreReceiver = rfm->GetMode() == RFM::Receiving;
+  if (m_restoreRate != entry->DataRate) {
+    rfm->SetDataRate(entry->DataRate);
+  }
+
+  unsigned long wait = millis() - entry->Due;
+  if (wait > m_maxWait) {
+    m_maxWait = wait;
+  }
+  rfm->StartSend(m_buffer + sizeof(Entry), entry->Length);
+  m_sending = true;
+}
+
+void TransmitQueue::Finish(Entry *entry) {
+  RFM *rfm = entry->Radio;
+  if (rfm->GetDataRate() != m_restoreRate) {
+    rfm->SetDataRate(m_restoreRate);
+  }
+  if (m_restoreReceiver) {
+    rfm->EnableReceiver(true);
+  }
+
+  m_sending = false;
+  m_sentFrames++;
+  byte size = sizeof(Entry) + entry->Length;
+  m_used -= size;
+  memmove(m_buffer, m_buffer + size, m_used);
+  m_count--;
+}
+
+bool TransmitQueue::IsSending(RFM *rfm) {
+  if (!m_sending) {
+    return false;
+  }
+  Entry entry;
+  GetHead(&entry);
+  return entry.Radio == rfm;
+}
+
+byte TransmitQueue::GetCount() {
+  return m_count;
+}
+
+unsigned long TransmitQueue::GetSentFrames() {
+  return m_sentFrames;
+}
+
+unsigned long TransmitQueue::GetDroppedFrames() {
+  return m_droppedFrames;
+}
+
+void TransmitQueue::ResetStatistics() {
+  m_highWaterMark = m_used;
+  m_sentFrames = 0;
+  m_droppedFrames = 0;
+  m_maxWait = 0;
+}
+
+// [Transmit queue max:37/94 sent:12 dropped:0 wait:3 ms], max in bytes
+void TransmitQueue::ShowStatistics() {
+  Serial.print(F("[Transmit queue max:"));
+  Serial.print(m_highWaterMark);
+  Serial.print('/');
+  Serial.print(sizeof(m_buffer));
+  Serial.print(F(" sent:"));
+  Serial.print(m_sentFrames);
+  Serial.print(F(" dropped:"));
+  Serial.print(m_droppedFrames);
+  Serial.print(F(" wait:"));
+  Serial.print(m_maxWait);
+  Serial.println(F(" ms]"));
+}
@@ -0,0 +1,68 @@
+#ifndef _TRANSMITQUEUE_h
+#define _TRANSMITQUEUE_h
+
+#include "Arduino.h"
+#include "RFM.h"
+
+// Longest frames that can wait for their radio, 47 bytes each with their
+// header (at most 5). A shorter frame takes only its own length, so 2 hold
+// 5 relayed frames of a TX29
+#ifndef TRANSMIT_QUEUE_SIZE
+#define TRANSMIT_QUEUE_SIZE 2
+#endif
+
+// Longest frame: the s command takes the ID and 31 bytes, CustomSensor adds 4
+#define TRANSMIT_FRAME_SIZE 36
+
+// Frames to send, in front of the radios.
+// Sending used to block loop(): SendArray() waits until the RFM69 is done,
+// a relay waited 64 ms before, and the radio it ran on was deaf meanwhile.
+// A frame is added with the radio, the rate and a delay and Handle() only
+// starts it when it is due and the radio is free. The RFM69 sends from its
+// FIFO while the other tasks go on, then the queue switches the radio back to
+// its rate and to receiving if it was. The frames are packed one after the
+// other in a buffer, header and data, the one at the head is sent first and
+// the others move up when it is out. A frame that does not fit is dropped.
+// Which radio sends is up to the caller: the sketch takes a transmit radio or
+// a second one, so that radio 1 keeps receiving.
+class TransmitQueue {
+public:
+  static bool Add(RFM *rfm, const byte *data, byte length, unsigned long dataRate, unsigned long delay = 0);
+  static void Handle();
+  // The radio is sending a frame of the queue, leave its rate alone
+  static bool IsSending(RFM *rfm);
+  static byte GetCount();
+
+  static unsigned long GetSentFrames();
+  static unsigned long GetDroppedFrames();
+  static void ResetStatistics();
+  static void ShowStatistics();
+
+private:
+  // Header of a frame in the buffer, its data follow
+  struct __attribute__((packed)) Entry {
+    RFM *Radio;
+    unsigned long DataRate;
+    unsigned long Due;          // millis()
+    byte Length;
+  };
+
+  static byte m_buffer[TRANSMIT_QUEUE_SIZE * (sizeof(Entry) + TRANSMIT_FRAME_SIZE)];
+  static byte m_used;
+  static byte m_count;
+  // Rate and mode of the radio before the frame at the head went out
+  static bool m_sending;
+  static unsigned long m_restoreRate;
+  static bool m_restoreReceiver;
+
+  static byte m_highWaterMark;
+  static unsigned long m_sentFrames;
+  static unsigned long m_droppedFrames;
+  static unsigned long m_maxWait;
+
+  static void Start(Entry *entry);
+  static void Finish(Entry *entry);
+  static void GetHead(Entry *entry);
+};
+
+#endif
@@ -35,7 +35,7 @@ bool Transmitter::Transmit() {
     frame.ID = m_id;
     frame.NewBatteryFlag = m_newBatteryFlag;
     frame.Bit12 = false;
-    frame.Temperature = m_temperature;
+    frame.Temperature = (int)(m_temperature * 10 + (m_temperature < 0 ? -0.5 : 0.5));
     frame.WeakBatteryFlag = false;
     frame.Humidity = m_humidity;
 
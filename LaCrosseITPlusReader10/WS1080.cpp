@@ -59,22 +59,22 @@ void WS1080::DecodeFrame(byte *bytes, struct Frame *frame) {
     if (sign) {
       temp = (~temp) + sign;
     }
-    frame->Temperature = temp * 0.1;
+    frame->Temperature = temp;
 
     // Humidity (%rH)
     frame->Humidity = bytes[3] & 0x7F;
 
     // Wind speed (m/s)
-    frame->WindSpeed = bytes[4] * 0.34;
+    frame->WindSpeed = bytes[4] * 34 / 10;
 
     // Wind gust (m/s)
-    frame->WindGust = bytes[5] * 0.34;
+    frame->WindGust = bytes[5] * 34 / 10;
     
-    //  Rain (0.5 mm steps)
-    frame->Rain = (((bytes[6] & 0x0F) << 8) | bytes[7]) * 0.6;
+    //  Rain (0.6 mm steps)
+    frame->Rain = (((bytes[6] & 0x0F) << 8) | bytes[7]) * 6;
     
     // Wind direction (degree  N=0, NNE=22.5, S=180, ... )
-    frame->WindDirection = 22.5 * (bytes[8] & 0x0F);
+    frame->WindDirection = 225 * (bytes[8] & 0x0F);
 
   }
 }
@@ -86,34 +86,44 @@ String WS1080::AnalyzeFrame(byte *data) {
 
   byte frameLength = WS1080::FRAME_LENGTH;
 
-  return WSBase::AnalyzeFrame(data, &frame, frameLength, "WS1080");
+  return WSBase::AnalyzeFrame(data, &frame, frameLength, F("WS1080"));
 }
 
-String WS1080::GetFhemDataString(byte *data) {
-  String fhemString = "";
+bool WS1080::GetFhemDataString(byte *data, LineWriter *line) {
+  bool result = false;
 
   if ((data[0] >> 4) == 0x0A) {
     struct Frame frame;
     DecodeFrame(data, &frame);
     if (frame.IsValid) {
-      fhemString = BuildFhemDataString(&frame, 3);
+      result = BuildFhemDataString(&frame, 3, line);
     }
   }
 
-  return fhemString;
+  return result;
 }
 
-bool WS1080::TryHandleData(byte *data) {
-  String fhemString = GetFhemDataString(data);
+bool WS1080::BuildRecord(const void *frame, RecordWriter *record) {
+  return BuildBinaryRecord((struct Frame *)frame, RECORD_WS1080, record);
+}
 
-  if (fhemString.length() > 0) {
-    Serial.println(fhemString);
-  }
- 
-  return fhemString.length() > 0;
+bool WS1080::BuildLine(const void *frame, LineWriter *line) {
+  return BuildFhemDataString((struct Frame *)frame, 3, line);
 }
 
+bool WS1080::TryHandleData(byte *data) {
+  bool result = false;
+
+  if ((data[0] >> 4) == 0x0A) {
+    struct Frame frame;
+    DecodeFrame(data, &frame);
+    if (frame.IsValid) {
+      result = HandleFrame(&frame, BuildRecord, BuildLine);
+    }
+  }
 
+  return result;
+}
 
 bool WS1080::IsValidDataRate(unsigned long dataRate) {
   return dataRate == 17241ul;
@@ -1,6 +1,6 @@
 #include "WSBase.h"
 
-String WSBase::BuildFhemDataString(struct Frame *frame, byte sensorType) {
+bool WSBase::BuildFhemDataString(struct Frame *frame, byte sensorType, LineWriter *line) {
   /* Format
   OK WS 60  1   4   193 52    2 88  4   101 15  20   ID=60  21.7C  52%rH  600mm  Dir.: 112.5  Wind:15m/s  Gust:20m/s
   OK WS ID  XXX TTT TTT HHH RRR RRR DDD DDD SSS SSS GGG GGG FFF PPP PPP
@@ -28,102 +28,153 @@ String WSBase::BuildFhemDataString(struct Frame *frame, byte sensorType) {
   |---------- Low battery
   */
 
-  String pBuf = "";
-
-  // Check if data is in the valid range
-  bool isValid = true;
-  if (frame->ErrorFlag) {
-    isValid = false;
-  }
-  if (frame->HasTemperature && (frame->Temperature < -40.0 || frame->Temperature > 59.9)) {
-    isValid = false;
-  }
-  if (frame->HasHumidity && (frame->Humidity < 1 || frame->Humidity > 100)) {
-    isValid = false;
-  }
-
+  bool isValid = IsValid(frame);
   if (isValid) {
-    pBuf += "OK WS ";
-    pBuf += frame->ID;
-    pBuf += " ";
-    pBuf += sensorType;
+    line->Add(F("OK WS "));
+    line->AddNumber(frame->ID);
+    line->Add(' ');
+    line->AddNumber(sensorType);
 
     // add temperature
-    pBuf += AddWord(frame->Temperature * 10 + 1000, frame->HasTemperature);
+    AddWord(line, frame->Temperature + 1000, frame->HasTemperature);
 
     // add humidity
-    pBuf += AddByte(frame->Humidity, frame->HasHumidity);
+    AddByte(line, frame->Humidity, frame->HasHumidity);
 
     // add rain
-    pBuf += AddWord(frame->Rain, frame->HasRain);
+    AddWord(line, frame->Rain / 10, frame->HasRain);
 
     // add wind direction
-    pBuf += AddWord(frame->WindDirection * 10, frame->HasWindDirection);
+    AddWord(line, frame->WindDirection, frame->HasWindDirection);
 
     // add wind speed
-    pBuf += AddWord(frame->WindSpeed * 10, frame->HasWindSpeed);
+    AddWord(line, frame->WindSpeed, frame->HasWindSpeed);
 
     // add gust
-    pBuf += AddWord(frame->WindGust * 10, frame->HasWindGust);
+    AddWord(line, frame->WindGust, frame->HasWindGust);
 
 
     // add Flags
-    byte flags = 0;
-    if (frame->NewBatteryFlag) {
-      flags += 1;
+    AddByte(line, GetFlags(frame), true);
+
+    // add pressure
+    if (frame->HasPressure) {
+      line->Add(' ');
+      line->AddNumber((byte)(frame->Pressure >> 8));
+      line->Add(' ');
+      line->AddNumber((byte)(frame->Pressure));
     }
-    if (frame->ErrorFlag) {
-      flags += 2;
+  }
+
+  return isValid;
+}
+
+
+// See RecordWriter.h for the layout
+bool WSBase::BuildBinaryRecord(struct Frame *frame, byte tag, RecordWriter *record) {
+  bool isValid = IsValid(frame);
+  if (isValid) {
+    byte fields = 0;
+    if (frame->HasTemperature) {
+      fields |= RECORD_HAS_TEMPERATURE;
     }
-    if (frame->LowBatteryFlag) {
-      flags += 4;
+    if (frame->HasHumidity) {
+      fields |= RECORD_HAS_HUMIDITY;
+    }
+    if (frame->HasRain) {
+      fields |= RECORD_HAS_RAIN;
+    }
+    if (frame->HasWindDirection) {
+      fields |= RECORD_HAS_WIND_DIRECTION;
+    }
+    if (frame->HasWindSpeed) {
+      fields |= RECORD_HAS_WIND_SPEED;
+    }
+    if (frame->HasWindGust) {
+      fields |= RECORD_HAS_WIND_GUST;
+    }
+    if (frame->HasPressure) {
+      fields |= RECORD_HAS_PRESSURE;
     }
-    pBuf += AddByte(flags, true);
 
-    // add pressure
+    record->Add(tag);
+    record->Add(frame->ID);
+    record->Add(GetFlags(frame));
+    record->Add(fields);
+
+    if (frame->HasTemperature) {
+      record->AddWord(frame->Temperature);
+    }
+    if (frame->HasHumidity) {
+      record->Add(frame->Humidity);
+    }
+    if (frame->HasRain) {
+      record->AddWord(frame->Rain);
+    }
+    if (frame->HasWindDirection) {
+      record->AddWord(frame->WindDirection);
+    }
+    if (frame->HasWindSpeed) {
+      record->AddWord(frame->WindSpeed);
+    }
+    if (frame->HasWindGust) {
+      record->AddWord(frame->WindGust);
+    }
     if (frame->HasPressure) {
-      pBuf += " ";
-      pBuf += (byte)(frame->Pressure >> 8);
-      pBuf += " ";
-      pBuf += (byte)(frame->Pressure);
+      record->AddWord(frame->Pressure);
     }
   }
 
-  return pBuf;
+  return isValid;
 }
 
+// Check if data is in the valid range
+bool WSBase::IsValid(struct Frame *frame) {
+  bool isValid = true;
+  if (frame->ErrorFlag) {
+    isValid = false;
+  }
+  if (frame->HasTemperature && (frame->Temperature < -400 || frame->Temperature > 599)) {
+    isValid = false;
+  }
+  if (frame->HasHumidity && (frame->Humidity < 1 || frame->Humidity > 100)) {
+    isValid = false;
+  }
+  return isValid;
+}
 
-String WSBase::AddWord(word value, bool hasValue) {
-  String result;
+byte WSBase::GetFlags(struct Frame *frame) {
+  byte flags = 0;
+  if (frame->NewBatteryFlag) {
+    flags += 1;
+  }
+  if (frame->ErrorFlag) {
+    flags += 2;
+  }
+  if (frame->LowBatteryFlag) {
+    flags += 4;
+  }
+  return flags;
+}
 
+void WSBase::AddWord(LineWriter *line, word value, bool hasValue) {
   if (!hasValue) {
     value = 0xFFFF;
   }
 
-  result += ' ';
-  result += (byte)(value >> 8);
-  result += ' ';
-  result += (byte)(value);
-
-  return result;
+  line->Add(' ');
+  line->AddNumber((byte)(value >> 8));
+  line->Add(' ');
+  line->AddNumber((byte)(value));
 }
 
-String WSBase::AddByte(byte value, bool hasValue) {
-  String result;
-  result += ' ';
-  result += hasValue ? value : 0xFF;
-
-  return result;
+void WSBase::AddByte(LineWriter *line, byte value, bool hasValue) {
+  line->Add(' ');
+  line->AddNumber(hasValue ? value : 0xFF);
 }
 
-float WSBase::DecodeValue(byte q1, byte q2, byte q3) {
-  float result = 0;
-
-  result += q1 * 100;
-  result += q2 * 10;
-  result += q3;
-
-  return result;
+word WSBase::DecodeValue(byte q1, byte q2, byte q3) {
+  return q1 * 100 + q2 * 10 + q3;
 }
 
 String WSBase::AnalyzeFrame(byte *data, Frame *frame, byte frameLength, String prefix) {
@@ -131,100 +182,100 @@ String WSBase::AnalyzeFrame(byte *data, Frame *frame, byte frameLength, String p
 
   // Show the raw data bytes
   result += prefix;
-  result += " [";
+  result += F(" [");
   for (int i = 0; i < frameLength; i++) {
     result += String(data[i], HEX);
     if (i < frameLength) {
-      result += " ";
+      result += F(" ");
     }
   }
-  result += "]";
+  result += F("]");
 
   // CRC
   if (!frame->IsValid) {
-    result += " CRC:WRONG";
+    result += F(" CRC:WRONG");
   }
   else {
-    result += " CRC:OK";
+    result += F(" CRC:OK");
 
     // Start
-    result += " S:";
+    result += F(" S:");
     result += String(frame->Header, HEX);
 
     // Sensor ID
-    result += " ID:";
+    result += F(" ID:");
     result += String(frame->ID, HEX);
 
     // New battery flag
-    result += " NewBatt:";
+    result += F(" NewBatt:");
     result += String(frame->NewBatteryFlag, DEC);
 
     // Low battery flag
-    result += " LowBatt:";
+    result += F(" LowBatt:");
     result += String(frame->LowBatteryFlag, DEC);
 
     // Error flag
-    result += " Error:";
+    result += F(" Error:");
     result += String(frame->ErrorFlag, DEC);
 
     // Temperature
-    result += " Temp:";
+    result += F(" Temp:");
     if (frame->HasTemperature) {
-      result += frame->Temperature;
+      result += frame->Temperature / 10.0;
     }
     else {
-      result += "---";
+      result += F("---");
     }
 
     // Humidity
-    result += " Hum:";
+    result += F(" Hum:");
     if (frame->HasHumidity) {
       result += frame->Humidity;
     }
     else {
-      result += "---";
+      result += F("---");
     }
 
     // Rain
-    result += " Rain:";
+    result += F(" Rain:");
     if (frame->HasRain) {
-      result += frame->Rain;
+      result += frame->Rain / 10.0;
     }
     else {
-      result += "---";
+      result += F("---");
     }
 
     // Wind speed
-    result += " Wind:";
+    result += F(" Wind:");
     if (frame->HasWindSpeed) {
-      result += frame->WindSpeed;
-      result += "m/s";
+      result += frame->WindSpeed / 10.0;
+      result += F("m/s");
     }
     else {
-      result += "---";
+      result += F("---");
     }
 
     // Wind direction
-    result += " from:";
+    result += F(" from:");
     if (frame->HasWindDirection) {
-      result += frame->WindDirection;
+      result += frame->WindDirection / 10.0;
     }
     else {
-      result += "---";
+      result += F("---");
     }
 
     // Wind gust
-    result += " Gust:";
+    result += F(" Gust:");
     if (frame->HasWindGust) {
-      result += frame->WindGust;
-      result += " m/s";
+      result += frame->WindGust / 10.0;
+      result += F(" m/s");
     }
     else {
-      result += "---";
+      result += F("---");
     }
 
     // CRC
-    result += " CRC:";
+    result += F(" CRC:");
     result += String(frame->CRC, HEX);
 
   }
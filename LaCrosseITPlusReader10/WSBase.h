@@ -3,6 +3,8 @@
 
 #include "Arduino.h"
 #include "SensorBase.h"
+#include "LineWriter.h"
+#include "RecordWriter.h"
 
 class WSBase : public SensorBase {
 public:
@@ -23,21 +25,24 @@ public:
     bool  HasWindGust;
     bool  HasPressure;
 
-    float Temperature;    // C 
+    int   Temperature;    // 1/10 C
     byte  Humidity;       // %rH
-    float Rain;           // mm
-    float WindDirection;  // Degree
-    float  WindSpeed;     // m/s
-    float  WindGust;      // m/s
+    word  Rain;           // 1/10 mm, the TX22IT counts 1/10 per contact closure
+    word  WindDirection;  // 1/10 degree
+    word  WindSpeed;      // 1/10 m/s
+    word  WindGust;       // 1/10 m/s
     int  Pressure;        // hPa
   };
 
 
 protected:
-  static String BuildFhemDataString(struct Frame *frame, byte sensorType);
-  static String AddWord(word value, bool hasValue);
-  static String AddByte(byte value, bool hasValue);
-  static float DecodeValue(byte q1, byte q2, byte q3);
+  static bool BuildFhemDataString(struct Frame *frame, byte sensorType, LineWriter *line);
+  static bool BuildBinaryRecord(struct Frame *frame, byte tag, RecordWriter *record);
+  static bool IsValid(struct Frame *frame);
+  static byte GetFlags(struct Frame *frame);
+  static void AddWord(LineWriter *line, word value, bool hasValue);
+  static void AddByte(LineWriter *line, byte value, bool hasValue);
+  static word DecodeValue(byte q1, byte q2, byte q3);
   static String AnalyzeFrame(byte *data, Frame *frame, byte frameLength, String prefix);
 };
 
@@ -32,37 +32,49 @@ void WT440XH::DecodeFrame(byte *bytes, struct LaCrosse::Frame *frame) {
 
   frame->ID = (deviceCode << 4) | houseCode;
 
-  frame->Temperature = ((bytes[2] - 50) * 10.0 + bytes[3]) / 10.0;
+  frame->Temperature = (bytes[2] - 50) * 10 + bytes[3];
   frame->Humidity = bytes[4];
   frame->WeakBatteryFlag = (bytes[1]) >> 6;
+  frame->NewBatteryFlag = false;
 
 }
 
 
-String WT440XH::GetFhemDataString(byte *data) {
-  String fhemString = "";
+bool WT440XH::GetFhemDataString(byte *data, LineWriter *line) {
+  bool result = false;
 
   if (data[0] == 0x51) {
     struct Frame frame;
     DecodeFrame(data, &frame);
     if (frame.IsValid) {
-      fhemString = BuildFhemDataString(&frame);
+      result = BuildFhemDataString(&frame, line);
     }
 
   }
 
-  return fhemString;
+  return result;
+}
+
+bool WT440XH::BuildRecord(const void *frame, RecordWriter *record) {
+  return BuildBinaryRecord((struct Frame *)frame, RECORD_WT440XH, record);
+}
+
+bool WT440XH::BuildLine(const void *frame, LineWriter *line) {
+  return BuildFhemDataString((struct Frame *)frame, line);
 }
 
 bool WT440XH::TryHandleData(byte *data) {
-  String fhemString = GetFhemDataString(data);
+  bool result = false;
 
-  if (fhemString.length() > 0) {
-    Serial.println(fhemString);
+  if (data[0] == 0x51) {
+    struct Frame frame;
+    DecodeFrame(data, &frame);
+    if (frame.IsValid) {
+      result = HandleFrame(&frame, BuildRecord, BuildLine);
+    }
   }
 
-  return fhemString.length() > 0;
-
+  return result;
 }
 
 bool WT440XH::CrcIsValid(byte *data) {
@@ -11,9 +11,13 @@ public:
   static const byte FRAME_LENGTH = 6;
   static void DecodeFrame(byte *bytes, struct LaCrosse::Frame *frame);
   static bool TryHandleData(byte *data);
-  static String GetFhemDataString(byte *data);
+  static bool GetFhemDataString(byte *data, LineWriter *line);
   static bool CrcIsValid(byte *data);
-  
+
+protected:
+  static bool BuildRecord(const void *frame, RecordWriter *record);
+  static bool BuildLine(const void *frame, LineWriter *line);
+
 };
 
 
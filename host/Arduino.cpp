@@ -0,0 +1,825 @@
+#include "Arduino.h"
+#include <unistd.h>
+
+// --- Time ------------------------------------------------------------------------------------------------------------
+#define HOST_MAX_DEVICES 8
+
+static unsigned long s_micros = 0;
+static unsigned long s_digitalWriteNanos = 0;
+static unsigned long s_portWriteNanos = 0;
+static unsigned long s_pendingNanos = 0;
+static HostDevice *s_devices[HOST_MAX_DEVICES];
+static byte s_deviceCount = 0;
+
+static void ServiceInterrupts();
+
+unsigned long millis() {
+  return s_micros / 1000;
+}
+
+unsigned long micros() {
+  return s_micros;
+}
+
+void delay(unsigned long ms) {
+  HostClock::AdvanceMicros(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  HostClock::AdvanceMicros(us);
+}
+
+void HostClock::SetMicros(unsigned long us) {
+  s_micros = us;
+}
+
+void HostClock::AdvanceMicros(unsigned long us) {
+  unsigned long target = s_micros + us;
+
+  // Step from event to event, so that an interrupt handler sees the devices
+  // exactly as the firmware would
+  for (;;) {
+    HostDevice *next = NULL;
+    unsigned long nextTime = target;
+    for (byte i = 0; i < s_deviceCount; i++) {
+      unsigned long time;
+      if (s_devices[i]->GetNextEventTime(&time)) {
+        if ((long)(time - s_micros) < 0) {
+          time = s_micros;
+        }
+        if ((long)(time - target) <= 0 && (next == NULL || (long)(time - nextTime) < 0)) {
+          next = s_devices[i];
+          nextTime = time;
+        }
+      }
+    }
+    if (next == NULL) {
+      break;
+    }
+
+    s_micros = nextTime;
+    next->Update(s_micros);
+    ServiceInterrupts();
+  }
+
+  // An interrupt handler may have moved the clock beyond the target
+  if ((long)(target - s_micros) > 0) {
+    s_micros = target;
+  }
+  ServiceInterrupts();
+}
+
+void HostClock::AdvanceMillis(unsigned long ms) {
+  AdvanceMicros(ms * 1000);
+}
+
+void HostClock::SetPinWriteCost(unsigned long digitalWriteNanos, unsigned long portWriteNanos) {
+  s_digitalWriteNanos = digitalWriteNanos;
+  s_portWriteNanos = portWriteNanos;
+  s_pendingNanos = 0;
+}
+
+void HostClock::AdvanceNanos(unsigned long ns) {
+  s_pendingNanos += ns;
+  if (s_pendingNanos >= 1000) {
+    unsigned long us = s_pendingNanos / 1000;
+    s_pendingNanos -= us * 1000;
+    AdvanceMicros(us);
+  }
+}
+
+void HostDevice::Register(HostDevice *device) {
+  if (s_deviceCount < HOST_MAX_DEVICES) {
+    s_devices[s_deviceCount++] = device;
+  }
+}
+
+void HostDevice::Unregister(HostDevice *device) {
+  for (byte i = 0; i < s_deviceCount; i++) {
+    if (s_devices[i] == device) {
+      s_devices[i] = s_devices[--s_deviceCount];
+      break;
+    }
+  }
+}
+
+
+// --- Pins ------------------------------------------------------------------------------------------------------------
+static uint8_t s_pinOutput[HOST_NUM_PINS];
+static volatile uint8_t s_pinInput[HOST_NUM_PINS];
+static HostOutputRegister s_outputRegisters[HOST_NUM_PINS];
+
+static void WritePin(uint8_t pin, uint8_t value, unsigned long costNanos) {
+  if (pin < HOST_NUM_PINS) {
+    s_pinOutput[pin] = value ? 1 : 0;
+    for (byte i = 0; i < s_deviceCount; i++) {
+      s_devices[i]->OnPinWrite(pin, s_pinOutput[pin]);
+    }
+
+    HostClock::AdvanceNanos(costNanos);
+  }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+void HostDriveOutput(uint8_t pin, uint8_t value) {
+  WritePin(pin, value, 0);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  WritePin(pin, value, s_digitalWriteNanos);
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < HOST_NUM_PINS ? s_pinInput[pin] : LOW;
+}
+
+// Every pin is its own port with bit 0 as the pin
+uint8_t digitalPinToPort(uint8_t pin) {
+  return pin < HOST_NUM_PINS ? pin : 0;
+}
+
+uint8_t digitalPinToBitMask(uint8_t pin) {
+  return 1;
+}
+
+HostOutputRegister &HostOutputRegister::operator|=(int mask) {
+  WritePin(Port, s_pinOutput[Port] | (mask & 1), s_portWriteNanos);
+  return *this;
+}
+
+HostOutputRegister &HostOutputRegister::operator&=(int mask) {
+  WritePin(Port, s_pinOutput[Port] & mask & 1, s_portWriteNanos);
+  return *this;
+}
+
+HostOutputRegister::operator uint8_t() const {
+  return s_pinOutput[Port];
+}
+
+HostOutputRegister *portOutputRegister(uint8_t port) {
+  s_outputRegisters[port].Port = port;
+  return &s_outputRegisters[port];
+}
+
+volatile uint8_t *portInputRegister(uint8_t port) {
+  return &s_pinInput[port];
+}
+
+
+// --- Interrupts ------------------------------------------------------------------------------------------------------
+volatile uint8_t SREG = 0x80;
+volatile uint8_t EIMSK = 0;
+static void (*s_isr[HOST_NUM_INTERRUPTS])();
+static int s_interruptMode[HOST_NUM_INTERRUPTS];
+static bool s_interruptFlag[HOST_NUM_INTERRUPTS];
+
+static uint8_t InterruptToPin(uint8_t interruptNumber) {
+  return interruptNumber + 2;
+}
+
+int digitalPinToInterrupt(uint8_t pin) {
+  return pin == 2 ? 0 : (pin == 3 ? 1 : NOT_AN_INTERRUPT);
+}
+
+void attachInterrupt(uint8_t interruptNumber, void (*isr)(), int mode) {
+  if (interruptNumber < HOST_NUM_INTERRUPTS) {
+    s_isr[interruptNumber] = isr;
+    s_interruptMode[interruptNumber] = mode;
+    s_interruptFlag[interruptNumber] = false;
+    EIMSK |= 1 << interruptNumber;
+  }
+}
+
+void detachInterrupt(uint8_t interruptNumber) {
+  if (interruptNumber < HOST_NUM_INTERRUPTS) {
+    EIMSK &= ~(1 << interruptNumber);
+    s_isr[interruptNumber] = NULL;
+  }
+}
+
+void HostSetInput(uint8_t pin, uint8_t value) {
+  if (pin < HOST_NUM_PINS) {
+    value = value ? 1 : 0;
+    int interruptNumber = digitalPinToInterrupt(pin);
+    if (interruptNumber != NOT_AN_INTERRUPT && s_pinInput[pin] != value) {
+      int mode = s_interruptMode[interruptNumber];
+      if (mode == CHANGE || (mode == FALLING && !value) || (mode == RISING && value)) {
+        s_interruptFlag[interruptNumber] = true;
+      }
+    }
+    s_pinInput[pin] = value;
+  }
+}
+
+// Runs the handlers like the AVR does: with the interrupts disabled and a LOW
+// level interrupt is executed again as long as the pin stays low
+static void ServiceInterrupts() {
+  for (byte i = 0; i < HOST_NUM_INTERRUPTS; i++) {
+    for (int guard = 0; guard < 1000 && s_isr[i] && (EIMSK & (1 << i)) && (SREG & 0x80); guard++) {
+      bool pending = s_interruptMode[i] == LOW ? s_pinInput[InterruptToPin(i)] == LOW : s_interruptFlag[i];
+      if (!pending) {
+        break;
+      }
+      s_interruptFlag[i] = false;
+      SREG &= ~0x80;
+      s_isr[i]();
+      SREG |= 0x80;
+    }
+  }
+}
+
+void cli() {
+  SREG &= ~0x80;
+}
+
+void sei() {
+  SREG |= 0x80;
+  ServiceInterrupts();
+}
+
+void noInterrupts() {
+  cli();
+}
+
+void interrupts() {
+  sei();
+}
+
+
+// --- AVR libc conversions ------------------------------------------------------------------------------------------
+char *ultoa(unsigned long value, char *str, int base) {
+  char buffer[sizeof(unsigned long) * 8 + 1];
+  int i = 0;
+  do {
+    byte digit = value % base;
+    buffer[i++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value);
+
+  int j = 0;
+  while (i > 0) {
+    str[j++] = buffer[--i];
+  }
+  str[j] = 0;
+  return str;
+}
+
+char *ltoa(long value, char *str, int base) {
+  if (value < 0 && base == 10) {
+    str[0] = '-';
+    ultoa(-(unsigned long)value, str + 1, base);
+  }
+  else {
+    ultoa((unsigned long)value, str, base);
+  }
+  return str;
+}
+
+char *utoa(unsigned int value, char *str, int base) {
+  return ultoa(value, str, base);
+}
+
+char *itoa(int value, char *str, int base) {
+  if (base == 10) {
+    return ltoa(value, str, base);
+  }
+  return ultoa((unsigned int)value, str, base);
+}
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *str) {
+  sprintf(str, "%*.*f", width, precision, value);
+  return str;
+}
+
+
+// --- String ----------------------------------------------------------------------------------------------------------
+unsigned long String::s_allocations = 0;
+
+String::String(const char *cstr) {
+  m_buffer = NULL;
+  m_capacity = 0;
+  m_len = 0;
+  if (cstr) {
+    Append(cstr, strlen(cstr));
+  }
+}
+
+String::String(const __FlashStringHelper *str) {
+  m_buffer = NULL;
+  m_capacity = 0;
+  m_len = 0;
+  if (str) {
+    Append(reinterpret_cast<const char *>(str), strlen(reinterpret_cast<const char *>(str)));
+  }
+}
+
+String::String(const String &str) {
+  m_buffer = NULL;
+  m_capacity = 0;
+  m_len = 0;
+  Append(str.c_str(), str.m_len);
+}
+
+String::String(char c) {
+  m_buffer = NULL;
+  m_capacity = 0;
+  m_len = 0;
+  Append(&c, 1);
+}
+
+String::String(unsigned char value, unsigned char base) {
+  char buf[9];
+  m_buffer = NULL;
+  m_capacity = 0;
+  m_len = 0;
+  utoa(value, buf, base);
+  Append(buf, strlen(buf));
+}
+
+String::String(int value, unsigned char base) {
+  char buf[34];
+  m_buffer = NULL;
+  m_capacity = 0;
+  m_len = 0;
+  itoa(value, buf, base);
+  Append(buf, strlen(buf));
+}
+
+String::String(unsigned int value, unsigned char base) {
+  char buf[34];
+  m_buffer = NULL;
+  m_capacity = 0;
+  m_len = 0;
+  utoa(value, buf, base);
+  Append(buf, strlen(buf));
+}
+
+String::String(long value, unsigned char base) {
+  char buf[66];
+  m_buffer = NULL;
+  m_capacity = 0;
+  m_len = 0;
+  ltoa(value, buf, base);
+  Append(buf, strlen(buf));
+}
+
+String::String(unsigned long value, unsigned char base) {
+  char buf[66];
+  m_buffer = NULL;
+  m_capacity = 0;
+  m_len = 0;
+  ultoa(value, buf, base);
+  Append(buf, strlen(buf));
+}
+
+String::String(float value, unsigned char decimalPlaces) {
+  char buf[33];
+  m_buffer = NULL;
+  m_capacity = 0;
+  m_len = 0;
+  dtostrf(value, decimalPlaces + 2, decimalPlaces, buf);
+  Append(buf, strlen(buf));
+}
+
+String::String(double value, unsigned char decimalPlaces) {
+  char buf[33];
+  m_buffer = NULL;
+  m_capacity = 0;
+  m_len = 0;
+  dtostrf(value, decimalPlaces + 2, decimalPlaces, buf);
+  Append(buf, strlen(buf));
+}
+
+String::~String() {
+  free(m_buffer);
+}
+
+String &String::operator=(const String &rhs) {
+  if (this != &rhs) {
+    m_len = 0;
+    Append(rhs.c_str(), rhs.m_len);
+  }
+  return *this;
+}
+
+String &String::operator=(const char *cstr) {
+  m_len = 0;
+  if (cstr) {
+    Append(cstr, strlen(cstr));
+  }
+  else if (m_buffer) {
+    m_buffer[0] = 0;
+  }
+  return *this;
+}
+
+bool String::Reserve(unsigned int size) {
+  if (m_buffer && m_capacity >= size) {
+    return true;
+  }
+  char *newBuffer = (char *)realloc(m_buffer, size + 1);
+  if (!newBuffer) {
+    return false;
+  }
+  s_allocations++;
+  m_buffer = newBuffer;
+  m_capacity = size;
+  return true;
+}
+
+bool String::Append(const char *cstr, unsigned int length) {
+  if (!Reserve(m_len + length)) {
+    return false;
+  }
+  memmove(m_buffer + m_len, cstr, length);
+  m_len += length;
+  m_buffer[m_len] = 0;
+  return true;
+}
+
+bool String::concat(const String &str) {
+  return Append(str.c_str(), str.m_len);
+}
+
+bool String::concat(const char *cstr) {
+  return cstr ? Append(cstr, strlen(cstr)) : false;
+}
+
+bool String::concat(const __FlashStringHelper *str) {
+  return concat(reinterpret_cast<const char *>(str));
+}
+
+bool String::concat(char c) {
+  return Append(&c, 1);
+}
+
+bool String::concat(unsigned char num) {
+  char buf[4];
+  utoa(num, buf, 10);
+  return concat(buf);
+}
+
+bool String::concat(int num) {
+  char buf[7];
+  itoa(num, buf, 10);
+  return concat(buf);
+}
+
+bool String::concat(unsigned int num) {
+  char buf[11];
+  utoa(num, buf, 10);
+  return concat(buf);
+}
+
+bool String::concat(long num) {
+  char buf[21];
+  ltoa(num, buf, 10);
+  return concat(buf);
+}
+
+bool String::concat(unsigned long num) {
+  char buf[21];
+  ultoa(num, buf, 10);
+  return concat(buf);
+}
+
+bool String::concat(float num) {
+  char buf[33];
+  return concat(dtostrf(num, 4, 2, buf));
+}
+
+bool String::concat(double num) {
+  char buf[33];
+  return concat(dtostrf(num, 4, 2, buf));
+}
+
+bool String::operator==(const String &rhs) const {
+  return m_len == rhs.m_len && strcmp(c_str(), rhs.c_str()) == 0;
+}
+
+bool String::operator==(const char *cstr) const {
+  return strcmp(c_str(), cstr ? cstr : "") == 0;
+}
+
+char String::charAt(unsigned int index) const {
+  return index < m_len ? m_buffer[index] : 0;
+}
+
+unsigned long String::GetAllocationCount() {
+  return s_allocations;
+}
+
+void String::ResetAllocationCount() {
+  s_allocations = 0;
+}
+
+
+// --- Print -----------------------------------------------------------------------------------------------------------
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::PrintNumber(unsigned long value, uint8_t base) {
+  char buf[8 * sizeof(long) + 1];
+  char *str = &buf[sizeof(buf) - 1];
+  *str = '\0';
+
+  if (base < 2) {
+    base = 10;
+  }
+
+  do {
+    char c = value % base;
+    value /= base;
+    *--str = c < 10 ? c + '0' : c + 'A' - 10;
+  } while (value);
+
+  return write(str);
+}
+
+size_t Print::PrintFloat(double value, uint8_t digits) {
+  char buf[48];
+  if (isnan(value)) {
+    return print("nan");
+  }
+  if (isinf(value)) {
+    return print("inf");
+  }
+  snprintf(buf, sizeof(buf), "%.*f", digits, value);
+  return write(buf);
+}
+
+size_t Print::print(const char *str) {
+  return write(str);
+}
+
+size_t Print::print(const __FlashStringHelper *str) {
+  return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const String &str) {
+  return write((const uint8_t *)str.c_str(), str.length());
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base) {
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base) {
+  return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base) {
+  if (base == 0) {
+    return write((uint8_t)value);
+  }
+  else if (base == 10 && value < 0) {
+    size_t n = print('-');
+    return n + PrintNumber(-(unsigned long)value, 10);
+  }
+  return PrintNumber((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  if (base == 0) {
+    return write((uint8_t)value);
+  }
+  return PrintNumber(value, base);
+}
+
+size_t Print::print(double value, int digits) {
+  return PrintFloat(value, digits);
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+size_t Print::println(const char *str) {
+  size_t n = print(str);
+  return n + println();
+}
+
+size_t Print::println(const __FlashStringHelper *str) {
+  size_t n = print(str);
+  return n + println();
+}
+
+size_t Print::println(const String &str) {
+  size_t n = print(str);
+  return n + println();
+}
+
+size_t Print::println(char c) {
+  size_t n = print(c);
+  return n + println();
+}
+
+size_t Print::println(unsigned char value, int base) {
+  size_t n = print(value, base);
+  return n + println();
+}
+
+size_t Print::println(int value, int base) {
+  size_t n = print(value, base);
+  return n + println();
+}
+
+size_t Print::println(unsigned int value, int base) {
+  size_t n = print(value, base);
+  return n + println();
+}
+
+size_t Print::println(long value, int base) {
+  size_t n = print(value, base);
+  return n + println();
+}
+
+size_t Print::println(unsigned long value, int base) {
+  size_t n = print(value, base);
+  return n + println();
+}
+
+size_t Print::println(double value, int digits) {
+  size_t n = print(value, digits);
+  return n + println();
+}
+
+
+// --- Serial ----------------------------------------------------------------------------------------------------------
+HardwareSerial Serial;
+
+HardwareSerial::HardwareSerial() {
+  m_baud = 0;
+  m_output = NULL;
+  m_outputLength = 0;
+  m_outputCapacity = 0;
+  m_capture = true;
+  m_simulateTiming = false;
+  m_txBusyUntil = 0;
+  m_fd = -1;
+  m_peerBaud = 0;
+  m_inputHead = 0;
+  m_inputTail = 0;
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+  m_baud = baud;
+}
+
+void HardwareSerial::end() {
+  m_baud = 0;
+}
+
+int HardwareSerial::available() {
+  if (m_fd >= 0) {
+    byte data[64];
+    ssize_t length = ::read(m_fd, data, sizeof(data));
+    // What was sent at another baud rate is garbage, here it is just lost
+    if (length > 0 && IsPeerInSync()) {
+      for (ssize_t i = 0; i < length; i++) {
+        unsigned int next = (m_inputHead + 1) % sizeof(m_input);
+        if (next == m_inputTail) {
+          break;
+        }
+        m_input[m_inputHead] = data[i];
+        m_inputHead = next;
+      }
+    }
+  }
+  return (m_inputHead - m_inputTail + sizeof(m_input)) % sizeof(m_input);
+}
+
+int HardwareSerial::read() {
+  if (m_inputHead == m_inputTail) {
+    return -1;
+  }
+  byte c = m_input[m_inputTail];
+  m_inputTail = (m_inputTail + 1) % sizeof(m_input);
+  return c;
+}
+
+int HardwareSerial::peek() {
+  return m_inputHead == m_inputTail ? -1 : (byte)m_input[m_inputTail];
+}
+
+// Waits until the last character is on the wire
+void HardwareSerial::flush() {
+  int pending = GetTxPending();
+  if (pending > 0) {
+    HostClock::AdvanceMicros(m_txBusyUntil - micros());
+  }
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (m_capture) {
+    if (m_outputLength + 1 >= m_outputCapacity) {
+      m_outputCapacity = m_outputCapacity ? m_outputCapacity * 2 : 4096;
+      m_output = (char *)realloc(m_output, m_outputCapacity);
+    }
+    m_output[m_outputLength++] = c;
+    m_output[m_outputLength] = 0;
+  }
+  if (m_fd >= 0 && IsPeerInSync()) {
+    while (::write(m_fd, &c, 1) != 1) {
+    }
+  }
+  if (m_simulateTiming && m_baud > 0) {
+    // Like the core: wait until the UDRE interrupt has made room
+    int pending = GetTxPending();
+    if (pending >= SERIAL_TX_BUFFER_SIZE - 1) {
+      HostClock::AdvanceMicros(m_txBusyUntil - micros() - (SERIAL_TX_BUFFER_SIZE - 2) * GetCharacterMicros());
+    }
+    if (GetTxPending() == 0) {
+      m_txBusyUntil = micros();
+    }
+    m_txBusyUntil += GetCharacterMicros();
+  }
+  return 1;
+}
+
+int HardwareSerial::availableForWrite() {
+  return SERIAL_TX_BUFFER_SIZE - 1 - GetTxPending();
+}
+
+// Start bit, 8 data bits, stop bit
+unsigned long HardwareSerial::GetCharacterMicros() {
+  return 10000000UL / m_baud;
+}
+
+// Characters in the TX buffer that are not on the wire yet
+int HardwareSerial::GetTxPending() {
+  if (!m_simulateTiming || m_baud == 0) {
+    return 0;
+  }
+  long busy = (long)(m_txBusyUntil - micros());
+  // The clock was set back by a new run
+  if (busy <= 0 || busy > (long)(SERIAL_TX_BUFFER_SIZE * GetCharacterMicros())) {
+    return 0;
+  }
+  return (busy + GetCharacterMicros() - 1) / GetCharacterMicros();
+}
+
+void HardwareSerial::SimulateTiming(bool enabled) {
+  m_simulateTiming = enabled;
+}
+
+unsigned long HardwareSerial::GetBaudRate() {
+  return m_baud;
+}
+
+void HardwareSerial::InjectInput(const char *data) {
+  while (*data) {
+    unsigned int next = (m_inputHead + 1) % sizeof(m_input);
+    if (next == m_inputTail) {
+      break;
+    }
+    m_input[m_inputHead] = *data++;
+    m_inputHead = next;
+  }
+}
+
+const char *HardwareSerial::GetOutput() {
+  return m_output ? m_output : "";
+}
+
+unsigned long HardwareSerial::GetOutputLength() {
+  return m_outputLength;
+}
+
+void HardwareSerial::ClearOutput() {
+  m_outputLength = 0;
+  if (m_output) {
+    m_output[0] = 0;
+  }
+}
+
+void HardwareSerial::EnableCapture(bool enabled) {
+  m_capture = enabled;
+}
+
+void HardwareSerial::Attach(int fd) {
+  m_fd = fd;
+}
+
+void HardwareSerial::SetPeerBaudRate(unsigned long baud) {
+  m_peerBaud = baud;
+}
+
+bool HardwareSerial::IsPeerInSync() {
+  return m_peerBaud == 0 || m_peerBaud == m_baud;
+}
@@ -0,0 +1,321 @@
+// Arduino.h (host)
+//
+// Minimal Arduino compatible layer so that the sketch sources can be compiled
+// and executed on a Linux host (benchmarks, CI).
+// Only the parts of the Arduino API that are used by the sketch are provided.
+// The serial port captures everything that is printed, the clock is virtual
+// and only advances when the host code (or delay()) moves it.
+// Simulated peripherals (HostDevice) see every pin write and are updated
+// while the clock advances, so they can raise pin change interrupts.
+
+#ifndef _HOST_ARDUINO_h
+#define _HOST_ARDUINO_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT  0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+#define NOT_AN_INTERRUPT -1
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+// As in the core F() has a type of its own, so a flash string only goes
+// where the core takes one
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) HostReadWord(addr)
+#define pgm_read_dword(addr) HostReadDword(addr)
+
+// The low bytes, like the AVR reads them (an unsigned long of a table is
+// 8 bytes on the host)
+inline uint16_t HostReadWord(const void *addr) {
+  uint16_t value;
+  memcpy(&value, addr, sizeof(value));
+  return value;
+}
+
+inline uint32_t HostReadDword(const void *addr) {
+  uint32_t value;
+  memcpy(&value, addr, sizeof(value));
+  return value;
+}
+
+
+// --- Time ------------------------------------------------------------------------------------------------------------
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Advancing the clock updates the registered devices at the times they ask
+// for and runs the interrupt handlers that became pending
+class HostClock {
+public:
+  static void SetMicros(unsigned long us);
+  static void AdvanceMicros(unsigned long us);
+  static void AdvanceMillis(unsigned long ms);
+  // Time a pin write costs on the target, so bit-banged SPI takes time too
+  static void SetPinWriteCost(unsigned long digitalWriteNanos, unsigned long portWriteNanos);
+  // Time spent by the CPU below the resolution of micros(), it is summed up
+  static void AdvanceNanos(unsigned long ns);
+};
+
+// A simulated peripheral connected to the pins
+class HostDevice {
+public:
+  virtual ~HostDevice() {}
+  virtual void OnPinWrite(uint8_t pin, uint8_t value) {}
+  // Returns false if the device has nothing scheduled
+  virtual bool GetNextEventTime(unsigned long *time) { return false; }
+  virtual void Update(unsigned long now) {}
+
+  static void Register(HostDevice *device);
+  static void Unregister(HostDevice *device);
+};
+
+
+// --- Pins ------------------------------------------------------------------------------------------------------------
+#define HOST_NUM_PINS 32
+
+// SPI pins of the ATmega328
+static const uint8_t SS = 10;
+static const uint8_t MOSI = 11;
+static const uint8_t MISO = 12;
+static const uint8_t SCK = 13;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// Host only: drives an input pin (e.g. MISO or nIRQ of a simulated radio)
+void HostSetInput(uint8_t pin, uint8_t value);
+// Host only: an on-chip peripheral (the SPI) drives an output pin, this costs no CPU time
+void HostDriveOutput(uint8_t pin, uint8_t value);
+
+// The output registers are proxies, so that the devices also see the writes
+// done with the fast port macros (*portOutputRegister(port) |= mask)
+class HostOutputRegister {
+public:
+  uint8_t Port;
+  HostOutputRegister &operator|=(int mask);
+  HostOutputRegister &operator&=(int mask);
+  operator uint8_t() const;
+};
+
+uint8_t digitalPinToPort(uint8_t pin);
+uint8_t digitalPinToBitMask(uint8_t pin);
+HostOutputRegister *portOutputRegister(uint8_t port);
+volatile uint8_t *portInputRegister(uint8_t port);
+
+
+// --- Interrupts ------------------------------------------------------------------------------------------------------
+// Only the global interrupt flag (bit 7) of SREG is modelled.
+// External interrupts 0 and 1 are on pin 2 and 3 like on the ATmega328,
+// attachInterrupt sets their bit in EIMSK, SPI transactions may clear it.
+#define HOST_NUM_INTERRUPTS 2
+extern volatile uint8_t SREG;
+extern volatile uint8_t EIMSK;
+void cli();
+void sei();
+void noInterrupts();
+void interrupts();
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t interruptNumber, void (*isr)(), int mode);
+void detachInterrupt(uint8_t interruptNumber);
+
+
+// --- AVR libc conversions ------------------------------------------------------------------------------------------
+char *itoa(int value, char *str, int base);
+char *utoa(unsigned int value, char *str, int base);
+char *ltoa(long value, char *str, int base);
+char *ultoa(unsigned long value, char *str, int base);
+char *dtostrf(double value, signed char width, unsigned char precision, char *str);
+
+
+// --- String ----------------------------------------------------------------------------------------------------------
+// Grows its buffer like the Arduino core does (realloc to the exact size),
+// so the number of heap operations is comparable to the target.
+class String {
+public:
+  String(const char *cstr = "");
+  String(const __FlashStringHelper *str);
+  String(const String &str);
+  explicit String(char c);
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimalPlaces = 2);
+  explicit String(double value, unsigned char decimalPlaces = 2);
+  ~String();
+
+  String &operator=(const String &rhs);
+  String &operator=(const char *cstr);
+
+  bool concat(const String &str);
+  bool concat(const char *cstr);
+  bool concat(const __FlashStringHelper *str);
+  bool concat(char c);
+  bool concat(unsigned char num);
+  bool concat(int num);
+  bool concat(unsigned int num);
+  bool concat(long num);
+  bool concat(unsigned long num);
+  bool concat(float num);
+  bool concat(double num);
+
+  String &operator+=(const String &rhs) { concat(rhs); return *this; }
+  String &operator+=(const char *cstr) { concat(cstr); return *this; }
+  String &operator+=(const __FlashStringHelper *str) { concat(str); return *this; }
+  String &operator+=(char c) { concat(c); return *this; }
+  String &operator+=(unsigned char num) { concat(num); return *this; }
+  String &operator+=(int num) { concat(num); return *this; }
+  String &operator+=(unsigned int num) { concat(num); return *this; }
+  String &operator+=(long num) { concat(num); return *this; }
+  String &operator+=(unsigned long num) { concat(num); return *this; }
+  String &operator+=(float num) { concat(num); return *this; }
+  String &operator+=(double num) { concat(num); return *this; }
+
+  bool operator==(const String &rhs) const;
+  bool operator==(const char *cstr) const;
+  bool operator!=(const String &rhs) const { return !(*this == rhs); }
+  bool operator!=(const char *cstr) const { return !(*this == cstr); }
+
+  unsigned int length() const { return m_len; }
+  const char *c_str() const { return m_buffer ? m_buffer : ""; }
+  char charAt(unsigned int index) const;
+
+  // Host only: number of malloc/realloc calls done by all String instances
+  static unsigned long GetAllocationCount();
+  static void ResetAllocationCount();
+
+private:
+  char *m_buffer;
+  unsigned int m_capacity;
+  unsigned int m_len;
+  static unsigned long s_allocations;
+
+  bool Reserve(unsigned int size);
+  bool Append(const char *cstr, unsigned int length);
+};
+
+
+// --- Print / Serial --------------------------------------------------------------------------------------------------
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+
+  size_t print(const char *str);
+  size_t print(const __FlashStringHelper *str);
+  size_t print(const String &str);
+  size_t print(char c);
+  size_t print(unsigned char value, int base = DEC);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println();
+  size_t println(const char *str);
+  size_t println(const __FlashStringHelper *str);
+  size_t println(const String &str);
+  size_t println(char c);
+  size_t println(unsigned char value, int base = DEC);
+  size_t println(int value, int base = DEC);
+  size_t println(unsigned int value, int base = DEC);
+  size_t println(long value, int base = DEC);
+  size_t println(unsigned long value, int base = DEC);
+  size_t println(double value, int digits = 2);
+
+private:
+  size_t PrintNumber(unsigned long value, uint8_t base);
+  size_t PrintFloat(double value, uint8_t digits);
+};
+
+// As in the AVR core for a device with 2 KB RAM
+#define SERIAL_TX_BUFFER_SIZE 64
+
+// Captures the output in memory, the input can be fed by the host code.
+// It can also be connected to a file descriptor (the master of a pty), then
+// the bytes go both ways as long as the baud rates of both ends match.
+class HardwareSerial : public Print {
+public:
+  HardwareSerial();
+  void begin(unsigned long baud);
+  void end();
+  int available();
+  int read();
+  int peek();
+  void flush();
+  using Print::write;
+  size_t write(uint8_t c);
+  int availableForWrite();
+  operator bool() { return true; }
+
+  // Host only
+  unsigned long GetBaudRate();
+  // When enabled the characters leave the TX buffer (SERIAL_TX_BUFFER_SIZE)
+  // at the baud rate and write() waits on the clock while it is full
+  void SimulateTiming(bool enabled);
+  void InjectInput(const char *data);
+  const char *GetOutput();
+  unsigned long GetOutputLength();
+  void ClearOutput();
+  void EnableCapture(bool enabled);
+  void Attach(int fd);
+  // Baud rate the other end of the attached line uses, 0 for any
+  void SetPeerBaudRate(unsigned long baud);
+
+private:
+  unsigned long m_baud;
+  char *m_output;
+  unsigned long m_outputLength;
+  unsigned long m_outputCapacity;
+  bool m_capture;
+  bool m_simulateTiming;
+  unsigned long m_txBusyUntil;
+  unsigned long GetCharacterMicros();
+  int GetTxPending();
+  int m_fd;
+  unsigned long m_peerBaud;
+  bool IsPeerInSync();
+  char m_input[256];
+  unsigned int m_inputHead;
+  unsigned int m_inputTail;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,84 @@
+#include "BMP180Sim.h"
+
+// AC1 AC2 AC3 AC4 AC5 AC6 B1 B2 MB MC MD
+static const int16_t s_exampleCalibration[11] = {
+  408, -72, -14383, (int16_t)32741, (int16_t)32757, 23153, 6190, 4, -32768, -8711, 2868
+};
+
+BMP180Sim::BMP180Sim() {
+  memset(m_registers, 0, sizeof(m_registers));
+  m_registers[0xD0] = 0x55;
+  SetCalibration(s_exampleCalibration);
+  m_pointer = 0;
+  m_ut = 27898;
+  m_up = 23843;
+  m_command = 0;
+  m_converting = false;
+  m_conversionStart = 0;
+  m_conversions = 0;
+  m_earlyReads = 0;
+}
+
+void BMP180Sim::SetCalibration(const int16_t values[11]) {
+  for (uint8_t i = 0; i < 11; i++) {
+    m_registers[0xAA + 2 * i] = (uint16_t)values[i] >> 8;
+    m_registers[0xAB + 2 * i] = (uint16_t)values[i] & 0xFF;
+  }
+}
+
+void BMP180Sim::SetRawValues(uint16_t ut, uint32_t up) {
+  m_ut = ut;
+  m_up = up;
+}
+
+unsigned long BMP180Sim::GetConversionCount() {
+  return m_conversions;
+}
+
+unsigned long BMP180Sim::GetEarlyReads() {
+  return m_earlyReads;
+}
+
+unsigned long BMP180Sim::GetConversionTime() {
+  static const unsigned long pressureMicros[] = { 4500, 7500, 13500, 25500 };
+  return m_command == 0x2E ? 4500 : pressureMicros[m_command >> 6];
+}
+
+void BMP180Sim::UpdateResult() {
+  if (!m_converting || micros() - m_conversionStart < GetConversionTime()) {
+    return;
+  }
+
+  m_converting = false;
+  if (m_command == 0x2E) {
+    m_registers[0xF6] = m_ut >> 8;
+    m_registers[0xF7] = m_ut & 0xFF;
+    m_registers[0xF8] = 0;
+  }
+  else {
+    uint32_t value = m_up << (8 - (m_command >> 6));
+    m_registers[0xF6] = value >> 16;
+    m_registers[0xF7] = value >> 8;
+    m_registers[0xF8] = value & 0xFF;
+  }
+}
+
+void BMP180Sim::OnReceive(const uint8_t *data, uint8_t length) {
+  m_pointer = data[0];
+  if (length >= 2 && data[0] == 0xF4) {
+    m_command = data[1];
+    m_converting = m_command == 0x2E || (m_command & 0x3F) == 0x34;
+    m_conversionStart = micros();
+    m_conversions++;
+  }
+}
+
+void BMP180Sim::OnRequest(uint8_t *data, uint8_t length) {
+  UpdateResult();
+  if (m_converting && m_pointer >= 0xF6 && m_pointer <= 0xF8) {
+    m_earlyReads++;
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    data[i] = m_registers[(uint8_t)(m_pointer + i)];
+  }
+}
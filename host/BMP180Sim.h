@@ -0,0 +1,43 @@
+// BMP180Sim.h (host)
+//
+// Simulated BMP180 on the I2C bus: calibration EEPROM, chip id and the
+// conversions started through register 0xF4. A result only shows up in
+// 0xF6 ... 0xF8 after the maximum conversion time of the data sheet, a read
+// before that returns the previous result and is counted.
+
+#ifndef _BMP180SIM_h
+#define _BMP180SIM_h
+
+#include "Arduino.h"
+#include "Wire.h"
+
+class BMP180Sim : public HostI2CDevice {
+public:
+  // Calibration of the example in the data sheet
+  BMP180Sim();
+
+  void SetCalibration(const int16_t values[11]);
+  // ut: 16 bit raw temperature, up: raw pressure with (16 + oss) bits
+  void SetRawValues(uint16_t ut, uint32_t up);
+  unsigned long GetConversionCount();
+  unsigned long GetEarlyReads();
+
+  void OnReceive(const uint8_t *data, uint8_t length);
+  void OnRequest(uint8_t *data, uint8_t length);
+
+private:
+  uint8_t m_registers[0x100];
+  uint8_t m_pointer;
+  uint16_t m_ut;
+  uint32_t m_up;
+  uint8_t m_command;
+  bool m_converting;
+  unsigned long m_conversionStart;
+  unsigned long m_conversions;
+  unsigned long m_earlyReads;
+
+  unsigned long GetConversionTime();
+  void UpdateResult();
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "EEPROM.h"
+
+EEPROMClass EEPROM;
+
+EEPROMClass::EEPROMClass() {
+  Erase();
+}
+
+uint8_t EEPROMClass::read(int address) {
+  return address >= 0 && address < HOST_EEPROM_SIZE ? m_data[address] : 0xFF;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if (address >= 0 && address < HOST_EEPROM_SIZE) {
+    m_data[address] = value;
+    m_writeCount++;
+  }
+}
+
+// Only writes the cell when the value changes
+void EEPROMClass::update(int address, uint8_t value) {
+  if (read(address) != value) {
+    write(address, value);
+  }
+}
+
+void EEPROMClass::Erase() {
+  memset(m_data, 0xFF, sizeof(m_data));
+  m_writeCount = 0;
+}
+
+unsigned long EEPROMClass::GetWriteCount() {
+  return m_writeCount;
+}
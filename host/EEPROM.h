@@ -0,0 +1,32 @@
+// EEPROM.h (host)
+//
+// The 1 KB EEPROM of an ATmega328 in RAM, erased (0xFF) at the start.
+// Writes are counted, the real one endures about 100000 per cell.
+
+#ifndef _HOST_EEPROM_h
+#define _HOST_EEPROM_h
+
+#include "Arduino.h"
+
+#define HOST_EEPROM_SIZE 1024
+
+class EEPROMClass {
+public:
+  EEPROMClass();
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  void update(int address, uint8_t value);
+  uint16_t length() { return HOST_EEPROM_SIZE; }
+
+  // Host only
+  void Erase();
+  unsigned long GetWriteCount();
+
+private:
+  uint8_t m_data[HOST_EEPROM_SIZE];
+  unsigned long m_writeCount;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,249 @@
+#include "RFM12Sim.h"
+
+RFM12Sim::RFM12Sim(byte mosi, byte miso, byte sck, byte ss, byte irq) {
+  m_mosi = mosi;
+  m_miso = miso;
+  m_sck = sck;
+  m_ss = ss;
+  m_irq = irq;
+  m_mosiLevel = LOW;
+
+  m_queueHead = 0;
+  m_queueCount = 0;
+
+  m_receiverOn = false;
+  m_transmitterOn = false;
+  m_fillEnabled = false;
+  m_filling = false;
+  m_byteIndex = 0;
+  m_nextByteTime = 0;
+  m_fifoCount = 0;
+  m_overflow = false;
+  m_dataRateCommand = 0x13;
+  m_noise = 0x12345678;
+
+  m_missedFrames = 0;
+  m_overflows = 0;
+  m_deafMicros = 0;
+  m_deafSince = micros();
+  m_deaf = true;
+
+  m_selected = false;
+  m_bitCount = 0;
+  m_command = 0;
+  m_response = 0;
+
+  HostSetInput(m_miso, LOW);
+  UpdateIrq();
+}
+
+bool RFM12Sim::Schedule(unsigned long start, const byte *data, byte length, unsigned long dataRate) {
+  if (m_queueCount >= RFM12SIM_QUEUE_SIZE || length > RFM12SIM_MAX_FRAME) {
+    return false;
+  }
+
+  AirFrame *frame = &m_queue[(m_queueHead + m_queueCount) % RFM12SIM_QUEUE_SIZE];
+  frame->Start = start;
+  frame->DataRate = dataRate;
+  frame->Length = length;
+  memcpy(frame->Data, data, length);
+  m_queueCount++;
+  return true;
+}
+
+unsigned long RFM12Sim::GetMissedFrames() {
+  return m_missedFrames;
+}
+
+unsigned long RFM12Sim::GetOverflows() {
+  return m_overflows;
+}
+
+unsigned long RFM12Sim::GetDataRate() {
+  // 10 MHz / 29 / (R + 1) / (1 + cs * 7)
+  unsigned long divider = (m_dataRateCommand & 0x7F) + 1;
+  if (m_dataRateCommand & 0x80) {
+    divider *= 8;
+  }
+  return (unsigned long)(344828.0 / divider + 0.5);
+}
+
+bool RFM12Sim::IsReceiverOn() {
+  return m_receiverOn;
+}
+
+unsigned long RFM12Sim::GetDeafMicros(unsigned long now) {
+  return m_deaf ? m_deafMicros + (now - m_deafSince) : m_deafMicros;
+}
+
+unsigned long RFM12Sim::GetByteTime(unsigned long dataRate) {
+  return (8000000UL + dataRate / 2) / dataRate;
+}
+
+unsigned long RFM12Sim::GetSyncTime(const AirFrame *frame) {
+  return frame->Start + 5 * GetByteTime(frame->DataRate);
+}
+
+bool RFM12Sim::IsMatchingDataRate(unsigned long dataRate) {
+  unsigned long own = GetDataRate();
+  unsigned long difference = own > dataRate ? own - dataRate : dataRate - own;
+  return difference * 100 < dataRate * 3;
+}
+
+bool RFM12Sim::GetNextEventTime(unsigned long *time) {
+  bool result = false;
+  if (m_queueCount > 0) {
+    *time = GetSyncTime(&m_queue[m_queueHead]);
+    result = true;
+  }
+  if (m_filling && (!result || (long)(m_nextByteTime - *time) < 0)) {
+    *time = m_nextByteTime;
+    result = true;
+  }
+  return result;
+}
+
+void RFM12Sim::Update(unsigned long now) {
+  // Bytes are due before a sync that happens at the same time
+  while (m_filling && (long)(m_nextByteTime - now) <= 0) {
+    byte data;
+    if (m_byteIndex < m_current.Length) {
+      data = m_current.Data[m_byteIndex++];
+    }
+    else {
+      m_noise = m_noise * 1103515245UL + 12345;
+      data = (byte)(m_noise >> 16);
+    }
+    PushFifo(data);
+    m_nextByteTime += GetByteTime(GetDataRate());
+  }
+
+  while (m_queueCount > 0 && (long)(GetSyncTime(&m_queue[m_queueHead]) - now) <= 0) {
+    AirFrame *frame = &m_queue[m_queueHead];
+    if (m_receiverOn && m_fillEnabled && !m_filling && IsMatchingDataRate(frame->DataRate)) {
+      m_current = *frame;
+      m_byteIndex = 0;
+      m_filling = true;
+      m_nextByteTime = GetSyncTime(frame) + GetByteTime(frame->DataRate);
+      UpdateDeafState();
+    }
+    else {
+      m_missedFrames++;
+    }
+    m_queueHead = (m_queueHead + 1) % RFM12SIM_QUEUE_SIZE;
+    m_queueCount--;
+  }
+}
+
+void RFM12Sim::PushFifo(byte data) {
+  if (m_fifoCount < sizeof(m_fifo)) {
+    m_fifo[m_fifoCount++] = data;
+  }
+  else {
+    m_overflow = true;
+    m_overflows++;
+  }
+  UpdateIrq();
+}
+
+byte RFM12Sim::PopFifo() {
+  byte result = 0;
+  if (m_fifoCount > 0) {
+    result = m_fifo[0];
+    m_fifo[0] = m_fifo[1];
+    m_fifoCount--;
+  }
+  UpdateIrq();
+  return result;
+}
+
+void RFM12Sim::Execute(word command) {
+  if ((command & 0xFF00) == 0x8200) {
+    // Power management
+    m_receiverOn = (command & 0x80) != 0;
+    m_transmitterOn = (command & 0x20) != 0;
+    if (!m_receiverOn) {
+      m_filling = false;
+    }
+  }
+  else if ((command & 0xFF00) == 0xCA00) {
+    // FIFO and reset mode, clearing ff stops the fill, setting it arms the sync detection
+    bool fillEnabled = (command & 0x02) != 0;
+    if (!fillEnabled) {
+      m_filling = false;
+    }
+    m_fillEnabled = fillEnabled;
+  }
+  else if ((command & 0xFF00) == 0xC600) {
+    m_dataRateCommand = command & 0xFF;
+  }
+  else if (command == 0x0000) {
+    m_overflow = false;
+  }
+
+  UpdateDeafState();
+  UpdateIrq();
+}
+
+void RFM12Sim::UpdateDeafState() {
+  bool deaf = !(m_receiverOn && m_fillEnabled && !m_filling);
+  if (deaf != m_deaf) {
+    unsigned long now = micros();
+    if (m_deaf) {
+      m_deafMicros += now - m_deafSince;
+    }
+    m_deafSince = now;
+    m_deaf = deaf;
+  }
+}
+
+void RFM12Sim::UpdateIrq() {
+  bool active = m_transmitterOn || m_fifoCount > 0 || m_overflow;
+  HostSetInput(m_irq, active ? LOW : HIGH);
+}
+
+void RFM12Sim::UpdateMiso() {
+  HostSetInput(m_miso, m_bitCount < 16 ? (m_response >> (15 - m_bitCount)) & 1 : LOW);
+}
+
+// MOSI is sampled on the rising edge of SCK, MISO changes on the falling edge
+void RFM12Sim::OnPinWrite(uint8_t pin, uint8_t value) {
+  if (pin == m_mosi) {
+    m_mosiLevel = value;
+  }
+  else if (pin == m_ss) {
+    if (!value && !m_selected) {
+      m_selected = true;
+      m_bitCount = 0;
+      m_command = 0;
+      // In TX mode bit 15 is RGIT (TX register ready)
+      m_response = 0;
+      if (m_transmitterOn || m_fifoCount > 0) {
+        m_response |= 0x8000;
+      }
+      if (m_overflow) {
+        m_response |= 0x2000;
+      }
+      UpdateMiso();
+    }
+    else if (value && m_selected) {
+      m_selected = false;
+      if (m_bitCount == 16) {
+        Execute(m_command);
+      }
+    }
+  }
+  else if (pin == m_sck && m_selected) {
+    if (value) {
+      m_command = (m_command << 1) | m_mosiLevel;
+      m_bitCount++;
+      if (m_bitCount == 8 && (m_command & 0xFF) == 0xB0) {
+        // FIFO read, the byte follows the command
+        m_response = (m_response & 0xFF00) | PopFifo();
+      }
+    }
+    else {
+      UpdateMiso();
+    }
+  }
+}
@@ -0,0 +1,87 @@
+// RFM12Sim.h (host)
+//
+// Simulated RFM12B on the bit-banged SPI pins of the RFM class.
+// It decodes the commands that are clocked in, receives the frames that are
+// scheduled "on air" at the configured data rate and drives MISO and nIRQ
+// like the real chip: a FIFO of two bytes, FFIT/FFOV in the status word and
+// after the sync pattern it keeps filling the FIFO (with noise once the frame
+// is over) until the firmware restarts the sync detection.
+
+#ifndef _RFM12SIM_h
+#define _RFM12SIM_h
+
+#include "Arduino.h"
+
+#define RFM12SIM_QUEUE_SIZE 64
+#define RFM12SIM_MAX_FRAME 64
+
+class RFM12Sim : public HostDevice {
+public:
+  RFM12Sim(byte mosi, byte miso, byte sck, byte ss, byte irq);
+
+  // Preamble and sync take 5 byte times, the first data byte is in the FIFO
+  // after 6 byte times. Frames have to be scheduled in order of time.
+  bool Schedule(unsigned long start, const byte *data, byte length, unsigned long dataRate);
+  // Frames that were on air while the receiver was off, not armed or busy
+  unsigned long GetMissedFrames();
+  unsigned long GetOverflows();
+  unsigned long GetDataRate();
+  bool IsReceiverOn();
+  // Time in us the receiver could not detect a new sync pattern
+  unsigned long GetDeafMicros(unsigned long now);
+
+  void OnPinWrite(uint8_t pin, uint8_t value);
+  bool GetNextEventTime(unsigned long *time);
+  void Update(unsigned long now);
+
+private:
+  struct AirFrame {
+    unsigned long Start;
+    unsigned long DataRate;
+    byte Length;
+    byte Data[RFM12SIM_MAX_FRAME];
+  };
+
+  byte m_mosi, m_miso, m_sck, m_ss, m_irq;
+  uint8_t m_mosiLevel;
+
+  AirFrame m_queue[RFM12SIM_QUEUE_SIZE];
+  byte m_queueHead;
+  byte m_queueCount;
+
+  bool m_receiverOn;
+  bool m_transmitterOn;
+  bool m_fillEnabled;
+  bool m_filling;
+  AirFrame m_current;
+  byte m_byteIndex;
+  unsigned long m_nextByteTime;
+  byte m_fifo[2];
+  byte m_fifoCount;
+  bool m_overflow;
+  byte m_dataRateCommand;
+  unsigned long m_noise;
+
+  unsigned long m_missedFrames;
+  unsigned long m_overflows;
+  unsigned long m_deafMicros;
+  unsigned long m_deafSince;
+  bool m_deaf;
+
+  bool m_selected;
+  byte m_bitCount;
+  word m_command;
+  word m_response;
+
+  unsigned long GetByteTime(unsigned long dataRate);
+  unsigned long GetSyncTime(const AirFrame *frame);
+  bool IsMatchingDataRate(unsigned long dataRate);
+  void PushFifo(byte data);
+  byte PopFifo();
+  void Execute(word command);
+  void UpdateDeafState();
+  void UpdateIrq();
+  void UpdateMiso();
+};
+
+#endif
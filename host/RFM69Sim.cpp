@@ -0,0 +1,222 @@
+#include "RFM69Sim.h"
+
+#define RFM69SIM_REG_FIFO 0x00
+#define RFM69SIM_REG_OPMODE 0x01
+#define RFM69SIM_REG_BITRATEMSB 0x03
+#define RFM69SIM_REG_BITRATELSB 0x04
+#define RFM69SIM_REG_VERSION 0x10
+#define RFM69SIM_REG_SYNCCONFIG 0x2E
+#define RFM69SIM_MODE_MASK 0x1C
+#define RFM69SIM_MODE_TRANSMITTER 0x0C
+#define RFM69SIM_PACKETSENT 0x08
+// Preamble of the packet engine (RegPreamble default)
+#define RFM69SIM_PREAMBLE_BYTES 3
+#define RFM69SIM_REG_IRQFLAGS2 0x28
+#define RFM69SIM_FIFONOTEMPTY 0x40
+#define RFM69SIM_FIFOOVERRUN 0x10
+#define RFM69SIM_PAYLOADREADY 0x04
+
+RFM69Sim::RFM69Sim(byte mosi, byte miso, byte sck, byte ss) {
+  m_mosi = mosi;
+  m_miso = miso;
+  m_sck = sck;
+  m_ss = ss;
+  m_mosiLevel = LOW;
+  m_sckLevel = LOW;
+
+  memset(m_registers, 0, sizeof(m_registers));
+  m_registers[RFM69SIM_REG_VERSION] = 0x24;
+  m_registers[RFM69SIM_REG_OPMODE] = 0x04;
+  ClearFifo();
+  m_transmitting = false;
+  m_packetSent = false;
+  m_transmitEnd = 0;
+  m_modeTime = 0;
+  m_sentFrames = 0;
+
+  m_selected = false;
+  m_bitCount = 0;
+  m_loadedAt = 0;
+  m_shift = 0;
+  m_address = 0;
+  m_write = false;
+  m_response = 0;
+
+  HostSetInput(m_miso, LOW);
+}
+
+void RFM69Sim::LoadPayload(const byte *data, byte length) {
+  ClearFifo();
+  for (byte i = 0; i < length && i < RFM69SIM_FIFO_SIZE; i++) {
+    m_fifo[m_fifoCount++] = data[i];
+  }
+  m_payloadReady = m_fifoCount > 0;
+}
+
+byte RFM69Sim::GetFifoCount() {
+  return m_fifoCount;
+}
+
+byte RFM69Sim::GetRegister(byte address) {
+  return m_registers[address & 0x7F];
+}
+
+byte RFM69Sim::GetMode() {
+  return m_registers[RFM69SIM_REG_OPMODE] & RFM69SIM_MODE_MASK;
+}
+
+unsigned long RFM69Sim::GetModeTime() {
+  return m_modeTime;
+}
+
+unsigned long RFM69Sim::GetSentFrames() {
+  UpdateTransmitter();
+  return m_sentFrames;
+}
+
+// Entering the transmitter mode starts the packet with what is in the FIFO,
+// leaving it clears PacketSent
+void RFM69Sim::SetMode(byte value) {
+  byte mode = value & RFM69SIM_MODE_MASK;
+  if (mode == RFM69SIM_MODE_TRANSMITTER && !m_transmitting) {
+    word divider = m_registers[RFM69SIM_REG_BITRATEMSB] << 8 | m_registers[RFM69SIM_REG_BITRATELSB];
+    unsigned long bitRate = 32000000ul / (divider > 0 ? divider : 1);
+    byte syncBytes = ((m_registers[RFM69SIM_REG_SYNCCONFIG] >> 3) & 7) + 1;
+    unsigned long bits = (RFM69SIM_PREAMBLE_BYTES + syncBytes + m_fifoCount) * 8ul;
+    m_transmitting = true;
+    m_packetSent = false;
+    m_transmitEnd = micros() + bits * 1000000ul / bitRate;
+  }
+  else if (mode != RFM69SIM_MODE_TRANSMITTER) {
+    m_transmitting = false;
+    m_packetSent = false;
+  }
+  if (mode != GetMode()) {
+    m_modeTime = micros();
+  }
+  m_registers[RFM69SIM_REG_OPMODE] = value;
+}
+
+void RFM69Sim::UpdateTransmitter() {
+  if (m_transmitting && !m_packetSent && (long)(micros() - m_transmitEnd) >= 0) {
+    m_packetSent = true;
+    m_sentFrames++;
+    ClearFifo();
+  }
+}
+
+void RFM69Sim::ClearFifo() {
+  m_fifoHead = 0;
+  m_fifoCount = 0;
+  m_payloadReady = false;
+}
+
+byte RFM69Sim::ReadRegister(byte address) {
+  if (address == RFM69SIM_REG_FIFO) {
+    return m_fifoCount > 0 ? m_fifo[m_fifoHead] : 0;
+  }
+  else if (address == RFM69SIM_REG_IRQFLAGS2) {
+    UpdateTransmitter();
+    byte result = 0;
+    if (m_packetSent) {
+      result |= RFM69SIM_PACKETSENT;
+    }
+    if (m_fifoCount > 0) {
+      result |= RFM69SIM_FIFONOTEMPTY;
+    }
+    if (m_payloadReady) {
+      result |= RFM69SIM_PAYLOADREADY;
+    }
+    return result;
+  }
+  return m_registers[address];
+}
+
+void RFM69Sim::PopFifo() {
+  if (m_fifoCount > 0) {
+    m_fifoHead++;
+    m_fifoCount--;
+  }
+  if (m_fifoCount == 0) {
+    m_fifoHead = 0;
+    m_payloadReady = false;
+  }
+}
+
+void RFM69Sim::WriteRegister(byte address, byte value) {
+  if (address == RFM69SIM_REG_FIFO) {
+    if (m_fifoCount < RFM69SIM_FIFO_SIZE) {
+      m_fifo[m_fifoCount++] = value;
+    }
+  }
+  else if (address == RFM69SIM_REG_OPMODE) {
+    SetMode(value);
+  }
+  else if (address == RFM69SIM_REG_IRQFLAGS2) {
+    if (value & RFM69SIM_FIFOOVERRUN) {
+      ClearFifo();
+    }
+  }
+  else if (address != RFM69SIM_REG_VERSION) {
+    m_registers[address] = value;
+  }
+}
+
+void RFM69Sim::UpdateMiso() {
+  HostSetInput(m_miso, (m_response >> (7 - m_bitCount % 8)) & 1);
+}
+
+// The first byte is the address (bit 7 set for a write), the address is
+// incremented after every data byte except for the FIFO. MOSI is sampled on
+// the rising edge, MISO changes on the falling edge. The falling edge after
+// the last byte already shows the next one, but the FIFO is only popped when
+// the master clocks it, so a burst read pops exactly the bytes it reads.
+void RFM69Sim::OnPinWrite(uint8_t pin, uint8_t value) {
+  if (pin == m_mosi) {
+    m_mosiLevel = value;
+  }
+  else if (pin == m_ss) {
+    if (!value && !m_selected) {
+      m_selected = true;
+      m_bitCount = 0;
+      m_loadedAt = 0;
+      m_response = 0;
+      UpdateMiso();
+    }
+    else if (value && m_selected) {
+      m_selected = false;
+    }
+  }
+  else if (pin == m_sck && m_selected) {
+    bool rising = value && !m_sckLevel;
+    m_sckLevel = value;
+    if (rising) {
+      m_shift = (m_shift << 1) | m_mosiLevel;
+      m_bitCount++;
+      if (!m_write && m_bitCount > 8 && m_bitCount % 8 == 1 && m_address == RFM69SIM_REG_FIFO) {
+        PopFifo();
+      }
+      if (m_bitCount % 8 == 0) {
+        if (m_bitCount == 8) {
+          m_address = m_shift & 0x7F;
+          m_write = (m_shift & 0x80) != 0;
+        }
+        else {
+          if (m_write) {
+            WriteRegister(m_address, m_shift);
+          }
+          if (m_address != RFM69SIM_REG_FIFO) {
+            m_address = (m_address + 1) & 0x7F;
+          }
+        }
+      }
+    }
+    else if (!value) {
+      if (!m_write && m_bitCount >= 8 && m_bitCount % 8 == 0 && m_loadedAt != m_bitCount) {
+        m_response = ReadRegister(m_address);
+        m_loadedAt = m_bitCount;
+      }
+      UpdateMiso();
+    }
+  }
+}
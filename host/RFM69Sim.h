@@ -0,0 +1,65 @@
+// RFM69Sim.h (host)
+//
+// Simulated RFM69CW on the SPI pins: the register file with auto-increment
+// on burst access and the 66 byte FIFO. There is no radio behind it, the host
+// code puts a received payload into the FIFO with LoadPayload(). In the
+// transmitter mode the FIFO goes on air at the programmed bit rate, preamble
+// and sync word included, and PacketSent is set when the last bit is out.
+
+#ifndef _RFM69SIM_h
+#define _RFM69SIM_h
+
+#include "Arduino.h"
+
+#define RFM69SIM_FIFO_SIZE 66
+
+class RFM69Sim : public HostDevice {
+public:
+  RFM69Sim(byte mosi, byte miso, byte sck, byte ss);
+
+  // Sets PayloadReady until the FIFO has been read empty
+  void LoadPayload(const byte *data, byte length);
+  byte GetFifoCount();
+  byte GetRegister(byte address);
+  // Mode bits of RegOpMode: 0x04 standby, 0x0C transmitter, 0x10 receiver
+  byte GetMode();
+  // micros() of the last change of the mode
+  unsigned long GetModeTime();
+  unsigned long GetSentFrames();
+
+  void OnPinWrite(uint8_t pin, uint8_t value);
+
+private:
+  byte m_mosi, m_miso, m_sck, m_ss;
+  uint8_t m_mosiLevel;
+  uint8_t m_sckLevel;
+
+  byte m_registers[0x80];
+  byte m_fifo[RFM69SIM_FIFO_SIZE];
+  byte m_fifoHead;
+  byte m_fifoCount;
+  bool m_payloadReady;
+  bool m_transmitting;
+  bool m_packetSent;
+  unsigned long m_transmitEnd;
+  unsigned long m_modeTime;
+  unsigned long m_sentFrames;
+
+  bool m_selected;
+  unsigned int m_bitCount;
+  unsigned int m_loadedAt;
+  byte m_shift;
+  byte m_address;
+  bool m_write;
+  byte m_response;
+
+  byte ReadRegister(byte address);
+  void WriteRegister(byte address, byte value);
+  void ClearFifo();
+  void PopFifo();
+  void UpdateMiso();
+  void SetMode(byte value);
+  void UpdateTransmitter();
+};
+
+#endif
@@ -0,0 +1,316 @@
+#include "RecordDecoder.h"
+#include <stdio.h>
+#include <string.h>
+
+// Tags and fields of RecordWriter.h
+#define TAG_LACROSSE       1
+#define TAG_TX22IT         2
+#define TAG_WS1080         3
+#define TAG_LEVELSENDER    4
+#define TAG_EMT7110        5
+#define TAG_WT440XH        6
+#define TAG_TX38IT         7
+#define TAG_CUSTOMSENSOR   8
+#define TAG_INTERNAL       9
+#define TAG_AGGREGATE      10
+
+#define HAS_TEMPERATURE    1
+#define HAS_HUMIDITY       2
+#define HAS_RAIN           4
+#define HAS_WIND_DIRECTION 8
+#define HAS_WIND_SPEED     16
+#define HAS_WIND_GUST      32
+#define HAS_PRESSURE       64
+
+RecordDecoder::RecordDecoder() {
+  m_chunkLength = 0;
+  m_chunkOverflow = false;
+  m_recordLength = 0;
+  m_isRecord = false;
+}
+
+bool RecordDecoder::Put(uint8_t value) {
+  if (value != 0) {
+    if (m_chunkLength < sizeof(m_chunk)) {
+      m_chunk[m_chunkLength++] = value;
+    }
+    else {
+      m_chunkOverflow = true;
+    }
+    return false;
+  }
+
+  m_isRecord = !m_chunkOverflow && Decode(m_chunk, m_chunkLength, m_record, &m_recordLength);
+  m_text.assign((const char *)m_chunk, m_chunkLength);
+  m_chunkLength = 0;
+  m_chunkOverflow = false;
+  return true;
+}
+
+bool RecordDecoder::IsRecord() {
+  return m_isRecord;
+}
+
+const uint8_t *RecordDecoder::GetRecord() {
+  return m_record;
+}
+
+size_t RecordDecoder::GetRecordLength() {
+  return m_recordLength;
+}
+
+std::string RecordDecoder::GetText() {
+  return m_text;
+}
+
+uint8_t RecordDecoder::Crc8(const uint8_t *data, size_t length) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = crc & 0x80 ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// Every block starts with its length + 1, all blocks but the last one end
+// with a zero that is not sent
+bool RecordDecoder::Decode(const uint8_t *chunk, size_t length, uint8_t *record, size_t *recordLength) {
+  size_t decoded = 0;
+  size_t position = 0;
+  while (position < length) {
+    size_t code = chunk[position++];
+    if (code == 0 || position + code - 1 > length) {
+      return false;
+    }
+    for (size_t i = 1; i < code; i++) {
+      record[decoded++] = chunk[position++];
+    }
+    if (position < length) {
+      record[decoded++] = 0;
+    }
+  }
+
+  // Tag and CRC at least
+  if (decoded < 2 || Crc8(record, decoded - 1) != record[decoded - 1]) {
+    return false;
+  }
+  *recordLength = decoded - 1;
+  return true;
+}
+
+static void AddNumber(std::string *line, unsigned int value) {
+  char text[8];
+  snprintf(text, sizeof(text), " %u", value);
+  *line += text;
+}
+
+static void AddWord(std::string *line, unsigned int value) {
+  AddNumber(line, (value >> 8) & 0xFF);
+  AddNumber(line, value & 0xFF);
+}
+
+static unsigned int GetWord(const uint8_t *data) {
+  return data[0] << 8 | data[1];
+}
+
+// Like WSBase::BuildFhemDataString(), missing values are 255 / 255 255
+static bool FormatWS(const uint8_t *record, size_t length, unsigned int sensorType, std::string *line) {
+  if (length < 4) {
+    return false;
+  }
+  uint8_t flags = record[2];
+  uint8_t fields = record[3];
+  size_t expected = 4;
+  expected += fields & HAS_TEMPERATURE ? 2 : 0;
+  expected += fields & HAS_HUMIDITY ? 1 : 0;
+  expected += fields & HAS_RAIN ? 2 : 0;
+  expected += fields & HAS_WIND_DIRECTION ? 2 : 0;
+  expected += fields & HAS_WIND_SPEED ? 2 : 0;
+  expected += fields & HAS_WIND_GUST ? 2 : 0;
+  expected += fields & HAS_PRESSURE ? 2 : 0;
+  if (length != expected) {
+    return false;
+  }
+
+  const uint8_t *data = record + 4;
+  *line = "OK WS";
+  AddNumber(line, record[1]);
+  AddNumber(line, sensorType);
+
+  if (fields & HAS_TEMPERATURE) {
+    AddWord(line, (int16_t)GetWord(data) + 1000);
+    data += 2;
+  }
+  else {
+    AddWord(line, 0xFFFF);
+  }
+
+  if (fields & HAS_HUMIDITY) {
+    AddNumber(line, *data++);
+  }
+  else {
+    AddNumber(line, 0xFF);
+  }
+
+  // The text line has whole mm
+  if (fields & HAS_RAIN) {
+    AddWord(line, GetWord(data) / 10);
+    data += 2;
+  }
+  else {
+    AddWord(line, 0xFFFF);
+  }
+
+  static const uint8_t windFields[] = { HAS_WIND_DIRECTION, HAS_WIND_SPEED, HAS_WIND_GUST };
+  for (size_t i = 0; i < sizeof(windFields); i++) {
+    if (fields & windFields[i]) {
+      AddWord(line, GetWord(data));
+      data += 2;
+    }
+    else {
+      AddWord(line, 0xFFFF);
+    }
+  }
+
+  AddNumber(line, flags);
+
+  if (fields & HAS_PRESSURE) {
+    AddWord(line, GetWord(data));
+  }
+  return true;
+}
+
+static void AddTemperature(std::string *line, const uint8_t *data, bool hasValue) {
+  AddWord(line, hasValue ? (int16_t)GetWord(data) + 1000 : 0xFFFF);
+}
+
+// Like Aggregator::SendLine(): OK 9A for the tags of the OK 9 line, OK WSA for the others
+static bool FormatAggregate(const uint8_t *record, size_t length, std::string *line) {
+  if (length < 6) {
+    return false;
+  }
+  uint8_t tag = record[1];
+  uint8_t flags = record[3];
+  uint8_t fields = record[4];
+  bool hasTemperature = fields & HAS_TEMPERATURE;
+  bool hasHumidity = fields & HAS_HUMIDITY;
+  size_t expected = 6;
+  expected += hasTemperature ? 6 : 0;
+  expected += hasHumidity ? 3 : 0;
+  if (length != expected) {
+    return false;
+  }
+  const uint8_t *temperature = record + 6;
+  const uint8_t *humidity = record + 6 + (hasTemperature ? 6 : 0);
+
+  bool isWS = false;
+  uint8_t humidityMean = hasHumidity ? humidity[0] : 0xFF;
+  if (tag == TAG_LACROSSE || tag == TAG_WT440XH || tag == TAG_TX38IT) {
+    if (!hasTemperature || !hasHumidity) {
+      return false;
+    }
+    *line = "OK 9A";
+    AddNumber(line, record[2]);
+    AddNumber(line, flags & 4 ? 130 : (flags & 1 ? 129 : 1));
+    humidityMean |= flags & 2 ? 0x80 : 0;
+  }
+  else if (tag == TAG_TX22IT || tag == TAG_INTERNAL || tag == TAG_WS1080) {
+    isWS = true;
+    *line = "OK WSA";
+    AddNumber(line, record[2]);
+    AddNumber(line, tag == TAG_TX22IT ? 1 : (tag == TAG_INTERNAL ? 2 : 3));
+  }
+  else {
+    return false;
+  }
+
+  AddTemperature(line, temperature, hasTemperature);
+  AddNumber(line, humidityMean);
+  AddTemperature(line, temperature + 2, hasTemperature);
+  AddTemperature(line, temperature + 4, hasTemperature);
+  AddNumber(line, hasHumidity ? humidity[1] : 0xFF);
+  AddNumber(line, hasHumidity ? humidity[2] : 0xFF);
+  if (isWS) {
+    AddNumber(line, flags);
+  }
+  AddNumber(line, record[5]);
+  return true;
+}
+
+bool RecordDecoder::Format(const uint8_t *record, size_t length, std::string *line) {
+  if (length < 1) {
+    return false;
+  }
+
+  switch (record[0]) {
+  case TAG_LACROSSE:
+  case TAG_WT440XH:
+  case TAG_TX38IT: {
+    if (length != 6) {
+      return false;
+    }
+    uint8_t flags = record[2];
+    // The sketch prints 130 for the second channel with or without a new battery
+    unsigned int sensorType = flags & 4 ? 130 : (flags & 1 ? 129 : 1);
+    *line = "OK 9";
+    AddNumber(line, record[1]);
+    AddNumber(line, sensorType);
+    AddWord(line, (int16_t)GetWord(record + 3) + 1000);
+    AddNumber(line, record[5] | (flags & 2 ? 0x80 : 0));
+    return true;
+  }
+
+  case TAG_TX22IT:
+    return FormatWS(record, length, 1, line);
+  case TAG_INTERNAL:
+    return FormatWS(record, length, 2, line);
+  case TAG_WS1080:
+    return FormatWS(record, length, 3, line);
+
+  case TAG_LEVELSENDER:
+    if (length != 8) {
+      return false;
+    }
+    *line = "OK LS";
+    AddNumber(line, record[1]);
+    AddNumber(line, 0);
+    AddWord(line, (int16_t)GetWord(record + 3) * 5 + 1000);
+    AddWord(line, (int16_t)GetWord(record + 5) + 1000);
+    AddNumber(line, record[7]);
+    return true;
+
+  case TAG_EMT7110:
+    if (length != 12) {
+      return false;
+    }
+    *line = "OK EMT7110";
+    AddWord(line, GetWord(record + 1));
+    for (size_t i = 4; i < 12; i += 2) {
+      AddWord(line, GetWord(record + i));
+    }
+    AddNumber(line, record[3]);
+    return true;
+
+  case TAG_AGGREGATE:
+    return FormatAggregate(record, length, line);
+
+  case TAG_CUSTOMSENSOR:
+    if (length < 3) {
+      return false;
+    }
+    *line = "OK CC";
+    AddNumber(line, record[1]);
+    *line += ' ';
+    for (size_t i = 3; i < length; i++) {
+      char text[8];
+      snprintf(text, sizeof(text), "%u ", record[i]);
+      *line += text;
+    }
+    return true;
+
+  default:
+    return false;
+  }
+}
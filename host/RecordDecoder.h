@@ -0,0 +1,52 @@
+// RecordDecoder.h
+//
+// Reference decoder for the binary output of the sketch (<1>b, see
+// LaCrosseITPlusReader10/RecordWriter.h). It does not need the Arduino shim,
+// so it can be taken as it is into a host program.
+//
+// The serial stream is cut at every zero. A chunk is a record when it can be
+// COBS decoded and its CRC8 fits, anything else (the version line, help and
+// statistics) is text.
+// Format() turns a record back into the "OK ..." line the text output would
+// have given for the same frame.
+
+#ifndef _RECORDDECODER_h
+#define _RECORDDECODER_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+#define RECORD_DECODER_CHUNK_SIZE 256
+
+class RecordDecoder {
+public:
+  RecordDecoder();
+
+  // Feeds one byte from the serial port, true when it completed a chunk
+  bool Put(uint8_t value);
+
+  // About the chunk that was completed last
+  bool IsRecord();
+  const uint8_t *GetRecord();
+  size_t GetRecordLength();
+  std::string GetText();
+
+  // COBS decode and check the CRC, the record is returned without the CRC
+  static bool Decode(const uint8_t *chunk, size_t length, uint8_t *record, size_t *recordLength);
+  // Text line of a sensor record, false for the raw payload, format and unknown records
+  static bool Format(const uint8_t *record, size_t length, std::string *line);
+
+private:
+  uint8_t m_chunk[RECORD_DECODER_CHUNK_SIZE];
+  size_t m_chunkLength;
+  bool m_chunkOverflow;
+  uint8_t m_record[RECORD_DECODER_CHUNK_SIZE];
+  size_t m_recordLength;
+  bool m_isRecord;
+  std::string m_text;
+
+  static uint8_t Crc8(const uint8_t *data, size_t length);
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "SPI.h"
+
+// Writing SPDR, polling SPIF and reading SPDR back
+#define HOST_SPI_BYTE_NANOS 250
+// Saving SREG and writing SPCR/SPSR in beginTransaction, restoring in endTransaction
+#define HOST_SPI_TRANSACTION_NANOS 500
+
+SPIClass SPI;
+uint32_t SPIClass::s_clock = 4000000;
+uint8_t SPIClass::s_interruptMask = 0;
+uint8_t SPIClass::s_interruptSave = 0;
+
+void SPIClass::begin() {
+  HostDriveOutput(SCK, LOW);
+  HostDriveOutput(MOSI, LOW);
+}
+
+void SPIClass::end() {
+}
+
+void SPIClass::beginTransaction(SPISettings settings) {
+  // The next lower clock the prescaler can make
+  uint32_t clock = HOST_SPI_MAX_CLOCK;
+  while (clock > settings.Clock && clock > HOST_SPI_MAX_CLOCK / 64) {
+    clock /= 2;
+  }
+  s_clock = clock;
+  if (s_interruptMask) {
+    s_interruptSave = EIMSK;
+    EIMSK &= ~s_interruptMask;
+  }
+  HostClock::AdvanceNanos(HOST_SPI_TRANSACTION_NANOS / 2);
+}
+
+void SPIClass::endTransaction() {
+  // A pending interrupt runs with the clock
+  if (s_interruptMask) {
+    EIMSK = s_interruptSave;
+  }
+  HostClock::AdvanceNanos(HOST_SPI_TRANSACTION_NANOS / 2);
+}
+
+void SPIClass::usingInterrupt(uint8_t interruptNumber) {
+  if (interruptNumber < HOST_NUM_INTERRUPTS) {
+    s_interruptMask |= 1 << interruptNumber;
+  }
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  for (uint8_t i = 0; i < 8; i++) {
+    HostDriveOutput(SCK, LOW);
+    HostDriveOutput(MOSI, (data & 0x80) ? HIGH : LOW);
+    data <<= 1;
+    HostDriveOutput(SCK, HIGH);
+    if (digitalRead(MISO)) {
+      data |= 1;
+    }
+  }
+  HostDriveOutput(SCK, LOW);
+
+  HostClock::AdvanceNanos(8000000000ULL / s_clock + HOST_SPI_BYTE_NANOS);
+  return data;
+}
@@ -0,0 +1,48 @@
+// SPI.h (host)
+//
+// The SPI hardware of the ATmega328 on MOSI, MISO and SCK. A transfer moves
+// the pins like the peripheral does (mode 0, MSB first), so the simulated
+// devices see the same bus as with bit-banging. The clock advances by the
+// bits at the SCK of the transaction plus the register accesses of the CPU.
+
+#ifndef _HOST_SPI_h
+#define _HOST_SPI_h
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0x00
+
+// The ATmega328 divides 16 MHz by 2 ... 128
+#define HOST_SPI_MAX_CLOCK 8000000UL
+
+class SPISettings {
+public:
+  SPISettings() : Clock(4000000), BitOrder(MSBFIRST), DataMode(SPI_MODE0) {}
+  SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+    : Clock(clock), BitOrder(bitOrder), DataMode(dataMode) {}
+
+  uint32_t Clock;
+  uint8_t BitOrder;
+  uint8_t DataMode;
+};
+
+class SPIClass {
+public:
+  static void begin();
+  static void end();
+  static void beginTransaction(SPISettings settings);
+  static void endTransaction();
+  static uint8_t transfer(uint8_t data);
+  // An external interrupt whose handler uses the bus is masked in EIMSK
+  // during a transaction
+  static void usingInterrupt(uint8_t interruptNumber);
+
+private:
+  static uint32_t s_clock;
+  static uint8_t s_interruptMask;
+  static uint8_t s_interruptSave;
+};
+
+extern SPIClass SPI;
+
+#endif
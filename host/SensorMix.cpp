@@ -0,0 +1,44 @@
+#include "SensorMix.h"
+#include "FrameRing.h"
+
+std::vector<SensorMix::Sensor> SensorMix::Build() {
+  std::vector<Sensor> sensors;
+  static const byte tx29[] = { 3, 9, 17, 22, 41, 58 };
+  for (size_t i = 0; i < sizeof(tx29); i++) {
+    Sensor sensor = { "TX29", FrameDispatcher::ProtocolLaCrosse, tx29[i], 17241ul, 4000ul + tx29[i] * 3, 5, 0, 0, 0 };
+    sensors.push_back(sensor);
+  }
+  Sensor tx27 = { "TX27", FrameDispatcher::ProtocolLaCrosse, 30, 9579ul, 4100, 5, 0, 0, 0 };
+  sensors.push_back(tx27);
+  Sensor tx22a = { "TX22IT", FrameDispatcher::ProtocolTX22IT, 12, 8842ul, 4500, 14, 0, 0, 0 };
+  sensors.push_back(tx22a);
+  Sensor tx22b = { "TX22IT", FrameDispatcher::ProtocolTX22IT, 45, 8842ul, 4470, 14, 0, 0, 0 };
+  sensors.push_back(tx22b);
+  Sensor emtA = { "EMT7110", FrameDispatcher::ProtocolEMT7110, 0x1234, 9579ul, 30000, 12, 0, 0, 0 };
+  sensors.push_back(emtA);
+  Sensor emtB = { "EMT7110", FrameDispatcher::ProtocolEMT7110, 0x5A01, 9579ul, 30000, 12, 0, 0, 0 };
+  sensors.push_back(emtB);
+  return sensors;
+}
+
+void SensorMix::BuildPayload(const Sensor &sensor, byte *payload) {
+  memset(payload, 0, PAYLOADSIZE);
+  switch (sensor.Protocol) {
+    case FrameDispatcher::ProtocolLaCrosse:
+      payload[0] = 0x90 | sensor.ID >> 2;
+      payload[1] = (sensor.ID & 3) << 6;
+      break;
+    case FrameDispatcher::ProtocolTX22IT:
+      payload[0] = 0xA0 | sensor.ID >> 2;
+      payload[1] = (sensor.ID & 3) << 6;
+      break;
+    case FrameDispatcher::ProtocolEMT7110:
+      payload[0] = 0x25;
+      payload[1] = 0x6A;
+      payload[2] = sensor.ID >> 8;
+      payload[3] = sensor.ID & 0xFF;
+      break;
+    default:
+      break;
+  }
+}
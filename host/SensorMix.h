@@ -0,0 +1,36 @@
+// SensorMix.h
+//
+// The sensors of a house that rate_bench and radio_bench receive: 6 TX29 at
+// 17.241 kbps (about every 4 s), a TX27 at 9.579 kbps, 2 TX22IT at
+// 8.842 kbps (about every 4.5 s) and 2 EMT7110 at 9.579 kbps (every 30 s).
+// A bench sets the phase (Next) and counts Sent and Captured itself.
+// BuildPayload() encodes only the header, the FrameDispatcher and the
+// RatePlanner do not look further.
+
+#ifndef _SENSORMIX_h
+#define _SENSORMIX_h
+
+#include <vector>
+#include "Arduino.h"
+#include "FrameDispatcher.h"
+
+class SensorMix {
+public:
+  struct Sensor {
+    const char *Name;
+    FrameDispatcher::Protocol Protocol;
+    word ID;
+    unsigned long DataRate;
+    unsigned long Period;
+    byte FrameLength;
+    unsigned long Next;
+    unsigned long Sent;
+    unsigned long Captured;
+  };
+
+  static std::vector<Sensor> Build();
+  // payload has PAYLOADSIZE bytes
+  static void BuildPayload(const Sensor &sensor, byte *payload);
+};
+
+#endif
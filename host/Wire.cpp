@@ -0,0 +1,108 @@
+#include "Wire.h"
+
+TwoWire Wire;
+
+TwoWire::TwoWire() {
+  m_slaveCount = 0;
+  m_clock = 100000;
+  m_address = 0;
+  m_txLength = 0;
+  m_rxLength = 0;
+  m_rxIndex = 0;
+  m_transactions = 0;
+}
+
+void TwoWire::begin() {
+}
+
+void TwoWire::setClock(uint32_t clock) {
+  m_clock = clock;
+}
+
+void TwoWire::Attach(uint8_t address, HostI2CDevice *device) {
+  Detach(address);
+  if (m_slaveCount < HOST_WIRE_MAX_DEVICES) {
+    m_slaves[m_slaveCount].Address = address;
+    m_slaves[m_slaveCount].Device = device;
+    m_slaveCount++;
+  }
+}
+
+void TwoWire::Detach(uint8_t address) {
+  for (uint8_t i = 0; i < m_slaveCount; i++) {
+    if (m_slaves[i].Address == address) {
+      m_slaves[i] = m_slaves[--m_slaveCount];
+      break;
+    }
+  }
+}
+
+unsigned long TwoWire::GetTransactionCount() {
+  return m_transactions;
+}
+
+HostI2CDevice *TwoWire::Find(uint8_t address) {
+  for (uint8_t i = 0; i < m_slaveCount; i++) {
+    if (m_slaves[i].Address == address) {
+      return m_slaves[i].Device;
+    }
+  }
+  return NULL;
+}
+
+// Start, address byte, data bytes and stop
+void TwoWire::Charge(uint8_t bytes) {
+  m_transactions++;
+  HostClock::AdvanceNanos((unsigned long)((bytes + 1) * 9 + 2) * (1000000000UL / m_clock));
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  m_address = address;
+  m_txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (m_txLength >= HOST_WIRE_BUFFER_SIZE) {
+    return 0;
+  }
+  m_txBuffer[m_txLength++] = data;
+  return 1;
+}
+
+// 0: success, 2: NACK on the address
+uint8_t TwoWire::endTransmission() {
+  HostI2CDevice *device = Find(m_address);
+  Charge(m_txLength);
+  if (device == NULL) {
+    return 2;
+  }
+  if (m_txLength > 0) {
+    device->OnReceive(m_txBuffer, m_txLength);
+  }
+  m_txLength = 0;
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity) {
+  HostI2CDevice *device = Find(address);
+  if (quantity > HOST_WIRE_BUFFER_SIZE) {
+    quantity = HOST_WIRE_BUFFER_SIZE;
+  }
+  Charge(quantity);
+
+  m_rxIndex = 0;
+  m_rxLength = 0;
+  if (device != NULL) {
+    device->OnRequest(m_rxBuffer, quantity);
+    m_rxLength = quantity;
+  }
+  return m_rxLength;
+}
+
+int TwoWire::available() {
+  return m_rxLength - m_rxIndex;
+}
+
+int TwoWire::read() {
+  return m_rxIndex < m_rxLength ? m_rxBuffer[m_rxIndex++] : -1;
+}
@@ -0,0 +1,64 @@
+// Wire.h (host)
+//
+// I2C master with simulated slaves (HostI2CDevice) attached by address.
+// Every transaction advances the clock by its bits at the bus clock (9 per
+// byte including the ACK, plus the address byte).
+
+#ifndef _HOST_WIRE_h
+#define _HOST_WIRE_h
+
+#include "Arduino.h"
+
+#define HOST_WIRE_BUFFER_SIZE 32
+#define HOST_WIRE_MAX_DEVICES 4
+
+class HostI2CDevice {
+public:
+  virtual ~HostI2CDevice() {}
+  // The master wrote the bytes in one transmission
+  virtual void OnReceive(const uint8_t *data, uint8_t length) = 0;
+  // The master reads length bytes
+  virtual void OnRequest(uint8_t *data, uint8_t length) = 0;
+};
+
+class TwoWire {
+public:
+  TwoWire();
+  void begin();
+  void setClock(uint32_t clock);
+  void beginTransmission(uint8_t address);
+  size_t write(uint8_t data);
+  uint8_t endTransmission();
+  uint8_t requestFrom(uint8_t address, uint8_t quantity);
+  int available();
+  int read();
+
+  // Host only
+  void Attach(uint8_t address, HostI2CDevice *device);
+  void Detach(uint8_t address);
+  unsigned long GetTransactionCount();
+
+private:
+  struct Slave {
+    uint8_t Address;
+    HostI2CDevice *Device;
+  };
+
+  Slave m_slaves[HOST_WIRE_MAX_DEVICES];
+  uint8_t m_slaveCount;
+  uint32_t m_clock;
+  uint8_t m_address;
+  uint8_t m_txBuffer[HOST_WIRE_BUFFER_SIZE];
+  uint8_t m_txLength;
+  uint8_t m_rxBuffer[HOST_WIRE_BUFFER_SIZE];
+  uint8_t m_rxLength;
+  uint8_t m_rxIndex;
+  unsigned long m_transactions;
+
+  HostI2CDevice *Find(uint8_t address);
+  void Charge(uint8_t bytes);
+};
+
+extern TwoWire Wire;
+
+#endif
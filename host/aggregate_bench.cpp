@@ -0,0 +1,322 @@
+// aggregate_bench.cpp
+//
+// Aggregation (<n>w, Aggregator) of TX29 and TX22IT sensors that send every
+// 4 s with slowly wandering values, run through the decoders as in the
+// sketch, with Aggregator::Handle() called like from loop().
+// Every scenario runs once with text lines and once with binary records. The
+// records, turned into lines by the RecordDecoder of the host, have to be
+// the same lines. From the lines the bench checks that no frame is lost
+// (the counts add up per sensor), that min <= mean <= max, that min and max
+// over all lines are those of the sent values and that the means add up to
+// the sent sum within their rounding.
+//
+// Usage: aggregate_bench [minutes]
+
+#include <map>
+#include <string>
+#include <vector>
+#include <sstream>
+#include "Arduino.h"
+#include "LaCrosse.h"
+#include "TX22IT.h"
+#include "FrameRing.h"
+#include "SerialQueue.h"
+#include "Aggregator.h"
+#include "RecordDecoder.h"
+
+#define SEND_INTERVAL 4000
+#define MAX_SENSORS 32
+#define LOOP_MILLIS 5
+
+struct Scenario {
+  const char *Name;
+  byte TX29;
+  byte TX22IT;
+  word Window;
+};
+
+static const Scenario s_scenarios[] = {
+  { "12 TX29 + 4 TX22IT, 60 s", 12, 4, 60 },
+  { "12 TX29 + 4 TX22IT, 300 s", 12, 4, 300 },
+  { "20 TX29 + 4 TX22IT, 60 s (table full)", 20, 4, 60 },
+};
+
+struct Sensor {
+  bool IsTX22IT;
+  byte ID;
+  int Temperature;
+  byte Humidity;
+  unsigned long NextFrame;
+};
+
+// What was sent and what came out, per sensor
+struct Totals {
+  unsigned long Frames;
+  long TemperatureSum;
+  long HumiditySum;
+  int TemperatureMin;
+  int TemperatureMax;
+  int HumidityMin;
+  int HumidityMax;
+};
+
+static Sensor s_sensors[MAX_SENSORS];
+static byte s_sensorCount;
+static unsigned long s_random = 1;
+
+static unsigned long Random(unsigned long range) {
+  s_random = s_random * 1103515245UL + 12345;
+  return (s_random >> 8) % range;
+}
+
+static void Setup(const Scenario *scenario) {
+  s_random = 1;
+  s_sensorCount = scenario->TX29 + scenario->TX22IT;
+  for (byte i = 0; i < s_sensorCount; i++) {
+    Sensor *sensor = &s_sensors[i];
+    sensor->IsTX22IT = i >= scenario->TX29;
+    sensor->ID = sensor->IsTX22IT ? 40 + i : i;
+    sensor->Temperature = Random(300) - 50;
+    sensor->Humidity = 30 + Random(50);
+    sensor->NextFrame = Random(SEND_INTERVAL);
+  }
+}
+
+static void Drift(Sensor *sensor) {
+  sensor->Temperature += (int)Random(5) - 2;
+  unsigned long dice = Random(10);
+  if (dice == 0 && sensor->Humidity < 99) {
+    sensor->Humidity++;
+  }
+  else if (dice == 1 && sensor->Humidity > 1) {
+    sensor->Humidity--;
+  }
+}
+
+// Temperature and humidity, each as type and three BCD digits
+static void EncodeTX22IT(const Sensor *sensor, byte *bytes) {
+  word temperature = sensor->Temperature + 400;
+  bytes[0] = 0xA0 | ((sensor->ID >> 2) & 0x0F);
+  bytes[1] = (sensor->ID & 3) << 6 | 2;
+  bytes[2] = 0x00 | temperature / 100;
+  bytes[3] = (temperature / 10 % 10) << 4 | temperature % 10;
+  bytes[4] = 0x10 | sensor->Humidity / 100;
+  bytes[5] = (sensor->Humidity / 10 % 10) << 4 | sensor->Humidity % 10;
+  bytes[6] = SensorBase::CalculateCRC(bytes, 6);
+}
+
+static void Send(const Sensor *sensor) {
+  byte payload[PAYLOADSIZE];
+  memset(payload, 0, sizeof(payload));
+  if (sensor->IsTX22IT) {
+    EncodeTX22IT(sensor, payload);
+    TX22IT::TryHandleData(payload);
+  }
+  else {
+    struct LaCrosse::Frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.ID = sensor->ID;
+    frame.Temperature = sensor->Temperature;
+    frame.Humidity = sensor->Humidity;
+    LaCrosse::EncodeFrame(&frame, payload);
+    LaCrosse::TryHandleData(payload);
+  }
+}
+
+static void Add(Totals *totals, int temperature, int humidity) {
+  if (totals->Frames == 0) {
+    totals->TemperatureMin = totals->TemperatureMax = temperature;
+    totals->HumidityMin = totals->HumidityMax = humidity;
+  }
+  totals->TemperatureMin = temperature < totals->TemperatureMin ? temperature : totals->TemperatureMin;
+  totals->TemperatureMax = temperature > totals->TemperatureMax ? temperature : totals->TemperatureMax;
+  totals->HumidityMin = humidity < totals->HumidityMin ? humidity : totals->HumidityMin;
+  totals->HumidityMax = humidity > totals->HumidityMax ? humidity : totals->HumidityMax;
+}
+
+static std::string GetKey(bool isTX22IT, int id) {
+  return (isTX22IT ? "WS " : "9 ") + std::to_string(id);
+}
+
+// Runs the scenario, returns what went over the serial port
+static std::string Run(const Scenario *scenario, bool binary, unsigned long minutes,
+  std::map<std::string, Totals> *sent, unsigned long *frames) {
+  HostClock::SetMicros(0);
+  Serial.ClearOutput();
+  Setup(scenario);
+  SensorBase::SetBinaryOutput(binary);
+  Aggregator::Configure(scenario->Window);
+  Aggregator::ResetStatistics();
+  sent->clear();
+  *frames = 0;
+
+  std::string output;
+  unsigned long end = minutes * 60000UL;
+  while (millis() < end) {
+    Sensor *next = &s_sensors[0];
+    for (byte i = 1; i < s_sensorCount; i++) {
+      if (s_sensors[i].NextFrame < next->NextFrame) {
+        next = &s_sensors[i];
+      }
+    }
+    while (millis() + LOOP_MILLIS < next->NextFrame) {
+      HostClock::AdvanceMicros(LOOP_MILLIS * 1000);
+      Aggregator::Handle();
+      SerialQueue::Flush();
+    }
+    HostClock::SetMicros(next->NextFrame * 1000);
+
+    Drift(next);
+    Send(next);
+    SerialQueue::Flush();
+    Totals *totals = &(*sent)[GetKey(next->IsTX22IT, next->ID)];
+    Add(totals, next->Temperature, next->Humidity);
+    totals->Frames++;
+    totals->TemperatureSum += next->Temperature;
+    totals->HumiditySum += next->Humidity;
+    (*frames)++;
+    next->NextFrame += SEND_INTERVAL - 50 + Random(100);
+
+    output.append(Serial.GetOutput(), Serial.GetOutputLength());
+    Serial.ClearOutput();
+  }
+
+  // What is still collected comes with switching off
+  Aggregator::Configure(0);
+  SerialQueue::Flush();
+  output.append(Serial.GetOutput(), Serial.GetOutputLength());
+  Serial.ClearOutput();
+  SensorBase::SetBinaryOutput(false);
+  return output;
+}
+
+static std::vector<std::string> SplitLines(const std::string &text) {
+  std::vector<std::string> lines;
+  size_t start = 0;
+  size_t position;
+  while ((position = text.find("\r\n", start)) != std::string::npos) {
+    lines.push_back(text.substr(start, position - start));
+    start = position + 2;
+  }
+  return lines;
+}
+
+static std::vector<std::string> DecodeRecords(const std::string &stream) {
+  std::vector<std::string> lines;
+  RecordDecoder decoder;
+  for (size_t i = 0; i < stream.size(); i++) {
+    if (decoder.Put(stream[i]) && decoder.IsRecord()) {
+      std::string line;
+      if (RecordDecoder::Format(decoder.GetRecord(), decoder.GetRecordLength(), &line)) {
+        lines.push_back(line);
+      }
+      else {
+        lines.push_back("?");
+      }
+    }
+  }
+  return lines;
+}
+
+// OK 9A ID type T T H Tmin Tmin Tmax Tmax Hmin Hmax [flags] count
+static bool Check(const std::vector<std::string> &lines, std::map<std::string, Totals> *sent) {
+  std::map<std::string, Totals> received;
+  std::map<std::string, long> temperatureTolerance;
+  std::map<std::string, long> humidityTolerance;
+  for (size_t i = 0; i < lines.size(); i++) {
+    std::istringstream stream(lines[i]);
+    std::string ok;
+    std::string type;
+    int v[13];
+    stream >> ok >> type;
+    // Sensors beyond the table come as they are
+    if (ok == "OK" && (type == "9" || type == "WS")) {
+      stream >> v[0] >> v[1] >> v[2] >> v[3] >> v[4];
+      int temperature = v[2] * 256 + v[3] - 1000;
+      int humidity = v[4] & 0x7F;
+      std::string key = GetKey(type == "WS", v[0]);
+      Totals *totals = &received[key];
+      Add(totals, temperature, humidity);
+      totals->Frames++;
+      totals->TemperatureSum += temperature;
+      totals->HumiditySum += humidity;
+      continue;
+    }
+
+    bool isWS = type == "WSA";
+    int fields = isWS ? 13 : 12;
+    for (int f = 0; f < fields; f++) {
+      stream >> v[f];
+    }
+    if (!stream || ok != "OK" || (type != "9A" && !isWS)) {
+      printf("Bad line: %s\n", lines[i].c_str());
+      return false;
+    }
+    int mean = v[2] * 256 + v[3] - 1000;
+    int humidity = v[4] & 0x7F;
+    int min = v[5] * 256 + v[6] - 1000;
+    int max = v[7] * 256 + v[8] - 1000;
+    int count = v[fields - 1];
+    if (!(min <= mean && mean <= max && v[9] <= humidity && humidity <= v[10]) || count == 0) {
+      printf("Bad values: %s\n", lines[i].c_str());
+      return false;
+    }
+
+    std::string key = GetKey(isWS, v[0]);
+    Totals *totals = &received[key];
+    Add(totals, min, v[9]);
+    totals->Frames += count;
+    Add(totals, max, v[10]);
+    totals->TemperatureSum += (long)mean * count;
+    totals->HumiditySum += (long)humidity * count;
+    // Half a step of rounding per line
+    temperatureTolerance[key] += (count + 1) / 2;
+    humidityTolerance[key] += (count + 1) / 2;
+  }
+
+  for (std::map<std::string, Totals>::iterator i = sent->begin(); i != sent->end(); i++) {
+    const Totals &s = i->second;
+    const Totals &r = received[i->first];
+    if (r.Frames != s.Frames || r.TemperatureMin != s.TemperatureMin || r.TemperatureMax != s.TemperatureMax
+      || r.HumidityMin != s.HumidityMin || r.HumidityMax != s.HumidityMax
+      || labs(r.TemperatureSum - s.TemperatureSum) > temperatureTolerance[i->first]
+      || labs(r.HumiditySum - s.HumiditySum) > humidityTolerance[i->first]) {
+      printf("Sensor %s: %lu frames sent, %lu in the lines\n", i->first.c_str(), s.Frames, r.Frames);
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  unsigned long minutes = argc > 1 ? strtoul(argv[1], NULL, 10) : 60;
+  if (minutes == 0) {
+    return 1;
+  }
+  Serial.EnableCapture(true);
+
+  bool ok = true;
+  printf("%-40s %7s %7s %8s %10s %10s %8s\n", "Scenario", "Frames", "Lines", "Frames/", "Raw bytes", "Bytes", "Records");
+  for (unsigned int i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); i++) {
+    const Scenario *scenario = &s_scenarios[i];
+    std::map<std::string, Totals> sent;
+    unsigned long frames;
+
+    Scenario raw = *scenario;
+    raw.Window = 0;
+    std::string rawOutput = Run(&raw, false, minutes, &sent, &frames);
+    std::string text = Run(scenario, false, minutes, &sent, &frames);
+    std::string records = Run(scenario, true, minutes, &sent, &frames);
+
+    std::vector<std::string> lines = SplitLines(text);
+    bool isOk = Check(lines, &sent) && DecodeRecords(records) == lines;
+    printf("%-40s %7lu %7zu %8.1f %10zu %10zu %8zu  %s\n", scenario->Name, frames, lines.size(),
+      (double)frames / lines.size(), rawOutput.size(), text.size(), records.size(), isOk ? "" : "<--");
+    ok = ok && isOk;
+  }
+
+  printf("\nFrames/: frames per line, Raw bytes: every frame as its line, Records: binary output\n");
+  printf("Aggregator: %u sensors, %u bytes RAM on the AVR\n", AGGREGATOR_SIZE, AGGREGATOR_SIZE * 17);
+  printf("%s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
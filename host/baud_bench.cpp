@@ -0,0 +1,229 @@
+// baud_bench.cpp
+//
+// Baud rate negotiation of the host link (HostLink, <n>u) over a pty and
+// the lines per second that reach the host at each rate.
+// The Serial of the shim is attached to the master of a pty, this program
+// plays the host on the slave. Both ends keep their own baud rate and bytes
+// only get through while they agree (SetPeerBaudRate), so the host has to
+// follow the announcement like a real one.
+// At every rate LaCrosse frames are offered as fast as the SerialQueue takes
+// them, as text lines and as binary records (<1>b). The clock is virtual:
+// the UART model of the shim and DECODE_MICROS per frame, not the pty, set
+// the pace.
+// A confirmation that is sent at the old rate has to end in the fallback to
+// 57600 without touching the stored rate.
+//
+// Usage: baud_bench [seconds]
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <string>
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "LaCrosse.h"
+#include "LineWriter.h"
+#include "FrameDispatcher.h"
+#include "FrameRing.h"
+#include "SerialQueue.h"
+#include "HostLink.h"
+
+#define LOOP_MICROS 20
+// Estimated for an ATmega328 at 16 MHz: classify, decode and format one frame
+#define DECODE_MICROS 250
+
+static const unsigned long s_baudRates[] = { 57600ul, 115200ul, 250000ul, 500000ul, 1000000ul };
+
+static HostLink s_hostLink;
+static int s_slave = -1;
+static std::string s_received;
+static unsigned long s_commandValue = 0;
+
+// The 'u' command of HandleSerialPort() in the sketch
+static void HandleSerialPort(char c) {
+  if ('0' <= c && c <= '9') {
+    s_commandValue = 10 * s_commandValue + c - '0';
+  }
+  else if (c == 'u') {
+    SerialQueue::Flush();
+    s_hostLink.Request(s_commandValue);
+    s_commandValue = 0;
+  }
+}
+
+// One pass of loop() without the radios
+static void Loop() {
+  HostClock::AdvanceMicros(LOOP_MICROS);
+  if (Serial.available()) {
+    HandleSerialPort(Serial.read());
+  }
+  SerialQueue::Handle();
+  s_hostLink.Handle();
+}
+
+// --- Host side -------------------------------------------------------------------------------------------------------
+static void HostReceive() {
+  char data[256];
+  ssize_t length;
+  while ((length = read(s_slave, data, sizeof(data))) > 0) {
+    s_received.append(data, length);
+  }
+}
+
+static void HostSend(const char *text) {
+  if (write(s_slave, text, strlen(text)) != (ssize_t)strlen(text)) {
+    printf("pty write failed\n");
+    exit(1);
+  }
+}
+
+// Runs the sketch until the host has the line or the time is over
+static bool HostWaitFor(const char *line, unsigned long timeoutMillis) {
+  unsigned long start = millis();
+  while (millis() - start < timeoutMillis) {
+    Loop();
+    HostReceive();
+    size_t position = s_received.find(line);
+    if (position != std::string::npos) {
+      s_received.erase(0, position + strlen(line));
+      return true;
+    }
+  }
+  return false;
+}
+
+// Announcement at the old rate, confirmation at the new one
+static bool Negotiate(byte index) {
+  char command[16];
+  char reply[32];
+  snprintf(command, sizeof(command), "%uu", index);
+  snprintf(reply, sizeof(reply), "[Baud:%lu]\r\n", s_baudRates[index]);
+
+  s_received.clear();
+  HostSend(command);
+  if (!HostWaitFor(reply, 100)) {
+    return false;
+  }
+  Serial.SetPeerBaudRate(s_baudRates[index]);
+  HostSend(command);
+  return HostWaitFor(reply, 100) && !s_hostLink.IsPending() && s_hostLink.GetBaudRate() == s_baudRates[index];
+}
+
+// Frames are offered whenever the queue has room for one more
+static double MeasureLinesPerSecond(bool binary, unsigned long seconds) {
+  struct LaCrosse::Frame frame;
+  frame.NewBatteryFlag = false;
+  frame.Bit12 = false;
+  frame.WeakBatteryFlag = false;
+  byte payload[PAYLOADSIZE];
+
+  SensorBase::SetBinaryOutput(binary);
+  SerialQueue::ResetStatistics();
+  s_received.clear();
+  unsigned long lines = 0;
+  unsigned long i = 0;
+  unsigned long start = micros();
+  while (micros() - start < seconds * 1000000) {
+    Loop();
+    if (SERIAL_QUEUE_SIZE - SerialQueue::GetCount() >= FHEM_LINE_SIZE) {
+      frame.ID = i % 64;
+      frame.Temperature = (i / 64) % 80 * 10 - 200 + i % 10;
+      frame.Humidity = 20 + i % 70;
+      memset(payload, 0, sizeof(payload));
+      LaCrosse::EncodeFrame(&frame, payload);
+      HostClock::AdvanceMicros(DECODE_MICROS);
+      FrameDispatcher::TryHandleData(payload, 17241);
+      i++;
+    }
+
+    HostReceive();
+    const char *separator = binary ? "\0" : "\r\n";
+    size_t separatorLength = binary ? 1 : 2;
+    size_t position;
+    while ((position = s_received.find(separator, 0, separatorLength)) != std::string::npos) {
+      lines++;
+      s_received.erase(0, position + separatorLength);
+    }
+  }
+  SensorBase::SetBinaryOutput(false);
+  SerialQueue::Flush();
+  Serial.flush();
+  HostReceive();
+
+  if (SerialQueue::GetDroppedLines() > 0) {
+    printf("%lu lines dropped\n", SerialQueue::GetDroppedLines());
+    exit(1);
+  }
+  return (double)lines / seconds;
+}
+
+static int OpenPty(int *master) {
+  *master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (*master < 0 || grantpt(*master) != 0 || unlockpt(*master) != 0) {
+    return -1;
+  }
+  int slave = open(ptsname(*master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (slave < 0) {
+    return -1;
+  }
+  // No echo, no CR/LF translation
+  struct termios settings;
+  tcgetattr(slave, &settings);
+  cfmakeraw(&settings);
+  tcsetattr(slave, TCSANOW, &settings);
+  return slave;
+}
+
+int main(int argc, char **argv) {
+  unsigned long seconds = argc > 1 ? strtoul(argv[1], NULL, 10) : 2;
+  if (seconds == 0) {
+    return 1;
+  }
+
+  int master;
+  s_slave = OpenPty(&master);
+  if (s_slave < 0) {
+    printf("No pty\n");
+    return 1;
+  }
+  Serial.Attach(master);
+  Serial.EnableCapture(false);
+  Serial.SimulateTiming(true);
+  HostClock::SetMicros(0);
+
+  s_hostLink.Begin();
+  Serial.SetPeerBaudRate(s_hostLink.GetBaudRate());
+
+  bool ok = true;
+  printf("%-10s %12s %14s\n", "Baud", "Lines/s", "Records/s");
+  for (byte index = 0; index < sizeof(s_baudRates) / sizeof(s_baudRates[0]); index++) {
+    if (!Negotiate(index) || EEPROM.read(HOST_LINK_EEPROM_ADDRESS + 1) != index) {
+      printf("%-10lu negotiation failed\n", s_baudRates[index]);
+      ok = false;
+      break;
+    }
+    double text = MeasureLinesPerSecond(false, seconds);
+    double binary = MeasureLinesPerSecond(true, seconds);
+    printf("%-10lu %12.0f %14.0f\n", s_baudRates[index], text, binary);
+  }
+
+  // The host does not follow to 500000: the confirmation is lost and the
+  // link has to come back at 57600, the stored rate stays as it was
+  if (ok) {
+    Negotiate(0);
+    s_received.clear();
+    HostSend("3u");
+    bool announced = HostWaitFor("[Baud:500000]\r\n", 100);
+    HostSend("3u");
+    bool fellBack = HostWaitFor("[Baud:57600]\r\n", HOST_LINK_CONFIRM_MILLIS + 100);
+    ok = announced && fellBack && s_hostLink.GetBaudRate() == 57600 && EEPROM.read(HOST_LINK_EEPROM_ADDRESS + 1) == 0;
+    printf("\nUnconfirmed switch: %s\n", ok ? "back at 57600" : "no fallback");
+  }
+
+  printf("EEPROM writes: %lu\n", EEPROM.GetWriteCount());
+  printf("%s\n", ok ? "OK" : "FAILED");
+
+  close(s_slave);
+  close(master);
+  return ok ? 0 : 1;
+}
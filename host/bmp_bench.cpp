@@ -0,0 +1,330 @@
+// bmp_bench.cpp
+//
+// The state machine BMP180 driver against the blocking one it replaced.
+// Both run on a simulated BMP180 (BMP180Sim) with the same raw values and
+// have to give exactly the same temperature and station pressure. The sea
+// level pressure is calculated in fixed point now and may be 1 hPa off where
+// the float result is truncated; it is checked against the float formula over
+// -500..4000 m instead and has to be within 0.1 hPa. The longest time a
+// single call keeps loop() from polling the radios is reported as well.
+// The other oversampling settings are checked with the example of the data
+// sheet (15.0 C, 699.64 hPa).
+//
+// Usage: bmp_bench [measurements]
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "BMP180.h"
+#include "BMP180Sim.h"
+
+// Serial.available(), the radios and the other parts of loop()
+#define LOOP_MICROS 100
+
+// --- The blocking driver as it was -----------------------------------------------------------------------------------
+class ReferenceBMP180 {
+public:
+  bool TryInitialize() {
+    if (Read8(0xD0) != 0x55) {
+      return false;
+    }
+    m_compensation.CAC1 = Read16(0xAA);
+    m_compensation.CAC2 = Read16(0xAC);
+    m_compensation.CAC3 = Read16(0xAE);
+    m_compensation.CAC4 = Read16(0xB0);
+    m_compensation.CAC5 = Read16(0xB2);
+    m_compensation.CAC6 = Read16(0xB4);
+    m_compensation.CB1 = Read16(0xB6);
+    m_compensation.CB2 = Read16(0xB8);
+    m_compensation.CMB = Read16(0xBA);
+    m_compensation.CMC = Read16(0xBC);
+    m_compensation.CMD = Read16(0xBE);
+    return true;
+  }
+
+  void SetAltitudeAboveSeaLevel(int32_t altitude) {
+    m_altitudeAboveSeaLevel = altitude;
+  }
+
+  int32_t GetStationPressure() {
+    return m_stationPressure;
+  }
+
+  float GetTemperature(void) {
+    int32_t UT, B5;
+    float temp;
+
+    UT = GetRawTemperature();
+
+    B5 = CalculateB5(UT);
+    temp = (B5 + 8) >> 4;
+    temp /= 10.0;
+
+    return temp;
+  }
+
+  int32_t GetPressure(void) {
+    int32_t UT, UP, B3, B5, B6, X1, X2, X3, p;
+    uint32_t B4, B7;
+
+    UT = GetRawTemperature();
+    UP = GetRawPressure();
+    B5 = CalculateB5(UT);
+
+    B6 = B5 - 4000;
+    X1 = ((int32_t)m_compensation.CB2 * ((B6 * B6) >> 12)) >> 11;
+    X2 = ((int32_t)m_compensation.CAC2 * B6) >> 11;
+    X3 = X1 + X2;
+    B3 = ((((int32_t)m_compensation.CAC1 * 4 + X3) << 2) + 2) / 4;
+    X1 = ((int32_t)m_compensation.CAC3 * B6) >> 13;
+    X2 = ((int32_t)m_compensation.CB1 * ((B6 * B6) >> 12)) >> 16;
+    X3 = ((X1 + X2) + 2) >> 2;
+    B4 = ((uint32_t)m_compensation.CAC4 * (uint32_t)(X3 + 32768)) >> 15;
+    B7 = ((uint32_t)UP - B3) * (uint32_t)(50000UL >> 2);
+
+    if (B7 < 0x80000000) {
+      p = (B7 * 2) / B4;
+    }
+    else {
+      p = (B7 / B4) * 2;
+    }
+    X1 = (p >> 8) * (p >> 8);
+    X1 = (X1 * 3038) >> 16;
+    X2 = (-7357 * p) >> 16;
+
+    p = p + ((X1 + X2 + (int32_t)3791) >> 4);
+
+    m_stationPressure = p / 100;
+
+    p /= pow(((float) 1.0 - ((float)m_altitudeAboveSeaLevel / 44330.0)), (float) 5.255);
+    p /= 100;
+
+    return p;
+  }
+
+private:
+  bmp180_compensation m_compensation;
+  int32_t m_altitudeAboveSeaLevel = 0;
+  int32_t m_stationPressure = 0;
+
+  int32_t CalculateB5(int32_t ut) {
+    int32_t x1 = (ut - (int32_t)m_compensation.CAC6) * ((int32_t)m_compensation.CAC5) >> 15;
+    int32_t x2 = ((int32_t)m_compensation.CMC << 11) / (x1 + (int32_t)m_compensation.CMD);
+    return x1 + x2;
+  }
+
+  uint16_t GetRawTemperature(void) {
+    Write8(0xF4, 0x2E);
+    delay(5);
+    return Read16(0xF6);
+  }
+
+  uint32_t GetRawPressure(void) {
+    uint32_t raw;
+
+    Write8(0xF4, 0x34 + (2 << 6));
+    delay(14);
+
+    raw = Read16(0xF6);
+    raw <<= 8;
+    raw |= Read8(0xF6 + 2);
+    raw >>= 6;
+
+    return raw;
+  }
+
+  uint8_t Read8(uint8_t a) {
+    uint8_t ret;
+
+    Wire.beginTransmission(BMP180_ADDRESS);
+    Wire.write(a);
+
+    Wire.endTransmission();
+
+    Wire.beginTransmission(BMP180_ADDRESS);
+    Wire.requestFrom(BMP180_ADDRESS, 1);
+    ret = Wire.read();
+    Wire.endTransmission();
+
+    return ret;
+  }
+
+  uint16_t Read16(uint8_t a) {
+    uint16_t ret;
+
+    Wire.beginTransmission(BMP180_ADDRESS);
+    Wire.write(a);
+    Wire.endTransmission();
+
+    Wire.beginTransmission(BMP180_ADDRESS);
+    Wire.requestFrom(BMP180_ADDRESS, 2);
+    ret = Wire.read();
+    ret <<= 8;
+    ret |= Wire.read();
+
+    Wire.endTransmission();
+
+    return ret;
+  }
+
+  void Write8(uint8_t a, uint8_t d) {
+    Wire.beginTransmission(BMP180_ADDRESS);
+    Wire.write(a);
+    Wire.write(d);
+    Wire.endTransmission();
+  }
+};
+
+
+// --- Measurements ----------------------------------------------------------------------------------------------------
+struct Measurement {
+  float Temperature;
+  int32_t Pressure;
+  int32_t SeaLevelPressure;
+  unsigned long Duration;      // from the start until the values are there
+  unsigned long LongestCall;   // longest time loop() was held up
+};
+
+static unsigned long s_random = 1;
+
+static unsigned long Random(unsigned long min, unsigned long max) {
+  s_random = s_random * 1103515245UL + 12345;
+  return min + (s_random >> 8) % (max - min + 1);
+}
+
+// Largest difference to the float formula in Pa
+static double SweepSeaLevelPressure(BMP180 *bmp, int32_t minAltitude, int32_t maxAltitude) {
+  double maxError = 0;
+  for (int32_t altitude = minAltitude; altitude <= maxAltitude; altitude++) {
+    bmp->SetAltitudeAboveSeaLevel(altitude);
+    double factor = pow(1.0 - altitude / 44330.0, 5.255);
+    for (int32_t pressure = 30000; pressure <= 110000; pressure += 97) {
+      double error = fabs(bmp->GetSeaLevelPressure(pressure) - pressure / factor);
+      if (error > maxError) {
+        maxError = error;
+      }
+    }
+  }
+  return maxError;
+}
+
+static Measurement MeasureReference(ReferenceBMP180 *bmp) {
+  Measurement result;
+  unsigned long start = micros();
+  result.Temperature = bmp->GetTemperature();
+  result.SeaLevelPressure = bmp->GetPressure();
+  result.Pressure = bmp->GetStationPressure();
+  result.Duration = micros() - start;
+  result.LongestCall = result.Duration;
+  return result;
+}
+
+static Measurement Measure(BMP180 *bmp) {
+  Measurement result;
+  result.LongestCall = 0;
+
+  unsigned long start = micros();
+  bmp->StartMeasurement();
+  for (;;) {
+    unsigned long callStart = micros();
+    bool done = bmp->Handle();
+    if (micros() - callStart > result.LongestCall) {
+      result.LongestCall = micros() - callStart;
+    }
+    if (done) {
+      break;
+    }
+    HostClock::AdvanceMicros(LOOP_MICROS);
+  }
+  result.Duration = micros() - start;
+
+  BMP180Value value = bmp->GetLastMeasuredValue();
+  result.Temperature = value.Temperature;
+  result.Pressure = value.Pressure;
+  result.SeaLevelPressure = value.SeaLevelPressure;
+  return result;
+}
+
+int main(int argc, char **argv) {
+  static const int32_t altitudes[] = { 0, 120, 850 };
+  unsigned long count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000;
+  if (count == 0) {
+    return 1;
+  }
+
+  BMP180Sim sim;
+  Wire.Attach(BMP180_ADDRESS, &sim);
+
+  ReferenceBMP180 reference;
+  BMP180 bmp;
+  if (!reference.TryInitialize() || !bmp.TryInitialize()) {
+    printf("BMP180 not found\n");
+    return 1;
+  }
+
+  // Same results as the blocking driver (oss 2)
+  unsigned long mismatches = 0;
+  unsigned long truncations = 0;
+  unsigned long referenceLongest = 0;
+  unsigned long longest = 0;
+  unsigned long referenceTransactions = 0;
+  unsigned long transactions = 0;
+  for (unsigned long i = 0; i < count; i++) {
+    int32_t altitude = altitudes[i % 3];
+    reference.SetAltitudeAboveSeaLevel(altitude);
+    bmp.SetAltitudeAboveSeaLevel(altitude);
+    sim.SetRawValues(Random(20000, 36000), Random(80000, 180000));
+
+    unsigned long before = Wire.GetTransactionCount();
+    Measurement expected = MeasureReference(&reference);
+    referenceTransactions += Wire.GetTransactionCount() - before;
+
+    before = Wire.GetTransactionCount();
+    Measurement actual = Measure(&bmp);
+    transactions += Wire.GetTransactionCount() - before;
+
+    int32_t seaLevelDifference = actual.SeaLevelPressure - expected.SeaLevelPressure;
+    if (seaLevelDifference != 0) {
+      truncations++;
+    }
+    if (actual.Temperature != expected.Temperature || actual.Pressure != expected.Pressure
+      || seaLevelDifference < -1 || seaLevelDifference > 1) {
+      if (mismatches++ < 5) {
+        printf("Mismatch: %.1f C %d/%d hPa, expected %.1f C %d/%d hPa\n", actual.Temperature, (int)actual.Pressure,
+          (int)actual.SeaLevelPressure, expected.Temperature, (int)expected.Pressure, (int)expected.SeaLevelPressure);
+      }
+    }
+    if (expected.LongestCall > referenceLongest) {
+      referenceLongest = expected.LongestCall;
+    }
+    if (actual.LongestCall > longest) {
+      longest = actual.LongestCall;
+    }
+  }
+
+  printf("%lu measurements (oss 2), %lu mismatches, %lu sea level pressures 1 hPa off\n", count, mismatches, truncations);
+  printf("%-10s %18s %18s\n", "", "Longest call us", "I2C transactions");
+  printf("%-10s %18lu %18.1f\n", "Blocking", referenceLongest, (double)referenceTransactions / count);
+  printf("%-10s %18lu %18.1f\n", "Async", longest, (double)transactions / count);
+
+  // Data sheet example with every oversampling setting
+  printf("\n%-4s %12s %12s %12s\n", "oss", "Temperature", "Pressure", "Duration us");
+  bool examplesOk = true;
+  bmp.SetAltitudeAboveSeaLevel(0);
+  for (uint8_t oss = 0; oss <= 3; oss++) {
+    bmp.SetOversampling(oss);
+    sim.SetRawValues(27898, 23843UL << oss);
+    Measurement example = Measure(&bmp);
+    printf("%-4u %12.1f %12d %12lu\n", oss, example.Temperature, (int)example.Pressure, example.Duration);
+    if (example.Temperature != 15.0f || example.Pressure != 699) {
+      examplesOk = false;
+    }
+  }
+
+  // Sea level correction against the float formula
+  double maxError = SweepSeaLevelPressure(&bmp, -500, 4000);
+  printf("\nSea level pressure -500..4000 m: max error %.1f Pa\n", maxError);
+
+  bool ok = mismatches == 0 && examplesOk && maxError < 10 && sim.GetEarlyReads() == 0;
+  printf("%s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
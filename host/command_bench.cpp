@@ -0,0 +1,189 @@
+// command_bench.cpp
+//
+// Command intake (CommandReader) behind a busy loop(). The host sends a
+// script of commands back to back, among them two long s commands, while
+// loop() takes 250 us and every 8th pass a frame costs 2.5 ms more. The
+// bytes wait in a model of the 64 byte RX buffer of the core, what arrives
+// while it is full is lost.
+// The bench compares reading one byte per loop() as before with the reader
+// taking all of them at once, and reports the commands that came through
+// unchanged, the lost bytes and the latency from the first byte on the wire
+// to the execution. With the reader every command has to come through, the
+// one with too many values has to be rejected and nothing may be lost, as
+// long as the RX buffer holds more than the longest pass (not at 500000).
+//
+// Usage: command_bench
+
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "CommandReader.h"
+
+#define RX_BUFFER_SIZE 64
+#define LOOP_MICROS 250
+#define FRAME_MICROS 2500
+#define FRAME_EVERY 8
+
+struct SentCommand {
+  std::string Text;
+  unsigned long FirstByte;
+};
+
+struct ExecutedCommand {
+  std::string Text;
+  unsigned long Time;
+};
+
+static std::vector<ExecutedCommand> s_executed;
+
+static void Handle(char name, unsigned long value, byte *arguments, byte count) {
+  ExecutedCommand command;
+  for (byte i = 0; i < count; i++) {
+    command.Text += std::to_string(arguments[i]) + ",";
+  }
+  command.Text += std::to_string(value) + name;
+  command.Time = micros();
+  s_executed.push_back(command);
+}
+
+static std::vector<std::string> BuildScript() {
+  std::vector<std::string> script;
+  script.push_back("0v");
+  script.push_back("30t");
+  script.push_back("1,4o");
+  std::string send = "17";
+  for (int i = 1; i <= 31; i++) {
+    send += "," + std::to_string(i * 8);
+  }
+  script.push_back(send + "s");
+  script.push_back("2,2,300k");
+  script.push_back("1,2i");
+  script.push_back("1,1,17i");
+  script.push_back("1q");
+  std::string tooLong = "17";
+  for (int i = 1; i <= 40; i++) {
+    tooLong += "," + std::to_string(i);
+  }
+  script.push_back(tooLong + "s");
+  script.push_back("5w");
+  script.push_back("868300f");
+  return script;
+}
+
+// The line as it arrives, a blank between the commands
+static std::string BuildLine(const std::vector<std::string> &script, std::vector<SentCommand> *sent, unsigned long charMicros) {
+  std::string line;
+  for (size_t i = 0; i < script.size(); i++) {
+    SentCommand command;
+    command.Text = script[i];
+    command.FirstByte = line.size() * charMicros;
+    sent->push_back(command);
+    line += script[i] + " ";
+  }
+  return line;
+}
+
+struct Result {
+  unsigned long Through;
+  unsigned long Lost;
+  unsigned long Rejected;
+  unsigned long MeanLatency;
+  unsigned long MaxLatency;
+  unsigned long Loops;
+};
+
+static Result Run(bool isBatched, unsigned long baud) {
+  unsigned long charMicros = 10000000UL / baud;
+  std::vector<std::string> script = BuildScript();
+  std::vector<SentCommand> sent;
+  std::string line = BuildLine(script, &sent, charMicros);
+
+  HostClock::SetMicros(0);
+  Serial.ClearOutput();
+  while (Serial.available()) {
+    Serial.read();
+  }
+  // Ends what the last run left half read
+  Serial.InjectInput("v");
+  CommandReader::Handle(Handle);
+  s_executed.clear();
+  CommandReader::ResetStatistics();
+
+  Result result;
+  memset(&result, 0, sizeof(result));
+  std::string rx;
+  size_t arrived = 0;
+  unsigned long end = line.size() * charMicros + 100000;
+  while (micros() < end) {
+    // What came in on the wire since the last pass
+    while (arrived < line.size() && (arrived + 1) * charMicros <= micros()) {
+      if (rx.size() < RX_BUFFER_SIZE - 1) {
+        rx += line[arrived];
+      }
+      else {
+        result.Lost++;
+      }
+      arrived++;
+    }
+
+    size_t take = isBatched ? rx.size() : (rx.empty() ? 0 : 1);
+    if (take > COMMAND_READ_LIMIT) {
+      take = COMMAND_READ_LIMIT;
+    }
+    Serial.InjectInput(rx.substr(0, take).c_str());
+    rx.erase(0, take);
+    CommandReader::Handle(Handle);
+
+    HostClock::AdvanceMicros(LOOP_MICROS + (result.Loops % FRAME_EVERY == 0 ? FRAME_MICROS : 0));
+    result.Loops++;
+  }
+
+  // In the order of the script, the latency from the first byte on the wire
+  size_t next = 0;
+  unsigned long latencySum = 0;
+  for (size_t i = 0; i < s_executed.size(); i++) {
+    for (size_t j = next; j < sent.size(); j++) {
+      if (s_executed[i].Text == sent[j].Text) {
+        unsigned long latency = s_executed[i].Time - sent[j].FirstByte;
+        latencySum += latency;
+        if (latency > result.MaxLatency) {
+          result.MaxLatency = latency;
+        }
+        result.Through++;
+        next = j + 1;
+        break;
+      }
+    }
+  }
+  result.MeanLatency = result.Through > 0 ? latencySum / result.Through : 0;
+  result.Rejected = CommandReader::GetRejected();
+  return result;
+}
+
+int main(int argc, char **argv) {
+  Serial.EnableCapture(false);
+  static const unsigned long bauds[] = { 57600, 115200, 500000 };
+  size_t commands = BuildScript().size();
+
+  bool ok = true;
+  printf("%-20s %7s %8s %5s %9s %12s %11s\n", "Reader", "Baud", "Through", "Lost", "Rejected", "Latency mean", "max (us)");
+  for (size_t i = 0; i < sizeof(bauds) / sizeof(bauds[0]); i++) {
+    Result single = Run(false, bauds[i]);
+    printf("%-20s %7lu %5lu/%-2zu %5lu %9lu %12lu %11lu\n", "1 byte per loop()", bauds[i], single.Through, commands,
+      single.Lost, single.Rejected, single.MeanLatency, single.MaxLatency);
+
+    Result batched = Run(true, bauds[i]);
+    printf("%-20s %7lu %5lu/%-2zu %5lu %9lu %12lu %11lu\n", "CommandReader", bauds[i], batched.Through, commands,
+      batched.Lost, batched.Rejected, batched.MeanLatency, batched.MaxLatency);
+
+    // Faster than the RX buffer fills during the longest pass, above that
+    // bytes get lost whoever reads them
+    if ((RX_BUFFER_SIZE - 1) * 10000000UL / bauds[i] > LOOP_MICROS + FRAME_MICROS) {
+      ok = ok && batched.Through == commands - 1 && batched.Lost == 0 && batched.Rejected == 1;
+    }
+  }
+
+  printf("\nThrough: commands executed unchanged and in order (the one with 41 values is rejected)\n");
+  printf("%s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
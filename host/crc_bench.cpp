@@ -0,0 +1,194 @@
+// crc_bench
+//
+// Compares the CRC8 implementations against the bitwise loop that
+// SensorBase::CalculateCRC used before and reports cycles per byte.
+// Before measuring, all variants are checked to give identical results.
+//
+// Usage: crc_bench [iterations]
+
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_TSC 1
+#endif
+#include "Arduino.h"
+#include "CRC8.h"
+#include "TX22IT.h"
+
+#define BENCH_BUFFER_SIZE 128
+
+typedef byte (*CrcFunction)(const byte *data, byte len);
+
+// The loop from SensorBase::CalculateCRC and TX38IT::CalculateCRC as it was
+static byte LegacyCalculateCRC(const byte *data, byte len, int bits) {
+  byte res = 0;
+  for (int j = 0; j < len; j++) {
+    uint8_t val = data[j];
+    for (int i = 0; i < 8; i++) {
+      if (j * 8 + i < bits) {
+        uint8_t tmp = (uint8_t)((res ^ val) & 0x80);
+        res <<= 1;
+        if (0 != tmp) {
+          res ^= 0x31;
+        }
+        val <<= 1;
+      }
+    }
+  }
+  return res;
+}
+
+static byte LegacyLoop(const byte *data, byte len) {
+  return LegacyCalculateCRC(data, len, len * 8);
+}
+
+// The bit array shift register from TX22IT::CalculateCRC as it was
+static byte LegacyTX22ITCRC(const byte *data, byte len) {
+  byte CRC[8];
+  byte bits[8];
+  int i, j;
+  byte val;
+  byte DoInvert;
+
+  for (i = 0; i < 8; i++) {
+    CRC[i] = 0;
+  }
+
+  for (j = 0; j < len; j++) {
+    val = data[j];
+
+    for (i = 0; i < 8; i++) {
+      switch (i) {
+        case 0: if ((val & 0x80) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
+        case 1: if ((val & 0x40) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
+        case 2: if ((val & 0x20) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
+        case 3: if ((val & 0x10) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
+        case 4: if ((val & 0x8) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
+        case 5: if ((val & 0x4) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
+        case 6: if ((val & 0x2) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
+        case 7: if ((val & 0x1) != 0) { bits[i] = 1; } else { bits[i] = 0; } break;
+      }
+
+      if (bits[i] == 1) {
+        DoInvert = 1 ^ CRC[7];
+      }
+      else {
+        DoInvert = 0 ^ CRC[7];
+      }
+
+      CRC[7] = CRC[6];
+      CRC[6] = CRC[5];
+      CRC[5] = CRC[4] ^ DoInvert;
+      CRC[4] = CRC[3] ^ DoInvert;
+      CRC[3] = CRC[2];
+      CRC[2] = CRC[1];
+      CRC[1] = CRC[0];
+      CRC[0] = DoInvert;
+    }
+  }
+
+  return (CRC[7] << 7) | (CRC[6] << 6) | (CRC[5] << 5) | (CRC[4] << 4) |
+         (CRC[3] << 3) | (CRC[2] << 2) | (CRC[1] << 1) | (CRC[0]);
+}
+
+static byte CurrentTX22ITCRC(const byte *data, byte len) {
+  return TX22IT::CalculateCRC((byte *)data);
+}
+
+static unsigned long s_random = 4711;
+
+static byte NextRandom() {
+  s_random = s_random * 1103515245ul + 12345ul;
+  return s_random >> 16;
+}
+
+static unsigned long long ReadCycles() {
+#ifdef HAS_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static void Measure(const char *name, CrcFunction function, const byte *buffer, byte len, unsigned long iterations) {
+  volatile byte sink = 0;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  unsigned long long cycles = ReadCycles();
+  for (unsigned long i = 0; i < iterations; i++) {
+    sink ^= function(buffer, len);
+  }
+  cycles = ReadCycles() - cycles;
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  double bytes = (double)iterations * len;
+  double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  printf("%-14s %4u %12.2f %12.2f\n", name, len, ns / bytes, cycles / bytes);
+}
+
+int main(int argc, char **argv) {
+  unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+  byte buffer[BENCH_BUFFER_SIZE];
+
+  // Exhaustive for single bytes, random for longer frames
+  for (int len = 0; len < BENCH_BUFFER_SIZE; len++) {
+    for (int round = 0; round < 256; round++) {
+      for (int i = 0; i < len; i++) {
+        buffer[i] = len == 1 ? round : NextRandom();
+      }
+      byte expected = LegacyLoop(buffer, len);
+      if (CRC8::CalculateBitwise(buffer, len) != expected
+        || CRC8::CalculateNibbleTable(buffer, len) != expected
+        || CRC8::CalculateByteTable(buffer, len) != expected
+        || CRC8::Calculate(buffer, len) != expected) {
+        printf("CRC mismatch, length %d\n", len);
+        return 1;
+      }
+    }
+  }
+
+  // TX38IT: CRC over the first 20 bits
+  for (unsigned long n = 0; n < 0x100000; n++) {
+    buffer[0] = n >> 12;
+    buffer[1] = n >> 4;
+    buffer[2] = (n << 4) | (NextRandom() & 0x0F);
+    if (CRC8::CalculateBits(buffer, 20) != LegacyCalculateCRC(buffer, 3, 20)) {
+      printf("CRC mismatch, 20 bits, %05lx\n", n);
+      return 1;
+    }
+  }
+
+  // TX22IT: random frames with 0 ... 7 quartets
+  for (unsigned long n = 0; n < 1000000; n++) {
+    for (int i = 0; i < 17; i++) {
+      buffer[i] = NextRandom();
+    }
+    buffer[0] = 0xA0 | (buffer[0] & 0x0F);
+    byte len = TX22IT::GetFrameLength(buffer) - 1;
+    if (TX22IT::CalculateCRC(buffer) != LegacyTX22ITCRC(buffer, len)) {
+      printf("TX22IT CRC mismatch, frame %lu\n", n);
+      return 1;
+    }
+  }
+
+  for (int i = 0; i < BENCH_BUFFER_SIZE; i++) {
+    buffer[i] = NextRandom();
+  }
+
+  printf("%-14s %4s %12s %12s\n", "Variant", "len", "ns/byte", "cycles/byte");
+  static const byte lengths[] = { 4, 9, 127 };
+  for (unsigned int l = 0; l < sizeof(lengths); l++) {
+    Measure("legacy loop", LegacyLoop, buffer, lengths[l], iterations);
+    Measure("bitwise", CRC8::CalculateBitwise, buffer, lengths[l], iterations);
+    Measure("nibble table", CRC8::CalculateNibbleTable, buffer, lengths[l], iterations);
+    Measure("byte table", CRC8::CalculateByteTable, buffer, lengths[l], iterations);
+  }
+
+  // TX22IT frame with 3 quartets, the CRC covers 8 bytes
+  buffer[0] = 0xA1;
+  buffer[1] = 0xC3;
+  Measure("TX22IT legacy", LegacyTX22ITCRC, buffer, 8, iterations);
+  Measure("TX22IT", CurrentTX22ITCRC, buffer, 8, iterations);
+
+  return 0;
+}
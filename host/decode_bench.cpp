@@ -0,0 +1,504 @@
+// decode_bench
+//
+// Runs a recorded mix of frames through the FrameDispatcher (and, for
+// comparison, through the old decoder cascade of HandleReceivedData()) and
+// reports the time, the number of String heap operations and the serial
+// output per protocol. The mix is run with the binary output (<1>b) as well,
+// every record has to give the same line through the RecordDecoder as the
+// text output and the bytes per frame of both are compared. Frames with a
+// length the payload cannot hold must not even reach their decoder.
+// The text output of every frame of the mix has to match the golden file
+// host/decode_bench.golden byte for byte.
+//
+// Usage: decode_bench [iterations]
+//        decode_bench dump      prints the output of every frame of the mix
+//                               (redirect it to the golden file after an intended change)
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "Arduino.h"
+#include "RFM.h"
+#include "LaCrosse.h"
+#include "LevelSenderLib.h"
+#include "EMT7110.h"
+#include "WT440XH.h"
+#include "TX38IT.h"
+#include "WSBase.h"
+#include "WS1080.h"
+#include "TX22IT.h"
+#include "CustomSensor.h"
+#include "FrameDispatcher.h"
+#include "RecordDecoder.h"
+
+// CustomSensor::EncodeFrame fills CS_PL_BUFFER_SIZE bytes and the decoders
+// may look behind PAYLOADSIZE for garbage frames, so be generous here
+#define BENCH_PAYLOAD_SIZE 256
+#define BENCH_MIX_SIZE 1000
+
+enum BenchProtocol {
+  BP_LaCrosse = 0,
+  BP_TX22IT,
+  BP_WS1080,
+  BP_LevelSender,
+  BP_EMT7110,
+  BP_WT440XH,
+  BP_TX38IT,
+  BP_CustomSensor,
+  BP_Undecoded,
+  BP_Count
+};
+
+static const char *ProtocolNames[BP_Count] = {
+  "LaCrosse", "TX22IT", "WS1080", "LevelSender", "EMT7110", "WT440XH", "TX38IT", "CustomSensor", "Undecoded"
+};
+
+struct RecordedFrame {
+  BenchProtocol Protocol;
+  unsigned long DataRate;
+  byte Payload[BENCH_PAYLOAD_SIZE];
+};
+
+struct ProtocolStatistics {
+  unsigned long Frames;
+  unsigned long Nanoseconds;
+  unsigned long Allocations;
+  unsigned long OutputBytes;
+};
+
+typedef byte (*HandleFunction)(byte *payload, unsigned long dataRate);
+
+static RecordedFrame s_templates[BP_Count];
+static RecordedFrame s_mix[BENCH_MIX_SIZE];
+static unsigned long s_random = 12345;
+
+static unsigned long NextRandom() {
+  s_random = s_random * 1103515245ul + 12345ul;
+  return (s_random >> 8) & 0xFFFFFF;
+}
+
+static void SetBytes(RecordedFrame *frame, const byte *bytes, byte length) {
+  memset(frame->Payload, 0, BENCH_PAYLOAD_SIZE);
+  memcpy(frame->Payload, bytes, length);
+}
+
+static void BuildTemplates() {
+  RecordedFrame *t;
+
+  // TX29DTH-IT, ID 56, 21.6 °C, 56 %rH
+  t = &s_templates[BP_LaCrosse];
+  t->Protocol = BP_LaCrosse;
+  t->DataRate = 17241ul;
+  struct LaCrosse::Frame lacrosse;
+  lacrosse.ID = 56;
+  lacrosse.NewBatteryFlag = false;
+  lacrosse.Bit12 = false;
+  lacrosse.Temperature = 216;
+  lacrosse.WeakBatteryFlag = false;
+  lacrosse.Humidity = 56;
+  memset(t->Payload, 0, BENCH_PAYLOAD_SIZE);
+  LaCrosse::EncodeFrame(&lacrosse, t->Payload);
+
+  // TX22IT, ID 7, 15.3 °C, rain counter 27
+  t = &s_templates[BP_TX22IT];
+  t->Protocol = BP_TX22IT;
+  t->DataRate = 8842ul;
+  const byte tx22[] = { 0xA1, 0xC2, 0x05, 0x53, 0x20, 0x1B, 0x19 };
+  SetBytes(t, tx22, sizeof(tx22));
+
+  // WS1080, ID 8C, 8.8 °C, 94 %rH
+  t = &s_templates[BP_WS1080];
+  t->Protocol = BP_WS1080;
+  t->DataRate = 17241ul;
+  const byte ws1080[] = { 0xA8, 0xC0, 0x58, 0x5E, 0x00, 0x00, 0x00, 0x86, 0x0A, 0xD8 };
+  SetBytes(t, ws1080, sizeof(ws1080));
+
+  // LevelSender, ID 1, 38 cm, 21.5 °C, 6.0 V
+  t = &s_templates[BP_LevelSender];
+  t->Protocol = BP_LevelSender;
+  t->DataRate = 17241ul;
+  struct LevelSenderLib::Frame level;
+  level.Header = 11;
+  level.ID = 1;
+  level.Level = 76;
+  level.Temperature = 215;
+  level.Voltage = 60;
+  memset(t->Payload, 0, BENCH_PAYLOAD_SIZE);
+  LevelSenderLib::EncodeFrame(&level, t->Payload);
+
+  // EMT7110, ID 5451, 228.5 V, 13 mA, 2 W, 2.62 kWh
+  t = &s_templates[BP_EMT7110];
+  t->Protocol = BP_EMT7110;
+  t->DataRate = 9579ul;
+  byte emt[] = { 0x25, 0x6A, 0x54, 0x51, 0x40, 0x04, 0x00, 0x0D, 0xC9, 0x01, 0x06, 0x00 };
+  byte sum = 0;
+  for (int i = 0; i < EMT7110::FRAME_LENGTH - 1; i++) {
+    sum += emt[i];
+  }
+  emt[EMT7110::FRAME_LENGTH - 1] = -sum;
+  SetBytes(t, emt, sizeof(emt));
+
+  // WT440XH, house code 11, device 4, 26.9 °C, 23 %rH
+  t = &s_templates[BP_WT440XH];
+  t->Protocol = BP_WT440XH;
+  t->DataRate = 9579ul;
+  const byte wt440[] = { 0x51, 0x4B, 0x4C, 0x09, 0x17, 0xF8 };
+  SetBytes(t, wt440, sizeof(wt440));
+
+  // TX38IT, ID 12, 19.4 °C
+  t = &s_templates[BP_TX38IT];
+  t->Protocol = BP_TX38IT;
+  t->DataRate = 17241ul;
+  struct TX38IT::Frame tx38;
+  tx38.ID = 12;
+  tx38.NewBatteryFlag = false;
+  tx38.WeakBatteryFlag = false;
+  tx38.Temperature = 194;
+  tx38.miscBits = 0;
+  memset(t->Payload, 0, BENCH_PAYLOAD_SIZE);
+  TX38IT::EncodeFrame(&tx38, t->Payload);
+
+  // CustomSensor, ID 17, 5 data bytes
+  t = &s_templates[BP_CustomSensor];
+  t->Protocol = BP_CustomSensor;
+  t->DataRate = 17241ul;
+  static const byte customData[] = { 1, 2, 3, 4, 5 };
+  struct CustomSensor::Frame custom;
+  custom.ID = 17;
+  custom.NbrOfDataBytes = sizeof(customData);
+  custom.Data = customData;
+  memset(t->Payload, 0, BENCH_PAYLOAD_SIZE);
+  CustomSensor::EncodeFrame(&custom, t->Payload);
+
+  t = &s_templates[BP_Undecoded];
+  t->Protocol = BP_Undecoded;
+  t->DataRate = 17241ul;
+  memset(t->Payload, 0, BENCH_PAYLOAD_SIZE);
+}
+
+// A dense install: mostly TX29/TX35, some weather stations and energy meters
+// and a good share of frames nobody can decode
+static void BuildMix() {
+  static const byte weights[BP_Count] = { 55, 5, 3, 2, 8, 3, 4, 2, 18 };
+
+  for (int i = 0; i < BENCH_MIX_SIZE; i++) {
+    unsigned long r = NextRandom() % 100;
+    int p = 0;
+    while (r >= weights[p]) {
+      r -= weights[p];
+      p++;
+    }
+
+    s_mix[i] = s_templates[p];
+    if (p == BP_Undecoded) {
+      for (int b = 0; b < PAYLOADSIZE; b++) {
+        s_mix[i].Payload[b] = NextRandom();
+      }
+      // Noise with a CustomSensor header would claim a length up to 259 bytes
+      if (s_mix[i].Payload[0] == CUSTOM_SENSOR_HEADER) {
+        s_mix[i].Payload[0] = 0;
+      }
+      s_mix[i].DataRate = i % 3 == 0 ? 17241ul : (i % 3 == 1 ? 9579ul : 8842ul);
+    }
+  }
+}
+
+// The cascade HandleReceivedData() in the sketch used before the FrameDispatcher
+static byte HandleFrameCascade(byte *payload, unsigned long dataRate) {
+  byte frameLength = 0;
+
+  if (LaCrosse::IsValidDataRate(dataRate) && LaCrosse::TryHandleData(payload)) {
+    frameLength = LaCrosse::FRAME_LENGTH;
+  }
+  else if (TX22IT::IsValidDataRate(dataRate) && TX22IT::TryHandleData(payload)) {
+    frameLength = TX22IT::GetFrameLength(payload);
+  }
+  else if (WS1080::IsValidDataRate(dataRate) && WS1080::TryHandleData(payload)) {
+    frameLength = WS1080::FRAME_LENGTH;
+  }
+  else if (LevelSenderLib::IsValidDataRate(dataRate) && LevelSenderLib::TryHandleData(payload)) {
+    frameLength = LevelSenderLib::FRAME_LENGTH;
+  }
+  else if (EMT7110::IsValidDataRate(dataRate) && EMT7110::TryHandleData(payload)) {
+    frameLength = EMT7110::FRAME_LENGTH;
+  }
+  else if (WT440XH::IsValidDataRate(dataRate) && WT440XH::TryHandleData(payload)) {
+    frameLength = WT440XH::FRAME_LENGTH;
+  }
+  else if (TX38IT::IsValidDataRate(dataRate) && TX38IT::TryHandleData(payload)) {
+    frameLength = TX38IT::FRAME_LENGTH;
+  }
+  else if (CustomSensor::IsValidDataRate(dataRate) && CustomSensor::TryHandleData(payload)) {
+    frameLength = CustomSensor::GetFrameLength(payload);
+  }
+
+  return frameLength;
+}
+
+// What HandleReceivedData() in the sketch does now
+static byte HandleFrameDispatcher(byte *payload, unsigned long dataRate) {
+  return FrameDispatcher::TryHandleData(payload, dataRate);
+}
+
+static void Run(const char *title, HandleFunction handleFrame, unsigned long iterations) {
+  ProtocolStatistics statistics[BP_Count];
+  memset(statistics, 0, sizeof(statistics));
+
+  for (unsigned long it = 0; it < iterations; it++) {
+    for (int i = 0; i < BENCH_MIX_SIZE; i++) {
+      RecordedFrame *frame = &s_mix[i];
+      byte payload[BENCH_PAYLOAD_SIZE];
+      memcpy(payload, frame->Payload, BENCH_PAYLOAD_SIZE);
+
+      Serial.ClearOutput();
+      String::ResetAllocationCount();
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      handleFrame(payload, frame->DataRate);
+      std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+      ProtocolStatistics *stat = &statistics[frame->Protocol];
+      stat->Frames++;
+      stat->Nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+      stat->Allocations += String::GetAllocationCount();
+      stat->OutputBytes += Serial.GetOutputLength();
+    }
+  }
+
+  printf("%s\n", title);
+  printf("%-13s %10s %10s %10s %10s\n", "Protocol", "Frames", "ns/frame", "allocs", "bytes");
+  unsigned long totalFrames = 0;
+  unsigned long totalNanoseconds = 0;
+  for (int p = 0; p < BP_Count; p++) {
+    ProtocolStatistics *stat = &statistics[p];
+    if (stat->Frames == 0) {
+      continue;
+    }
+    printf("%-13s %10lu %10lu %10.1f %10.1f\n",
+      ProtocolNames[p],
+      stat->Frames,
+      stat->Nanoseconds / stat->Frames,
+      (double)stat->Allocations / stat->Frames,
+      (double)stat->OutputBytes / stat->Frames);
+    totalFrames += stat->Frames;
+    totalNanoseconds += stat->Nanoseconds;
+  }
+  printf("%-13s %10lu %10lu\n\n", "Total", totalFrames, totalNanoseconds / totalFrames);
+}
+
+// The dispatcher must print exactly what the cascade printed
+static bool CompareWithCascade() {
+  for (int i = 0; i < BENCH_MIX_SIZE; i++) {
+    byte payload[BENCH_PAYLOAD_SIZE];
+
+    memcpy(payload, s_mix[i].Payload, BENCH_PAYLOAD_SIZE);
+    Serial.ClearOutput();
+    byte expectedLength = HandleFrameCascade(payload, s_mix[i].DataRate);
+    String expected = Serial.GetOutput();
+
+    memcpy(payload, s_mix[i].Payload, BENCH_PAYLOAD_SIZE);
+    Serial.ClearOutput();
+    byte length = HandleFrameDispatcher(payload, s_mix[i].DataRate);
+
+    if (length != expectedLength || expected != Serial.GetOutput()) {
+      printf("Frame %d (%s): cascade and dispatcher differ\n", i, ProtocolNames[s_mix[i].Protocol]);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Text and binary output of every frame, the record has to give the same line
+static bool CompareBinaryOutput() {
+  unsigned long frames[BP_Count];
+  unsigned long textBytes[BP_Count];
+  unsigned long binaryBytes[BP_Count];
+  memset(frames, 0, sizeof(frames));
+  memset(textBytes, 0, sizeof(textBytes));
+  memset(binaryBytes, 0, sizeof(binaryBytes));
+
+  for (int i = 0; i < BENCH_MIX_SIZE; i++) {
+    byte payload[BENCH_PAYLOAD_SIZE];
+    BenchProtocol protocol = s_mix[i].Protocol;
+
+    memcpy(payload, s_mix[i].Payload, BENCH_PAYLOAD_SIZE);
+    SensorBase::SetBinaryOutput(false);
+    Serial.ClearOutput();
+    HandleFrameDispatcher(payload, s_mix[i].DataRate);
+    std::string expected(Serial.GetOutput(), Serial.GetOutputLength());
+
+    memcpy(payload, s_mix[i].Payload, BENCH_PAYLOAD_SIZE);
+    SensorBase::SetBinaryOutput(true);
+    Serial.ClearOutput();
+    HandleFrameDispatcher(payload, s_mix[i].DataRate);
+    const byte *output = (const byte *)Serial.GetOutput();
+    unsigned long length = Serial.GetOutputLength();
+
+    RecordDecoder decoder;
+    std::string line;
+    int records = 0;
+    bool formatted = true;
+    for (unsigned long b = 0; b < length; b++) {
+      if (decoder.Put(output[b])) {
+        records += decoder.IsRecord() ? 1 : 0;
+        formatted = decoder.IsRecord() && RecordDecoder::Format(decoder.GetRecord(), decoder.GetRecordLength(), &line);
+      }
+    }
+    if (!expected.empty()) {
+      line += "\r\n";
+    }
+
+    bool isValid = expected.empty() ? length == 0 : records == 1 && formatted && output[length - 1] == 0 && line == expected;
+    if (!isValid) {
+      printf("Frame %d (%s): the record does not give \"%s\" but \"%s\"\n", i, ProtocolNames[protocol],
+        expected.c_str(), line.c_str());
+      SensorBase::SetBinaryOutput(false);
+      return false;
+    }
+
+    if (length > 0) {
+      frames[protocol]++;
+      textBytes[protocol] += expected.size();
+      binaryBytes[protocol] += length;
+    }
+  }
+  SensorBase::SetBinaryOutput(false);
+
+  printf("Output per decoded frame\n");
+  printf("%-13s %10s %10s %10s %10s\n", "Protocol", "Frames", "text", "binary", "saved");
+  unsigned long totalText = 0;
+  unsigned long totalBinary = 0;
+  for (int p = 0; p < BP_Count; p++) {
+    if (frames[p] == 0) {
+      continue;
+    }
+    printf("%-13s %10lu %10.1f %10.1f %9.0f%%\n", ProtocolNames[p], frames[p], (double)textBytes[p] / frames[p],
+      (double)binaryBytes[p] / frames[p], 100.0 - 100.0 * binaryBytes[p] / textBytes[p]);
+    totalText += textBytes[p];
+    totalBinary += binaryBytes[p];
+  }
+  printf("%-13s %10s %10lu %10lu %9.0f%%\n\n", "Total", "", totalText, totalBinary, 100.0 - 100.0 * totalBinary / totalText);
+  return true;
+}
+
+// A CustomSensor length byte of 252..255 wraps the byte sized frame length
+// to 0..3. The payload has exactly PAYLOADSIZE bytes, so a sanitizer build
+// catches any read behind or before it.
+static bool CheckMalformedFrames() {
+  static const unsigned long dataRates[] = { 9579ul, 17241ul };
+  for (byte length = 0xFC; length != 0; length++) {
+    for (size_t r = 0; r < sizeof(dataRates) / sizeof(dataRates[0]); r++) {
+      byte *payload = new byte[PAYLOADSIZE];
+      memset(payload, 0x55, PAYLOADSIZE);
+      payload[0] = CUSTOM_SENSOR_HEADER;
+      payload[1] = 0x01;
+      payload[2] = length;
+
+      word misses = FrameDispatcher::GetMisses(FrameDispatcher::ProtocolCustomSensor);
+      Serial.ClearOutput();
+      byte frameLength = HandleFrameDispatcher(payload, dataRates[r]);
+      bool isValid = frameLength == 0 && Serial.GetOutputLength() == 0
+        && FrameDispatcher::GetMisses(FrameDispatcher::ProtocolCustomSensor) == misses;
+      delete[] payload;
+      if (!isValid) {
+        printf("CustomSensor length %u at %lu: decoded behind the payload\n", length, dataRates[r]);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Output of the whole mix, one line per frame with its number and length
+static std::string Dump() {
+  std::string result;
+  for (int i = 0; i < BENCH_MIX_SIZE; i++) {
+    byte payload[BENCH_PAYLOAD_SIZE];
+    memcpy(payload, s_mix[i].Payload, BENCH_PAYLOAD_SIZE);
+    Serial.ClearOutput();
+    byte length = HandleFrameDispatcher(payload, s_mix[i].DataRate);
+    char prefix[16];
+    snprintf(prefix, sizeof(prefix), "%4d %2u ", i, length);
+    result += prefix;
+    result.append(Serial.GetOutput(), Serial.GetOutputLength());
+    if (length == 0) {
+      result += "\n";
+    }
+  }
+  return result;
+}
+
+// The dump has to be the golden one, the first differing line is shown
+static bool CompareWithGolden() {
+  std::ifstream file(DECODE_GOLDEN_FILE, std::ios::binary);
+  if (!file) {
+    printf("Golden file %s not found\n", DECODE_GOLDEN_FILE);
+    return false;
+  }
+  std::stringstream golden;
+  golden << file.rdbuf();
+
+  std::istringstream expected(golden.str());
+  std::istringstream actual(Dump());
+  std::string expectedLine;
+  std::string actualLine;
+  for (int line = 1; ; line++) {
+    bool hasExpected = (bool)std::getline(expected, expectedLine);
+    bool hasActual = (bool)std::getline(actual, actualLine);
+    if (!hasExpected && !hasActual) {
+      return true;
+    }
+    if (hasExpected != hasActual || expectedLine != actualLine) {
+      printf("Output differs from %s in line %d\n  expected: %s\n  actual:   %s\n", DECODE_GOLDEN_FILE, line,
+        hasExpected ? expectedLine.c_str() : "(end)", hasActual ? actualLine.c_str() : "(end)");
+      return false;
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  BuildTemplates();
+  BuildMix();
+
+  if (argc > 1 && strcmp(argv[1], "dump") == 0) {
+    std::string dump = Dump();
+    fwrite(dump.data(), 1, dump.size(), stdout);
+    return 0;
+  }
+
+  unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+
+  // Every template except the noise must decode, else the numbers are worthless
+  String firstLines[BP_Count];
+  for (int p = 0; p < BP_Undecoded; p++) {
+    Serial.ClearOutput();
+    if (HandleFrameDispatcher(s_templates[p].Payload, s_templates[p].DataRate) == 0) {
+      printf("Template %s is not decoded\n", ProtocolNames[p]);
+      return 1;
+    }
+    firstLines[p] = Serial.GetOutput();
+  }
+
+  if (!CompareWithGolden() || !CheckMalformedFrames() || !CompareWithCascade() || !CompareBinaryOutput()) {
+    return 1;
+  }
+
+  Run("Cascade", HandleFrameCascade, iterations);
+  FrameDispatcher::ResetStatistics();
+  Run("FrameDispatcher", HandleFrameDispatcher, iterations);
+
+  printf("%-13s %10s %10s\n", "Classified", "hits", "misses");
+  for (int p = 0; p < FrameDispatcher::ProtocolCount; p++) {
+    FrameDispatcher::Protocol protocol = (FrameDispatcher::Protocol)p;
+    // A flash string is a plain one on the host
+    printf("%-13s %10lu %10u\n", reinterpret_cast<const char *>(FrameDispatcher::GetProtocolName(protocol)),
+      FrameDispatcher::GetHits(protocol), FrameDispatcher::GetMisses(protocol));
+  }
+
+  printf("\n");
+  for (int p = 0; p < BP_Undecoded; p++) {
+    printf("%-13s %s", ProtocolNames[p], firstLines[p].c_str());
+  }
+
+  return 0;
+}
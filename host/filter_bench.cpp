@@ -0,0 +1,283 @@
+// filter_bench.cpp
+//
+// Sensor ID filter (<p>,<mode>i, IdFilter) in a neighbourhood: 4 TX29 and
+// 2 EMT7110 of our own among 40 TX29 and 10 EMT7110 of the neighbours. The
+// mix goes through the FrameDispatcher without a filter, with allow lists
+// of our sensors and with a deny list of the neighbours, and the bench
+// reports the lines that come out, the filtered frames and the time per
+// frame. Only our sensors may come through the filters, the filtered counts
+// have to match the frames of the neighbours and the filters have to come
+// back the same from the EEPROM. A CC frame at 17.241 kbps, TX38IT ID 12 or
+// a CustomSensor, has to be filtered by the protocol it turns out to be.
+//
+// Usage: filter_bench [iterations]
+
+#include <chrono>
+#include <set>
+#include <string>
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "LaCrosse.h"
+#include "EMT7110.h"
+#include "TX38IT.h"
+#include "CustomSensor.h"
+#include "FrameRing.h"
+#include "FrameDispatcher.h"
+#include "SerialQueue.h"
+#include "IdFilter.h"
+
+#define TX29_COUNT 44
+#define EMT7110_COUNT 12
+#define MIX_SIZE 1000
+
+struct BenchFrame {
+  byte Payload[PAYLOADSIZE];
+  unsigned long DataRate;
+  FrameDispatcher::Protocol Protocol;
+  word ID;
+  bool IsOwn;
+};
+
+static const byte s_ownTX29[] = { 5, 17, 33, 48 };
+static const word s_ownEMT7110[] = { 0x5451, 0x1F02 };
+static BenchFrame s_mix[MIX_SIZE];
+static unsigned long s_random = 1;
+
+static unsigned long Random(unsigned long range) {
+  s_random = s_random * 1103515245UL + 12345;
+  return (s_random >> 8) % range;
+}
+
+// Our TX29 are the first 4, our EMT7110 the first 2
+static void BuildMix() {
+  byte tx29[TX29_COUNT];
+  word emt7110[EMT7110_COUNT];
+  memcpy(tx29, s_ownTX29, sizeof(s_ownTX29));
+  byte count = sizeof(s_ownTX29);
+  for (byte id = 0; count < TX29_COUNT; id++) {
+    if (!memchr(s_ownTX29, id, sizeof(s_ownTX29))) {
+      tx29[count++] = id;
+    }
+  }
+  for (byte i = 0; i < EMT7110_COUNT; i++) {
+    emt7110[i] = i < 2 ? s_ownEMT7110[i] : 0x2000 + i * 0x0111;
+  }
+
+  for (int i = 0; i < MIX_SIZE; i++) {
+    BenchFrame *frame = &s_mix[i];
+    memset(frame->Payload, 0, sizeof(frame->Payload));
+    if (Random(5) > 0) {
+      byte index = Random(TX29_COUNT);
+      struct LaCrosse::Frame tx;
+      memset(&tx, 0, sizeof(tx));
+      tx.ID = tx29[index];
+      tx.Temperature = Random(500) - 100;
+      tx.Humidity = 20 + Random(70);
+      LaCrosse::EncodeFrame(&tx, frame->Payload);
+      frame->DataRate = 17241;
+      frame->Protocol = FrameDispatcher::ProtocolLaCrosse;
+      frame->ID = tx.ID;
+      frame->IsOwn = index < sizeof(s_ownTX29);
+    }
+    else {
+      byte index = Random(EMT7110_COUNT);
+      byte emt[] = { 0x25, 0x6A, (byte)(emt7110[index] >> 8), (byte)emt7110[index], 0x40, 0x04, 0x00, 0x0D, 0xC9, 0x01, 0x06, 0x00 };
+      byte sum = 0;
+      for (int b = 0; b < EMT7110::FRAME_LENGTH - 1; b++) {
+        sum += emt[b];
+      }
+      emt[EMT7110::FRAME_LENGTH - 1] = -sum;
+      memcpy(frame->Payload, emt, sizeof(emt));
+      frame->DataRate = 9579;
+      frame->Protocol = FrameDispatcher::ProtocolEMT7110;
+      frame->ID = emt7110[index];
+      frame->IsOwn = index < 2;
+    }
+  }
+}
+
+struct Result {
+  unsigned long Frames;
+  unsigned long Lines;
+  unsigned long Filtered;
+  unsigned long NeighbourFrames;
+  double NanosPerFrame;
+  std::set<std::string> Sensors;
+};
+
+static Result Run(unsigned long iterations) {
+  Result result;
+  result.Frames = 0;
+  result.Lines = 0;
+  result.NeighbourFrames = 0;
+  IdFilter::ResetStatistics();
+
+  // Timed without the capture of the shim, then once more for the lines
+  Serial.EnableCapture(false);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (unsigned long n = 0; n < iterations; n++) {
+    for (int i = 0; i < MIX_SIZE; i++) {
+      FrameDispatcher::TryHandleData(s_mix[i].Payload, s_mix[i].DataRate);
+      SerialQueue::Flush();
+    }
+  }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  result.NanosPerFrame = std::chrono::duration<double, std::nano>(end - start).count() / (iterations * MIX_SIZE);
+
+  IdFilter::ResetStatistics();
+  Serial.EnableCapture(true);
+  Serial.ClearOutput();
+  for (int i = 0; i < MIX_SIZE; i++) {
+    FrameDispatcher::TryHandleData(s_mix[i].Payload, s_mix[i].DataRate);
+    SerialQueue::Flush();
+    result.Frames++;
+    if (!s_mix[i].IsOwn) {
+      result.NeighbourFrames++;
+    }
+  }
+
+  std::string output(Serial.GetOutput(), Serial.GetOutputLength());
+  size_t position = 0;
+  size_t next;
+  while ((next = output.find("\r\n", position)) != std::string::npos) {
+    std::string line = output.substr(position, next - position);
+    result.Lines++;
+    // "OK 9 ID" and "OK EMT7110 IDH IDL"
+    size_t end = line.find(' ', line.find(' ', 3) + 1);
+    if (line.compare(0, 10, "OK EMT7110") == 0) {
+      end = line.find(' ', end + 1);
+    }
+    result.Sensors.insert(line.substr(0, end));
+    position = next + 2;
+  }
+  result.Filtered = IdFilter::GetFiltered(FrameDispatcher::ProtocolLaCrosse)
+    + IdFilter::GetFiltered(FrameDispatcher::ProtocolEMT7110);
+  return result;
+}
+
+// Lines of one frame and whether its protocol counted it as filtered
+static bool IsFiltered(byte *payload, FrameDispatcher::Protocol protocol, unsigned long *lines) {
+  IdFilter::ResetStatistics();
+  Serial.ClearOutput();
+  FrameDispatcher::TryHandleData(payload, 17241);
+  SerialQueue::Flush();
+  std::string output(Serial.GetOutput(), Serial.GetOutputLength());
+  *lines = 0;
+  size_t position = 0;
+  while ((position = output.find("\r\n", position)) != std::string::npos) {
+    (*lines)++;
+    position += 2;
+  }
+  return IdFilter::GetFiltered(protocol) == 1;
+}
+
+static bool CheckCustomSensorHeader() {
+  byte tx38it[PAYLOADSIZE];
+  byte custom[PAYLOADSIZE];
+  memset(tx38it, 0, sizeof(tx38it));
+  memset(custom, 0, sizeof(custom));
+
+  struct TX38IT::Frame tx;
+  memset(&tx, 0, sizeof(tx));
+  tx.ID = 12;
+  tx.Temperature = 215;
+  TX38IT::EncodeFrame(&tx, tx38it);
+
+  struct CustomSensor::Frame cs;
+  memset(&cs, 0, sizeof(cs));
+  cs.ID = 0x42;
+  static const byte csData[] = { 1, 2, 3 };
+  cs.NbrOfDataBytes = sizeof(csData);
+  cs.Data = csData;
+  CustomSensor::EncodeFrame(&cs, custom);
+
+  bool ok = tx38it[0] == CUSTOM_SENSOR_HEADER;
+  unsigned long lines;
+  Serial.EnableCapture(true);
+
+  IdFilter::Clear();
+  IdFilter::SetMode(FrameDispatcher::ProtocolTX38IT, ID_FILTER_DENY);
+  ok = IdFilter::Add(FrameDispatcher::ProtocolTX38IT, 12) && ok;
+  ok = IsFiltered(tx38it, FrameDispatcher::ProtocolTX38IT, &lines) && lines == 0 && ok;
+  ok = !IsFiltered(custom, FrameDispatcher::ProtocolTX38IT, &lines) && lines == 1 && ok;
+
+  IdFilter::Clear();
+  IdFilter::SetMode(FrameDispatcher::ProtocolCustomSensor, ID_FILTER_ALLOW);
+  ok = IdFilter::Add(FrameDispatcher::ProtocolCustomSensor, 0x43) && ok;
+  ok = IsFiltered(custom, FrameDispatcher::ProtocolCustomSensor, &lines) && lines == 0 && ok;
+  ok = !IsFiltered(tx38it, FrameDispatcher::ProtocolCustomSensor, &lines) && lines == 1 && ok;
+
+  IdFilter::Clear();
+  printf("CC at 17.241 kbps filtered as TX38IT ID 12 and as CustomSensor: %s\n", ok ? "yes" : "no");
+  return ok;
+}
+
+static void Print(const char *name, const Result *result) {
+  printf("%-28s %7lu %7lu %9lu %8zu %9.0f\n", name, result->Frames, result->Lines, result->Filtered,
+    result->Sensors.size(), result->NanosPerFrame);
+}
+
+int main(int argc, char **argv) {
+  unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+  if (iterations == 0) {
+    return 1;
+  }
+  BuildMix();
+  EEPROM.Erase();
+  IdFilter::Begin();
+
+  bool ok = true;
+  printf("%-28s %7s %7s %9s %8s %9s\n", "Filter", "Frames", "Lines", "Filtered", "Sensors", "ns/frame");
+
+  Result none = Run(iterations);
+  Print("none", &none);
+  ok = ok && none.Lines == none.Frames && none.Filtered == 0 && none.Sensors.size() == TX29_COUNT + EMT7110_COUNT;
+
+  // Only ours
+  IdFilter::SetMode(FrameDispatcher::ProtocolLaCrosse, ID_FILTER_ALLOW);
+  IdFilter::SetMode(FrameDispatcher::ProtocolEMT7110, ID_FILTER_ALLOW);
+  for (byte i = 0; i < sizeof(s_ownTX29); i++) {
+    ok = IdFilter::Add(FrameDispatcher::ProtocolLaCrosse, s_ownTX29[i]) && ok;
+  }
+  for (byte i = 0; i < 2; i++) {
+    ok = IdFilter::Add(FrameDispatcher::ProtocolEMT7110, s_ownEMT7110[i]) && ok;
+  }
+  Result allow = Run(iterations);
+  Print("allow 4 TX29, 2 EMT7110", &allow);
+  ok = ok && allow.Lines == allow.Frames - allow.NeighbourFrames && allow.Filtered == allow.NeighbourFrames
+    && allow.Sensors.size() == sizeof(s_ownTX29) + 2;
+
+  // After a reset
+  unsigned long writes = EEPROM.GetWriteCount();
+  IdFilter::Begin();
+  Result stored = Run(1);
+  ok = ok && stored.Lines == allow.Lines && stored.Sensors == allow.Sensors;
+
+  // The neighbours by name, the set takes the 10 EMT7110
+  IdFilter::Clear();
+  IdFilter::SetMode(FrameDispatcher::ProtocolLaCrosse, ID_FILTER_DENY);
+  IdFilter::SetMode(FrameDispatcher::ProtocolEMT7110, ID_FILTER_DENY);
+  for (int i = 0; i < MIX_SIZE; i++) {
+    if (!s_mix[i].IsOwn) {
+      ok = IdFilter::Add(s_mix[i].Protocol, s_mix[i].ID) && ok;
+    }
+  }
+  Result deny = Run(iterations);
+  Print("deny 40 TX29, 10 EMT7110", &deny);
+  ok = ok && deny.Lines == allow.Lines && deny.Filtered == allow.Filtered && deny.Sensors == allow.Sensors;
+
+  // Removing from the middle of a probe run must not lose the others
+  for (int i = 0; i < MIX_SIZE; i++) {
+    if (!s_mix[i].IsOwn && s_mix[i].Protocol == FrameDispatcher::ProtocolEMT7110) {
+      IdFilter::Remove(s_mix[i].Protocol, s_mix[i].ID);
+      break;
+    }
+  }
+  Result removed = Run(1);
+  ok = ok && removed.Sensors.size() == allow.Sensors.size() + 1;
+
+  printf("\nEEPROM bytes written up to the allow lists: %lu\n", writes);
+  ok = CheckCustomSensorHeader() && ok;
+  printf("%s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,466 @@
+// fixed_bench
+//
+// The decoders carry scaled integers (1/10 C, 0.5 cm, mA, 1/10 V, ...) in
+// their frames now instead of float. This runs every value the fields can
+// take through the float decoders as they were and through the current ones
+// and checks that the integer is the float value in its scale, truncated
+// like the FHEM line does, but without the float error: where the old
+// float * 10 cast ended up one below, the line is counted as corrected.
+// Then both decoders are timed per frame.
+//
+// Usage: fixed_bench [iterations]
+
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_TSC 1
+#endif
+#include "Arduino.h"
+#include "LaCrosse.h"
+#include "TX22IT.h"
+#include "WS1080.h"
+#include "LevelSenderLib.h"
+#include "EMT7110.h"
+
+#define BENCH_FRAME_SIZE 16
+#define BENCH_MAX_FRAMES (5 * 0x1000)
+
+// --- The float decoders as they were ---------------------------------------------------------------------------------
+struct FloatLaCrosseFrame {
+  float Temperature;
+  bool IsValid;
+};
+
+struct FloatWSFrame {
+  float Temperature;
+  byte  Humidity;
+  float Rain;
+  float WindDirection;
+  float WindSpeed;
+  float WindGust;
+  bool IsValid;
+};
+
+struct FloatLevelSenderFrame {
+  float Level;
+  float Temperature;
+  float Voltage;
+  bool IsValid;
+};
+
+struct FloatEMT7110Frame {
+  float Voltage;
+  float Current;
+  float Power;
+  float AccumulatedPower;
+  bool IsValid;
+};
+
+static void FloatDecodeLaCrosse(byte *bytes, FloatLaCrosseFrame *frame) {
+  frame->IsValid = bytes[4] == LaCrosse::CalculateCRC(bytes) && (bytes[0] & 0xF0) >> 4 == 9;
+
+  byte bcd[3];
+  bcd[0] = bytes[1] & 0xF;
+  bcd[1] = (bytes[2] & 0xF0) >> 4;
+  bcd[2] = (bytes[2] & 0xF);
+  float t = 0;
+  t += bcd[0] * 100.0;
+  t += bcd[1] * 10.0;
+  t += bcd[2] * 1.0;
+  t = t / 10;
+  t -= 40;
+  frame->Temperature = t;
+}
+
+static float FloatDecodeValue(byte q1, byte q2, byte q3) {
+  float result = 0;
+
+  result += q1 * 100;
+  result += q2 * 10;
+  result += q3;
+
+  return result;
+}
+
+static void FloatDecodeTX22IT(byte *bytes, FloatWSFrame *frame) {
+  frame->Temperature = 0;
+  frame->Humidity = 0;
+  frame->Rain = 0;
+  frame->WindDirection = 0;
+  frame->WindSpeed = 0;
+  frame->WindGust = 0;
+
+  byte frameLength = TX22IT::GetFrameLength(bytes);
+  frame->IsValid = bytes[frameLength - 1] == SensorBase::CalculateCRC(bytes, frameLength - 1)
+    && (bytes[0] & 0xF0) >> 4 == 0xA;
+
+  if (frame->IsValid) {
+    byte ct = bytes[1] & 0x7;
+    for (int i = 0; i < ct; i++) {
+      byte byte1 = bytes[2 + i * 2];
+      byte byte2 = bytes[3 + i * 2];
+
+      byte type = (byte1 & 0xF0) >> 4;
+      byte q1 = (byte1 & 0xF);
+      byte q2 = (byte2 & 0xF0) >> 4;
+      byte q3 = (byte2 & 0xF);
+
+      switch (type) {
+        case 0:
+          frame->Temperature = (FloatDecodeValue(q1, q2, q3) - 400) / 10.0;
+          if (frame->Temperature > 60 || frame->Temperature < -40) {
+            frame->IsValid = false;
+          }
+          break;
+
+        case 1:
+          // float to byte is undefined above 255, x86 and AVR keep the low byte
+          frame->Humidity = (byte)(int)FloatDecodeValue(q1, q2, q3);
+          if (frame->Humidity > 100) {
+            frame->IsValid = false;
+          }
+          break;
+
+        case 2:
+          frame->Rain = q1 * 256 + q2 * 16 + q3;
+          break;
+
+        case 3:
+          frame->WindDirection = q1 * 22.5;
+          frame->WindSpeed = (q2 * 16 + q3) / 10.0;
+          break;
+
+        case 4:
+          frame->WindGust = (q2 * 16 + q3) / 10.0;
+          break;
+      }
+    }
+  }
+}
+
+static void FloatDecodeWS1080(byte *bytes, FloatWSFrame *frame) {
+  frame->IsValid = bytes[WS1080::FRAME_LENGTH - 1] == WS1080::CalculateCRC(bytes) && bytes[0] >> 4 == 0xA;
+
+  if (frame->IsValid) {
+    byte sign = (bytes[1] >> 3) & 1;
+    int temp = ((bytes[1] & 0x07) << 8) | bytes[2];
+    if (sign) {
+      temp = (~temp) + sign;
+    }
+    frame->Temperature = temp * 0.1;
+    frame->Humidity = bytes[3] & 0x7F;
+    frame->WindSpeed = bytes[4] * 0.34;
+    frame->WindGust = bytes[5] * 0.34;
+    frame->Rain = (((bytes[6] & 0x0F) << 8) | bytes[7]) * 0.6;
+    frame->WindDirection = 22.5 * (bytes[8] & 0x0F);
+  }
+}
+
+static void FloatDecodeLevelSender(byte *data, FloatLevelSenderFrame *frame) {
+  frame->IsValid = data[5] == LevelSenderLib::CalculateCRC(data) && (data[0] & 0xF0) >> 4 == 11;
+
+  frame->Level = ((data[1] & 0xF0) >> 4) * 100;
+  frame->Level += (data[1] & 0x0F) * 10;
+  frame->Level += ((data[2] & 0xF0) >> 4);
+  frame->Level *= 0.5;
+
+  frame->Temperature = (data[2] & 0xF) * 10;
+  frame->Temperature += ((data[3] & 0xF0) >> 4);
+  frame->Temperature += (data[3] & 0xF) * 0.1;
+  frame->Temperature -= 40;
+
+  frame->Voltage = (data[4] & 0xF0) >> 4;
+  frame->Voltage += (data[4] & 0x0F) * 0.1;
+
+  if (frame->Temperature < -40.0 || frame->Temperature > 60.0) {
+    frame->IsValid = false;
+  }
+  if (frame->Level < 2.0 || frame->Level > 300) {
+    frame->IsValid = false;
+  }
+  if (frame->Voltage < 2.0 || frame->Voltage > 13.0) {
+    frame->IsValid = false;
+  }
+}
+
+static void FloatDecodeEMT7110(byte *data, FloatEMT7110Frame *frame) {
+  frame->Voltage = 128.0 + data[8] * 0.5;
+  frame->Current = (data[6] << 8) | data[7];
+  frame->Power = ((data[4] & 0x3F) << 8 | data[5]) / 2;
+  frame->AccumulatedPower = ((data[9] & 0x3F) << 8 | data[10]) / 100.0;
+  frame->IsValid = EMT7110::CrcIsValid(data) && !(data[4] & 0x80) && !(data[6] == 0xAA && data[7] == 0xAA);
+}
+
+
+// --- Frames with every value of the fields ---------------------------------------------------------------------------
+static byte s_frames[BENCH_MAX_FRAMES][BENCH_FRAME_SIZE];
+static unsigned long s_frameCount;
+static unsigned long s_mismatches;
+static unsigned long s_corrected;
+
+static unsigned long BuildLaCrosseFrames() {
+  unsigned long count = 0;
+  for (unsigned int t = 0; t < 0x1000; t++) {
+    byte *bytes = s_frames[count++];
+    bytes[0] = 0x90 | 14;
+    bytes[1] = 0x00 | (t >> 8);
+    bytes[2] = t;
+    bytes[3] = 55;
+    bytes[4] = LaCrosse::CalculateCRC(bytes);
+  }
+  return count;
+}
+
+// One quartet per frame: every 12 bit value of every type
+static unsigned long BuildTX22ITFrames() {
+  unsigned long count = 0;
+  for (byte type = 0; type <= 4; type++) {
+    for (unsigned int value = 0; value < 0x1000; value++) {
+      byte *bytes = s_frames[count++];
+      bytes[0] = 0xA1;
+      bytes[1] = 0xC1;
+      bytes[2] = (type << 4) | (value >> 8);
+      bytes[3] = value;
+      bytes[4] = SensorBase::CalculateCRC(bytes, 4);
+    }
+  }
+  return count;
+}
+
+static unsigned long BuildWS1080Frames() {
+  unsigned long count = 0;
+  for (unsigned int value = 0; value < 0x1000; value++) {
+    byte *bytes = s_frames[count++];
+    bytes[0] = 0xA8;
+    bytes[1] = 0xC0 | (value >> 8);
+    bytes[2] = value;
+    bytes[3] = 60;
+    bytes[4] = value;
+    bytes[5] = ~value;
+    bytes[6] = value >> 8;
+    bytes[7] = value;
+    bytes[8] = value & 0x0F;
+    bytes[9] = WS1080::CalculateCRC(bytes);
+  }
+  return count;
+}
+
+// All BCD digits of level and temperature, the voltage digits go along
+static unsigned long BuildLevelSenderFrames() {
+  unsigned long count = 0;
+  for (unsigned int value = 0; value < 0x1000; value++) {
+    byte *bytes = s_frames[count++];
+    bytes[0] = 0xB1;
+    bytes[1] = value >> 4;
+    bytes[2] = (value << 4) | (value >> 8);
+    bytes[3] = value;
+    bytes[4] = value >> 2;
+    bytes[5] = LevelSenderLib::CalculateCRC(bytes);
+  }
+  return count;
+}
+
+static unsigned long BuildEMT7110Frames() {
+  unsigned long count = 0;
+  for (unsigned int value = 0; value < 0x4000; value++) {
+    byte *bytes = s_frames[count++];
+    bytes[0] = 0x25;
+    bytes[1] = 0x6A;
+    bytes[2] = 0x54;
+    bytes[3] = 0x51;
+    bytes[4] = 0x40 | (value >> 8);
+    bytes[5] = value;
+    bytes[6] = value >> 8;
+    bytes[7] = value;
+    bytes[8] = value;
+    bytes[9] = value >> 8;
+    bytes[10] = value;
+    byte sum = 0;
+    for (int i = 0; i < EMT7110::FRAME_LENGTH - 1; i++) {
+      sum += bytes[i];
+    }
+    bytes[11] = -sum;
+  }
+  return count;
+}
+
+
+// --- Checks ----------------------------------------------------------------------------------------------------------
+// value has to be the float value in its scale, truncated, without the float error.
+// oldOutput is what the float code put on the FHEM line.
+static void Check(const char *name, unsigned long frame, double floatValue, double scale, long value, long oldOutput) {
+  long exact = (long)floor(floatValue * scale + 0.01);
+  if (value != exact) {
+    if (s_mismatches++ < 5) {
+      printf("%s frame %lu: %ld, expected %ld\n", name, frame, value, exact);
+    }
+  }
+  else if (value != oldOutput) {
+    s_corrected++;
+  }
+}
+
+static void CheckValidity(const char *name, unsigned long frame, bool floatValid, bool valid) {
+  if (floatValid != valid && s_mismatches++ < 5) {
+    printf("%s frame %lu: valid %d, expected %d\n", name, frame, valid, floatValid);
+  }
+}
+
+static void CheckLaCrosse(unsigned long i, byte *bytes) {
+  FloatLaCrosseFrame expected;
+  LaCrosse::Frame frame;
+  FloatDecodeLaCrosse(bytes, &expected);
+  LaCrosse::DecodeFrame(bytes, &frame);
+  CheckValidity("LaCrosse", i, expected.IsValid, frame.IsValid);
+  Check("LaCrosse", i, expected.Temperature, 10, frame.Temperature, (uint16_t)(expected.Temperature * 10 + 1000) - 1000);
+}
+
+static void CheckWS(const char *name, unsigned long i, FloatWSFrame *expected, WSBase::Frame *frame) {
+  Check(name, i, expected->Temperature, 10, frame->Temperature, (word)(expected->Temperature * 10 + 1000) - 1000);
+  Check(name, i, expected->Rain, 10, frame->Rain, frame->Rain);
+  Check(name, i, expected->Rain, 1, frame->Rain / 10, (word)expected->Rain);
+  Check(name, i, expected->WindDirection, 10, frame->WindDirection, (word)(expected->WindDirection * 10));
+  Check(name, i, expected->WindSpeed, 10, frame->WindSpeed, (word)(expected->WindSpeed * 10));
+  Check(name, i, expected->WindGust, 10, frame->WindGust, (word)(expected->WindGust * 10));
+}
+
+static void CheckTX22IT(unsigned long i, byte *bytes) {
+  FloatWSFrame expected;
+  WSBase::Frame frame;
+  FloatDecodeTX22IT(bytes, &expected);
+  TX22IT::DecodeFrame(bytes, &frame);
+
+  // Humidities above 255 passed as their low byte before
+  if (bytes[2] >> 4 == 1 && expected.IsValid && !frame.IsValid && FloatDecodeValue(bytes[2] & 0xF, bytes[3] >> 4, bytes[3] & 0xF) > 255) {
+    s_corrected++;
+    return;
+  }
+
+  CheckValidity("TX22IT", i, expected.IsValid, frame.IsValid);
+  if (frame.IsValid) {
+    Check("TX22IT", i, expected.Humidity, 1, frame.Humidity, expected.Humidity);
+    CheckWS("TX22IT", i, &expected, &frame);
+  }
+}
+
+static void CheckWS1080(unsigned long i, byte *bytes) {
+  FloatWSFrame expected;
+  WSBase::Frame frame;
+  FloatDecodeWS1080(bytes, &expected);
+  WS1080::DecodeFrame(bytes, &frame);
+  CheckValidity("WS1080", i, expected.IsValid, frame.IsValid);
+  if (frame.IsValid) {
+    CheckWS("WS1080", i, &expected, &frame);
+  }
+}
+
+static void CheckLevelSender(unsigned long i, byte *bytes) {
+  FloatLevelSenderFrame expected;
+  LevelSenderLib::Frame frame;
+  FloatDecodeLevelSender(bytes, &expected);
+  LevelSenderLib::DecodeFrame(bytes, &frame);
+  CheckValidity("LevelSender", i, expected.IsValid, frame.IsValid);
+  Check("LevelSender", i, expected.Level, 2, frame.Level, frame.Level);
+  Check("LevelSender", i, expected.Level, 10, frame.Level * 5, (int)(expected.Level * 10 + 1000) - 1000);
+  Check("LevelSender", i, expected.Temperature, 10, frame.Temperature, (int)(expected.Temperature * 10 + 1000) - 1000);
+  Check("LevelSender", i, expected.Voltage, 10, frame.Voltage, (int)(expected.Voltage * 10));
+}
+
+static void CheckEMT7110(unsigned long i, byte *bytes) {
+  FloatEMT7110Frame expected;
+  EMT7110::Frame frame;
+  FloatDecodeEMT7110(bytes, &expected);
+  EMT7110::DecodeFrame(bytes, &frame);
+  CheckValidity("EMT7110", i, expected.IsValid, frame.IsValid);
+  Check("EMT7110", i, expected.Voltage, 10, frame.Voltage, (int)(expected.Voltage * 10));
+  Check("EMT7110", i, expected.Current, 1, frame.Current, (word)expected.Current);
+  Check("EMT7110", i, expected.Power, 1, frame.Power, (word)expected.Power);
+  Check("EMT7110", i, expected.AccumulatedPower, 100, frame.AccumulatedPower, (int)(expected.AccumulatedPower * 100));
+}
+
+
+// --- Timing ----------------------------------------------------------------------------------------------------------
+template<typename TFrame> struct Decoder {
+  typedef void (*Function)(byte *bytes, TFrame *frame);
+};
+
+static unsigned long long ReadCycles() {
+#ifdef HAS_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+struct Timing {
+  double Nanoseconds;
+  double Cycles;
+};
+
+template<typename TFrame> static Timing Measure(typename Decoder<TFrame>::Function decode, unsigned long iterations) {
+  volatile bool sink = false;
+  TFrame frame;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  unsigned long long cycles = ReadCycles();
+  for (unsigned long it = 0; it < iterations; it++) {
+    for (unsigned long i = 0; i < s_frameCount; i++) {
+      decode(s_frames[i], &frame);
+      sink = sink ^ frame.IsValid;
+    }
+  }
+  cycles = ReadCycles() - cycles;
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  double frames = (double)iterations * s_frameCount;
+  Timing result;
+  result.Nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / frames;
+  result.Cycles = cycles / frames;
+  return result;
+}
+
+typedef unsigned long (*BuildFunction)();
+typedef void (*CheckFunction)(unsigned long i, byte *bytes);
+
+template<typename TFloatFrame, typename TFrame>
+static void Run(const char *name, BuildFunction build, CheckFunction check,
+  typename Decoder<TFloatFrame>::Function floatDecode, typename Decoder<TFrame>::Function decode, unsigned long iterations) {
+  memset(s_frames, 0, sizeof(s_frames));
+  s_frameCount = build();
+
+  unsigned long mismatches = s_mismatches;
+  unsigned long corrected = s_corrected;
+  for (unsigned long i = 0; i < s_frameCount; i++) {
+    check(i, s_frames[i]);
+  }
+
+  Timing before = Measure<TFloatFrame>(floatDecode, iterations);
+  Timing after = Measure<TFrame>(decode, iterations);
+  printf("%-12s %7lu %10lu %10lu %9.1f %9.1f %10.1f %10.1f\n", name, s_frameCount, s_mismatches - mismatches,
+    s_corrected - corrected, before.Nanoseconds, after.Nanoseconds, before.Cycles, after.Cycles);
+}
+
+int main(int argc, char **argv) {
+  unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+  if (iterations == 0) {
+    return 1;
+  }
+
+  printf("%-12s %7s %10s %10s %9s %9s %10s %10s\n", "Decoder", "Frames", "Mismatches", "Corrected",
+    "float ns", "fixed ns", "float cyc", "fixed cyc");
+  Run<FloatLaCrosseFrame, LaCrosse::Frame>("LaCrosse", BuildLaCrosseFrames, CheckLaCrosse,
+    FloatDecodeLaCrosse, LaCrosse::DecodeFrame, iterations);
+  Run<FloatWSFrame, WSBase::Frame>("TX22IT", BuildTX22ITFrames, CheckTX22IT,
+    FloatDecodeTX22IT, TX22IT::DecodeFrame, iterations);
+  Run<FloatWSFrame, WSBase::Frame>("WS1080", BuildWS1080Frames, CheckWS1080,
+    FloatDecodeWS1080, WS1080::DecodeFrame, iterations);
+  Run<FloatLevelSenderFrame, LevelSenderLib::Frame>("LevelSender", BuildLevelSenderFrames, CheckLevelSender,
+    FloatDecodeLevelSender, LevelSenderLib::DecodeFrame, iterations);
+  Run<FloatEMT7110Frame, EMT7110::Frame>("EMT7110", BuildEMT7110Frames, CheckEMT7110,
+    FloatDecodeEMT7110, EMT7110::DecodeFrame, iterations);
+
+  printf("\nCorrected: FHEM value one off (or invalid frame accepted) with the float code\n");
+  bool ok = s_mismatches == 0;
+  printf("%s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
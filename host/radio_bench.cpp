@@ -0,0 +1,184 @@
+// radio_bench.cpp
+//
+// One to four simulated radios with their RadioConfig among the sensors of
+// a house (SensorMix.h): TX29 at 17.241 kbps, a TX27 at 9.579 kbps, TX22IT
+// at 8.842 kbps and EMT7110 at 9.579 kbps, each with its own period, phase
+// and a few ms of jitter. Each radio captures a frame when it is on its
+// rate from the first to the last bit and not busy with another one; a
+// frame captured by two radios counts once, as the host would drop the
+// second line.
+// The radios switch their rate through RadioConfig::UpdateDataRate every
+// 10 ms as the DataRate task of the sketch does, and every captured frame is
+// tagged with the number of the radio that got it.
+// The bench reports the capture ratio per data rate for each board and the
+// frames per radio. More radios must not capture less, three fixed radios
+// have to get at least 98 % of everything and a transmit radio must not
+// receive anything.
+//
+// Usage: radio_bench [minutes]
+
+#include <vector>
+#include "Arduino.h"
+#include "FrameDispatcher.h"
+#include "FrameRing.h"
+#include "RatePlanner.h"
+#include "RadioConfig.h"
+#include "SensorMix.h"
+
+#define MAX_RADIOS 4
+#define TASK_PERIOD 10
+#define LEARN_MILLIS 600000ul
+// Preamble and sync word before the frame
+#define PREAMBLE_BYTES 5
+
+typedef SensorMix::Sensor Sensor;
+
+struct Board {
+  const char *Name;
+  byte Count;
+  RadioConfig Configs[MAX_RADIOS];
+};
+
+// A frame one radio is receiving
+struct Reception {
+  size_t Sensor;
+  unsigned long Start;
+  unsigned long End;
+};
+
+struct Result {
+  unsigned long Sent[3];
+  unsigned long Captured[3];
+  unsigned long PerRadio[MAX_RADIOS];
+};
+
+static Result Run(Board *board, unsigned long minutes) {
+  std::vector<Sensor> sensors = SensorMix::Build();
+  srand(7);
+  for (size_t i = 0; i < sensors.size(); i++) {
+    sensors[i].Next = rand() % sensors[i].Period;
+  }
+  RatePlanner::Clear();
+  HostClock::SetMicros(0);
+
+  Result result;
+  memset(&result, 0, sizeof(result));
+  std::vector<Reception> receiving[MAX_RADIOS];
+  // Sensor and start of the frame the last capture was of, to count it once
+  std::vector<unsigned long> lastCaptured(sensors.size(), 0xFFFFFFFF);
+  unsigned long end = minutes * 60000ul;
+
+  for (unsigned long now = 0; now < end; now++) {
+    HostClock::SetMicros(now * 1000);
+
+    if (now % TASK_PERIOD == 0) {
+      for (byte r = 0; r < board->Count; r++) {
+        board->Configs[r].UpdateDataRate(now);
+      }
+    }
+
+    for (size_t i = 0; i < sensors.size(); i++) {
+      Sensor *sensor = &sensors[i];
+      if (now != sensor->Next) {
+        continue;
+      }
+      unsigned long frameEnd = now + (PREAMBLE_BYTES + sensor->FrameLength) * 8000ul / sensor->DataRate + 1;
+      for (byte r = 0; r < board->Count; r++) {
+        RadioConfig *config = &board->Configs[r];
+        // The radio has to be on the rate when the preamble starts
+        if (config->IsReceiving() && config->DataRate == sensor->DataRate && receiving[r].empty()) {
+          Reception reception = { i, now, frameEnd };
+          receiving[r].push_back(reception);
+        }
+      }
+      if (now >= LEARN_MILLIS) {
+        result.Sent[RatePlanner::GetRateIndex(sensor->DataRate)]++;
+      }
+      sensor->Next += sensor->Period - 3 + rand() % 7;
+    }
+
+    for (byte r = 0; r < board->Count; r++) {
+      if (receiving[r].empty() || now + 1 < receiving[r][0].End) {
+        continue;
+      }
+      Reception reception = receiving[r][0];
+      receiving[r].clear();
+      Sensor *sensor = &sensors[reception.Sensor];
+      if (board->Configs[r].DataRate != sensor->DataRate) {
+        continue;
+      }
+
+      // The frame as the ring of radio r + 1 would hand it over
+      FrameRing::Entry frame;
+      frame.Radio = r + 1;
+      frame.Time = reception.Start;
+      frame.DataRate = sensor->DataRate;
+      SensorMix::BuildPayload(*sensor, frame.Payload);
+      RatePlanner::Learn(frame.Payload, frame.DataRate, frame.Time);
+
+      if (frame.Time >= LEARN_MILLIS) {
+        result.PerRadio[frame.Radio - 1]++;
+        if (lastCaptured[reception.Sensor] != frame.Time) {
+          lastCaptured[reception.Sensor] = frame.Time;
+          result.Captured[RatePlanner::GetRateIndex(frame.DataRate)]++;
+        }
+      }
+    }
+  }
+  return result;
+}
+
+static unsigned long GetPercent(unsigned long part, unsigned long whole) {
+  return whole > 0 ? part * 100 / whole : 0;
+}
+
+int main(int argc, char **argv) {
+  Serial.EnableCapture(false);
+  unsigned long minutes = argc > 1 ? strtoul(argv[1], NULL, 10) : 70;
+  if (minutes <= LEARN_MILLIS / 60000) {
+    minutes = LEARN_MILLIS / 60000 + 1;
+  }
+
+  Board boards[] = {
+    { "1 toggling (7m 5t)", 1, { RadioConfig(RADIO_ROLE_TOGGLE, 17241ul, 5, 7) } },
+    { "1 predicting (15m 5t)", 1, { RadioConfig(RADIO_ROLE_TOGGLE, 17241ul, 5, 15) } },
+    { "2: 17241 + predicting", 2, { RadioConfig(RADIO_ROLE_FIXED, 17241ul),
+      RadioConfig(RADIO_ROLE_TOGGLE, 9579ul, 5, 6 | RATE_PLANNER_MODE) } },
+    { "3: one per rate", 3, { RadioConfig(RADIO_ROLE_FIXED, 17241ul), RadioConfig(RADIO_ROLE_FIXED, 9579ul),
+      RadioConfig(RADIO_ROLE_FIXED, 8842ul) } },
+    { "4: one per rate + transmit", 4, { RadioConfig(RADIO_ROLE_FIXED, 17241ul),
+      RadioConfig(RADIO_ROLE_FIXED, 9579ul), RadioConfig(RADIO_ROLE_FIXED, 8842ul),
+      RadioConfig(RADIO_ROLE_TRANSMIT, 17241ul) } },
+  };
+  size_t boardCount = sizeof(boards) / sizeof(boards[0]);
+
+  bool ok = true;
+  unsigned long lastTotal = 0;
+  printf("%-28s %8s %8s %8s %7s   %s\n", "Radios", "17.241", "9.579", "8.842", "Total", "Frames per radio");
+  for (size_t b = 0; b < boardCount; b++) {
+    Result result = Run(&boards[b], minutes);
+    unsigned long sent = result.Sent[0] + result.Sent[1] + result.Sent[2];
+    unsigned long captured = result.Captured[0] + result.Captured[1] + result.Captured[2];
+    unsigned long total = GetPercent(captured, sent);
+
+    printf("%-28s %7lu%% %7lu%% %7lu%% %6lu%%  ", boards[b].Name, GetPercent(result.Captured[0], result.Sent[0]),
+      GetPercent(result.Captured[1], result.Sent[1]), GetPercent(result.Captured[2], result.Sent[2]), total);
+    for (byte r = 0; r < boards[b].Count; r++) {
+      printf(" R%u:%lu", r + 1, result.PerRadio[r]);
+    }
+    printf("\n");
+
+    ok = ok && total >= lastTotal;
+    lastTotal = total;
+    if (boards[b].Count >= 3) {
+      ok = ok && total >= 98;
+    }
+    if (boards[b].Count == 4) {
+      ok = ok && result.PerRadio[3] == 0;
+    }
+  }
+
+  printf("\nCapture ratio per data rate after the first %lu minutes\n", LEARN_MILLIS / 60000);
+  printf("%s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// rate_bench.cpp
+//
+// One radio and the sensors of a house (SensorMix.h) on three data rates:
+// TX29 at 17.241 kbps (about every 4 s), a TX27 at 9.579 kbps, TX22IT at
+// 8.842 kbps (about every 4.5 s) and EMT7110 at 9.579 kbps (every 30 s).
+// Every sensor starts at a random phase and its frames come with a few ms
+// of jitter.
+// A frame is captured when the radio is on its rate from the first to the
+// last bit and not busy with another frame.
+// The radio switches its rate like HandleDataRateToggle() in the sketch,
+// every 10 ms (the DataRate task): round-robin every <n>t seconds as before
+// (7m), or with the RatePlanner (15m), which learns period and phase from the
+// captured frames and toggles only while no sensor is expected.
+// The bench reports the capture ratio per sensor and in total, and for the
+// prediction also the ratio the RatePlanner estimated itself. The prediction
+// has to catch at least 90 % of the frames of every sensor after the first
+// ten minutes, and has to find all of them.
+//
+// Usage: rate_bench [minutes]
+
+#include <vector>
+#include "Arduino.h"
+#include "FrameDispatcher.h"
+#include "FrameRing.h"
+#include "RatePlanner.h"
+#include "SensorMix.h"
+
+#define TASK_PERIOD 10
+#define LEARN_MILLIS 600000ul
+// Preamble and sync word before the frame
+#define PREAMBLE_BYTES 5
+
+typedef SensorMix::Sensor Sensor;
+
+struct Result {
+  unsigned long Sent;
+  unsigned long Captured;
+};
+
+// The rotation of HandleDataRateToggle() in the sketch
+static unsigned long Toggle(unsigned long dataRate, byte toggleMode) {
+  if (dataRate == 8842ul) {
+    if (toggleMode & 2) {
+      return 9579ul;
+    }
+    if (toggleMode & 1) {
+      return 17241ul;
+    }
+  }
+  else if (dataRate == 9579ul) {
+    if (toggleMode & 1) {
+      return 17241ul;
+    }
+    if (toggleMode & 4) {
+      return 8842ul;
+    }
+  }
+  else if (dataRate == 17241ul) {
+    if (toggleMode & 4) {
+      return 8842ul;
+    }
+    if (toggleMode & 2) {
+      return 9579ul;
+    }
+  }
+  return dataRate;
+}
+
+// In steps of a ms. The rate is checked when the preamble starts and when the
+// frame ends; it only changes every 10 ms, so not unseen in between.
+static std::vector<Sensor> Run(bool isPredicting, unsigned long interval, unsigned long minutes) {
+  std::vector<Sensor> sensors = SensorMix::Build();
+  srand(7);
+  for (size_t i = 0; i < sensors.size(); i++) {
+    sensors[i].Next = rand() % sensors[i].Period;
+    sensors[i].Sent = sensors[i].Captured = 0;
+  }
+  RatePlanner::Clear();
+  RatePlanner planner;
+  HostClock::SetMicros(0);
+
+  unsigned long dataRate = 17241ul;
+  unsigned long lastToggle = 0;
+  unsigned long busyUntil = 0;
+  // Frames on air: sensor and start
+  std::vector<std::pair<size_t, unsigned long> > onAir;
+  unsigned long end = minutes * 60000ul;
+
+  for (unsigned long now = 0; now < end; now++) {
+    HostClock::SetMicros(now * 1000);
+
+    if (now % TASK_PERIOD == 0) {
+      if (isPredicting) {
+        dataRate = planner.GetDataRate(now, 7 | RATE_PLANNER_MODE, interval * 1000ul);
+      }
+      else if (now - lastToggle >= interval * 1000ul) {
+        dataRate = Toggle(dataRate, 7);
+        lastToggle = now;
+      }
+    }
+
+    for (size_t i = 0; i < sensors.size(); i++) {
+      Sensor *sensor = &sensors[i];
+      if (now == sensor->Next) {
+        // The radio has to be on the rate when the preamble starts
+        if (dataRate == sensor->DataRate && now >= busyUntil) {
+          onAir.push_back(std::make_pair(i, now));
+          busyUntil = now + (PREAMBLE_BYTES + sensor->FrameLength) * 8000ul / sensor->DataRate + 1;
+        }
+        if (now >= LEARN_MILLIS) {
+          sensor->Sent++;
+        }
+        sensor->Next += sensor->Period - 3 + rand() % 7;
+      }
+    }
+
+    for (size_t j = 0; j < onAir.size(); ) {
+      Sensor *sensor = &sensors[onAir[j].first];
+      if (now + 1 < busyUntil) {
+        j++;
+        continue;
+      }
+      if (dataRate == sensor->DataRate) {
+        byte payload[PAYLOADSIZE];
+        SensorMix::BuildPayload(*sensor, payload);
+        RatePlanner::Learn(payload, sensor->DataRate, onAir[j].second);
+        if (onAir[j].second >= LEARN_MILLIS) {
+          sensor->Captured++;
+        }
+      }
+      onAir.erase(onAir.begin() + j);
+    }
+
+    if (now == LEARN_MILLIS) {
+      RatePlanner::ResetStatistics();
+    }
+  }
+  return sensors;
+}
+
+static Result Sum(const std::vector<Sensor> &sensors) {
+  Result result = { 0, 0 };
+  for (size_t i = 0; i < sensors.size(); i++) {
+    result.Sent += sensors[i].Sent;
+    result.Captured += sensors[i].Captured;
+  }
+  return result;
+}
+
+static unsigned long GetPercent(unsigned long part, unsigned long whole) {
+  return whole > 0 ? part * 100 / whole : 0;
+}
+
+int main(int argc, char **argv) {
+  Serial.EnableCapture(false);
+  unsigned long minutes = argc > 1 ? strtoul(argv[1], NULL, 10) : 70;
+  if (minutes <= LEARN_MILLIS / 60000) {
+    minutes = LEARN_MILLIS / 60000 + 1;
+  }
+
+  std::vector<Sensor> toggle1 = Run(false, 1, minutes);
+  std::vector<Sensor> toggle5 = Run(false, 5, minutes);
+  std::vector<Sensor> predicted = Run(true, 5, minutes);
+
+  bool ok = true;
+  printf("%-8s %6s %8s %7s %8s %8s %8s %9s %9s\n", "Sensor", "ID", "Rate", "Period", "Frames", "7m 1t", "7m 5t",
+    "15m 5t", "Estimate");
+  for (size_t i = 0; i < predicted.size(); i++) {
+    const Sensor &sensor = predicted[i];
+    unsigned long estimate = GetPercent(RatePlanner::GetCaptured(sensor.Protocol, sensor.ID),
+      RatePlanner::GetExpected(sensor.Protocol, sensor.ID));
+    printf("%-8s %6u %8lu %7lu %8lu %7lu%% %7lu%% %8lu%% %8lu%%\n", sensor.Name, sensor.ID, sensor.DataRate,
+      sensor.Period, sensor.Sent, GetPercent(toggle1[i].Captured, toggle1[i].Sent),
+      GetPercent(toggle5[i].Captured, toggle5[i].Sent), GetPercent(sensor.Captured, sensor.Sent), estimate);
+    ok = ok && GetPercent(sensor.Captured, sensor.Sent) >= 90 && RatePlanner::GetPeriod(sensor.Protocol, sensor.ID) > 0;
+  }
+
+  Result sum1 = Sum(toggle1);
+  Result sum5 = Sum(toggle5);
+  Result sumPredicted = Sum(predicted);
+  printf("%-8s %6s %8s %7s %8lu %7lu%% %7lu%% %8lu%%\n", "Total", "", "", "", sumPredicted.Sent,
+    GetPercent(sum1.Captured, sum1.Sent), GetPercent(sum5.Captured, sum5.Sent),
+    GetPercent(sumPredicted.Captured, sumPredicted.Sent));
+  ok = ok && RatePlanner::GetCount() == predicted.size();
+
+  printf("\nFrames after the first %lu minutes, Estimate: capture ratio as q shows it for 15m\n", LEARN_MILLIS / 60000);
+  printf("%s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
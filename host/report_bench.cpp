@@ -0,0 +1,255 @@
+// report_bench.cpp
+//
+// Change-only reporting (<t,h,s>k, SensorTable) on a house full of sensors.
+// Every sensor sends every 4 s (TX29, with some jitter), the temperature
+// wanders by a tenth now and then, the humidity less often and now and then
+// a battery gets weak. The frames go through the decoders as in the sketch
+// and the bench counts the lines that come out.
+// For every frame without a line it checks that it had to be suppressed:
+// temperature and humidity within the deltas of the last line of that sensor,
+// the same battery flags and that line not older than the max silence (plus
+// the 4 s resolution of the table). With more sensors than the table holds
+// the evicted ones are reported again, which costs lines but no changes.
+// A WS1080 record whose rain value jumps to another one of all 65536 in
+// every frame checks that no change of the other fields is lost.
+//
+// Usage: report_bench [minutes]
+
+#include "Arduino.h"
+#include "LaCrosse.h"
+#include "TX38IT.h"
+#include "FrameRing.h"
+#include "SerialQueue.h"
+#include "SensorTable.h"
+#include "RecordWriter.h"
+
+#define SEND_INTERVAL 4000
+#define MAX_SENSORS 96
+// ID, tag and temperature, humidity, checksum and tick of the last report on the AVR
+#define ENTRY_SIZE_AVR 7
+
+struct Scenario {
+  const char *Name;
+  byte Sensors;
+  word MaxSilence;
+  byte TemperatureDelta;
+  byte HumidityDelta;
+};
+
+static const Scenario s_scenarios[] = {
+  { "Every frame (0k)", 64, 0, 0, 0 },
+  { "Any change, 300 s (0,0,300k)", 64, 300, 0, 0 },
+  { "0.2 C / 2 %, 300 s (2,2,300k)", 64, 300, 2, 2 },
+  { "0.5 C / 5 %, 600 s (5,5,600k)", 64, 600, 5, 5 },
+  { "80 sensors, 0.2 C / 2 %, 300 s", 80, 300, 2, 2 },
+};
+
+struct Sensor {
+  bool IsTX38IT;
+  byte ID;
+  int Temperature;
+  byte Humidity;
+  bool WeakBattery;
+  unsigned long NextFrame;
+
+  bool IsReported;
+  int ReportedTemperature;
+  byte ReportedHumidity;
+  bool ReportedWeakBattery;
+  unsigned long LastReport;
+};
+
+static Sensor s_sensors[MAX_SENSORS];
+static unsigned long s_random = 1;
+
+static unsigned long Random(unsigned long range) {
+  s_random = s_random * 1103515245UL + 12345;
+  return (s_random >> 8) % range;
+}
+
+// 64 TX29 (LaCrosse), then TX38IT with their own IDs (no humidity, 106)
+static void Setup(byte count) {
+  s_random = 1;
+  for (byte i = 0; i < count; i++) {
+    Sensor *sensor = &s_sensors[i];
+    memset(sensor, 0, sizeof(Sensor));
+    sensor->IsTX38IT = i >= 64;
+    sensor->ID = i % 64;
+    sensor->Temperature = 150 + Random(100);
+    sensor->Humidity = sensor->IsTX38IT ? 106 : 40 + Random(30);
+    sensor->NextFrame = Random(SEND_INTERVAL);
+  }
+}
+
+static void Drift(Sensor *sensor) {
+  unsigned long dice = Random(100);
+  if (dice < 15) {
+    sensor->Temperature++;
+  }
+  else if (dice < 30) {
+    sensor->Temperature--;
+  }
+  dice = sensor->IsTX38IT ? 100 : Random(100);
+  if (dice < 5 && sensor->Humidity < 95) {
+    sensor->Humidity++;
+  }
+  else if (dice < 10 && sensor->Humidity > 5) {
+    sensor->Humidity--;
+  }
+  if (Random(5000) == 0) {
+    sensor->WeakBattery = !sensor->WeakBattery;
+  }
+}
+
+static void Send(Sensor *sensor) {
+  byte payload[PAYLOADSIZE];
+  memset(payload, 0, sizeof(payload));
+  if (sensor->IsTX38IT) {
+    struct TX38IT::Frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.ID = sensor->ID;
+    frame.Temperature = sensor->Temperature;
+    frame.Humidity = sensor->Humidity;
+    frame.WeakBatteryFlag = sensor->WeakBattery;
+    TX38IT::EncodeFrame(&frame, payload);
+    TX38IT::TryHandleData(payload);
+  }
+  else {
+    struct LaCrosse::Frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.ID = sensor->ID;
+    frame.Temperature = sensor->Temperature;
+    frame.Humidity = sensor->Humidity;
+    frame.WeakBatteryFlag = sensor->WeakBattery;
+    LaCrosse::EncodeFrame(&frame, payload);
+    LaCrosse::TryHandleData(payload);
+  }
+  SerialQueue::Flush();
+}
+
+static int Difference(int a, int b) {
+  return a > b ? a - b : b - a;
+}
+
+// A suppressed frame must be within the deltas and the max silence
+static bool IsSuppressionValid(const Scenario *scenario, const Sensor *sensor) {
+  byte temperatureDelta = scenario->TemperatureDelta > 0 ? scenario->TemperatureDelta : 1;
+  byte humidityDelta = scenario->HumidityDelta > 0 ? scenario->HumidityDelta : 1;
+  unsigned long tick = 1UL << SENSOR_TABLE_TICK_SHIFT;
+  return sensor->IsReported
+    && Difference(sensor->Temperature, sensor->ReportedTemperature) < temperatureDelta
+    && Difference(sensor->Humidity, sensor->ReportedHumidity) < humidityDelta
+    && sensor->WeakBattery == sensor->ReportedWeakBattery
+    && millis() - sensor->LastReport < scenario->MaxSilence * 1000UL + tick;
+}
+
+static bool Run(const Scenario *scenario, unsigned long minutes) {
+  HostClock::SetMicros(0);
+  Serial.ClearOutput();
+  Setup(scenario->Sensors);
+  SensorTable::SetDeltas(scenario->TemperatureDelta, scenario->HumidityDelta);
+  SensorTable::Configure(scenario->MaxSilence);
+  SensorTable::ResetStatistics();
+
+  unsigned long frames = 0;
+  unsigned long lines = 0;
+  unsigned long errors = 0;
+  unsigned long longestSilence = 0;
+  unsigned long end = minutes * 60000UL;
+  while (millis() < end) {
+    Sensor *next = &s_sensors[0];
+    for (byte i = 1; i < scenario->Sensors; i++) {
+      if (s_sensors[i].NextFrame < next->NextFrame) {
+        next = &s_sensors[i];
+      }
+    }
+    HostClock::SetMicros(next->NextFrame * 1000);
+    SensorTable::Handle();
+
+    Drift(next);
+    unsigned long length = Serial.GetOutputLength();
+    Send(next);
+    frames++;
+
+    if (Serial.GetOutputLength() != length) {
+      lines++;
+      if (next->IsReported && millis() - next->LastReport > longestSilence) {
+        longestSilence = millis() - next->LastReport;
+      }
+      next->IsReported = true;
+      next->ReportedTemperature = next->Temperature;
+      next->ReportedHumidity = next->Humidity;
+      next->ReportedWeakBattery = next->WeakBattery;
+      next->LastReport = millis();
+    }
+    else if (!IsSuppressionValid(scenario, next)) {
+      errors++;
+    }
+    next->NextFrame += SEND_INTERVAL - 50 + Random(100);
+    Serial.ClearOutput();
+  }
+
+  // Without change-only reporting the table does not count
+  bool ok = errors == 0;
+  if (SensorTable::IsEnabled()) {
+    ok = ok && lines == SensorTable::GetReported() && frames - lines == SensorTable::GetSuppressed();
+  }
+  else {
+    ok = ok && lines == frames && SensorTable::GetReported() == 0;
+  }
+  printf("%-32s %8lu %8lu %10.1f%% %8.0f %7lu  %s\n", scenario->Name, frames, lines,
+    100.0 * (frames - lines) / frames, longestSilence / 1000.0, errors, ok ? "" : "<--");
+  return ok;
+}
+
+// Every rain value once, each one differs from the last in some bits of the
+// word and has to be reported
+static bool CheckFieldChanges() {
+  HostClock::SetMicros(0);
+  SensorTable::SetDeltas(0, 0);
+  SensorTable::Configure(SENSOR_TABLE_MAX_SILENCE);
+  SensorTable::ResetStatistics();
+
+  unsigned long missed = 0;
+  for (unsigned long i = 0; i <= 0xFFFF; i++) {
+    word rain = i * 40503;
+    byte buffer[RECORD_SIZE];
+    RecordWriter record(buffer, sizeof(buffer));
+    record.Add(RECORD_WS1080);
+    record.Add(7);
+    record.Add(0);
+    record.Add(RECORD_HAS_TEMPERATURE | RECORD_HAS_HUMIDITY | RECORD_HAS_RAIN);
+    record.AddWord(215);
+    record.Add(55);
+    record.AddWord(rain);
+    if (!SensorTable::IsReported(buffer, record.GetLength())) {
+      missed++;
+    }
+  }
+
+  printf("%-32s %8u %8lu %11s %8s %7lu  %s\n", "Rain value of every frame new", 0x10000, 0x10000 - missed, "", "",
+    missed, missed == 0 ? "" : "<--");
+  return missed == 0;
+}
+
+int main(int argc, char **argv) {
+  unsigned long minutes = argc > 1 ? strtoul(argv[1], NULL, 10) : 60;
+  if (minutes == 0) {
+    return 1;
+  }
+  Serial.EnableCapture(true);
+
+  bool ok = true;
+  printf("%-32s %8s %8s %11s %8s %7s\n", "Scenario", "Frames", "Lines", "Suppressed", "Silence", "Errors");
+  for (unsigned int i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); i++) {
+    ok = Run(&s_scenarios[i], minutes) && ok;
+  }
+  ok = CheckFieldChanges() && ok;
+
+  unsigned int tableSize = SENSOR_TABLE_SIZE * ENTRY_SIZE_AVR;
+  printf("\nSilence: longest time in s between two lines of a sensor\n");
+  printf("SensorTable: %u sensors, %u bytes RAM on the AVR\n", SENSOR_TABLE_SIZE, tableSize);
+  ok = ok && tableSize < 512;
+  printf("%s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
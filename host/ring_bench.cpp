@@ -0,0 +1,208 @@
+// ring_bench.cpp
+//
+// Stress for the FrameRing. Every frame carries its sequence number and a
+// CRC, so lost, duplicated and torn frames are detected.
+//
+// 1. Virtual clock: a simulated device commits a frame every 1/rate s, like
+//    the nIRQ handler would, and preempts loop(), which needs LOOP_MICROS per
+//    iteration and FRAME_MICROS per frame. Nothing may be lost.
+// 2. Threads: a producer thread against the consumer in the main thread on
+//    real cores, to check the lock-free protocol. The host scheduler is no
+//    MCU and may hold the consumer off for ms, so the producer waits for a
+//    free entry instead of dropping the frame. Every frame has to come
+//    through, the waits are only reported.
+//
+// Usage: ring_bench [frames per second] [seconds]
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "Arduino.h"
+#include "FrameRing.h"
+#include "CRC8.h"
+
+#define LOOP_MICROS 20
+#define FRAME_MICROS 50
+
+struct Statistics {
+  unsigned long Produced;
+  unsigned long Full;
+  unsigned long Consumed;
+  unsigned long OutOfOrder;
+  unsigned long Corrupted;
+  unsigned long Expected;
+  byte MaxCount;
+};
+
+static void FillPayload(byte *payload, unsigned long sequence) {
+  for (byte i = 0; i < PAYLOADSIZE - 1; i++) {
+    payload[i] = (byte)((sequence >> (8 * (i % 4))) + i);
+  }
+  payload[PAYLOADSIZE - 1] = CRC8::Calculate(payload, PAYLOADSIZE - 1);
+}
+
+// False when the ring is full
+static bool Produce(FrameRing *ring, unsigned long sequence, Statistics *statistics) {
+  FrameRing::Entry *entry = ring->GetWriteEntry();
+  if (entry) {
+    entry->Time = sequence;
+    entry->DataRate = 17241;
+    entry->Radio = 1;
+    FillPayload(entry->Payload, sequence);
+    ring->Commit();
+    statistics->Produced++;
+    return true;
+  }
+  statistics->Full++;
+  return false;
+}
+
+// Frames that did not fit into the ring are gaps, not errors of the ring
+static bool Consume(FrameRing *ring, Statistics *statistics) {
+  FrameRing::Entry *entry = ring->GetReadEntry();
+  if (entry == NULL) {
+    return false;
+  }
+
+  if (ring->GetCount() > statistics->MaxCount) {
+    statistics->MaxCount = ring->GetCount();
+  }
+
+  byte payload[PAYLOADSIZE];
+  FillPayload(payload, entry->Time);
+  if (memcmp(payload, entry->Payload, PAYLOADSIZE) != 0 || entry->Radio != 1) {
+    statistics->Corrupted++;
+  }
+  if (entry->Time < statistics->Expected) {
+    statistics->OutOfOrder++;
+  }
+  statistics->Expected = entry->Time + 1;
+  statistics->Consumed++;
+
+  ring->Release();
+  return true;
+}
+
+static void Print(const char *title, const Statistics *statistics) {
+  printf("%-14s %10lu %10lu %10lu %12lu %10lu %6u\n", title, statistics->Produced, statistics->Full,
+    statistics->Consumed, statistics->OutOfOrder, statistics->Corrupted, statistics->MaxCount);
+}
+
+
+// --- Virtual clock ---------------------------------------------------------------------------------------------------
+class FrameSource : public HostDevice {
+public:
+  FrameRing Ring;
+  Statistics Results;
+
+  FrameSource(unsigned long rate, unsigned long count) {
+    m_interval = 1000000UL / rate;
+    m_count = count;
+    m_sequence = 0;
+    m_next = micros() + m_interval;
+    memset(&Results, 0, sizeof(Results));
+  }
+
+  bool IsDone() {
+    return m_sequence >= m_count;
+  }
+
+  bool GetNextEventTime(unsigned long *time) {
+    *time = m_next;
+    return !IsDone();
+  }
+
+  void Update(unsigned long now) {
+    Produce(&Ring, m_sequence++, &Results);
+    m_next += m_interval;
+  }
+
+private:
+  unsigned long m_interval;
+  unsigned long m_count;
+  unsigned long m_sequence;
+  unsigned long m_next;
+};
+
+static Statistics RunVirtual(unsigned long rate, unsigned long count) {
+  HostClock::SetMicros(0);
+  FrameSource source(rate, count);
+  HostDevice::Register(&source);
+
+  while (!source.IsDone() || !source.Ring.IsEmpty()) {
+    HostClock::AdvanceMicros(LOOP_MICROS);
+    if (Consume(&source.Ring, &source.Results)) {
+      HostClock::AdvanceMicros(FRAME_MICROS);
+    }
+  }
+
+  HostDevice::Unregister(&source);
+  return source.Results;
+}
+
+
+// --- Threads ---------------------------------------------------------------------------------------------------------
+static FrameRing s_ring;
+static std::atomic<bool> s_producerDone(false);
+
+static void ProduceThread(unsigned long rate, unsigned long count, Statistics *statistics) {
+  std::chrono::nanoseconds interval(1000000000UL / rate);
+  std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+
+  for (unsigned long sequence = 0; sequence < count; sequence++) {
+    next += interval;
+    std::this_thread::sleep_until(next);
+    while (!Produce(&s_ring, sequence, statistics)) {
+      std::this_thread::yield();
+    }
+  }
+  s_producerDone = true;
+}
+
+static Statistics RunThreads(unsigned long rate, unsigned long count) {
+  Statistics produced;
+  Statistics consumed;
+  memset(&produced, 0, sizeof(produced));
+  memset(&consumed, 0, sizeof(consumed));
+
+  std::thread producer(ProduceThread, rate, count, &produced);
+  for (;;) {
+    bool done = s_producerDone;
+    if (!Consume(&s_ring, &consumed)) {
+      if (done) {
+        break;
+      }
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  consumed.Produced = produced.Produced;
+  consumed.Full = produced.Full;
+  return consumed;
+}
+
+
+int main(int argc, char **argv) {
+  unsigned long rate = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+  unsigned long seconds = argc > 2 ? strtoul(argv[2], NULL, 10) : 2;
+  if (rate == 0 || rate > 1000000) {
+    return 1;
+  }
+  unsigned long count = rate * seconds;
+
+  printf("FrameRing, %d entries, %lu frames/s for %lu s\n", FRAME_RING_SIZE, rate, seconds);
+  printf("%-14s %10s %10s %10s %12s %10s %6s\n", "", "Produced", "Ring full", "Consumed", "Out of order", "Corrupted", "Max");
+
+  Statistics virtualClock = RunVirtual(rate, count);
+  Print("Virtual clock", &virtualClock);
+  Statistics threads = RunThreads(rate, count);
+  Print("Threads", &threads);
+
+  bool ok = virtualClock.Full == 0 && virtualClock.Consumed == count
+    && virtualClock.OutOfOrder == 0 && virtualClock.Corrupted == 0
+    && threads.Produced == count && threads.Consumed == count && threads.OutOfOrder == 0 && threads.Corrupted == 0;
+  printf("\nRing full: frames dropped on the virtual clock, retries of the producer thread\n");
+  printf("%s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+// rx_bench.cpp
+//
+// Frame loss of the receive path on a simulated RFM12 (RFM12Sim).
+// LaCrosse frames are put on air at random intervals while the receive loop
+// of the sketch runs with its real costs: serial output at 57600 baud, the
+// activity LED, the InternalSensors on a simulated BMP180 and the SPI transfers.
+// The same schedule is received by polling, by polling as before
+// RestartReceiver and the non-blocking LED ("Before": the receiver switched
+// off while a frame is handled, 100 ms of blinking in that time and the old
+// ClearFifo() when it is switched on again) and on nIRQ, with the bit-banged
+// and with the hardware SPI.
+// "LED" counts the frames that were received while the activity LED of an
+// earlier frame was still blinking.
+//
+// Usage: rx_bench [frames]
+
+#include "Arduino.h"
+#include "RFM.h"
+#include "SpiTransport.h"
+#include "RFM12Sim.h"
+#include "LaCrosse.h"
+#include "JeeLink.h"
+#include "FrameDispatcher.h"
+#include "InternalSensors.h"
+#include "BMP180Sim.h"
+#include "SerialQueue.h"
+
+#define PIN_MOSI 11
+#define PIN_MISO 12
+#define PIN_SCK  13
+#define PIN_SS   10
+#define PIN_IRQ  2
+
+// Serial.available(), the data rate toggle and the other cheap parts of loop()
+#define LOOP_MICROS 20
+
+// Estimated for an ATmega328 at 16 MHz: digitalWrite() and one setb/clrb of
+// the RFM port macros (they look up port and mask every time)
+#define DIGITAL_WRITE_NANOS 3500
+#define PORT_WRITE_NANOS 1500
+
+#define LACROSSE_FRAME_LENGTH 5
+
+struct Scenario {
+  const char *Name;
+  unsigned long MinGap;
+  unsigned long MaxGap;
+};
+
+static const Scenario s_scenarios[] = {
+  { "20 sensors (gap 20..380 ms)", 20, 380 },
+  { "dense (gap 10..90 ms)", 10, 90 },
+};
+
+struct Result {
+  unsigned long Received;
+  unsigned long DuringBlink;
+  unsigned long Lost;
+  unsigned long Missed;
+  unsigned long Overflows;
+  unsigned long DeafMicros;
+  unsigned long Duration;
+};
+
+static byte (*s_frames)[LACROSSE_FRAME_LENGTH];
+static unsigned long *s_starts;
+static unsigned long s_frameCount;
+static unsigned long s_nextExpected;
+static unsigned long s_received;
+static unsigned long s_duringBlink;
+static JeeLink s_jeeLink;
+static unsigned long s_random = 1;
+
+static unsigned long Random(unsigned long min, unsigned long max) {
+  s_random = s_random * 1103515245UL + 12345;
+  return min + (s_random >> 8) % (max - min + 1);
+}
+
+static void BuildSchedule(const Scenario *scenario) {
+  s_random = 1;
+  unsigned long start = 100000;
+  for (unsigned long i = 0; i < s_frameCount; i++) {
+    struct LaCrosse::Frame frame;
+    frame.ID = i % 64;
+    frame.NewBatteryFlag = false;
+    frame.Bit12 = false;
+    frame.Temperature = (i / 64) % 80 * 10 - 200 + i % 10;
+    frame.WeakBatteryFlag = false;
+    frame.Humidity = 20 + i % 70;
+    LaCrosse::EncodeFrame(&frame, s_frames[i]);
+
+    start += Random(scenario->MinGap, scenario->MaxGap) * 1000;
+    s_starts[i] = start;
+  }
+}
+
+// Frames are delivered in order, so a match is searched from the last one on
+static void CountFrame(byte *payload) {
+  for (unsigned long i = s_nextExpected; i < s_frameCount && i < s_nextExpected + 256; i++) {
+    if (memcmp(payload, s_frames[i], LACROSSE_FRAME_LENGTH) == 0) {
+      s_received++;
+      s_nextExpected = i + 1;
+      break;
+    }
+  }
+}
+
+// EnableReceiver(true) of the RFM12 before RestartReceiver: receiver on, sync
+// restarted and ClearFifo() with a FIFO read per byte of PAYLOADSIZE
+static void EnableReceiverBefore(RFM *rfm) {
+  rfm->SetHFParameter((unsigned short)0x82C8);
+  rfm->SetHFParameter((unsigned short)0xCA81);
+  rfm->SetHFParameter((unsigned short)0xCA83);
+  for (byte i = 0; i < PAYLOADSIZE; i++) {
+    rfm->SetHFParameter((unsigned short)0xB000);
+  }
+}
+
+// Same as HandleReceivedData of the sketch, or with pauseReceiver as it was
+// before RestartReceiver and the non-blocking LED
+static void HandleReceivedData(RFM *rfm, bool pauseReceiver) {
+  if (pauseReceiver) {
+    rfm->EnableReceiver(false);
+  }
+
+  FrameRing::Entry *frame = rfm->GetFrame();
+  byte *payload = frame->Payload;
+
+  bool blinking = s_jeeLink.IsBlinking();
+  if (pauseReceiver) {
+    // JeeLink::Blink(1) was LED on, delay(50), LED off, delay(50)
+    delay(100);
+  }
+  else {
+    s_jeeLink.Blink(1);
+  }
+  byte frameLength = FrameDispatcher::TryHandleData(payload, frame->DataRate);
+  if (frameLength > 0) {
+    unsigned long received = s_received;
+    CountFrame(payload);
+    if (blinking && s_received > received) {
+      s_duringBlink++;
+    }
+  }
+
+  rfm->ReleaseFrame();
+
+  if (pauseReceiver) {
+    EnableReceiverBefore(rfm);
+  }
+  else if (!rfm->IsInterruptDriven()) {
+    rfm->RestartReceiver();
+  }
+}
+
+static Result Run(byte irq, bool pauseReceiver, bool hardwareSpi) {
+  Result result;
+  HostClock::SetMicros(0);
+
+  RFM12Sim sim(PIN_MOSI, PIN_MISO, PIN_SCK, PIN_SS, PIN_IRQ);
+  HostDevice::Register(&sim);
+
+  BitBangSpi bitBang(PIN_MOSI, PIN_MISO, PIN_SCK, PIN_SS);
+  HardwareSpi hardware(PIN_SS);
+  RFM rfm(hardwareSpi ? (SpiTransport *)&hardware : (SpiTransport *)&bitBang, irq);
+  rfm.Begin(1);
+  rfm.InitializeLaCrosse();
+  rfm.SetFrequency(868300);
+  rfm.SetDataRate(17241);
+  rfm.EnableReceiver(true);
+
+  s_nextExpected = 0;
+  s_received = 0;
+  s_duringBlink = 0;
+  unsigned long scheduled = 0;
+  BMP180Sim bmp;
+  Wire.Attach(BMP180_ADDRESS, &bmp);
+  InternalSensors internalSensors;
+  internalSensors.TryInitializeBMP180();
+  unsigned long end = s_starts[s_frameCount - 1] + 1000000;
+
+  while ((long)(micros() - end) < 0) {
+    // Keep the queue of the simulator filled
+    while (scheduled < s_frameCount && (long)(s_starts[scheduled] - micros()) < 2000000) {
+      if (!sim.Schedule(s_starts[scheduled], s_frames[scheduled], LACROSSE_FRAME_LENGTH, 17241)) {
+        break;
+      }
+      scheduled++;
+    }
+
+    HostClock::AdvanceMicros(LOOP_MICROS);
+    SerialQueue::Handle();
+    s_jeeLink.Handle();
+
+    internalSensors.TryHandleData();
+
+    rfm.Receive();
+    if (rfm.PayloadIsReady()) {
+      HandleReceivedData(&rfm, pauseReceiver);
+    }
+  }
+
+  result.Received = s_received;
+  result.DuringBlink = s_duringBlink;
+  result.Lost = rfm.GetLostFrames();
+  result.Missed = sim.GetMissedFrames();
+  result.Overflows = sim.GetOverflows();
+  result.DeafMicros = sim.GetDeafMicros(micros());
+  result.Duration = micros();
+
+  Wire.Detach(BMP180_ADDRESS);
+  detachInterrupt(0);
+  HostDevice::Unregister(&sim);
+  return result;
+}
+
+static void Print(const char *mode, const Result *result) {
+  printf("%-12s %8lu %9lu %6.1f%% %6lu %6lu %8lu %10lu %6.1f%%\n", mode, s_frameCount, result->Received,
+    100.0 * (s_frameCount - result->Received) / s_frameCount, result->DuringBlink, result->Lost, result->Missed, result->Overflows,
+    100.0 * result->DeafMicros / result->Duration);
+}
+
+int main(int argc, char **argv) {
+  s_frameCount = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000;
+  if (s_frameCount == 0) {
+    return 1;
+  }
+  s_frames = new byte[s_frameCount][LACROSSE_FRAME_LENGTH];
+  s_starts = new unsigned long[s_frameCount];
+
+  Serial.begin(57600);
+  Serial.EnableCapture(false);
+  Serial.SimulateTiming(true);
+  HostClock::SetPinWriteCost(DIGITAL_WRITE_NANOS, PORT_WRITE_NANOS);
+
+  for (unsigned int i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); i++) {
+    BuildSchedule(&s_scenarios[i]);
+    printf("\n%s\n", s_scenarios[i].Name);
+    printf("%-12s %8s %9s %7s %6s %6s %8s %10s %7s\n", "Mode", "Sent", "Received", "Loss", "LED", "Lost", "Missed", "Overflows", "Deaf");
+    Result before = Run(RFM_NO_IRQ, true, false);
+    Print("Before", &before);
+    Result polling = Run(RFM_NO_IRQ, false, false);
+    Print("Polling", &polling);
+    Result interrupt = Run(PIN_IRQ, false, false);
+    Print("nIRQ", &interrupt);
+    Result pollingSpi = Run(RFM_NO_IRQ, false, true);
+    Print("Polling SPI", &pollingSpi);
+    Result interruptSpi = Run(PIN_IRQ, false, true);
+    Print("nIRQ SPI", &interruptSpi);
+  }
+  printf("\nLost: counted by RFM, Missed: on air while the receiver was deaf, Overflows: RFM12 FIFO overruns\n");
+
+  delete[] s_frames;
+  delete[] s_starts;
+  return 0;
+}
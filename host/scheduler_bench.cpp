@@ -0,0 +1,199 @@
+// scheduler_bench.cpp
+//
+// The tasks of loop() on the virtual clock, once in the fixed order of the
+// old loop() (every task in every pass) and once with the Scheduler. The
+// tasks cost what they take on the target; now and then the BMP180 task
+// reads a conversion (1.5 ms), the aggregator sends a line (2 ms) and the
+// serial task pushes a line into the UART (1 ms). Frames arrive at random
+// every 2 to 6 ms; the radio holds one frame, a frame that is not drained
+// before the next one has arrived is lost.
+// The bench reports the frames lost, the longest gap between two polls of
+// the radio and what the Scheduler measured per task. With the Scheduler no
+// frame may be lost, the radio gap must stay below the slowest task plus
+// the radio itself, and the periodic tasks must run at their period.
+//
+// Usage: scheduler_bench [seconds]
+
+#include "Arduino.h"
+#include "Scheduler.h"
+
+#define RADIO_MICROS 40
+#define FRAME_MICROS 300
+
+static unsigned long s_nextFrame;
+static bool s_isFrameWaiting;
+static unsigned long s_received;
+static unsigned long s_lost;
+static unsigned long s_passes;
+static unsigned long s_maxGap;
+static unsigned long s_lastPoll;
+
+// The frames that arrived since the last poll, all but the last one are lost
+static void ArriveFrames() {
+  while ((long)(micros() - s_nextFrame) >= 0) {
+    if (s_isFrameWaiting) {
+      s_lost++;
+    }
+    s_isFrameWaiting = true;
+    s_nextFrame += 2000 + rand() % 4000;
+  }
+}
+
+static void Radio() {
+  ArriveFrames();
+  unsigned long gap = micros() - s_lastPoll;
+  if (gap > s_maxGap) {
+    s_maxGap = gap;
+  }
+  HostClock::AdvanceMicros(RADIO_MICROS);
+  if (s_isFrameWaiting) {
+    s_isFrameWaiting = false;
+    s_received++;
+    HostClock::AdvanceMicros(FRAME_MICROS);
+  }
+  s_lastPoll = micros();
+}
+
+static unsigned long s_serialCalls;
+static void Output() {
+  HostClock::AdvanceMicros(++s_serialCalls % 50 == 0 ? 1000 : 15);
+}
+
+static void Commands() {
+  HostClock::AdvanceMicros(20);
+}
+
+static unsigned long s_dataRateCalls;
+static void DataRate() {
+  s_dataRateCalls++;
+  HostClock::AdvanceMicros(10);
+}
+
+static void HostLink() {
+  HostClock::AdvanceMicros(5);
+}
+
+static void LED() {
+  HostClock::AdvanceMicros(5);
+}
+
+static unsigned long s_bmpCalls;
+static void BMP180() {
+  HostClock::AdvanceMicros(++s_bmpCalls % 200 == 0 ? 1500 : 25);
+}
+
+static unsigned long s_aggregateCalls;
+static void Aggregate() {
+  HostClock::AdvanceMicros(++s_aggregateCalls % 100 == 0 ? 2000 : 30);
+}
+
+static unsigned long s_tableCalls;
+static void Table() {
+  s_tableCalls++;
+  HostClock::AdvanceMicros(400);
+}
+
+struct Result {
+  unsigned long Received;
+  unsigned long Lost;
+  unsigned long MaxGap;
+  unsigned long Passes;
+};
+
+static void Reset() {
+  HostClock::SetMicros(0);
+  srand(1);
+  s_nextFrame = 3000;
+  s_isFrameWaiting = false;
+  s_received = s_lost = s_passes = s_maxGap = 0;
+  s_lastPoll = 0;
+  s_serialCalls = s_dataRateCalls = s_bmpCalls = s_aggregateCalls = s_tableCalls = 0;
+}
+
+static Result GetResult() {
+  Result result;
+  result.Received = s_received;
+  result.Lost = s_lost;
+  result.MaxGap = s_maxGap;
+  result.Passes = s_passes;
+  return result;
+}
+
+// The old loop(): everything in every pass
+static Result RunFixed(unsigned long seconds) {
+  Reset();
+  unsigned long lastTable = 0;
+  while (micros() < seconds * 1000000UL) {
+    Commands();
+    Output();
+    BMP180();
+    LED();
+    HostLink();
+    if (millis() - lastTable >= 1000) {
+      lastTable = millis();
+      Table();
+    }
+    Aggregate();
+    Radio();
+    DataRate();
+    s_passes++;
+  }
+  return GetResult();
+}
+
+static Result RunScheduled(unsigned long seconds) {
+  Reset();
+  //             Name            Function   Period Deadline Priority (ms)
+  Scheduler::Add(F("Radio"),     Radio,     0,     0,       TASK_PRIORITY_RADIO);
+  Scheduler::Add(F("Serial"),    Output,    1,     1,       1);
+  Scheduler::Add(F("Commands"),  Commands,  1,     5,       1);
+  Scheduler::Add(F("DataRate"),  DataRate,  100,   100,     2);
+  Scheduler::Add(F("HostLink"),  HostLink,  100,   500,     2);
+  Scheduler::Add(F("LED"),       LED,       10,    20,      3);
+  Scheduler::Add(F("BMP180"),    BMP180,    5,     20,      3);
+  Scheduler::Add(F("Aggregate"), Aggregate, 10,    100,     3);
+  Scheduler::Add(F("Table"),     Table,     1000,  1000,    3);
+  while (micros() < seconds * 1000000UL) {
+    Scheduler::Run();
+    s_passes++;
+  }
+  return GetResult();
+}
+
+int main(int argc, char **argv) {
+  Serial.EnableCapture(false);
+  unsigned long seconds = argc > 1 ? strtoul(argv[1], NULL, 10) : 60;
+
+  Result fixed = RunFixed(seconds);
+  Result scheduled = RunScheduled(seconds);
+
+  printf("%-12s %8s %6s %8s %12s\n", "loop()", "Frames", "Lost", "Passes", "Radio gap us");
+  printf("%-12s %8lu %6lu %8lu %12lu\n", "fixed order", fixed.Received + fixed.Lost, fixed.Lost, fixed.Passes,
+    fixed.MaxGap);
+  printf("%-12s %8lu %6lu %8lu %12lu\n", "Scheduler", scheduled.Received + scheduled.Lost, scheduled.Lost,
+    scheduled.Passes, scheduled.MaxGap);
+
+  printf("\n%-10s %9s %10s %10s\n", "Task", "Runs", "Run us", "Late us");
+  unsigned long maxRunTime = 0;
+  for (byte i = 0; i < Scheduler::GetTaskCount(); i++) {
+    // A flash string is a plain one on the host
+    printf("%-10s %9lu %10u %10u\n", reinterpret_cast<const char *>(Scheduler::GetName(i)), Scheduler::GetRuns(i),
+      Scheduler::GetMaxRunTime(i), Scheduler::GetMaxLateness(i));
+    if (i > 0 && Scheduler::GetMaxRunTime(i) > maxRunTime) {
+      maxRunTime = Scheduler::GetMaxRunTime(i);
+    }
+  }
+
+  // The radio waits for one task at most, the periodic ones keep their period
+  bool ok = scheduled.Lost == 0 && scheduled.MaxGap <= maxRunTime + RADIO_MICROS + FRAME_MICROS;
+  ok = ok && Scheduler::GetRuns(0) == scheduled.Passes;
+  ok = ok && s_tableCalls >= seconds - 1 && s_tableCalls <= seconds + 1;
+  ok = ok && s_dataRateCalls >= seconds * 10 - 10 && s_dataRateCalls <= seconds * 10 + 1;
+
+  Scheduler::ResetStatistics();
+  ok = ok && Scheduler::GetRuns(0) == 0 && Scheduler::GetMaxRunTime(0) == 0 && Scheduler::GetMaxLateness(0) == 0;
+
+  printf("\nRadio gap: longest time between two polls of the radio\n");
+  printf("%s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+// serial_bench.cpp
+//
+// The receive loop of rx_bench behind a slow UART. LaCrosse frames come in
+// on a simulated RFM12 faster than their lines can go out, once as "OK 9"
+// lines and once as payload lines (<1>p, 64 bytes in hex). The radio is
+// polled like the second RFM of the sketch, so while loop() is held up it
+// is deaf.
+// "Blocking" waits for the TX buffer of the core after every frame, as the
+// decoders did with Serial.println(); "Queued" leaves the lines in the
+// SerialQueue and loop() passes on only what fits.
+// The queued run has to account for every frame: it is either a complete
+// line on the wire or counted as dropped.
+//
+// Usage: serial_bench [frames]
+
+#include "Arduino.h"
+#include "RFM.h"
+#include "SpiTransport.h"
+#include "RFM12Sim.h"
+#include "LaCrosse.h"
+#include "LineWriter.h"
+#include "FrameDispatcher.h"
+#include "SerialQueue.h"
+
+#define PIN_SS   10
+#define PIN_IRQ  2
+
+#define LOOP_MICROS 20
+#define LACROSSE_FRAME_LENGTH 5
+
+struct Scenario {
+  const char *Name;
+  unsigned long Baud;
+  bool PassPayload;
+  unsigned long MinGap;
+  unsigned long MaxGap;
+};
+
+static const Scenario s_scenarios[] = {
+  { "57600 baud, dense (gap 10..90 ms)", 57600, false, 10, 90 },
+  { "9600 baud, dense (gap 10..90 ms)", 9600, false, 10, 90 },
+  { "9600 baud, payload lines (gap 10..90 ms)", 9600, true, 10, 90 },
+  { "57600 baud, payload lines (gap 10..90 ms)", 57600, true, 10, 90 },
+};
+
+struct Result {
+  unsigned long Received;
+  unsigned long Missed;
+  unsigned long Lines;
+  unsigned long BrokenLines;
+  unsigned long Dropped;
+  word HighWaterMark;
+  unsigned long LongestStall;
+};
+
+static byte (*s_frames)[LACROSSE_FRAME_LENGTH];
+static unsigned long *s_starts;
+static unsigned long s_frameCount;
+static unsigned long s_random = 1;
+
+static unsigned long Random(unsigned long min, unsigned long max) {
+  s_random = s_random * 1103515245UL + 12345;
+  return min + (s_random >> 8) % (max - min + 1);
+}
+
+static void BuildSchedule(const Scenario *scenario) {
+  s_random = 1;
+  unsigned long start = 100000;
+  for (unsigned long i = 0; i < s_frameCount; i++) {
+    struct LaCrosse::Frame frame;
+    frame.ID = i % 64;
+    frame.NewBatteryFlag = false;
+    frame.Bit12 = false;
+    frame.Temperature = (i / 64) % 80 * 10 - 200 + i % 10;
+    frame.WeakBatteryFlag = false;
+    frame.Humidity = 20 + i % 70;
+    LaCrosse::EncodeFrame(&frame, s_frames[i]);
+
+    start += Random(scenario->MinGap, scenario->MaxGap) * 1000;
+    s_starts[i] = start;
+  }
+}
+
+// Same as SendPayload and AddPayload of the sketch
+static void AddPayload(byte *payload, LineWriter *line) {
+  for (int i = 0; i < PAYLOADSIZE; i++) {
+    line->AddHex(payload[i]);
+    line->Add(' ');
+  }
+}
+
+static void SendPayload(byte *payload) {
+  LineWriter counter(false);
+  AddPayload(payload, &counter);
+  if (SerialQueue::Reserve(counter.GetLength() + 2)) {
+    LineWriter line(true);
+    AddPayload(payload, &line);
+    SerialQueue::Put('\r');
+    SerialQueue::Put('\n');
+    SerialQueue::Handle();
+  }
+}
+
+// A complete line is an "OK 9" line with 5 numbers or 64 hex bytes
+static void CountLines(Result *result, bool passPayload) {
+  const char *output = Serial.GetOutput();
+  unsigned long length = Serial.GetOutputLength();
+  unsigned long start = 0;
+  for (unsigned long i = 0; i + 1 < length; i++) {
+    if (output[i] != '\r' || output[i + 1] != '\n') {
+      continue;
+    }
+    int fields = 0;
+    for (unsigned long c = start; c < i; c++) {
+      if (output[c] == ' ') {
+        fields++;
+      }
+    }
+    bool isComplete = passPayload ? fields == PAYLOADSIZE : fields == 6 && strncmp(output + start, "OK 9 ", 5) == 0;
+    result->Lines++;
+    if (!isComplete) {
+      result->BrokenLines++;
+    }
+    start = i + 2;
+  }
+  if (start != length) {
+    result->BrokenLines++;
+  }
+}
+
+static Result Run(const Scenario *scenario, bool queued) {
+  Result result;
+  memset(&result, 0, sizeof(result));
+  HostClock::SetMicros(0);
+  Serial.begin(scenario->Baud);
+  Serial.ClearOutput();
+  SerialQueue::ResetStatistics();
+
+  RFM12Sim sim(11, 12, 13, PIN_SS, PIN_IRQ);
+  HostDevice::Register(&sim);
+
+  HardwareSpi spi(PIN_SS);
+  RFM rfm(&spi);
+  rfm.Begin(1);
+  rfm.InitializeLaCrosse();
+  rfm.SetFrequency(868300);
+  rfm.SetDataRate(17241);
+  rfm.EnableReceiver(true);
+
+  unsigned long scheduled = 0;
+  unsigned long end = s_starts[s_frameCount - 1] + 1000000;
+
+  while ((long)(micros() - end) < 0) {
+    while (scheduled < s_frameCount && (long)(s_starts[scheduled] - micros()) < 2000000) {
+      if (!sim.Schedule(s_starts[scheduled], s_frames[scheduled], LACROSSE_FRAME_LENGTH, 17241)) {
+        break;
+      }
+      scheduled++;
+    }
+
+    HostClock::AdvanceMicros(LOOP_MICROS);
+    SerialQueue::Handle();
+
+    rfm.Receive();
+    if (rfm.PayloadIsReady()) {
+      unsigned long start = micros();
+      FrameRing::Entry *frame = rfm.GetFrame();
+      if (scenario->PassPayload) {
+        SendPayload(frame->Payload);
+        result.Received++;
+      }
+      else if (FrameDispatcher::TryHandleData(frame->Payload, frame->DataRate) > 0) {
+        result.Received++;
+      }
+      if (!queued) {
+        SerialQueue::Flush();
+      }
+      rfm.ReleaseFrame();
+      if (micros() - start > result.LongestStall) {
+        result.LongestStall = micros() - start;
+      }
+    }
+  }
+  SerialQueue::Flush();
+
+  result.Missed = sim.GetMissedFrames();
+  result.Dropped = SerialQueue::GetDroppedLines();
+  result.HighWaterMark = SerialQueue::GetHighWaterMark();
+  CountLines(&result, scenario->PassPayload);
+
+  HostDevice::Unregister(&sim);
+  return result;
+}
+
+static bool Print(const char *mode, const Result *result) {
+  printf("%-10s %8lu %9lu %7lu %7lu %8lu %7u %12lu\n", mode, s_frameCount, result->Received, result->Missed,
+    result->Lines, result->Dropped, result->HighWaterMark, result->LongestStall);
+  return result->BrokenLines == 0 && result->Lines + result->Dropped == result->Received;
+}
+
+int main(int argc, char **argv) {
+  s_frameCount = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000;
+  if (s_frameCount == 0) {
+    return 1;
+  }
+  s_frames = new byte[s_frameCount][LACROSSE_FRAME_LENGTH];
+  s_starts = new unsigned long[s_frameCount];
+
+  Serial.SimulateTiming(true);
+
+  bool ok = true;
+  for (unsigned int i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); i++) {
+    BuildSchedule(&s_scenarios[i]);
+    printf("\n%s\n", s_scenarios[i].Name);
+    printf("%-10s %8s %9s %7s %7s %8s %7s %12s\n", "Mode", "Sent", "Received", "Missed", "Lines", "Dropped", "Queue",
+      "Longest us");
+    Result blocking = Run(&s_scenarios[i], false);
+    ok = Print("Blocking", &blocking) && ok;
+    Result queued = Run(&s_scenarios[i], true);
+    ok = Print("Queued", &queued) && ok;
+  }
+  printf("\nQueue: high-water mark of the SerialQueue (%d bytes), Longest: longest time a frame held up loop()\n",
+    SERIAL_QUEUE_SIZE);
+  printf("%s\n", ok ? "OK" : "FAILED");
+
+  delete[] s_frames;
+  delete[] s_starts;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+// spi_bench.cpp
+//
+// Cost of the radio bus with the bit-banged and the hardware SPI transport.
+// The same RFM operations run against a simulated RFM12 and RFM69 and a bus
+// monitor counts the SCK cycles and chip selects. The time comes from the
+// virtual clock, with the pin write costs of rx_bench for bit-banging and the
+// SCK of the radio (RFM12_SPI_CLOCK / RFM69_SPI_CLOCK) for the hardware.
+// The RFM69 gets a 64 byte payload, of which only the frame has to be read.
+//
+// Usage: spi_bench [operations]
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "RFM.h"
+#include "SpiTransport.h"
+#include "RFM12Sim.h"
+#include "RFM69Sim.h"
+
+#define PIN_MOSI 11
+#define PIN_MISO 12
+#define PIN_SCK  13
+#define PIN_SS   10
+#define PIN_IRQ  2
+
+#define DIGITAL_WRITE_NANOS 3500
+#define PORT_WRITE_NANOS 1500
+
+// Counts what is on the bus, whoever drives it
+class BusMonitor : public HostDevice {
+public:
+  unsigned long Clocks;
+  unsigned long Selects;
+
+  BusMonitor() {
+    Clocks = 0;
+    Selects = 0;
+    m_sck = LOW;
+    m_ss = HIGH;
+  }
+
+  void OnPinWrite(uint8_t pin, uint8_t value) {
+    if (pin == PIN_SCK) {
+      if (value && !m_sck) {
+        Clocks++;
+      }
+      m_sck = value;
+    }
+    else if (pin == PIN_SS) {
+      if (!value && m_ss) {
+        Selects++;
+      }
+      m_ss = value;
+    }
+  }
+
+private:
+  uint8_t m_sck;
+  uint8_t m_ss;
+};
+
+struct Result {
+  double Micros;
+  double Clocks;
+  double Selects;
+};
+
+enum Operation {
+  Rfm12Command,
+  Rfm12Poll,
+  Rfm69RegisterWrite,
+  Rfm69Poll,
+  Rfm69LaCrosseFrame,
+  Rfm69TX22ITFrame,
+  Rfm69UnknownFrame
+};
+
+static const char *s_operationNames[] = {
+  "RFM12 command",
+  "RFM12 poll",
+  "RFM69 register write",
+  "RFM69 poll",
+  "RFM69 LaCrosse frame",
+  "RFM69 TX22IT frame",
+  "RFM69 unknown frame"
+};
+
+struct TestFrame {
+  unsigned long DataRate;
+  byte Length;
+  byte Data[8];
+};
+
+// The header decides the length, the rest of the 64 bytes is noise
+static const TestFrame s_testFrames[] = {
+  { 17241, 5, { 0x9A, 0x26, 0x66, 0x6A, 0x91 } },
+  { 8842, 9, { 0xA1, 0x83, 0x10, 0x42, 0x20, 0x55, 0x31, 0x07 } },
+  { 17241, PAYLOADSIZE, { 0x00, 0x12, 0x34 } },
+};
+
+static const TestFrame *GetTestFrame(Operation operation) {
+  return operation >= Rfm69LaCrosseFrame ? &s_testFrames[operation - Rfm69LaCrosseFrame] : NULL;
+}
+
+static void ReceiveFrame(Operation operation, RFM *rfm, RFM69Sim *rfm69) {
+  const TestFrame *frame = GetTestFrame(operation);
+  byte payload[PAYLOADSIZE];
+  byte expected[PAYLOADSIZE];
+  for (byte i = 0; i < PAYLOADSIZE; i++) {
+    payload[i] = i < sizeof(frame->Data) ? frame->Data[i] : (byte)(0x55 + i);
+    expected[i] = i < frame->Length ? payload[i] : 0;
+  }
+
+  rfm69->LoadPayload(payload, PAYLOADSIZE);
+  rfm->Receive();
+  if (!rfm->PayloadIsReady() || memcmp(rfm->GetFrame()->Payload, expected, PAYLOADSIZE) != 0
+    || rfm69->GetFifoCount() != 0) {
+    printf("%s: payload not received\n", s_operationNames[operation]);
+    exit(1);
+  }
+  rfm->ReleaseFrame();
+}
+
+static void Execute(Operation operation, RFM *rfm, RFM69Sim *rfm69) {
+  switch (operation) {
+    case Rfm12Command:
+      rfm->SetHFParameter((unsigned short)0xC481);
+      break;
+    case Rfm69RegisterWrite:
+      rfm->SetHFParameter(0x19, 0x4A);
+      break;
+    case Rfm69LaCrosseFrame:
+    case Rfm69TX22ITFrame:
+    case Rfm69UnknownFrame:
+      ReceiveFrame(operation, rfm, rfm69);
+      break;
+    default:
+      rfm->Receive();
+      break;
+  }
+}
+
+static Result Run(Operation operation, bool hardware, unsigned long count) {
+  HostClock::SetMicros(0);
+
+  bool isRfm69 = operation >= Rfm69RegisterWrite;
+  RFM12Sim rfm12(PIN_MOSI, PIN_MISO, PIN_SCK, PIN_SS, PIN_IRQ);
+  RFM69Sim rfm69(PIN_MOSI, PIN_MISO, PIN_SCK, PIN_SS);
+  HostDevice *radio = isRfm69 ? (HostDevice *)&rfm69 : (HostDevice *)&rfm12;
+  HostDevice::Register(radio);
+
+  BitBangSpi bitBang(PIN_MOSI, PIN_MISO, PIN_SCK, PIN_SS);
+  HardwareSpi hardwareSpi(PIN_SS);
+  SpiTransport *spi = hardware ? (SpiTransport *)&hardwareSpi : (SpiTransport *)&bitBang;
+
+  RFM rfm(spi);
+  rfm.Begin(1);
+  rfm.InitializeLaCrosse();
+  if (GetTestFrame(operation)) {
+    rfm.SetDataRate(GetTestFrame(operation)->DataRate);
+  }
+  rfm.EnableReceiver(true);
+
+  if ((rfm.GetRadioType() == RFM::RFM69CW) != isRfm69) {
+    printf("%s: wrong radio detected\n", s_operationNames[operation]);
+    exit(1);
+  }
+
+  BusMonitor monitor;
+  HostDevice::Register(&monitor);
+  unsigned long start = micros();
+  for (unsigned long i = 0; i < count; i++) {
+    Execute(operation, &rfm, &rfm69);
+  }
+
+  Result result;
+  result.Micros = (double)(micros() - start) / count;
+  result.Clocks = (double)monitor.Clocks / count;
+  result.Selects = (double)monitor.Selects / count;
+
+  HostDevice::Unregister(&monitor);
+  HostDevice::Unregister(radio);
+  return result;
+}
+
+int main(int argc, char **argv) {
+  unsigned long count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000;
+  if (count == 0) {
+    return 1;
+  }
+
+  HostClock::SetPinWriteCost(DIGITAL_WRITE_NANOS, PORT_WRITE_NANOS);
+
+  printf("%-24s %12s %12s %8s %8s %8s\n", "Operation", "Bit-bang us", "Hardware us", "Speedup", "SCK", "Selects");
+  for (int operation = Rfm12Command; operation <= Rfm69UnknownFrame; operation++) {
+    Result bitBang = Run((Operation)operation, false, count);
+    Result hardware = Run((Operation)operation, true, count);
+    if (bitBang.Clocks != hardware.Clocks || bitBang.Selects != hardware.Selects) {
+      printf("%s: the transports differ on the bus\n", s_operationNames[operation]);
+      return 1;
+    }
+    printf("%-24s %12.1f %12.1f %7.1fx %8.1f %8.1f\n", s_operationNames[operation], bitBang.Micros, hardware.Micros,
+      bitBang.Micros / hardware.Micros, hardware.Clocks, hardware.Selects);
+  }
+  return 0;
+}
@@ -0,0 +1,260 @@
+// tx_bench.cpp
+//
+// Sending while receiving. Two simulated RFM69 share the bus, radio 1
+// receives TX29 frames at 17.241 kbps from 20 sensors, radio 2 (if there is
+// one) receives at 9.579 kbps. Every frame radio 1 gets is relayed (<1>y)
+// and every 2 s an s command sends a frame of 10 bytes.
+// Before, both were sent on radio 1 from loop(): the relay after delay(64),
+// and SendArray() waits until the packet is out. Now they go through the
+// TransmitQueue, on radio 1 for a board with one radio and on radio 2 for a
+// board with two.
+// A frame is captured when radio 1 is receiving from the preamble to the end
+// of the frame. The bench reports the capture ratio and the receive time of
+// radio 1, the time radio 2 spent sending and the longest pass of loop().
+// The queue must never block loop() for more than a few ms, and with two
+// radios radio 1 has to receive at least 99.9 % of the time.
+//
+// Usage: tx_bench [minutes]
+
+#include <vector>
+#include "Arduino.h"
+#include "SPI.h"
+#include "RFM.h"
+#include "SpiTransport.h"
+#include "RFM69Sim.h"
+#include "TransmitQueue.h"
+
+#define PIN_MOSI 11
+#define PIN_MISO 12
+#define PIN_SCK  13
+#define PIN_SS1  10
+#define PIN_SS2  8
+
+#define SENSOR_COUNT 20
+#define FRAME_LENGTH 5
+// Preamble and sync word before the frame
+#define PREAMBLE_BYTES 5
+#define COMMAND_PERIOD 2000000ul
+// Rest of a pass of loop(): decoders, serial output, LED
+#define PASS_MICROS 200
+#define RELAY_DELAY 64
+
+enum Mode {
+  Blocking,
+  QueueRadio1,
+  QueueRadio2,
+  ModeCount
+};
+
+static const char *s_modeNames[ModeCount] = {
+  "1 radio, blocking (before)",
+  "1 radio, queue",
+  "2 radios, queue on radio 2",
+};
+
+struct Sensor {
+  unsigned long Period;
+  unsigned long Next;
+};
+
+// A frame on air, captured or not when its last bit is out
+struct Transmission {
+  size_t Sensor;
+  unsigned long Start;
+  unsigned long End;
+};
+
+struct Result {
+  unsigned long OnAir;
+  unsigned long Captured;
+  unsigned long Requested;
+  unsigned long Sent;
+  unsigned long ReceiveMillis;
+  unsigned long Millis;
+  unsigned long Radio2SendMillis;
+  unsigned long LongestPass;
+};
+
+static void BuildPayload(size_t sensor, byte *payload) {
+  memset(payload, 0, PAYLOADSIZE);
+  payload[0] = 0x90 | (sensor & 0x3F) >> 2;
+  payload[1] = (sensor & 3) << 6;
+}
+
+// The s command of the sketch before: radio 1 stops receiving for it
+static void SendBlocking(RFM *rfm, byte *data, byte length, unsigned long dataRate) {
+  rfm->EnableReceiver(false);
+  unsigned long currentDataRate = rfm->GetDataRate();
+  rfm->SetDataRate(dataRate);
+  rfm->SendArray(data, length);
+  rfm->SetDataRate(currentDataRate);
+  rfm->EnableReceiver(true);
+}
+
+static void Send(Mode mode, RFM *radio1, RFM *radio2, byte *data, byte length, unsigned long delayMillis) {
+  if (mode == Blocking) {
+    delay(delayMillis);
+    SendBlocking(radio1, data, length, 17241ul);
+  }
+  else {
+    TransmitQueue::Add(mode == QueueRadio2 ? radio2 : radio1, data, length, 17241ul, delayMillis);
+  }
+}
+
+static Result Run(Mode mode, unsigned long minutes) {
+  HostClock::SetMicros(0);
+  RFM69Sim sim1(PIN_MOSI, PIN_MISO, PIN_SCK, PIN_SS1);
+  RFM69Sim sim2(PIN_MOSI, PIN_MISO, PIN_SCK, PIN_SS2);
+  HostDevice::Register(&sim1);
+  if (mode == QueueRadio2) {
+    HostDevice::Register(&sim2);
+  }
+
+  HardwareSpi spi1(PIN_SS1);
+  HardwareSpi spi2(PIN_SS2);
+  RFM radio1(&spi1);
+  RFM radio2(&spi2);
+  radio1.Begin(1);
+  radio1.InitializeLaCrosse();
+  radio1.SetDataRate(17241ul);
+  radio1.EnableReceiver(true);
+  if (mode == QueueRadio2) {
+    radio2.Begin(2);
+    radio2.InitializeLaCrosse();
+    radio2.SetDataRate(9579ul);
+    radio2.EnableReceiver(true);
+    if (!radio2.IsConnected()) {
+      printf("radio 2 not found\n");
+      exit(1);
+    }
+  }
+  radio1.ResetModeMillis();
+  radio2.ResetModeMillis();
+  TransmitQueue::ResetStatistics();
+
+  srand(11);
+  std::vector<Sensor> sensors(SENSOR_COUNT);
+  for (size_t i = 0; i < sensors.size(); i++) {
+    sensors[i].Period = 4000000ul + i * 3000;
+    sensors[i].Next = rand() % sensors[i].Period;
+  }
+
+  Result result;
+  memset(&result, 0, sizeof(result));
+  std::vector<Transmission> onAir;
+  unsigned long frameMicros = (PREAMBLE_BYTES + FRAME_LENGTH) * 8000000ul / 17241ul;
+  unsigned long nextCommand = COMMAND_PERIOD;
+  unsigned long end = minutes * 60000000ul;
+
+  while (micros() < end) {
+    unsigned long passStart = micros();
+    unsigned long now = micros();
+
+    // The sensors do not wait for loop()
+    for (size_t i = 0; i < sensors.size(); i++) {
+      while ((long)(now - sensors[i].Next) >= 0) {
+        Transmission transmission = { i, sensors[i].Next, sensors[i].Next + frameMicros };
+        onAir.push_back(transmission);
+        result.OnAir++;
+        sensors[i].Next += sensors[i].Period - 20000 + rand() % 40000;
+      }
+    }
+    for (size_t j = 0; j < onAir.size(); ) {
+      if ((long)(now - onAir[j].End) < 0) {
+        j++;
+        continue;
+      }
+      if (sim1.GetMode() == RF_OPMODE_RECEIVER && (long)(onAir[j].Start - sim1.GetModeTime()) >= 0
+        && sim1.GetFifoCount() == 0) {
+        byte payload[PAYLOADSIZE];
+        BuildPayload(onAir[j].Sensor, payload);
+        sim1.LoadPayload(payload, PAYLOADSIZE);
+      }
+      onAir.erase(onAir.begin() + j);
+    }
+
+    // The Radios task
+    radio1.Receive();
+    if (radio1.PayloadIsReady()) {
+      byte payload[PAYLOADSIZE];
+      memcpy(payload, radio1.GetFrame()->Payload, PAYLOADSIZE);
+      radio1.ReleaseFrame();
+      result.Captured++;
+      result.Requested++;
+      Send(mode, &radio1, &radio2, payload, FRAME_LENGTH, RELAY_DELAY);
+    }
+    if (mode == QueueRadio2) {
+      radio2.Receive();
+      if (radio2.PayloadIsReady()) {
+        radio2.ReleaseFrame();
+      }
+    }
+
+    // The Commands task
+    if ((long)(now - nextCommand) >= 0) {
+      byte command[10] = { 0xCC, 0x10, 6, 1, 2, 3, 4, 5, 6, 0 };
+      result.Requested++;
+      Send(mode, &radio1, &radio2, command, sizeof(command), 0);
+      nextCommand += COMMAND_PERIOD;
+    }
+
+    // The Transmit task
+    if (mode != Blocking) {
+      TransmitQueue::Handle();
+    }
+
+    HostClock::AdvanceMicros(PASS_MICROS);
+    if (micros() - passStart > result.LongestPass) {
+      result.LongestPass = micros() - passStart;
+    }
+  }
+
+  while (TransmitQueue::GetCount() > 0) {
+    TransmitQueue::Handle();
+    HostClock::AdvanceMicros(PASS_MICROS);
+  }
+
+  result.Sent = sim1.GetSentFrames() + sim2.GetSentFrames();
+  result.ReceiveMillis = radio1.GetModeMillis(RFM::Receiving);
+  result.Millis = result.ReceiveMillis + radio1.GetModeMillis(RFM::Transmitting) + radio1.GetModeMillis(RFM::Idle);
+  result.Radio2SendMillis = radio2.GetModeMillis(RFM::Transmitting);
+
+  HostDevice::Unregister(&sim1);
+  HostDevice::Unregister(&sim2);
+  return result;
+}
+
+static double GetPercent(unsigned long part, unsigned long whole) {
+  return whole > 0 ? part * 100.0 / whole : 0;
+}
+
+int main(int argc, char **argv) {
+  Serial.EnableCapture(false);
+  unsigned long minutes = argc > 1 ? strtoul(argv[1], NULL, 10) : 10;
+  if (minutes == 0) {
+    minutes = 1;
+  }
+
+  bool ok = true;
+  printf("%-28s %8s %9s %9s %8s %10s %10s %9s\n", "Sending", "Frames", "Captured", "R1 rx", "Sent",
+    "R2 tx ms", "Dropped", "Pass ms");
+  Result results[ModeCount];
+  for (int m = 0; m < ModeCount; m++) {
+    Result result = Run((Mode)m, minutes);
+    results[m] = result;
+    printf("%-28s %8lu %8.2f%% %8.3f%% %4lu/%-4lu %10lu %10lu %9.1f\n", s_modeNames[m], result.OnAir,
+      GetPercent(result.Captured, result.OnAir), GetPercent(result.ReceiveMillis, result.Millis), result.Sent,
+      result.Requested, result.Radio2SendMillis, TransmitQueue::GetDroppedFrames(), result.LongestPass / 1000.0);
+
+    ok = ok && result.Sent == result.Requested;
+    if (m != Blocking) {
+      ok = ok && result.LongestPass < 5000 && TransmitQueue::GetDroppedFrames() == 0;
+    }
+  }
+  ok = ok && results[QueueRadio2].Captured > results[Blocking].Captured
+    && GetPercent(results[QueueRadio2].ReceiveMillis, results[QueueRadio2].Millis) >= 99.9;
+
+  printf("\nR1 rx: time radio 1 was receiving, Pass: longest pass of loop()\n");
+  printf("%s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}